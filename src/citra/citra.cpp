@@ -7,6 +7,7 @@
 #include <regex>
 #include <string>
 #include <thread>
+#include <fmt/format.h>
 
 // This needs to be included before getopt.h because the latter #defines symbols used by it
 #include "common/microprofile.h"
@@ -27,15 +28,18 @@
 #include "common/logging/backend.h"
 #include "common/logging/filter.h"
 #include "common/logging/log.h"
+#include "common/microprofile_trace.h"
 #include "common/scm_rev.h"
 #include "common/scope_exit.h"
 #include "common/string_util.h"
 #include "core/core.h"
+#include "core/custom_tex_cache.h"
 #include "core/dumping/backend.h"
 #include "core/file_sys/cia_container.h"
 #include "core/frontend/applets/default_applets.h"
 #include "core/frontend/framebuffer_layout.h"
 #include "core/frontend/scope_acquire_context.h"
+#include "core/game_library.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/service/am/am.h"
 #include "core/hle/service/cfg/cfg.h"
@@ -68,6 +72,12 @@ static void PrintHelp(const char* argv0) {
                  "-r, --movie-record=[file]  Record a movie (game inputs) to the given file\n"
                  "-p, --movie-play=[file]    Playback the movie (game inputs) from the given file\n"
                  "-d, --dump-video=[file]    Dumps audio and video to the given video file\n"
+                 "-t, --pack-textures=TITLEID Pack the custom textures of a title and exit\n"
+                 "-l, --list-games=DIR Lists the games in DIR and its subdirectories and exit\n"
+                 "-P, --profile-trace=FILE Records profiler scopes and writes them to FILE as a\n"
+                 "                         Chrome trace on exit\n"
+                 "-s, --frame-statistics=FILE Writes the frame time statistics to FILE on exit,\n"
+                 "                            as JSON if it ends with .json and CSV otherwise\n"
                  "-f, --fullscreen     Start in fullscreen mode\n"
                  "-h, --help           Display this help and exit\n"
                  "-v, --version        Output version information and exit\n";
@@ -182,6 +192,9 @@ static void InitializeLogging() {
 #ifdef _WIN32
     Log::AddBackend(std::make_unique<Log::DebuggerBackend>());
 #endif
+    if (Settings::values.binary_logging) {
+        Log::StartBinaryLogging(log_dir + LOG_BINARY_FILE);
+    }
 }
 
 /// Application entry point
@@ -194,8 +207,12 @@ int main(int argc, char** argv) {
     std::string movie_record;
     std::string movie_play;
     std::string dump_video;
+    std::string profile_trace;
+    std::string frame_statistics;
 
     InitializeLogging();
+    // Writes out the messages still buffered by the binary log on every exit path
+    SCOPE_EXIT({ Log::StopBinaryLogging(); });
 
     char* endarg;
 #ifdef _WIN32
@@ -221,11 +238,14 @@ int main(int argc, char** argv) {
         {"multiplayer", required_argument, 0, 'm'}, {"movie-record", required_argument, 0, 'r'},
         {"movie-play", required_argument, 0, 'p'},  {"dump-video", required_argument, 0, 'd'},
         {"fullscreen", no_argument, 0, 'f'},        {"help", no_argument, 0, 'h'},
-        {"version", no_argument, 0, 'v'},           {0, 0, 0, 0},
+        {"version", no_argument, 0, 'v'},           {"pack-textures", required_argument, 0, 't'},
+        {"profile-trace", required_argument, 0, 'P'}, {"list-games", required_argument, 0, 'l'},
+        {"frame-statistics", required_argument, 0, 's'},
+        {0, 0, 0, 0},
     };
 
     while (optind < argc) {
-        int arg = getopt_long(argc, argv, "g:i:m:r:p:fhv", long_options, &option_index);
+        int arg = getopt_long(argc, argv, "g:i:m:r:p:t:P:l:s:fhv", long_options, &option_index);
         if (arg != -1) {
             switch (static_cast<char>(arg)) {
             case 'g':
@@ -291,6 +311,37 @@ int main(int argc, char** argv) {
             case 'd':
                 dump_video = optarg;
                 break;
+            case 'P':
+                profile_trace = optarg;
+                break;
+            case 's':
+                frame_statistics = optarg;
+                break;
+            case 't': {
+                errno = 0;
+                const u64 program_id = std::strtoull(optarg, &endarg, 16);
+                if (endarg == optarg)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--pack-textures");
+                    exit(1);
+                }
+                LodePNGImageInterface image_interface;
+                Core::CustomTexCache custom_tex_cache;
+                custom_tex_cache.FindCustomTextures(program_id);
+                return custom_tex_cache.PackTextures(image_interface, program_id) != 0 ? 0 : 1;
+            }
+            case 'l': {
+                Core::GameLibrary library;
+                for (const Core::GameLibraryEntry& entry : library.Scan(optarg, 256)) {
+                    std::cout << fmt::format(
+                        "{:016X} {:<5} {} ({})\n", entry.program_id,
+                        Loader::GetFileTypeString(entry.file_type),
+                        entry.GetShortTitle(Loader::SMDH::TitleLanguage::English), entry.path);
+                }
+                library.SaveIndex();
+                return 0;
+            }
             case 'f':
                 fullscreen = true;
                 LOG_INFO(Frontend, "Starting in fullscreen mode...");
@@ -421,11 +472,24 @@ int main(int argc, char** argv) {
                       total);
         });
 
+    if (!profile_trace.empty()) {
+        Common::ProfileTrace::StartRecording();
+    }
+
     while (emu_window->IsOpen()) {
         system.RunLoop();
     }
     render_thread.join();
 
+    if (!profile_trace.empty()) {
+        Common::ProfileTrace::Dump(profile_trace);
+        Common::ProfileTrace::StopRecording();
+    }
+
+    if (!frame_statistics.empty()) {
+        system.ExportFrameStatistics(frame_statistics);
+    }
+
     Core::Movie::GetInstance().Shutdown();
     if (system.VideoDumper().IsDumping()) {
         system.VideoDumper().StopDumping();
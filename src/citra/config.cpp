@@ -106,6 +106,12 @@ void Config::ReadValues() {
     Settings::values.use_cpu_jit = sdl2_config->GetBoolean("Core", "use_cpu_jit", true);
     Settings::values.cpu_clock_percentage =
         sdl2_config->GetInteger("Core", "cpu_clock_percentage", 100);
+    Settings::values.use_multi_core = sdl2_config->GetBoolean("Core", "use_multi_core", false);
+    Settings::values.skip_idle_loops = sdl2_config->GetBoolean("Core", "skip_idle_loops", false);
+    Settings::values.enable_rewind = sdl2_config->GetBoolean("Core", "enable_rewind", false);
+    Settings::values.rewind_interval = sdl2_config->GetInteger("Core", "rewind_interval", 60);
+    Settings::values.rewind_memory_limit =
+        sdl2_config->GetInteger("Core", "rewind_memory_limit", 512);
 
     // Renderer
     Settings::values.use_gles = sdl2_config->GetBoolean("Renderer", "use_gles", false);
@@ -121,6 +127,7 @@ void Config::ReadValues() {
     Settings::values.shaders_accurate_mul =
         sdl2_config->GetBoolean("Renderer", "shaders_accurate_mul", true);
     Settings::values.use_shader_jit = sdl2_config->GetBoolean("Renderer", "use_shader_jit", true);
+    Settings::values.use_gpu_thread = sdl2_config->GetBoolean("Renderer", "use_gpu_thread", false);
     Settings::values.resolution_factor =
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "resolution_factor", 1));
     Settings::values.use_disk_shader_cache =
@@ -131,6 +138,11 @@ void Config::ReadValues() {
         sdl2_config->GetBoolean("Renderer", "use_frame_limit_alternate", false);
     Settings::values.frame_limit_alternate =
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "frame_limit_alternate", 200));
+    Settings::values.use_turbo = sdl2_config->GetBoolean("Renderer", "use_turbo", false);
+    Settings::values.turbo_skip_frames =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "turbo_skip_frames", 9));
+    Settings::values.turbo_frame_interval =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "turbo_frame_interval", 10));
     Settings::values.use_vsync_new =
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "use_vsync_new", 1));
     Settings::values.texture_filter_name =
@@ -201,6 +213,10 @@ void Config::ReadValues() {
     // Data Storage
     Settings::values.use_virtual_sd =
         sdl2_config->GetBoolean("Data Storage", "use_virtual_sd", true);
+    Settings::values.async_file_reads =
+        sdl2_config->GetBoolean("Data Storage", "async_file_reads", false);
+    Settings::values.write_back_save_data =
+        sdl2_config->GetBoolean("Data Storage", "write_back_save_data", false);
 
     // System
     Settings::values.is_new_3ds = sdl2_config->GetBoolean("System", "is_new_3ds", true);
@@ -252,10 +268,14 @@ void Config::ReadValues() {
 
     // Miscellaneous
     Settings::values.log_filter = sdl2_config->GetString("Miscellaneous", "log_filter", "*:Info");
+    Settings::values.binary_logging =
+        sdl2_config->GetBoolean("Miscellaneous", "binary_logging", false);
 
     // Debugging
     Settings::values.record_frame_times =
         sdl2_config->GetBoolean("Debugging", "record_frame_times", false);
+    Settings::values.movie_keyframe_interval =
+        sdl2_config->GetInteger("Debugging", "movie_keyframe_interval", 60);
     Settings::values.use_gdbstub = sdl2_config->GetBoolean("Debugging", "use_gdbstub", false);
     Settings::values.gdbstub_port =
         static_cast<u16>(sdl2_config->GetInteger("Debugging", "gdbstub_port", 24689));
@@ -97,6 +97,29 @@ use_cpu_jit =
 # Range is any positive integer (but we suspect 25 - 400 is a good idea) Default is 100
 cpu_clock_percentage =
 
+# Whether to run the emulated CPU cores on separate host threads. Experimental, requires the JIT.
+# 0 (default): Off, 1: On
+use_multi_core =
+
+# Whether to detect loops that only wait for memory or the system tick to change and skip ahead to
+# the next event instead of running them. Only used with the JIT. This is a speed hack: it changes
+# the timing of the guest and can break timing-sensitive games.
+# 0 (default): Off, 1: On
+skip_idle_loops =
+
+# Whether to keep snapshots of the emulated system in memory to go back in time
+# 0 (default): Off, 1: On
+enable_rewind =
+
+# Number of frames between two rewind snapshots, which is also how far back a rewind goes
+# Default is 60
+rewind_interval =
+
+# Memory the rewind snapshots may use, in MiB. Rewind also keeps an uncompressed copy of the
+# emulated RAM, which takes another 134 MiB, or 266 MiB in New 3DS mode.
+# Default is 512
+rewind_memory_limit =
+
 [Renderer]
 # Whether to render using GLES or OpenGL
 # 0 (default): OpenGL, 1: GLES
@@ -122,6 +145,10 @@ shaders_accurate_mul =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether to emulate the GPU on a separate thread, in parallel with the CPU
+# 0 (default): Off, 1: On
+use_gpu_thread =
+
 # Forces VSync on the display thread. Usually doesn't impact performance, but on some drivers it can
 # so only turn this off if you notice a speed difference.
 # 0: Off, 1 (default): On
@@ -148,6 +175,18 @@ frame_limit =
 # 0: Off (default), 1: On
 use_frame_limit_alternate =
 
+# Runs the emulation unthrottled and skips the rasterization of most frames. Games that read back
+# what they rendered see stale contents on skipped frames, which can cause glitches or desyncs.
+# 0: Off (default), 1: On
+use_turbo =
+
+# In turbo mode, the number of frames out of every turbo_frame_interval frames that are skipped.
+# Setting this to turbo_frame_interval or higher skips every frame. 9 (default)
+turbo_skip_frames =
+
+# In turbo mode, the number of frames over which turbo_skip_frames frames are skipped. 10 (default)
+turbo_frame_interval =
+
 # Alternate speed limit to be used instead of frame_limit if use_frame_limit_alternate is enabled
 # 5 - 995: Speed limit as a percentage of target game speed. 0 for unthrottled. 200 (default)
 frame_limit_alternate =
@@ -250,6 +289,15 @@ volume =
 # 1 (default): Yes, 0: No
 use_virtual_sd =
 
+# Whether to read large files on a background thread while the emulated read latency elapses
+# 0 (default): No, 1: Yes
+async_file_reads =
+
+# Whether to buffer writes to save data in memory. They are written to disk when the game closes
+# the file or commits the save data, or once they are 2 seconds old.
+# 0 (default): Off, 1: On
+write_back_save_data =
+
 [System]
 # The system model that Citra will try to emulate
 # 0: Old 3DS, 1: New 3DS (default)
@@ -295,9 +343,18 @@ camera_inner_flip =
 # Examples: *:Debug Kernel.SVC:Trace Service.*:Critical
 log_filter = *:Info
 
+# Also logs to a binary file in the log directory, which leaves formatting the messages to a
+# separate thread, so that Debug and Trace messages are cheaper. Decode it with citra-log-decoder.
+# 0 (default): Off, 1: On
+binary_logging =
+
 [Debugging]
 # Record frame time data, can be found in the log directory. Boolean value
 record_frame_times =
+# Seconds of emulated time between the keyframes of a recorded movie, which seeking restores.
+# Every keyframe is a compressed save state that makes the movie file larger. 0 disables them.
+# Default is 60
+movie_keyframe_interval =
 # Port for listening to GDB connections.
 use_gdbstub=false
 gdbstub_port=24689
@@ -35,6 +35,12 @@ ConfigureGeneral::ConfigureGeneral(QWidget* parent)
     connect(ui->button_reset_defaults, &QPushButton::clicked, this,
             &ConfigureGeneral::ResetDefaults);
 
+    // Rewind is set up when emulation starts
+    ui->rewindBox->setEnabled(!Core::System::GetInstance().IsPoweredOn());
+    connect(ui->toggle_rewind, &QCheckBox::toggled, ui->rewind_interval, &QSpinBox::setEnabled);
+    connect(ui->toggle_rewind, &QCheckBox::toggled, ui->rewind_memory_limit,
+            &QSpinBox::setEnabled);
+
     connect(ui->frame_limit, &QSlider::valueChanged, [&](int value) {
         if (value == ui->frame_limit->maximum()) {
             ui->emulation_speed_display_label->setText(tr("unthrottled"));
@@ -101,6 +107,12 @@ void ConfigureGeneral::SetConfiguration() {
                 .arg(SliderToSettings(ui->frame_limit_alternate->value()))
                 .rightJustified(tr("unthrottled").size()));
     }
+
+    ui->toggle_rewind->setChecked(Settings::values.enable_rewind);
+    ui->rewind_interval->setValue(Settings::values.rewind_interval);
+    ui->rewind_memory_limit->setValue(Settings::values.rewind_memory_limit);
+    ui->rewind_interval->setEnabled(Settings::values.enable_rewind);
+    ui->rewind_memory_limit->setEnabled(Settings::values.enable_rewind);
 }
 
 void ConfigureGeneral::ResetDefaults() {
@@ -138,6 +150,10 @@ void ConfigureGeneral::ApplyConfiguration() {
         Settings::values.frame_limit_alternate =
             SliderToSettings(ui->frame_limit_alternate->value());
     }
+
+    Settings::values.enable_rewind = ui->toggle_rewind->isChecked();
+    Settings::values.rewind_interval = ui->rewind_interval->value();
+    Settings::values.rewind_memory_limit = ui->rewind_memory_limit->value();
 }
 
 void ConfigureGeneral::RetranslateUI() {
@@ -30,6 +30,7 @@
 #include "common/logging/log.h"
 #include "core/file_sys/archive_extsavedata.h"
 #include "core/file_sys/archive_source_sd_savedata.h"
+#include "core/game_library.h"
 #include "core/hle/service/fs/archive.h"
 
 GameListSearchField::KeyReleaseEater::KeyReleaseEater(GameList* gamelist, QObject* parent)
@@ -711,9 +712,13 @@ void GameList::LoadInterfaceLayout() {
     header->resizeSection(COLUMN_NAME, header->width());
 }
 
-const QStringList GameList::supported_file_extensions = {
-    QStringLiteral("3ds"), QStringLiteral("3dsx"), QStringLiteral("elf"), QStringLiteral("axf"),
-    QStringLiteral("cci"), QStringLiteral("cxi"),  QStringLiteral("app")};
+const QStringList GameList::supported_file_extensions = [] {
+    QStringList extensions;
+    for (const char* extension : Core::GameLibrary::SUPPORTED_EXTENSIONS) {
+        extensions.append(QString::fromLatin1(extension));
+    }
+    return extensions;
+}();
 
 void GameList::RefreshGameDirectory() {
     if (!UISettings::values.game_dirs.isEmpty() && current_worker != nullptr) {
@@ -16,6 +16,7 @@
 #include <QVector>
 #include "citra_qt/compatibility_list.h"
 #include "common/common_types.h"
+#include "core/game_library.h"
 
 class QStandardItem;
 
@@ -53,12 +54,13 @@ signals:
     void Finished(QStringList watch_list);
 
 private:
-    void AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion,
-                                 GameListDir* parent_dir);
+    void AddEntriesToGameList(const std::string& dir_path, unsigned int recursion,
+                              GameListDir* parent_dir);
 
     QVector<UISettings::GameDir>& game_dirs;
     const CompatibilityList& compatibility_list;
 
+    Core::GameLibrary library;
     QStringList watch_list;
     std::atomic_bool stop_processing;
 };
@@ -2,8 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <clocale>
 #include <fstream>
+#include <limits>
 #include <memory>
 #include <thread>
 #include <QDesktopWidget>
@@ -65,6 +67,7 @@
 #include "common/logging/log.h"
 #include "common/logging/text_formatter.h"
 #include "common/microprofile.h"
+#include "common/microprofile_trace.h"
 #include "common/scm_rev.h"
 #include "common/scope_exit.h"
 #ifdef ARCHITECTURE_x86_64
@@ -147,6 +150,9 @@ static void InitializeLogging() {
 #ifdef _WIN32
     Log::AddBackend(std::make_unique<Log::DebuggerBackend>());
 #endif
+    if (Settings::values.binary_logging) {
+        Log::StartBinaryLogging(log_dir + LOG_BINARY_FILE);
+    }
 }
 
 GMainWindow::GMainWindow()
@@ -314,8 +320,41 @@ void GMainWindow::InitializeDebugWidgets() {
     microProfileDialog = new MicroProfileDialog(this);
     microProfileDialog->hide();
     debug_menu->addAction(microProfileDialog->toggleViewAction());
+
+    QAction* record_profile_trace = debug_menu->addAction(tr("Record Profile Trace"));
+    record_profile_trace->setCheckable(true);
+    connect(record_profile_trace, &QAction::toggled, this, [this](bool checked) {
+        if (checked) {
+            Common::ProfileTrace::StartRecording();
+            return;
+        }
+        const QString path = QFileDialog::getSaveFileName(this, tr("Save Profile Trace"), {},
+                                                          tr("Chrome Trace (*.json)"));
+        if (!path.isEmpty() && !Common::ProfileTrace::Dump(path.toStdString())) {
+            QMessageBox::critical(this, tr("Save Profile Trace"),
+                                  tr("Could not write the profile trace."));
+        }
+        Common::ProfileTrace::StopRecording();
+    });
 #endif
 
+    QAction* export_frame_statistics = debug_menu->addAction(tr("Export Frame Statistics..."));
+    connect(export_frame_statistics, &QAction::triggered, this, [this] {
+        if (!Core::System::GetInstance().IsPoweredOn()) {
+            return;
+        }
+        const QString path = QFileDialog::getSaveFileName(
+            this, tr("Export Frame Statistics"), {}, tr("JSON (*.json);;CSV (*.csv)"));
+        if (!path.isEmpty() &&
+            !Core::System::GetInstance().ExportFrameStatistics(path.toStdString())) {
+            QMessageBox::critical(this, tr("Export Frame Statistics"),
+                                  tr("Could not write the frame statistics."));
+        }
+    });
+    QAction* reset_frame_statistics = debug_menu->addAction(tr("Reset Frame Statistics"));
+    connect(reset_frame_statistics, &QAction::triggered, this,
+            [] { Core::System::GetInstance().ResetFrameStatistics(); });
+
     registersWidget = new RegistersWidget(this);
     addDockWidget(Qt::RightDockWidgetArea, registersWidget);
     registersWidget->hide();
@@ -507,6 +546,11 @@ void GMainWindow::InitializeHotkeys() {
     connect(hotkey_registry.GetHotkey(main_window, QStringLiteral("Toggle Texture Dumping"), this),
             &QShortcut::activated, this,
             [&] { Settings::values.dump_textures = !Settings::values.dump_textures; });
+    connect(hotkey_registry.GetHotkey(main_window, QStringLiteral("Toggle Turbo Mode"), this),
+            &QShortcut::activated, this, [&] {
+                Settings::values.use_turbo = !Settings::values.use_turbo;
+                UpdateStatusBar();
+            });
     // We use "static" here in order to avoid capturing by lambda due to a MSVC bug, which makes
     // the variable hold a garbage value after this function exits
     static constexpr u16 SPEED_LIMIT_STEP = 5;
@@ -573,6 +617,12 @@ void GMainWindow::InitializeHotkeys() {
                     OnCaptureScreenshot();
                 }
             });
+    connect(hotkey_registry.GetHotkey(main_window, QStringLiteral("Rewind"), this),
+            &QShortcut::activated, this, [&] {
+                if (emulation_running) {
+                    Core::System::GetInstance().RequestRewind(Settings::values.rewind_interval);
+                }
+            });
     connect(hotkey_registry.GetHotkey(main_window, QStringLiteral("Load from Newest Slot"), this),
             &QShortcut::activated, ui->action_Load_from_Newest_Slot, &QAction::trigger);
     connect(hotkey_registry.GetHotkey(main_window, QStringLiteral("Save to Oldest Slot"), this),
@@ -745,6 +795,7 @@ void GMainWindow::ConnectMenuEvents() {
     connect(ui->action_Play_Movie, &QAction::triggered, this, &GMainWindow::OnPlayMovie);
     connect(ui->action_Stop_Recording_Playback, &QAction::triggered, this,
             &GMainWindow::OnStopRecordingPlayback);
+    connect(ui->action_Seek_Movie, &QAction::triggered, this, &GMainWindow::OnSeekMovie);
     connect(ui->action_Enable_Frame_Advancing, &QAction::triggered, this, [this] {
         if (emulation_running) {
             Core::System::GetInstance().frame_limiter.SetFrameAdvancing(
@@ -1963,6 +2014,7 @@ void GMainWindow::OnPlayMovie() {
     ui->action_Record_Movie->setEnabled(false);
     ui->action_Play_Movie->setEnabled(false);
     ui->action_Stop_Recording_Playback->setEnabled(true);
+    ui->action_Seek_Movie->setEnabled(true);
 }
 
 void GMainWindow::OnStopRecordingPlayback() {
@@ -1981,6 +2033,31 @@ void GMainWindow::OnStopRecordingPlayback() {
     ui->action_Record_Movie->setEnabled(true);
     ui->action_Play_Movie->setEnabled(true);
     ui->action_Stop_Recording_Playback->setEnabled(false);
+    ui->action_Seek_Movie->setEnabled(false);
+}
+
+void GMainWindow::OnSeekMovie() {
+    auto& movie = Core::Movie::GetInstance();
+    const u64 frame_count = movie.GetFrameCount();
+    if (frame_count == 0) {
+        return;
+    }
+
+    bool ok;
+    const int last_frame =
+        static_cast<int>(std::min<u64>(frame_count - 1, std::numeric_limits<int>::max()));
+    const int current_frame = static_cast<int>(std::min<u64>(movie.GetCurrentFrame(), last_frame));
+    const int frame = QInputDialog::getInt(this, tr("Seek to Frame"),
+                                           tr("Frame (0 - %1):").arg(last_frame), current_frame,
+                                           0, last_frame, 1, &ok);
+    if (!ok)
+        return;
+
+    if (!movie.SeekToFrame(static_cast<u64>(frame))) {
+        QMessageBox::critical(this, tr("Seek to Frame"),
+                              tr("Unable to seek to frame %1. Refer to the log for details.")
+                                  .arg(frame));
+    }
 }
 
 void GMainWindow::OnCaptureScreenshot() {
@@ -2072,7 +2149,10 @@ void GMainWindow::UpdateStatusBar() {
 
     auto results = Core::System::GetInstance().GetAndResetPerfStats();
 
-    if (Settings::values.use_frame_limit_alternate) {
+    if (Settings::values.use_turbo) {
+        emu_speed_label->setText(
+            tr("Speed: %1% (Turbo)").arg(results.emulation_speed * 100.0, 0, 'f', 0));
+    } else if (Settings::values.use_frame_limit_alternate) {
         if (Settings::values.frame_limit_alternate == 0) {
             emu_speed_label->setText(
                 tr("Speed: %1%").arg(results.emulation_speed * 100.0, 0, 'f', 0));
@@ -2363,6 +2443,7 @@ void GMainWindow::OnMoviePlaybackCompleted() {
     ui->action_Record_Movie->setEnabled(true);
     ui->action_Play_Movie->setEnabled(true);
     ui->action_Stop_Recording_Playback->setEnabled(false);
+    ui->action_Seek_Movie->setEnabled(false);
 }
 
 void GMainWindow::UpdateWindowTitle() {
@@ -2492,5 +2573,7 @@ int main(int argc, char* argv[]) {
 
     int result = app.exec();
     detached_tasks.WaitForAllTasks();
+    // Writes out the messages still buffered by the binary log
+    Log::StopBinaryLogging();
     return result;
 }
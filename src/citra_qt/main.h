@@ -209,6 +209,7 @@ private slots:
     void OnRecordMovie();
     void OnPlayMovie();
     void OnStopRecordingPlayback();
+    void OnSeekMovie();
     void OnCaptureScreenshot();
     void OnConnectCTroll3D();
 #ifdef ENABLE_FFMPEG_VIDEO_DUMPER
@@ -99,6 +99,16 @@ private:
 // Returns the size of filename (64bit)
 [[nodiscard]] u64 GetSize(const std::string& filename);
 
+struct FileStatus {
+    u64 size;
+    /// Last modification time, in seconds since the epoch
+    s64 modification_time;
+};
+
+// Returns the size and last modification time of a regular file with a single stat, or
+// std::nullopt if filename doesn't exist or is a directory
+[[nodiscard]] std::optional<FileStatus> GetFileStatus(const std::string& filename);
+
 // Overloaded GetSize, accepts file descriptor
 [[nodiscard]] u64 GetSize(int fd);
 
@@ -121,6 +131,10 @@ bool DeleteDir(const std::string& filename);
 // renames file srcFilename to destFilename, returns true on success
 bool Rename(const std::string& srcFilename, const std::string& destFilename);
 
+// renames file srcFilename to destFilename, replacing destFilename if it exists,
+// returns true on success
+bool RenameReplacing(const std::string& srcFilename, const std::string& destFilename);
+
 // copies file srcFilename to destFilename, returns true on success
 bool Copy(const std::string& srcFilename, const std::string& destFilename);
 
@@ -376,6 +390,37 @@ private:
     friend class boost::serialization::access;
 };
 
+// Read-only memory mapping of a whole file. The contents are paged in by the OS on first access,
+// so large files can be opened without reading them into memory.
+class MappedFile : public NonCopyable {
+public:
+    MappedFile();
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    [[nodiscard]] bool IsOpen() const {
+        return data != nullptr;
+    }
+
+    [[nodiscard]] const u8* Data() const {
+        return data;
+    }
+
+    [[nodiscard]] std::size_t Size() const {
+        return size;
+    }
+
+private:
+    const u8* data = nullptr;
+    std::size_t size = 0;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+};
+
 } // namespace FileUtil
 
 // To deal with Windows being dumb at unicode:
@@ -0,0 +1,118 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Histogram of integer values with a bounded relative error, in the style of HdrHistogram. Values
+ * below SubBuckets are counted exactly, and every power of two above that is split into SubBuckets
+ * / 2 linear buckets, so values are rounded down by at most 2 / SubBuckets of their value. Its size
+ * is fixed, so recording never allocates.
+ */
+class Histogram {
+public:
+    /// Number of buckets per power of two, which sets the precision to about 1.5%
+    static constexpr u32 SubBucketBits = 7;
+    static constexpr u32 SubBuckets = 1 << SubBucketBits;
+
+    void Record(u64 value) {
+        ++counts[BucketIndex(value)];
+        ++count;
+        sum += value;
+        max = std::max(max, value);
+    }
+
+    void Reset() {
+        counts.fill(0);
+        count = 0;
+        sum = 0;
+        max = 0;
+    }
+
+    u64 Count() const {
+        return count;
+    }
+
+    u64 Max() const {
+        return max;
+    }
+
+    double Mean() const {
+        return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count);
+    }
+
+    /**
+     * Gets the value below or at which the given fraction of the recorded values are.
+     * @param fraction Fraction between 0 and 1, 0.99 for the 99th percentile
+     * @return The lowest value of the bucket holding that value, or the maximum for a fraction of 1
+     */
+    u64 Percentile(double fraction) const {
+        if (count == 0) {
+            return 0;
+        }
+        if (fraction >= 1.0) {
+            return max;
+        }
+        const u64 rank = std::max<u64>(1, static_cast<u64>(std::ceil(fraction * count)));
+        u64 seen = 0;
+        for (std::size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(BucketValue(i), max);
+            }
+        }
+        return max;
+    }
+
+    /// Gets the number of recorded values in buckets entirely above the given value
+    u64 CountAbove(u64 value) const {
+        u64 above = 0;
+        for (std::size_t i = BucketIndex(value) + 1; i < counts.size(); ++i) {
+            above += counts[i];
+        }
+        return above;
+    }
+
+private:
+    /// Number of powers of two that are split into buckets, for values of up to 64 bits
+    static constexpr u32 NumRanges = 64 - SubBucketBits + 1;
+
+    static std::size_t BucketIndex(u64 value) {
+        if (value < SubBuckets) {
+            return static_cast<std::size_t>(value);
+        }
+        u32 msb = 0;
+        while ((value >> msb) > 1) {
+            ++msb;
+        }
+        // Keep the SubBucketBits - 1 bits below the most significant one
+        const u32 shift = msb - (SubBucketBits - 1);
+        const u64 sub_bucket = (value >> shift) - SubBuckets / 2;
+        return SubBuckets + (shift - 1) * (SubBuckets / 2) + static_cast<std::size_t>(sub_bucket);
+    }
+
+    static u64 BucketValue(std::size_t index) {
+        if (index < SubBuckets) {
+            return index;
+        }
+        const u32 shift = static_cast<u32>((index - SubBuckets) / (SubBuckets / 2)) + 1;
+        const u64 sub_bucket = (index - SubBuckets) % (SubBuckets / 2) + SubBuckets / 2;
+        return sub_bucket << shift;
+    }
+
+    std::array<u64, SubBuckets + (NumRanges - 1) * (SubBuckets / 2)> counts{};
+    u64 count = 0;
+    u64 sum = 0;
+    u64 max = 0;
+};
+
+} // namespace Common
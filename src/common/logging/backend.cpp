@@ -19,6 +19,7 @@
 #endif
 #include "common/assert.h"
 #include "common/logging/backend.h"
+#include "common/logging/binary_log.h"
 #include "common/logging/log.h"
 #include "common/logging/text_formatter.h"
 #include "common/string_util.h"
@@ -45,6 +46,10 @@ public:
             CreateEntry(log_class, log_level, filename, line_num, function, std::move(message)));
     }
 
+    void PushEntry(Entry entry) {
+        message_queue.Push(std::move(entry));
+    }
+
     void AddBackend(std::unique_ptr<Backend> backend) {
         std::lock_guard lock{writing_mutex};
         backends.push_back(std::move(backend));
@@ -299,6 +304,20 @@ Backend* GetBackend(std::string_view backend_name) {
     return Impl::Instance().GetBackend(backend_name);
 }
 
+bool StartBinaryLogging(const std::string& path, bool forward_to_backends) {
+    if (!forward_to_backends) {
+        return BinaryLog::Start(path);
+    }
+    // The writer thread pushes to the backend thread, which has to outlive it
+    auto& instance = Impl::Instance();
+    return BinaryLog::Start(path,
+                            [&instance](Entry entry) { instance.PushEntry(std::move(entry)); });
+}
+
+void StopBinaryLogging() {
+    BinaryLog::Stop();
+}
+
 void FmtLogMessageImpl(Class log_class, Level log_level, const char* filename,
                        unsigned int line_num, const char* function, const char* format,
                        const fmt::format_args& args) {
@@ -307,6 +326,9 @@ void FmtLogMessageImpl(Class log_class, Level log_level, const char* filename,
     if (!filter.CheckMessage(log_class, log_level))
         return;
 
+    if (BinaryLog::PushMessage(log_class, log_level, filename, line_num, function, format, args))
+        return;
+
     instance.PushEntry(log_class, log_level, filename, line_num, function,
                        fmt::vformat(format, args));
 }
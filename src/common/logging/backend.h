@@ -142,4 +142,17 @@ const char* GetLevelName(Level log_level);
  * never get the message
  */
 void SetGlobalFilter(const Filter& filter);
+
+/**
+ * Starts logging the messages that pass the global filter to a binary log file, without formatting
+ * them on the logging thread. They are decoded with citra-log-decoder.
+ * @param path Path of the binary log file
+ * @param forward_to_backends Whether the messages are also formatted off the logging threads and
+ * written to the backends
+ * @return False if the file can't be opened, or binary logging was already started
+ */
+bool StartBinaryLogging(const std::string& path, bool forward_to_backends = true);
+
+/// Stops logging to the binary log file, and returns to formatting the messages when logged
+void StopBinaryLogging();
 } // namespace Log
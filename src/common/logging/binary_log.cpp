@@ -0,0 +1,738 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#if __has_include(<fmt/args.h>)
+#include <fmt/args.h>
+#endif
+#include "common/file_util.h"
+#include "common/logging/backend.h"
+#include "common/logging/binary_log.h"
+#include "common/logging/log.h"
+#include "common/thread.h"
+
+namespace Log::BinaryLog {
+
+namespace {
+
+constexpr u32 FileMagic = 0x474C4243; // "CBLG"
+constexpr u32 FileVersion = 1;
+
+/// How often the writer thread drains the buffers, unless one of them fills up before that
+constexpr auto FlushInterval = std::chrono::milliseconds(50);
+
+/// Maximum number of arguments of a message, which is the number fmt packs into format_args
+constexpr int MaxArgs = 15;
+
+enum class RecordType : u8 {
+    Site,             ///< Call site: id, class, level, line, filename, function and format string
+    Message,          ///< Message with raw arguments: site id, timestamp and arguments
+    FormattedMessage, ///< Message formatted by the logging thread: site id, timestamp and message
+    Dropped,          ///< Number of messages that a thread dropped as its buffer was full
+};
+
+enum class ArgType : u8 { Int, UInt, Bool, Char, Double, String, Pointer };
+
+const auto time_origin = std::chrono::steady_clock::now();
+
+template <typename T>
+void Write(std::vector<u8>& out, T value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const std::size_t offset = out.size();
+    out.resize(offset + sizeof(T));
+    std::memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+void WriteString(std::vector<u8>& out, std::string_view str) {
+    Write(out, static_cast<u32>(str.size()));
+    out.insert(out.end(), str.begin(), str.end());
+}
+
+/// Reads values from a record, and remembers if it ran past its end
+class RecordReader {
+public:
+    RecordReader(const u8* data, std::size_t size) : pos(data), end(data + size) {}
+
+    template <typename T>
+    T Read() {
+        T value{};
+        if (static_cast<std::size_t>(end - pos) < sizeof(T)) {
+            good = false;
+            pos = end;
+            return value;
+        }
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    std::string_view ReadString() {
+        const auto size = Read<u32>();
+        if (static_cast<std::size_t>(end - pos) < size) {
+            good = false;
+            pos = end;
+            return {};
+        }
+        const std::string_view str(reinterpret_cast<const char*>(pos), size);
+        pos += size;
+        return str;
+    }
+
+    bool IsGood() const {
+        return good;
+    }
+
+    std::size_t Offset(const u8* begin) const {
+        return static_cast<std::size_t>(pos - begin);
+    }
+
+private:
+    const u8* pos;
+    const u8* end;
+    bool good = true;
+};
+
+/// Stores the raw value of a format argument, or fails if it uses a custom formatter
+struct ArgEncoder {
+    std::vector<u8>& out;
+
+    template <typename T>
+    bool operator()(T value) {
+        if constexpr (std::is_same_v<T, bool>) {
+            Write(out, ArgType::Bool);
+            Write(out, static_cast<u8>(value));
+        } else if constexpr (std::is_same_v<T, char>) {
+            Write(out, ArgType::Char);
+            Write(out, value);
+        } else if constexpr (std::is_integral_v<T> && sizeof(T) <= sizeof(u64)) {
+            if constexpr (std::is_signed_v<T>) {
+                Write(out, ArgType::Int);
+                Write(out, static_cast<s64>(value));
+            } else {
+                Write(out, ArgType::UInt);
+                Write(out, static_cast<u64>(value));
+            }
+        } else if constexpr (std::is_floating_point_v<T>) {
+            Write(out, ArgType::Double);
+            Write(out, static_cast<double>(value));
+        } else if constexpr (std::is_same_v<T, const char*>) {
+            Write(out, ArgType::String);
+            WriteString(out, value);
+        } else if constexpr (std::is_same_v<T, fmt::basic_string_view<char>>) {
+            Write(out, ArgType::String);
+            WriteString(out, std::string_view(value.data(), value.size()));
+        } else if constexpr (std::is_same_v<T, const void*>) {
+            Write(out, ArgType::Pointer);
+            Write(out, static_cast<u64>(reinterpret_cast<std::uintptr_t>(value)));
+        } else {
+            // Custom formatters and 128-bit integers
+            return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * Returns a copy of a filename that is never freed. Entries point to their filename, and can still
+ * be queued for the backends after the decoder is gone.
+ */
+const char* InternFilename(std::string_view filename) {
+    static std::mutex mutex;
+    static auto* filenames = new std::unordered_set<std::string>();
+    std::lock_guard lock{mutex};
+    return filenames->emplace(filename).first->c_str();
+}
+
+/// Turns the records of a binary log back into entries
+class Decoder {
+public:
+    /**
+     * Decodes one record.
+     * @param has_entry Set if the record was a message, which is stored in entry
+     * @return Size of the record, or 0 if it is malformed
+     */
+    std::size_t Decode(const u8* data, std::size_t size, Entry& entry, bool& has_entry) {
+        RecordReader reader(data, size);
+        has_entry = false;
+        switch (reader.Read<RecordType>()) {
+        case RecordType::Site: {
+            Site site;
+            const auto id = reader.Read<u32>();
+            site.log_class = reader.Read<Class>();
+            site.log_level = reader.Read<Level>();
+            site.line_num = reader.Read<u32>();
+            site.filename = InternFilename(reader.ReadString());
+            site.function = reader.ReadString();
+            site.format = reader.ReadString();
+            if (!reader.IsGood() || site.log_class >= Class::Count ||
+                site.log_level >= Level::Count) {
+                return 0;
+            }
+            if (sites.size() <= id) {
+                sites.resize(id + 1);
+            }
+            sites[id] = std::move(site);
+            break;
+        }
+        case RecordType::Message:
+        case RecordType::FormattedMessage: {
+            const bool formatted = data[0] == static_cast<u8>(RecordType::FormattedMessage);
+            const auto id = reader.Read<u32>();
+            const auto timestamp = reader.Read<u64>();
+            if (!reader.IsGood() || id >= sites.size() || sites[id].filename == nullptr) {
+                return 0;
+            }
+            const Site& site = sites[id];
+            entry.timestamp = std::chrono::microseconds(timestamp);
+            entry.log_class = site.log_class;
+            entry.log_level = site.log_level;
+            entry.filename = site.filename;
+            entry.line_num = site.line_num;
+            entry.function = site.function;
+            if (formatted) {
+                entry.message = reader.ReadString();
+            } else if (!FormatMessage(reader, site.format, entry.message)) {
+                return 0;
+            }
+            has_entry = reader.IsGood();
+            break;
+        }
+        case RecordType::Dropped: {
+            const auto dropped = reader.Read<u64>();
+            const auto timestamp = reader.Read<u64>();
+            num_dropped += dropped;
+            entry.timestamp = std::chrono::microseconds(timestamp);
+            entry.log_class = Class::Log;
+            entry.log_level = Level::Warning;
+            entry.filename = "";
+            entry.line_num = 0;
+            entry.function.clear();
+            entry.message = fmt::format("{} messages were dropped as the buffer was full", dropped);
+            has_entry = reader.IsGood();
+            break;
+        }
+        default:
+            return 0;
+        }
+        return reader.IsGood() ? reader.Offset(data) : 0;
+    }
+
+    u64 NumDropped() const {
+        return num_dropped;
+    }
+
+private:
+    struct Site {
+        Class log_class{};
+        Level log_level{};
+        u32 line_num = 0;
+        const char* filename = nullptr;
+        std::string function;
+        std::string format;
+    };
+
+    static bool FormatMessage(RecordReader& reader, const std::string& format,
+                              std::string& message) {
+        fmt::dynamic_format_arg_store<fmt::format_context> store;
+        const auto num_args = reader.Read<u8>();
+        for (u8 i = 0; i < num_args && reader.IsGood(); ++i) {
+            switch (reader.Read<ArgType>()) {
+            case ArgType::Int:
+                store.push_back(reader.Read<s64>());
+                break;
+            case ArgType::UInt:
+                store.push_back(reader.Read<u64>());
+                break;
+            case ArgType::Bool:
+                store.push_back(reader.Read<u8>() != 0);
+                break;
+            case ArgType::Char:
+                store.push_back(reader.Read<char>());
+                break;
+            case ArgType::Double:
+                store.push_back(reader.Read<double>());
+                break;
+            case ArgType::String:
+                store.push_back(std::string(reader.ReadString()));
+                break;
+            case ArgType::Pointer:
+                store.push_back(reinterpret_cast<const void*>(
+                    static_cast<std::uintptr_t>(reader.Read<u64>())));
+                break;
+            default:
+                return false;
+            }
+        }
+        try {
+            message = fmt::vformat(format, store);
+        } catch (const fmt::format_error& error) {
+            message = fmt::format("Invalid log message \"{}\": {}", format, error.what());
+        }
+        return true;
+    }
+
+    std::vector<Site> sites;
+    u64 num_dropped = 0;
+};
+
+/// Ring buffer that one logging thread writes records to, and the writer thread reads them from
+struct ThreadBuffer {
+    std::vector<u8> data = std::vector<u8>(ThreadBufferSize);
+    std::atomic<std::size_t> write_pos{0}; ///< Total number of bytes written, only grows
+    std::atomic<std::size_t> read_pos{0};  ///< Total number of bytes read, only grows
+    std::atomic<u64> dropped{0};
+    std::atomic_bool exited{false};
+    u32 generation = 0;
+
+    /// Writes a record with its size in front, or fails if the buffer doesn't have space for it
+    bool Push(const std::vector<u8>& record) {
+        const auto size = static_cast<u32>(record.size());
+        const std::size_t write = write_pos.load(std::memory_order_relaxed);
+        const std::size_t read = read_pos.load(std::memory_order_acquire);
+        if (ThreadBufferSize - (write - read) < sizeof(size) + size) {
+            return false;
+        }
+        Copy(write, reinterpret_cast<const u8*>(&size), sizeof(size));
+        Copy(write + sizeof(size), record.data(), size);
+        write_pos.store(write + sizeof(size) + size, std::memory_order_release);
+        return true;
+    }
+
+    /// Returns whether more than half of the buffer is used
+    bool IsHalfFull() const {
+        return write_pos.load(std::memory_order_relaxed) -
+                   read_pos.load(std::memory_order_relaxed) >
+               ThreadBufferSize / 2;
+    }
+
+    /// Reads the records written before the given position, without their sizes
+    template <typename Func>
+    void Read(std::size_t end, Func&& func) {
+        std::size_t read = read_pos.load(std::memory_order_relaxed);
+        std::vector<u8> record;
+        while (read < end) {
+            u32 size;
+            CopyOut(read, reinterpret_cast<u8*>(&size), sizeof(size));
+            record.resize(size);
+            CopyOut(read + sizeof(size), record.data(), size);
+            read += sizeof(size) + size;
+            func(record);
+        }
+        read_pos.store(read, std::memory_order_release);
+    }
+
+private:
+    void Copy(std::size_t pos, const u8* src, std::size_t size) {
+        const std::size_t offset = pos % ThreadBufferSize;
+        const std::size_t first = std::min(size, ThreadBufferSize - offset);
+        std::memcpy(data.data() + offset, src, first);
+        std::memcpy(data.data(), src + first, size - first);
+    }
+
+    void CopyOut(std::size_t pos, u8* dest, std::size_t size) const {
+        const std::size_t offset = pos % ThreadBufferSize;
+        const std::size_t first = std::min(size, ThreadBufferSize - offset);
+        std::memcpy(dest, data.data() + offset, first);
+        std::memcpy(dest + first, data.data(), size - first);
+    }
+};
+
+struct SiteKey {
+    const char* format;
+    const char* filename;
+    const char* function;
+    unsigned int line_num;
+    Class log_class;
+    Level log_level;
+
+    bool operator==(const SiteKey& other) const {
+        return format == other.format && filename == other.filename &&
+               function == other.function && line_num == other.line_num &&
+               log_class == other.log_class && log_level == other.log_level;
+    }
+};
+
+struct SiteKeyHash {
+    std::size_t operator()(const SiteKey& key) const {
+        const std::hash<const void*> hash;
+        return hash(key.format) ^ (hash(key.filename) << 1) ^ (hash(key.function) << 2) ^
+               (static_cast<std::size_t>(key.line_num) << 16) ^
+               (static_cast<std::size_t>(key.log_class) << 8) ^
+               static_cast<std::size_t>(key.log_level);
+    }
+};
+
+using SiteMap = std::unordered_map<SiteKey, u32, SiteKeyHash>;
+
+class Writer {
+public:
+    static Writer& Instance() {
+        static Writer writer;
+        return writer;
+    }
+
+    ~Writer() {
+        Stop();
+    }
+
+    bool Start(const std::string& path, ForwardCallback forward_callback) {
+        std::lock_guard lock{control_mutex};
+        if (active) {
+            return false;
+        }
+        file = FileUtil::IOFile(path, "wb");
+        if (!file.IsOpen()) {
+            return false;
+        }
+        std::vector<u8> header;
+        Write(header, FileMagic);
+        Write(header, FileVersion);
+        file.WriteBytes(header.data(), header.size());
+
+        forward = std::move(forward_callback);
+        decoder = Decoder();
+        {
+            std::lock_guard sites_lock{sites_mutex};
+            sites.clear();
+            pending_sites.clear();
+            too_many_args_sites.clear();
+        }
+        ++generation;
+        running = true;
+        active = true;
+        thread = std::thread(&Writer::ThreadLoop, this);
+        return true;
+    }
+
+    void Stop() {
+        std::lock_guard lock{control_mutex};
+        if (!active) {
+            return;
+        }
+        active = false;
+        running = false;
+        drain_event.Set();
+        thread.join();
+
+        std::lock_guard buffers_lock{buffers_mutex};
+        buffers.clear();
+        file.Close();
+        forward = nullptr;
+    }
+
+    bool IsActive() const {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    bool Push(Class log_class, Level log_level, const char* filename, unsigned int line_num,
+              const char* function, const char* format, const fmt::format_args& args) {
+        if (!IsActive()) {
+            return false;
+        }
+        const auto timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - time_origin);
+        ThreadBuffer& buffer = GetThreadBuffer();
+        const u32 site = GetSiteId({format, filename, function, line_num, log_class, log_level});
+
+        thread_local std::vector<u8> record = [] {
+            std::vector<u8> vector;
+            vector.reserve(4096);
+            return vector;
+        }();
+        record.clear();
+        Write(record, RecordType::Message);
+        Write(record, site);
+        Write(record, static_cast<u64>(timestamp.count()));
+        Write(record, u8{0});
+
+        const auto WriteFormatted = [&] {
+            record.clear();
+            Write(record, RecordType::FormattedMessage);
+            Write(record, site);
+            Write(record, static_cast<u64>(timestamp.count()));
+            WriteString(record, fmt::vformat(format, args));
+        };
+
+        if (args.get(MaxArgs)) {
+            // The record can't hold the arguments, so the message is formatted here instead
+            WarnTooManyArgs(site, filename, line_num);
+            WriteFormatted();
+        } else {
+            u8 num_args = 0;
+            for (int i = 0; i < MaxArgs; ++i) {
+                const auto arg = args.get(i);
+                if (!arg) {
+                    break;
+                }
+                if (!fmt::visit_format_arg(ArgEncoder{record}, arg)) {
+                    // Arguments with custom formatters can only be formatted here
+                    WriteFormatted();
+                    break;
+                }
+                record[1 + sizeof(u32) + sizeof(u64)] = ++num_args;
+            }
+        }
+
+        if (!buffer.Push(record)) {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            drain_event.Set();
+        } else if (buffer.IsHalfFull()) {
+            drain_event.Set();
+        }
+        return true;
+    }
+
+private:
+    /// Owns the buffer of a thread, and tells the writer once the thread exited
+    struct ThreadBufferHolder {
+        ~ThreadBufferHolder() {
+            if (buffer) {
+                buffer->exited.store(true, std::memory_order_release);
+            }
+        }
+        std::shared_ptr<ThreadBuffer> buffer;
+    };
+
+    Writer() = default;
+
+    /// Warns once per call site about messages with more than MaxArgs arguments
+    void WarnTooManyArgs(u32 site, const char* filename, unsigned int line_num) {
+        {
+            std::lock_guard lock{sites_mutex};
+            if (!too_many_args_sites.insert(site).second) {
+                return;
+            }
+        }
+        LOG_WARNING(Log, "Message at {}:{} has more than {} arguments, formatting it when logged",
+                    filename, line_num, MaxArgs);
+    }
+
+    ThreadBuffer& GetThreadBuffer() {
+        thread_local ThreadBufferHolder holder;
+        const u32 current_generation = generation.load(std::memory_order_relaxed);
+        if (!holder.buffer || holder.buffer->generation != current_generation) {
+            holder.buffer = std::make_shared<ThreadBuffer>();
+            holder.buffer->generation = current_generation;
+            std::lock_guard lock{buffers_mutex};
+            buffers.push_back(holder.buffer);
+        }
+        return *holder.buffer;
+    }
+
+    u32 GetSiteId(const SiteKey& key) {
+        thread_local SiteMap cache;
+        thread_local u32 cache_generation = 0;
+        const u32 current_generation = generation.load(std::memory_order_relaxed);
+        if (cache_generation != current_generation) {
+            cache.clear();
+            cache_generation = current_generation;
+        }
+        if (const auto it = cache.find(key); it != cache.end()) {
+            return it->second;
+        }
+
+        std::lock_guard lock{sites_mutex};
+        auto [it, inserted] = sites.try_emplace(key, static_cast<u32>(sites.size()));
+        if (inserted) {
+            Write(pending_sites, RecordType::Site);
+            Write(pending_sites, it->second);
+            Write(pending_sites, key.log_class);
+            Write(pending_sites, key.log_level);
+            Write(pending_sites, static_cast<u32>(key.line_num));
+            WriteString(pending_sites, key.filename);
+            WriteString(pending_sites, key.function);
+            WriteString(pending_sites, key.format);
+        }
+        cache.emplace(key, it->second);
+        return it->second;
+    }
+
+    void ThreadLoop() {
+        Common::SetCurrentThreadName("BinaryLogWriter");
+        while (running) {
+            drain_event.WaitUntil(std::chrono::steady_clock::now() + FlushInterval);
+            Drain();
+        }
+        Drain();
+    }
+
+    void Drain() {
+        std::vector<std::shared_ptr<ThreadBuffer>> drained;
+        {
+            std::lock_guard lock{buffers_mutex};
+            drained = buffers;
+        }
+        // Whether a thread exited has to be read before the end of its buffer, and the end before
+        // the sites, so that all the sites of the read messages are written before them
+        std::vector<std::pair<bool, std::size_t>> ends;
+        for (const auto& buffer : drained) {
+            const bool exited = buffer->exited.load(std::memory_order_acquire);
+            ends.emplace_back(exited, buffer->write_pos.load(std::memory_order_acquire));
+        }
+        std::vector<u8> out;
+        {
+            std::lock_guard lock{sites_mutex};
+            out.swap(pending_sites);
+        }
+
+        std::vector<Entry> entries;
+        const auto add_record = [this, &entries](const u8* data, std::size_t size) {
+            Entry entry;
+            bool has_entry;
+            if (forward && decoder.Decode(data, size, entry, has_entry) && has_entry) {
+                entries.push_back(std::move(entry));
+            }
+        };
+        for (std::size_t offset = 0; forward && offset < out.size();) {
+            Entry entry;
+            bool has_entry;
+            const std::size_t size =
+                decoder.Decode(out.data() + offset, out.size() - offset, entry, has_entry);
+            if (size == 0) {
+                break;
+            }
+            offset += size;
+        }
+        for (std::size_t i = 0; i < drained.size(); ++i) {
+            ThreadBuffer& buffer = *drained[i];
+            buffer.Read(ends[i].second, [&out, &add_record](const std::vector<u8>& record) {
+                out.insert(out.end(), record.begin(), record.end());
+                add_record(record.data(), record.size());
+            });
+            if (const u64 dropped = buffer.dropped.exchange(0); dropped != 0) {
+                const std::size_t offset = out.size();
+                Write(out, RecordType::Dropped);
+                Write(out, dropped);
+                Write(out, static_cast<u64>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                std::chrono::steady_clock::now() - time_origin)
+                                                .count()));
+                add_record(out.data() + offset, out.size() - offset);
+            }
+        }
+
+        if (!out.empty()) {
+            file.WriteBytes(out.data(), out.size());
+            file.Flush();
+        }
+        // Messages of different threads are drained one thread after another
+        std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.timestamp < b.timestamp;
+        });
+        for (auto& entry : entries) {
+            forward(std::move(entry));
+        }
+
+        std::lock_guard lock{buffers_mutex};
+        for (std::size_t i = 0; i < drained.size(); ++i) {
+            if (ends[i].first) {
+                buffers.erase(std::find(buffers.begin(), buffers.end(), drained[i]));
+            }
+        }
+    }
+
+    std::mutex control_mutex;
+    std::atomic_bool active{false};
+    std::atomic<u32> generation{0};
+
+    std::mutex buffers_mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+    std::mutex sites_mutex;
+    SiteMap sites;
+    std::vector<u8> pending_sites; ///< Records of the sites that weren't written yet
+    std::unordered_set<u32> too_many_args_sites; ///< Sites that WarnTooManyArgs warned about
+
+    // Only used by the writer thread while it runs
+    std::atomic_bool running{false};
+    Common::Event drain_event;
+    std::thread thread;
+    FileUtil::IOFile file;
+    ForwardCallback forward;
+    Decoder decoder;
+};
+
+} // Anonymous namespace
+
+bool Start(const std::string& path, ForwardCallback forward) {
+    return Writer::Instance().Start(path, std::move(forward));
+}
+
+void Stop() {
+    Writer::Instance().Stop();
+}
+
+bool IsActive() {
+    return Writer::Instance().IsActive();
+}
+
+bool PushMessage(Class log_class, Level log_level, const char* filename, unsigned int line_num,
+                 const char* function, const char* format, const fmt::format_args& args) {
+    return Writer::Instance().Push(log_class, log_level, filename, line_num, function, format,
+                                   args);
+}
+
+struct Reader::Impl {
+    std::vector<u8> data;
+    std::size_t offset = 0;
+    Decoder decoder;
+};
+
+Reader::Reader() : impl(std::make_unique<Impl>()) {}
+
+Reader::~Reader() = default;
+
+bool Reader::Open(const std::string& path) {
+    FileUtil::IOFile file(path, "rb");
+    if (!file.IsOpen()) {
+        return false;
+    }
+    impl = std::make_unique<Impl>();
+    impl->data.resize(file.GetSize());
+    if (file.ReadBytes(impl->data.data(), impl->data.size()) != impl->data.size()) {
+        return false;
+    }
+
+    RecordReader reader(impl->data.data(), impl->data.size());
+    const auto magic = reader.Read<u32>();
+    const auto version = reader.Read<u32>();
+    if (!reader.IsGood() || magic != FileMagic || version != FileVersion) {
+        return false;
+    }
+    impl->offset = reader.Offset(impl->data.data());
+    return true;
+}
+
+bool Reader::ReadEntry(Entry& entry) {
+    while (impl->offset < impl->data.size()) {
+        bool has_entry;
+        const std::size_t size =
+            impl->decoder.Decode(impl->data.data() + impl->offset,
+                                 impl->data.size() - impl->offset, entry, has_entry);
+        if (size == 0) {
+            impl->offset = impl->data.size();
+            return false;
+        }
+        impl->offset += size;
+        if (has_entry) {
+            return true;
+        }
+    }
+    return false;
+}
+
+u64 Reader::NumDroppedMessages() const {
+    return impl->decoder.NumDropped();
+}
+
+} // namespace Log::BinaryLog
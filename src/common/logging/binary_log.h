@@ -0,0 +1,87 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <fmt/format.h>
+#include "common/common_types.h"
+#include "common/logging/log.h"
+
+namespace Log {
+
+struct Entry;
+
+/**
+ * Binary logging mode, in which a log call stores the id of its call site and its raw arguments in
+ * a ring buffer of the calling thread instead of formatting the message. A writer thread drains the
+ * buffers into a binary log file, and optionally formats the messages for the logging backends.
+ *
+ * Arguments of types that fmt formats with a custom formatter can't be stored raw, so messages with
+ * them are still formatted on the calling thread. When the ring buffer of a thread is full, its
+ * messages are dropped and their number is logged instead.
+ */
+namespace BinaryLog {
+
+/// Size of the ring buffer of each thread that logs
+constexpr std::size_t ThreadBufferSize = 256 * 1024;
+
+/// Called on the writer thread with every message read from the buffers
+using ForwardCallback = std::function<void(Entry)>;
+
+/**
+ * Starts the binary logging mode.
+ * @param path Path of the binary log file, which is replaced if it exists
+ * @param forward Callback for the formatted messages, or none to only write the binary log file
+ * @return False if the file can't be opened, or if binary logging is already active
+ */
+bool Start(const std::string& path, ForwardCallback forward = nullptr);
+
+/**
+ * Stops the binary logging mode, after writing out the buffered messages. Messages logged by other
+ * threads while it's stopping may be lost.
+ */
+void Stop();
+
+/// Returns whether the binary logging mode is active
+bool IsActive();
+
+/**
+ * Stores a message in the ring buffer of the calling thread, if binary logging is active.
+ * @return False if binary logging is not active, in which case the message must be logged normally
+ */
+bool PushMessage(Class log_class, Level log_level, const char* filename, unsigned int line_num,
+                 const char* function, const char* format, const fmt::format_args& args);
+
+/// Reads and formats the messages of a binary log file
+class Reader {
+public:
+    Reader();
+    ~Reader();
+
+    /**
+     * Reads a binary log file into memory.
+     * @return False if the file can't be read or is not a binary log file
+     */
+    bool Open(const std::string& path);
+
+    /**
+     * Reads and formats the next message of the file.
+     * @return False at the end of the file, or if the rest of the file is malformed
+     */
+    bool ReadEntry(Entry& entry);
+
+    /// Returns the number of messages that were dropped by the logging threads so far
+    u64 NumDroppedMessages() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+} // namespace BinaryLog
+} // namespace Log
@@ -0,0 +1,249 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <mutex>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/microprofile_trace.h"
+
+namespace Common::ProfileTrace {
+
+#if MICROPROFILE_ENABLED
+
+namespace {
+
+/// A scope that was entered and left on a thread
+struct Scope {
+    u16 timer_index;
+    u8 thread_index;
+    s64 begin_tick;
+    s64 end_tick;
+};
+
+/// The recording state of one of the MicroProfile thread logs
+struct ThreadState {
+    const MicroProfileThreadLog* log = nullptr; ///< The log the state belongs to
+    u32 get = 0;                                ///< Position of the next entry to read
+    std::vector<std::pair<u16, s64>> stack;     ///< Timer index and tick of the open scopes
+    std::string name;
+};
+
+struct Recorder {
+    std::mutex mutex;
+    bool recording = false;
+
+    // Settings of the profiler UI to restore once recording stops
+    bool force_enable = false;
+    bool enable_all_groups = false;
+
+    std::vector<Scope> scopes;
+    std::size_t max_scopes = 0;
+    std::size_t next_scope = 0; ///< Where the next scope is stored once the buffer is full
+
+    std::array<ThreadState, MICROPROFILE_MAX_THREADS> threads;
+};
+
+Recorder recorder;
+
+void AddScope(const Scope& scope) {
+    if (recorder.scopes.size() < recorder.max_scopes) {
+        recorder.scopes.push_back(scope);
+        return;
+    }
+    recorder.scopes[recorder.next_scope] = scope;
+    recorder.next_scope = (recorder.next_scope + 1) % recorder.max_scopes;
+}
+
+/// Escapes the characters that are not allowed in a JSON string
+std::string EscapeJson(const char* str) {
+    std::string escaped;
+    for (; *str != '\0'; ++str) {
+        if (*str == '"' || *str == '\\') {
+            escaped += '\\';
+        }
+        if (static_cast<unsigned char>(*str) >= 0x20) {
+            escaped += *str;
+        }
+    }
+    return escaped;
+}
+
+} // Anonymous namespace
+
+void StartRecording(std::size_t max_scopes) {
+    std::lock_guard mp_lock{MicroProfileGetMutex()};
+    std::lock_guard lock{recorder.mutex};
+    if (!recorder.recording) {
+        recorder.force_enable = MicroProfileGetForceEnable();
+        recorder.enable_all_groups = MicroProfileGetEnableAllGroups();
+    }
+    // Groups are only logged while MicroProfile is enabled, which it normally is only while the
+    // profiler UI is shown
+    MicroProfileSetForceEnable(true);
+    MicroProfileSetEnableAllGroups(true);
+
+    recorder.recording = true;
+    recorder.scopes.clear();
+    recorder.scopes.shrink_to_fit();
+    recorder.max_scopes = max_scopes;
+    recorder.next_scope = 0;
+    recorder.threads = {};
+}
+
+void StopRecording() {
+    std::lock_guard mp_lock{MicroProfileGetMutex()};
+    std::lock_guard lock{recorder.mutex};
+    if (!recorder.recording) {
+        return;
+    }
+    recorder.recording = false;
+    MicroProfileSetForceEnable(recorder.force_enable);
+    MicroProfileSetEnableAllGroups(recorder.enable_all_groups);
+}
+
+bool IsRecording() {
+    std::lock_guard lock{recorder.mutex};
+    return recorder.recording;
+}
+
+void Collect() {
+    // MicroProfileFlip holds the same mutex while it moves the read positions of the logs
+    std::lock_guard mp_lock{MicroProfileGetMutex()};
+    std::lock_guard lock{recorder.mutex};
+    if (!recorder.recording) {
+        return;
+    }
+
+    const MicroProfile* profile = MicroProfileGet();
+    // Ticks are logged truncated, and are extended relative to the current one
+    const s64 now = MP_TICK();
+    const MicroProfileLogEntry now_entry = static_cast<MicroProfileLogEntry>(now);
+    for (u32 i = 0; i < MICROPROFILE_MAX_THREADS; ++i) {
+        const MicroProfileThreadLog* log = profile->Pool[i];
+        ThreadState& thread = recorder.threads[i];
+        if (log == nullptr || !log->nActive || log->nGpu) {
+            // Keep the name of exited threads for their recorded scopes
+            thread.log = nullptr;
+            thread.stack.clear();
+            continue;
+        }
+        if (thread.log != log || thread.name != log->ThreadName) {
+            // The log was reused by another thread
+            thread = {};
+            thread.log = log;
+            thread.get = log->nGet.load(std::memory_order_relaxed);
+            thread.name = log->ThreadName;
+        }
+
+        const u32 put = log->nPut.load(std::memory_order_acquire);
+        for (; thread.get != put; thread.get = (thread.get + 1) % MICROPROFILE_BUFFER_SIZE) {
+            const MicroProfileLogEntry entry = log->Log[thread.get];
+            const u16 timer_index = static_cast<u16>(MicroProfileLogTimerIndex(entry));
+            const s64 tick = now + MicroProfileLogTickDifference(now_entry, entry);
+            switch (MicroProfileLogType(entry)) {
+            case MP_LOG_ENTER:
+                thread.stack.emplace_back(timer_index, tick);
+                break;
+            case MP_LOG_LEAVE:
+                // Scopes are nested, unless the enter was logged before recording started
+                while (!thread.stack.empty()) {
+                    const auto [open_index, begin_tick] = thread.stack.back();
+                    thread.stack.pop_back();
+                    if (open_index == timer_index) {
+                        AddScope({timer_index, static_cast<u8>(i), begin_tick, tick});
+                        break;
+                    }
+                }
+                break;
+            default:
+                // Meta counters and GPU timestamps are not recorded
+                break;
+            }
+        }
+    }
+}
+
+bool Dump(const std::string& path) {
+    Collect();
+
+    std::lock_guard mp_lock{MicroProfileGetMutex()};
+    std::lock_guard lock{recorder.mutex};
+    FileUtil::IOFile file(path, "wb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Common, "Failed to open profile trace file {}", path);
+        return false;
+    }
+
+    const MicroProfile* profile = MicroProfileGet();
+    const double us_per_tick = 1000000.0 / MicroProfileTicksPerSecondCpu();
+    s64 first_tick = 0;
+    for (std::size_t i = 0; i < recorder.scopes.size(); ++i) {
+        if (i == 0 || recorder.scopes[i].begin_tick < first_tick) {
+            first_tick = recorder.scopes[i].begin_tick;
+        }
+    }
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    const auto append = [&json, &first](const std::string& event) {
+        json += first ? "" : ",\n";
+        json += event;
+        first = false;
+    };
+    for (u32 i = 0; i < MICROPROFILE_MAX_THREADS; ++i) {
+        const ThreadState& thread = recorder.threads[i];
+        if (!thread.name.empty()) {
+            append(fmt::format(
+                "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":"
+                "\"{}\"}}}}",
+                i, EscapeJson(thread.name.c_str())));
+        }
+    }
+    // Oldest first, also when the buffer wrapped around
+    for (std::size_t n = 0; n < recorder.scopes.size(); ++n) {
+        const Scope& scope = recorder.scopes[(recorder.next_scope + n) % recorder.scopes.size()];
+        const MicroProfileTimerInfo& timer = profile->TimerInfo[scope.timer_index];
+        const MicroProfileGroupInfo& group = profile->GroupInfo[timer.nGroupIndex];
+        append(fmt::format("{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},"
+                           "\"dur\":{:.3f},\"pid\":1,\"tid\":{}}}",
+                           EscapeJson(timer.pName), EscapeJson(group.pName),
+                           (scope.begin_tick - first_tick) * us_per_tick,
+                           (scope.end_tick - scope.begin_tick) * us_per_tick, scope.thread_index));
+    }
+    json += "\n]}\n";
+
+    if (file.WriteString(json) != json.size()) {
+        LOG_ERROR(Common, "Failed to write profile trace file {}", path);
+        return false;
+    }
+    LOG_INFO(Common, "Wrote {} profile scopes to {}", recorder.scopes.size(), path);
+    return true;
+}
+
+#else
+
+void StartRecording(std::size_t max_scopes) {
+    LOG_WARNING(Common, "MicroProfile is disabled in this build, no scopes are recorded");
+}
+
+void StopRecording() {}
+
+bool IsRecording() {
+    return false;
+}
+
+void Collect() {}
+
+bool Dump(const std::string& path) {
+    return false;
+}
+
+#endif
+
+} // namespace Common::ProfileTrace
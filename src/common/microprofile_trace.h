@@ -0,0 +1,41 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Records the MicroProfile scopes entered on all threads without the profiler UI, and writes them
+ * in the Chrome trace event format, which chrome://tracing and Perfetto show as flame charts.
+ *
+ * The scopes are moved out of the per-thread logs of MicroProfile by Collect, which must run before
+ * every MicroProfileFlip, as that allows MicroProfile to reuse the logs. Only the most recent
+ * scopes are kept once the buffer is full.
+ */
+namespace Common::ProfileTrace {
+
+/**
+ * Enables all MicroProfile groups and starts recording, discarding anything recorded before.
+ * @param max_scopes Number of scopes to keep
+ */
+void StartRecording(std::size_t max_scopes = 1 << 20);
+
+/// Stops recording, keeping the recorded scopes until the next StartRecording
+void StopRecording();
+
+/// Returns whether scopes are being recorded
+bool IsRecording();
+
+/// Moves the scopes logged since the last call into the buffer. Call before MicroProfileFlip.
+void Collect();
+
+/**
+ * Writes the recorded scopes to a file in the Chrome trace event format.
+ * @return False if the file could not be written
+ */
+bool Dump(const std::string& path);
+
+} // namespace Common::ProfileTrace
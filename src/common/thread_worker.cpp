@@ -0,0 +1,72 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/thread.h"
+#include "common/thread_worker.h"
+
+namespace Common {
+
+ThreadWorker::ThreadWorker(std::size_t num_workers, std::string name_) : name(std::move(name_)) {
+    num_workers = std::max<std::size_t>(num_workers, 1);
+    threads.reserve(num_workers);
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        threads.emplace_back([this] { Run(); });
+    }
+}
+
+ThreadWorker::~ThreadWorker() {
+    {
+        std::lock_guard lock{queue_mutex};
+        stop = true;
+    }
+    request_condition.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadWorker::QueueWork(Task task) {
+    {
+        std::lock_guard lock{queue_mutex};
+        if (stop) {
+            return;
+        }
+        requests.emplace(std::move(task));
+        ++pending;
+    }
+    request_condition.notify_one();
+}
+
+void ThreadWorker::WaitForRequests() {
+    std::unique_lock lock{queue_mutex};
+    done_condition.wait(lock, [this] { return pending == 0; });
+}
+
+void ThreadWorker::Run() {
+    SetCurrentThreadName(name.c_str());
+    while (true) {
+        Task task;
+        {
+            std::unique_lock lock{queue_mutex};
+            request_condition.wait(lock, [this] { return stop || !requests.empty(); });
+            if (requests.empty()) {
+                // Only reached when stopping with no work left
+                return;
+            }
+            task = std::move(requests.front());
+            requests.pop();
+        }
+
+        task();
+
+        {
+            std::lock_guard lock{queue_mutex};
+            --pending;
+        }
+        done_condition.notify_all();
+    }
+}
+
+} // namespace Common
@@ -0,0 +1,60 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Common {
+
+/**
+ * A fixed-size pool of host threads which execute queued tasks in FIFO order. Tasks queued after
+ * the worker has started shutting down are discarded; tasks already queued are still executed.
+ */
+class ThreadWorker final {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @param num_workers Number of host threads to spawn. At least one thread is always spawned.
+     * @param name Name given to the host threads, used for debugging purposes.
+     */
+    explicit ThreadWorker(std::size_t num_workers, std::string name);
+    ~ThreadWorker();
+
+    ThreadWorker(const ThreadWorker&) = delete;
+    ThreadWorker& operator=(const ThreadWorker&) = delete;
+
+    /// Queues a task to be executed by one of the worker threads.
+    void QueueWork(Task task);
+
+    /// Blocks until every task queued so far has finished executing.
+    void WaitForRequests();
+
+    /// Returns the number of host threads in this pool.
+    std::size_t NumWorkers() const {
+        return threads.size();
+    }
+
+private:
+    void Run();
+
+    std::string name;
+    std::vector<std::thread> threads;
+    std::queue<Task> requests;
+    std::mutex queue_mutex;
+    std::condition_variable request_condition;
+    std::condition_variable done_condition;
+    std::size_t pending = 0; ///< Number of queued or executing tasks
+    bool stop = false;
+};
+
+} // namespace Common
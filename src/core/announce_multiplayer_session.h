@@ -29,6 +29,13 @@ class AnnounceMultiplayerSession : NonCopyable {
 public:
     using CallbackHandle = std::shared_ptr<std::function<void(const Common::WebResult&)>>;
     AnnounceMultiplayerSession();
+
+    /**
+     * Creates a session announcing the given room instead of the room of the network module
+     * @param room The room to announce, which can be one of several rooms hosted by the process
+     */
+    explicit AnnounceMultiplayerSession(std::weak_ptr<Network::Room> room);
+
     ~AnnounceMultiplayerSession();
 
     /**
@@ -89,6 +96,11 @@ private:
 
     std::atomic_bool registered = false; ///< Whether the room has been registered
 
+    bool use_network_room = true;      ///< Whether to announce the room of the network module
+    std::weak_ptr<Network::Room> room; ///< The announced room otherwise
+
+    std::shared_ptr<Network::Room> GetRoom() const;
+
     void UpdateBackendData(std::shared_ptr<Network::Room> room);
     void AnnounceMultiplayerLoop();
 };
@@ -2,18 +2,26 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstring>
 #include <dynarmic/A32/a32.h>
 #include <dynarmic/A32/context.h>
+#include <dynarmic/exclusive_monitor.h>
 #include "common/assert.h"
+#include "common/atomic_ops.h"
 #include "common/microprofile.h"
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #include "core/arm/dynarmic/arm_dynarmic_cp15.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/cpu_threads.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/kernel/svc.h"
 #include "core/memory.h"
+#include "core/settings.h"
+
+/// Ticks an idle loop gets at the start of a slice to notice changes before it is skipped
+constexpr s64 IDLE_LOOP_PROBE_TICKS = 256;
 
 class DynarmicThreadContext final : public ARM_Interface::ThreadContext {
 public:
@@ -74,30 +82,56 @@ public:
         : parent(parent), svc_context(parent.system), memory(parent.memory) {}
     ~DynarmicUserCallbacks() = default;
 
+    // The JIT accesses regular memory directly, so these are only called for memory that needs
+    // special handling, like MMIO and memory cached by the rasterizer, and for the LDREX of cores
+    // that share an exclusive monitor
     std::uint8_t MemoryRead8(VAddr vaddr) override {
-        return memory.Read8(vaddr);
+        return Read(vaddr, &Memory::MemorySystem::Read8);
     }
     std::uint16_t MemoryRead16(VAddr vaddr) override {
-        return memory.Read16(vaddr);
+        return Read(vaddr, &Memory::MemorySystem::Read16);
     }
     std::uint32_t MemoryRead32(VAddr vaddr) override {
-        return memory.Read32(vaddr);
+        return Read(vaddr, &Memory::MemorySystem::Read32);
     }
     std::uint64_t MemoryRead64(VAddr vaddr) override {
-        return memory.Read64(vaddr);
+        return Read(vaddr, &Memory::MemorySystem::Read64);
     }
 
     void MemoryWrite8(VAddr vaddr, std::uint8_t value) override {
-        memory.Write8(vaddr, value);
+        RunSerialized([&] { memory.Write8(vaddr, value); });
     }
     void MemoryWrite16(VAddr vaddr, std::uint16_t value) override {
-        memory.Write16(vaddr, value);
+        RunSerialized([&] { memory.Write16(vaddr, value); });
     }
     void MemoryWrite32(VAddr vaddr, std::uint32_t value) override {
-        memory.Write32(vaddr, value);
+        RunSerialized([&] { memory.Write32(vaddr, value); });
     }
     void MemoryWrite64(VAddr vaddr, std::uint64_t value) override {
-        memory.Write64(vaddr, value);
+        RunSerialized([&] { memory.Write64(vaddr, value); });
+    }
+
+    // With an exclusive monitor shared by the cores, every STREX goes through these. They only
+    // write if the memory still holds what the LDREX read, which catches plain stores of other
+    // cores that the monitor doesn't see.
+    bool MemoryWriteExclusive8(VAddr vaddr, std::uint8_t value, std::uint8_t expected) override {
+        return WriteExclusive(vaddr, value, expected, &Memory::MemorySystem::Read8,
+                              &Memory::MemorySystem::Write8);
+    }
+    bool MemoryWriteExclusive16(VAddr vaddr, std::uint16_t value,
+                                std::uint16_t expected) override {
+        return WriteExclusive(vaddr, value, expected, &Memory::MemorySystem::Read16,
+                              &Memory::MemorySystem::Write16);
+    }
+    bool MemoryWriteExclusive32(VAddr vaddr, std::uint32_t value,
+                                std::uint32_t expected) override {
+        return WriteExclusive(vaddr, value, expected, &Memory::MemorySystem::Read32,
+                              &Memory::MemorySystem::Write32);
+    }
+    bool MemoryWriteExclusive64(VAddr vaddr, std::uint64_t value,
+                                std::uint64_t expected) override {
+        return WriteExclusive(vaddr, value, expected, &Memory::MemorySystem::Read64,
+                              &Memory::MemorySystem::Write64);
     }
 
     void InterpreterFallback(VAddr pc, std::size_t num_instructions) override {
@@ -107,7 +141,7 @@ public:
     }
 
     void CallSVC(std::uint32_t swi) override {
-        svc_context.CallSVC(swi);
+        RunSerialized([&] { svc_context.CallSVC(swi); });
     }
 
     void ExceptionRaised(VAddr pc, Dynarmic::A32::Exception exception) override {
@@ -141,18 +175,70 @@ public:
     }
     std::uint64_t GetTicksRemaining() override {
         s64 ticks = parent.GetTimer().GetDowncount();
+        if (parent.probing_idle_loop) {
+            ticks = std::min(ticks, IDLE_LOOP_PROBE_TICKS);
+        }
         return static_cast<u64>(ticks <= 0 ? 0 : ticks);
     }
 
+    /// Reads regular memory directly, like the JIT does, and forwards everything else to the
+    /// emulation thread
+    template <typename T>
+    T Read(VAddr vaddr, T (Memory::MemorySystem::*read)(VAddr)) {
+        const u8* const page =
+            parent.current_page_table->GetPointerArray()[vaddr >> Memory::PAGE_BITS];
+        T value;
+        if (page) {
+            std::memcpy(&value, page + (vaddr & Memory::PAGE_MASK), sizeof(T));
+        } else {
+            RunSerialized([&] { value = (memory.*read)(vaddr); });
+        }
+        return value;
+    }
+
+    /// Writes regular memory atomically, as the other cores access it directly, and forwards
+    /// everything else to the emulation thread
+    template <typename T>
+    bool WriteExclusive(VAddr vaddr, T value, T expected,
+                        T (Memory::MemorySystem::*read)(VAddr),
+                        void (Memory::MemorySystem::*write)(VAddr, T)) {
+        u8* const page = parent.current_page_table->GetPointerArray()[vaddr >> Memory::PAGE_BITS];
+        if (page) {
+            return Common::AtomicCompareAndSwap(
+                reinterpret_cast<volatile T*>(page + (vaddr & Memory::PAGE_MASK)), value, expected);
+        }
+
+        bool written = false;
+        RunSerialized([&] {
+            if ((memory.*read)(vaddr) == expected) {
+                (memory.*write)(vaddr, value);
+                written = true;
+            }
+        });
+        return written;
+    }
+
+    /// Forwards work that has to happen on the emulation thread when the core runs on its own
+    template <typename Func>
+    void RunSerialized(Func&& func) {
+        if (Core::CPUThreads::IsCPUThread()) {
+            parent.system.GetCPUThreads()->RunSerialized(parent, func);
+        } else {
+            func();
+        }
+    }
+
     ARM_Dynarmic& parent;
     Kernel::SVCContext svc_context;
     Memory::MemorySystem& memory;
 };
 
 ARM_Dynarmic::ARM_Dynarmic(Core::System* system, Memory::MemorySystem& memory, u32 id,
-                           std::shared_ptr<Core::Timing::Timer> timer)
+                           std::shared_ptr<Core::Timing::Timer> timer,
+                           std::shared_ptr<Dynarmic::ExclusiveMonitor> exclusive_monitor)
     : ARM_Interface(id, timer), system(*system), memory(memory),
-      cb(std::make_unique<DynarmicUserCallbacks>(*this)) {
+      cb(std::make_unique<DynarmicUserCallbacks>(*this)),
+      exclusive_monitor(std::move(exclusive_monitor)) {
     SetPageTable(memory.GetCurrentPageTable());
 }
 
@@ -164,7 +250,32 @@ void ARM_Dynarmic::Run() {
     ASSERT(memory.GetCurrentPageTable() == current_page_table);
     MICROPROFILE_SCOPE(ARM_Jit);
 
+    if (idle_loop && InIdleLoop()) {
+        probing_idle_loop = true;
+        jit->Run();
+        probing_idle_loop = false;
+        if (InIdleLoop()) {
+            GetTimer().SkipIdleLoop();
+            return;
+        }
+        // The loop was left, so return like after a halt and let the dispatcher run the rest of
+        // the slice. Halts requested during the probe are not lost this way.
+        idle_loop.reset();
+        return;
+    }
+
     jit->Run();
+
+    // Only check for idle loops when the slice ran out, halts happen at arbitrary places
+    idle_loop.reset();
+    if (Settings::values.skip_idle_loops && GetTimer().GetDowncount() <= 0 &&
+        !GDBStub::IsConnected() && (jit->Cpsr() & 0x20) == 0) {
+        idle_loop = Core::FindIdleLoop(*current_page_table, jit->Regs()[15]);
+    }
+}
+
+bool ARM_Dynarmic::InIdleLoop() const {
+    return idle_loop->Contains(jit->Regs()[15]) && (jit->Cpsr() & 0x20) == 0;
 }
 
 void ARM_Dynarmic::Step() {
@@ -282,12 +393,14 @@ void ARM_Dynarmic::PrepareReschedule() {
 }
 
 void ARM_Dynarmic::ClearInstructionCache() {
+    idle_loop.reset();
     for (const auto& j : jits) {
         j.second->ClearCache();
     }
 }
 
 void ARM_Dynarmic::InvalidateCacheRange(u32 start_address, std::size_t length) {
+    idle_loop.reset();
     jit->InvalidateCacheRange(start_address, length);
 }
 
@@ -296,7 +409,13 @@ std::shared_ptr<Memory::PageTable> ARM_Dynarmic::GetPageTable() const {
 }
 
 void ARM_Dynarmic::SetPageTable(const std::shared_ptr<Memory::PageTable>& page_table) {
+    if (jit && current_page_table == page_table) {
+        // The kernel switches to a core while it is inside a callback when the cores run in
+        // parallel, so avoid touching the context of the JIT unless the page table changes
+        return;
+    }
     current_page_table = page_table;
+    idle_loop.reset();
     Dynarmic::A32::Context ctx{};
     if (jit) {
         jit->SaveContext(ctx);
@@ -328,6 +447,10 @@ std::unique_ptr<Dynarmic::A32::Jit> ARM_Dynarmic::MakeJit() {
     config.page_table = &current_page_table->GetPointerArray();
     config.coprocessors[15] = std::make_shared<DynarmicCP15>(cp15_state);
     config.define_unpredictable_behaviour = true;
+    if (exclusive_monitor) {
+        config.processor_id = GetID();
+        config.global_monitor = exclusive_monitor.get();
+    }
     return std::make_unique<Dynarmic::A32::Jit>(config);
 }
 
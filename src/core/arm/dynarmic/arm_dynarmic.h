@@ -6,10 +6,16 @@
 
 #include <map>
 #include <memory>
+#include <optional>
 #include <dynarmic/A32/a32.h>
 #include "common/common_types.h"
 #include "core/arm/arm_interface.h"
 #include "core/arm/dynarmic/arm_dynarmic_cp15.h"
+#include "core/arm/idle_loop.h"
+
+namespace Dynarmic {
+class ExclusiveMonitor;
+}
 
 namespace Memory {
 struct PageTable;
@@ -24,8 +30,13 @@ class DynarmicUserCallbacks;
 
 class ARM_Dynarmic final : public ARM_Interface {
 public:
+    /**
+     * @param exclusive_monitor Monitor shared by all cores that run concurrently, so that their
+     * LDREX and STREX see each other. Each core has its own monitor if null.
+     */
     ARM_Dynarmic(Core::System* system, Memory::MemorySystem& memory, u32 id,
-                 std::shared_ptr<Core::Timing::Timer> timer);
+                 std::shared_ptr<Core::Timing::Timer> timer,
+                 std::shared_ptr<Dynarmic::ExclusiveMonitor> exclusive_monitor = nullptr);
     ~ARM_Dynarmic() override;
 
     void Run() override;
@@ -60,12 +71,14 @@ protected:
 
 private:
     void ServeBreak();
+    bool InIdleLoop() const;
 
     friend class DynarmicUserCallbacks;
     Core::System& system;
     Memory::MemorySystem& memory;
     std::unique_ptr<DynarmicUserCallbacks> cb;
     std::unique_ptr<Dynarmic::A32::Jit> MakeJit();
+    std::shared_ptr<Dynarmic::ExclusiveMonitor> exclusive_monitor;
 
     u32 fpexc = 0;
     CP15State cp15_state;
@@ -73,4 +86,8 @@ private:
     Dynarmic::A32::Jit* jit = nullptr;
     std::shared_ptr<Memory::PageTable> current_page_table = nullptr;
     std::map<std::shared_ptr<Memory::PageTable>, std::unique_ptr<Dynarmic::A32::Jit>> jits;
+
+    /// Idle loop the core was spinning in when its last slice ran out
+    std::optional<Core::IdleLoop> idle_loop;
+    bool probing_idle_loop = false;
 };
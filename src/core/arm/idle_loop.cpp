@@ -0,0 +1,265 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <bitset>
+#include <cstring>
+#include "core/arm/idle_loop.h"
+#include "core/memory.h"
+
+namespace Core {
+
+namespace {
+
+/// Longest loop body, in instructions, that is considered for idle loop detection
+constexpr u32 MaxLoopLength = 16;
+
+constexpr u32 SVC_GetSystemTick = 0x28;
+
+// Registers 0-15 are the general purpose registers, followed by the individual APSR flags
+constexpr std::size_t REG_PC = 15;
+constexpr std::size_t FLAG_N = 16;
+constexpr std::size_t FLAG_Z = 17;
+constexpr std::size_t FLAG_C = 18;
+constexpr std::size_t FLAG_V = 19;
+
+using RegisterSet = std::bitset<20>;
+
+struct Instruction {
+    RegisterSet reads;
+    RegisterSet writes;
+    bool conditional = false;
+    std::optional<VAddr> branch_target;
+};
+
+std::optional<u32> ReadCode(Memory::PageTable& page_table, VAddr addr) {
+    const u8* page = page_table.GetPointerArray()[addr >> Memory::PAGE_BITS];
+    if (page == nullptr) {
+        return std::nullopt;
+    }
+    u32 value;
+    std::memcpy(&value, page + (addr & Memory::PAGE_MASK), sizeof(value));
+    return value;
+}
+
+/// Returns the flags tested by a condition code
+RegisterSet ConditionFlags(u32 cond) {
+    RegisterSet flags;
+    switch (cond) {
+    case 0x0: // EQ
+    case 0x1: // NE
+        flags.set(FLAG_Z);
+        break;
+    case 0x2: // CS
+    case 0x3: // CC
+        flags.set(FLAG_C);
+        break;
+    case 0x4: // MI
+    case 0x5: // PL
+        flags.set(FLAG_N);
+        break;
+    case 0x6: // VS
+    case 0x7: // VC
+        flags.set(FLAG_V);
+        break;
+    case 0x8: // HI
+    case 0x9: // LS
+        flags.set(FLAG_C).set(FLAG_Z);
+        break;
+    case 0xA: // GE
+    case 0xB: // LT
+        flags.set(FLAG_N).set(FLAG_V);
+        break;
+    case 0xC: // GT
+    case 0xD: // LE
+        flags.set(FLAG_N).set(FLAG_Z).set(FLAG_V);
+        break;
+    }
+    return flags;
+}
+
+/**
+ * Decodes an ARM instruction that may appear in an idle loop. Only instructions without side
+ * effects besides writing registers are accepted, plus B and svcGetSystemTick.
+ * @return The registers read and written by the instruction, or nullopt if it is not allowed
+ */
+std::optional<Instruction> Decode(u32 inst, VAddr addr) {
+    const auto reg = [inst](u32 lsb) -> std::size_t { return (inst >> lsb) & 0xF; };
+    const auto bit = [inst](u32 index) { return ((inst >> index) & 1) != 0; };
+
+    Instruction result;
+    const u32 cond = inst >> 28;
+    if (cond == 0xF) {
+        return std::nullopt;
+    }
+
+    if ((inst & 0x0E000000) == 0x0A000000) {
+        // B and BL
+        if (bit(24)) {
+            return std::nullopt;
+        }
+        const s32 offset = static_cast<s32>(inst << 8) >> 6;
+        result.branch_target = addr + 8 + offset;
+    } else if ((inst & 0x0F000000) == 0x0F000000) {
+        // SVC
+        if ((inst & 0x00FFFFFF) != SVC_GetSystemTick) {
+            return std::nullopt;
+        }
+        result.writes.set(0).set(1);
+    } else if ((inst & 0x0C000000) == 0x04000000) {
+        // LDR and LDRB, without writeback. Register offsets with bit 4 set are media instructions
+        if (!bit(20) || !bit(24) || bit(21) || (bit(25) && bit(4)) || reg(12) == REG_PC) {
+            return std::nullopt;
+        }
+        result.reads.set(reg(16));
+        if (bit(25)) {
+            result.reads.set(reg(0));
+        }
+        result.writes.set(reg(12));
+    } else if ((inst & 0x0E000090) == 0x00000090 && (inst & 0x60) != 0) {
+        // LDRH, LDRSB and LDRSH, without writeback
+        if (!bit(20) || !bit(24) || bit(21) || reg(12) == REG_PC) {
+            return std::nullopt;
+        }
+        result.reads.set(reg(16));
+        if (!bit(22)) {
+            result.reads.set(reg(0));
+        }
+        result.writes.set(reg(12));
+    } else if ((inst & 0x0C000000) == 0x00000000) {
+        // Data processing. This space also holds multiplies, swaps and exclusive accesses, as
+        // well as the status register and branch-and-exchange instructions, none of which we allow
+        const bool immediate = bit(25);
+        const bool set_flags = bit(20);
+        const u32 opcode = (inst >> 21) & 0xF;
+        const bool is_test = opcode >= 0x8 && opcode <= 0xB;
+        if ((!immediate && (inst & 0x90) == 0x90) || (is_test && !set_flags)) {
+            return std::nullopt;
+        }
+        if (!is_test) {
+            if (reg(12) == REG_PC) {
+                return std::nullopt;
+            }
+            result.writes.set(reg(12));
+        }
+        // MOV and MVN have no first operand
+        if (opcode != 0xD && opcode != 0xF) {
+            result.reads.set(reg(16));
+        }
+
+        // Whether the shifter produces a carry out, and whether that depends on the old carry
+        bool shifter_carry = false;
+        bool shifter_carry_partial = false;
+        if (immediate) {
+            shifter_carry = (inst & 0xF00) != 0;
+        } else {
+            result.reads.set(reg(0));
+            const u32 shift_type = (inst >> 5) & 3;
+            if (bit(4)) {
+                result.reads.set(reg(8));
+                shifter_carry = shifter_carry_partial = true;
+            } else if (((inst >> 7) & 0x1F) != 0) {
+                shifter_carry = true;
+            } else if (shift_type == 3) {
+                // RRX
+                result.reads.set(FLAG_C);
+                shifter_carry = true;
+            } else if (shift_type != 0) {
+                // LSR #32 and ASR #32
+                shifter_carry = true;
+            }
+        }
+
+        // ADC, SBC and RSC
+        if (opcode >= 0x5 && opcode <= 0x7) {
+            result.reads.set(FLAG_C);
+        }
+
+        if (set_flags) {
+            result.writes.set(FLAG_N).set(FLAG_Z);
+            const bool is_logical = opcode == 0x0 || opcode == 0x1 || opcode == 0x8 ||
+                                    opcode == 0x9 || opcode >= 0xC;
+            if (!is_logical) {
+                result.writes.set(FLAG_C).set(FLAG_V);
+            } else if (shifter_carry) {
+                result.writes.set(FLAG_C);
+                if (shifter_carry_partial) {
+                    result.reads.set(FLAG_C);
+                }
+            }
+        }
+    } else {
+        return std::nullopt;
+    }
+
+    if (cond != 0xE) {
+        // A conditional instruction keeps the old value of anything it writes when it is skipped
+        result.conditional = true;
+        result.reads |= ConditionFlags(cond) | result.writes;
+    }
+    return result;
+}
+
+} // Anonymous namespace
+
+std::optional<IdleLoop> FindIdleLoop(Memory::PageTable& page_table, VAddr pc) {
+    // Look for the branch back to the start of the loop
+    std::optional<IdleLoop> loop;
+    for (VAddr addr = pc; addr < pc + MaxLoopLength * 4; addr += 4) {
+        const auto inst = ReadCode(page_table, addr);
+        if (!inst) {
+            return std::nullopt;
+        }
+        const auto decoded = Decode(*inst, addr);
+        if (!decoded) {
+            return std::nullopt;
+        }
+        if (decoded->branch_target && *decoded->branch_target <= pc) {
+            if (addr - *decoded->branch_target >= MaxLoopLength * 4) {
+                return std::nullopt;
+            }
+            loop = IdleLoop{*decoded->branch_target, addr};
+            break;
+        }
+    }
+    if (!loop) {
+        return std::nullopt;
+    }
+
+    std::array<Instruction, MaxLoopLength> body;
+    std::size_t body_length = 0;
+    RegisterSet written;
+    for (VAddr addr = loop->start; addr <= loop->end; addr += 4) {
+        const auto inst = ReadCode(page_table, addr);
+        if (!inst) {
+            return std::nullopt;
+        }
+        const auto decoded = Decode(*inst, addr);
+        if (!decoded) {
+            return std::nullopt;
+        }
+        // Other branches may only leave the loop, and only conditionally
+        if (decoded->branch_target && addr != loop->end &&
+            (!decoded->conditional || loop->Contains(*decoded->branch_target))) {
+            return std::nullopt;
+        }
+        written |= decoded->writes;
+        body[body_length++] = *decoded;
+    }
+
+    // Every register the loop reads must either be left alone by the loop or be set earlier in
+    // the same iteration, otherwise the next iteration could behave differently
+    RegisterSet defined;
+    for (std::size_t i = 0; i < body_length; ++i) {
+        if ((body[i].reads & written & ~defined).any()) {
+            return std::nullopt;
+        }
+        if (!body[i].conditional) {
+            defined |= body[i].writes;
+        }
+    }
+    return loop;
+}
+
+} // namespace Core
@@ -0,0 +1,37 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <optional>
+#include "common/common_types.h"
+
+namespace Memory {
+struct PageTable;
+}
+
+namespace Core {
+
+/// A loop in guest code that only waits for some state outside of the CPU to change
+struct IdleLoop {
+    VAddr start; ///< Address of the first instruction of the loop body
+    VAddr end;   ///< Address of the branch back to start
+
+    bool Contains(VAddr pc) const {
+        return pc >= start && pc <= end;
+    }
+};
+
+/**
+ * Checks whether the ARM code at pc is part of an idle loop, i.e. a short loop that only polls
+ * memory or svcGetSystemTick and carries no state from one iteration to the next. Running such a
+ * loop any number of times has the same effect as running it once, so the CPU can skip ahead to
+ * the next event instead.
+ * @param page_table Page table to read the code from
+ * @param pc Address of an instruction in the loop
+ * @return The loop containing pc, if it is an idle loop
+ */
+std::optional<IdleLoop> FindIdleLoop(Memory::PageTable& page_table, VAddr pc);
+
+} // namespace Core
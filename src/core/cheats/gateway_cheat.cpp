@@ -3,7 +3,9 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstring>
 #include <fstream>
 #include <functional>
 #include <string>
@@ -11,6 +13,7 @@
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
+#include "common/swap.h"
 #include "core/cheats/gateway_cheat.h"
 #include "core/core.h"
 #include "core/hle/service/hid/hid.h"
@@ -18,6 +21,35 @@
 
 namespace Cheats {
 
+namespace {
+
+/// Gives cheats access to the running system
+class SystemEnvironment final : public GatewayCheat::Environment {
+public:
+    explicit SystemEnvironment(Core::System& system) : system(system) {}
+
+    Memory::MemorySystem& Memory() override {
+        return system.Memory();
+    }
+
+    void InvalidateCacheRange(VAddr address, std::size_t size) override {
+        system.InvalidateCacheRange(address, size);
+    }
+
+    u32 GetPadState() override {
+        return system.ServiceManager()
+            .GetService<Service::HID::Module::Interface>("hid:USER")
+            ->GetModule()
+            ->GetState()
+            .hex;
+    }
+
+private:
+    Core::System& system;
+};
+
+} // Anonymous namespace
+
 struct State {
     u32 reg = 0;
     u32 offset = 0;
@@ -33,12 +65,12 @@ static inline std::enable_if_t<std::is_integral_v<T>> WriteOp(const GatewayCheat
                                                               const State& state,
                                                               ReadFunction read_func,
                                                               WriteFunction write_func,
-                                                              Core::System& system) {
+                                                              GatewayCheat::Environment& env) {
     u32 addr = line.address + state.offset;
     T val = read_func(addr);
     if (val != static_cast<T>(line.value)) {
         write_func(addr, static_cast<T>(line.value));
-        system.InvalidateCacheRange(addr, sizeof(T));
+        env.InvalidateCacheRange(addr, sizeof(T));
     }
 }
 
@@ -106,12 +138,12 @@ static inline void SetValueOp(const GatewayCheat::CheatLine& line, State& state)
 template <typename T, typename ReadFunction, typename WriteFunction>
 static inline std::enable_if_t<std::is_integral_v<T>> IncrementiveWriteOp(
     const GatewayCheat::CheatLine& line, State& state, ReadFunction read_func,
-    WriteFunction write_func, Core::System& system) {
+    WriteFunction write_func, GatewayCheat::Environment& env) {
     u32 addr = line.value + state.offset;
     T val = read_func(addr);
     if (val != static_cast<T>(state.reg)) {
         write_func(addr, static_cast<T>(state.reg));
-        system.InvalidateCacheRange(addr, sizeof(T));
+        env.InvalidateCacheRange(addr, sizeof(T));
     }
     state.offset += sizeof(T);
 }
@@ -129,19 +161,16 @@ static inline void AddOffsetOp(const GatewayCheat::CheatLine& line, State& state
 }
 
 static inline void JokerOp(const GatewayCheat::CheatLine& line, State& state,
-                           const Core::System& system) {
-    u32 pad_state = system.ServiceManager()
-                        .GetService<Service::HID::Module::Interface>("hid:USER")
-                        ->GetModule()
-                        ->GetState()
-                        .hex;
+                           GatewayCheat::Environment& env) {
+    u32 pad_state = env.GetPadState();
     bool pressed = (pad_state & line.value) == line.value;
     if (!pressed) {
         state.if_flag++;
     }
 }
 
-static inline void PatchOp(const GatewayCheat::CheatLine& line, State& state, Core::System& system,
+static inline void PatchOp(const GatewayCheat::CheatLine& line, State& state,
+                           GatewayCheat::Environment& env,
                            const std::vector<GatewayCheat::CheatLine>& cheat_lines) {
     if (state.if_flag > 0) {
         // Skip over the additional patch lines
@@ -150,7 +179,7 @@ static inline void PatchOp(const GatewayCheat::CheatLine& line, State& state, Co
     }
     u32 num_bytes = line.value;
     u32 addr = line.address + state.offset;
-    system.InvalidateCacheRange(addr, num_bytes);
+    env.InvalidateCacheRange(addr, num_bytes);
 
     bool first = true;
     u32 bit_offset = 0;
@@ -163,7 +192,7 @@ static inline void PatchOp(const GatewayCheat::CheatLine& line, State& state, Co
             state.current_line_nr++;
         }
         first = !first;
-        system.Memory().Write32(addr, tmp);
+        env.Memory().Write32(addr, tmp);
         addr += 4;
         num_bytes -= 4;
     }
@@ -171,13 +200,76 @@ static inline void PatchOp(const GatewayCheat::CheatLine& line, State& state, Co
         u32 tmp = (first ? cheat_lines[state.current_line_nr].first
                          : cheat_lines[state.current_line_nr].value) >>
                   bit_offset;
-        system.Memory().Write8(addr, tmp);
+        env.Memory().Write8(addr, tmp);
         addr += 1;
         num_bytes -= 1;
         bit_offset += 8;
     }
 }
 
+// The cheat lines are compiled into a bytecode that is cheaper to run than the lines themselves:
+// - Operands are decoded once, and the data lines of patch codes are folded into their patch.
+// - Where the offset is known at compile time, it is added to the address ahead of time, and runs
+//   of writes to such static addresses are batched into a single instruction.
+// - Conditionals know where execution continues when they fail, instead of scanning for the
+//   matching terminator on every run.
+// Loops are kept as in the cheat, since their bounds depend on the loop state at run time.
+
+enum class GatewayOp : u8 {
+    Write32,
+    Write16,
+    Write8,
+    WriteBatch,
+    GreaterThan32,
+    LessThan32,
+    EqualTo32,
+    NotEqualTo32,
+    GreaterThan16WithMask,
+    LessThan16WithMask,
+    EqualTo16WithMask,
+    NotEqualTo16WithMask,
+    Joker,
+    LoadOffset,
+    Loop,
+    Terminator,
+    LoopExecuteVariant,
+    FullTerminator,
+    SetOffset,
+    AddValue,
+    SetValue,
+    IncrementiveWrite32,
+    IncrementiveWrite16,
+    IncrementiveWrite8,
+    Load32,
+    Load16,
+    Load8,
+    AddOffset,
+    Patch,
+};
+
+struct GatewayCheat::Instruction {
+    GatewayOp op;
+    /// True if the offset was known at compile time and has been added to the address already
+    bool static_address = false;
+    /// Address accessed by the instruction, before adding the offset
+    u32 address = 0;
+    u32 value = 0;
+    /// Mask applied to the memory value by the 16 bit conditionals
+    u16 mask = 0;
+    /// Conditionals: instruction to continue at if the condition fails.
+    /// Batches and patches: index of the first write or byte of data.
+    u32 target = 0;
+    /// Conditionals: value of the if flag after skipping to the target.
+    /// Batches and patches: number of writes or bytes of data.
+    u32 count = 0;
+};
+
+struct GatewayCheat::StaticWrite {
+    VAddr address;
+    u32 value;
+    u32 size;
+};
+
 GatewayCheat::CheatLine::CheatLine(const std::string& line) {
     constexpr std::size_t cheat_length = 17;
     if (line.length() != cheat_length) {
@@ -209,6 +301,7 @@ GatewayCheat::CheatLine::CheatLine(const std::string& line) {
 GatewayCheat::GatewayCheat(std::string name_, std::vector<CheatLine> cheat_lines_,
                            std::string comments_)
     : name(std::move(name_)), cheat_lines(std::move(cheat_lines_)), comments(std::move(comments_)) {
+    Compile();
 }
 
 GatewayCheat::GatewayCheat(std::string name_, std::string code, std::string comments_)
@@ -223,14 +316,15 @@ GatewayCheat::GatewayCheat(std::string name_, std::string code, std::string comm
             temp_cheat_lines.emplace_back(code_lines[i]);
     }
     cheat_lines = std::move(temp_cheat_lines);
+    Compile();
 }
 
 GatewayCheat::~GatewayCheat() = default;
 
-void GatewayCheat::Execute(Core::System& system) const {
+void GatewayCheat::ExecuteLineByLine(Environment& env) const {
     State state;
 
-    Memory::MemorySystem& memory = system.Memory();
+    Memory::MemorySystem& memory = env.Memory();
     auto Read8 = [&memory](VAddr addr) { return memory.Read8(addr); };
     auto Read16 = [&memory](VAddr addr) { return memory.Read16(addr); };
     auto Read32 = [&memory](VAddr addr) { return memory.Read32(addr); };
@@ -240,7 +334,7 @@ void GatewayCheat::Execute(Core::System& system) const {
 
     for (state.current_line_nr = 0; state.current_line_nr < cheat_lines.size();
          state.current_line_nr++) {
-        auto line = cheat_lines[state.current_line_nr];
+        const auto& line = cheat_lines[state.current_line_nr];
         if (state.if_flag > 0) {
             switch (line.type) {
             case CheatType::GreaterThan32:
@@ -259,7 +353,7 @@ void GatewayCheat::Execute(Core::System& system) const {
                 // EXXXXXXX YYYYYYYY
                 // Copies YYYYYYYY bytes from (current code location + 8) to [XXXXXXXX + offset].
                 // We need to call this here to skip the additional patch lines
-                PatchOp(line, state, system, cheat_lines);
+                PatchOp(line, state, env, cheat_lines);
                 break;
             case CheatType::Terminator:
                 // D0000000 00000000 - ENDIF
@@ -280,15 +374,15 @@ void GatewayCheat::Execute(Core::System& system) const {
             break;
         case CheatType::Write32:
             // 0XXXXXXX YYYYYYYY - word[XXXXXXX+offset] = YYYYYYYY
-            WriteOp<u32>(line, state, Read32, Write32, system);
+            WriteOp<u32>(line, state, Read32, Write32, env);
             break;
         case CheatType::Write16:
             // 1XXXXXXX 0000YYYY - half[XXXXXXX+offset] = YYYY
-            WriteOp<u16>(line, state, Read16, Write16, system);
+            WriteOp<u16>(line, state, Read16, Write16, env);
             break;
         case CheatType::Write8:
             // 2XXXXXXX 000000YY - byte[XXXXXXX+offset] = YY
-            WriteOp<u8>(line, state, Read8, Write8, system);
+            WriteOp<u8>(line, state, Read8, Write8, env);
             break;
         case CheatType::GreaterThan32:
             // 3XXXXXXX YYYYYYYY - Execute next block IF YYYYYYYY > word[XXXXXXX]   ;unsigned
@@ -334,7 +428,7 @@ void GatewayCheat::Execute(Core::System& system) const {
             break;
         case CheatType::LoadOffset:
             // BXXXXXXX 00000000 - offset = word[XXXXXXX+offset]
-            LoadOffsetOp(system.Memory(), line, state);
+            LoadOffsetOp(memory, line, state);
             break;
         case CheatType::Loop: {
             // C0000000 YYYYYYYY - LOOP next block YYYYYYYY times
@@ -374,17 +468,17 @@ void GatewayCheat::Execute(Core::System& system) const {
         }
         case CheatType::IncrementiveWrite32: {
             // D6000000 XXXXXXXX – (32bit) [XXXXXXXX+offset] = reg ; offset += 4
-            IncrementiveWriteOp<u32>(line, state, Read32, Write32, system);
+            IncrementiveWriteOp<u32>(line, state, Read32, Write32, env);
             break;
         }
         case CheatType::IncrementiveWrite16: {
             // D7000000 XXXXXXXX – (16bit) [XXXXXXXX+offset] = reg & 0xffff ; offset += 2
-            IncrementiveWriteOp<u16>(line, state, Read16, Write16, system);
+            IncrementiveWriteOp<u16>(line, state, Read16, Write16, env);
             break;
         }
         case CheatType::IncrementiveWrite8: {
             // D8000000 XXXXXXXX – (16bit) [XXXXXXXX+offset] = reg & 0xff ; offset++
-            IncrementiveWriteOp<u8>(line, state, Read8, Write8, system);
+            IncrementiveWriteOp<u8>(line, state, Read8, Write8, env);
             break;
         }
         case CheatType::Load32: {
@@ -409,17 +503,480 @@ void GatewayCheat::Execute(Core::System& system) const {
         }
         case CheatType::Joker: {
             // DD000000 XXXXXXXX – if KEYPAD has value XXXXXXXX execute next block
-            JokerOp(line, state, system);
+            JokerOp(line, state, env);
             break;
         }
         case CheatType::Patch: {
             // EXXXXXXX YYYYYYYY
             // Copies YYYYYYYY bytes from (current code location + 8) to [XXXXXXXX + offset].
-            PatchOp(line, state, system, cheat_lines);
+            PatchOp(line, state, env, cheat_lines);
+            break;
+        }
+        }
+    }
+}
+
+static bool IsConditional(GatewayOp op) {
+    return op >= GatewayOp::GreaterThan32 && op <= GatewayOp::Joker;
+}
+
+/// Guest memory accessor that goes straight to the page pointers when possible
+class CheatMemory {
+public:
+    explicit CheatMemory(Memory::MemorySystem& memory)
+        : memory(memory), page_table(memory.GetCurrentPageTable()),
+          pointers(page_table->GetPointerArray()) {}
+
+    template <typename T>
+    T Read(VAddr addr) {
+        if (const u8* page = pointers[addr >> Memory::PAGE_BITS]) {
+            T value;
+            std::memcpy(&value, page + (addr & Memory::PAGE_MASK), sizeof(T));
+            return value;
+        }
+        if constexpr (sizeof(T) == 1) {
+            return memory.Read8(addr);
+        } else if constexpr (sizeof(T) == 2) {
+            return memory.Read16(addr);
+        } else {
+            return memory.Read32(addr);
+        }
+    }
+
+    template <typename T>
+    void Write(VAddr addr, T value) {
+        if (u8* page = pointers[addr >> Memory::PAGE_BITS]) {
+            std::memcpy(page + (addr & Memory::PAGE_MASK), &value, sizeof(T));
+            return;
+        }
+        if constexpr (sizeof(T) == 1) {
+            memory.Write8(addr, value);
+        } else if constexpr (sizeof(T) == 2) {
+            memory.Write16(addr, value);
+        } else {
+            memory.Write32(addr, value);
+        }
+    }
+
+    /// Writes a value unless memory already holds it, like the write codes do
+    template <typename T>
+    void Update(GatewayCheat::Environment& env, VAddr addr, T value) {
+        if (Read<T>(addr) != value) {
+            Write<T>(addr, value);
+            env.InvalidateCacheRange(addr, sizeof(T));
+        }
+    }
+
+private:
+    Memory::MemorySystem& memory;
+    std::shared_ptr<Memory::PageTable> page_table;
+    std::array<u8*, Memory::PAGE_TABLE_NUM_ENTRIES>& pointers;
+};
+
+/**
+ * Finds where each failing conditional continues, by doing ahead of time what ExecuteLineByLine
+ * does while the if flag is set. The scan stops at the matching terminator, or at a full
+ * terminator, whose effect depends on the loop state at run time.
+ */
+template <typename Instruction>
+static void ResolveConditionals(std::vector<Instruction>& program) {
+    for (std::size_t i = 0; i < program.size(); ++i) {
+        if (!IsConditional(program[i].op)) {
+            continue;
+        }
+        u32 depth = 1;
+        std::size_t next = i + 1;
+        for (; next < program.size(); ++next) {
+            const GatewayOp op = program[next].op;
+            if (IsConditional(op)) {
+                ++depth;
+            } else if (op == GatewayOp::Terminator && --depth == 0) {
+                ++next;
+                break;
+            } else if (op == GatewayOp::FullTerminator) {
+                break;
+            }
+        }
+        program[i].target = static_cast<u32>(next);
+        program[i].count = depth;
+    }
+}
+
+void GatewayCheat::Compile() {
+    program.clear();
+    static_writes.clear();
+    patch_data.clear();
+
+    for (std::size_t i = 0; i < cheat_lines.size(); ++i) {
+        const CheatLine& line = cheat_lines[i];
+        Instruction instr;
+        instr.address = line.address;
+        instr.value = line.value;
+        switch (line.type) {
+        case CheatType::Write32:
+            instr.op = GatewayOp::Write32;
+            break;
+        case CheatType::Write16:
+            instr.op = GatewayOp::Write16;
+            instr.value = static_cast<u16>(line.value);
+            break;
+        case CheatType::Write8:
+            instr.op = GatewayOp::Write8;
+            instr.value = static_cast<u8>(line.value);
+            break;
+        case CheatType::GreaterThan32:
+            instr.op = GatewayOp::GreaterThan32;
+            break;
+        case CheatType::LessThan32:
+            instr.op = GatewayOp::LessThan32;
+            break;
+        case CheatType::EqualTo32:
+            instr.op = GatewayOp::EqualTo32;
+            break;
+        case CheatType::NotEqualTo32:
+            instr.op = GatewayOp::NotEqualTo32;
+            break;
+        case CheatType::GreaterThan16WithMask:
+        case CheatType::LessThan16WithMask:
+        case CheatType::EqualTo16WithMask:
+        case CheatType::NotEqualTo16WithMask:
+            instr.op = static_cast<GatewayOp>(static_cast<int>(GatewayOp::GreaterThan16WithMask) +
+                                              static_cast<int>(line.type) -
+                                              static_cast<int>(CheatType::GreaterThan16WithMask));
+            instr.value = static_cast<u16>(line.value);
+            instr.mask = static_cast<u16>(~line.value >> 16);
+            break;
+        case CheatType::LoadOffset:
+            instr.op = GatewayOp::LoadOffset;
+            break;
+        case CheatType::Loop:
+            instr.op = GatewayOp::Loop;
+            break;
+        case CheatType::Terminator:
+            instr.op = GatewayOp::Terminator;
+            break;
+        case CheatType::LoopExecuteVariant:
+            instr.op = GatewayOp::LoopExecuteVariant;
+            break;
+        case CheatType::FullTerminator:
+            instr.op = GatewayOp::FullTerminator;
+            break;
+        case CheatType::SetOffset:
+            instr.op = GatewayOp::SetOffset;
+            break;
+        case CheatType::AddValue:
+            instr.op = GatewayOp::AddValue;
+            break;
+        case CheatType::SetValue:
+            instr.op = GatewayOp::SetValue;
+            break;
+        case CheatType::IncrementiveWrite32:
+        case CheatType::IncrementiveWrite16:
+        case CheatType::IncrementiveWrite8:
+        case CheatType::Load32:
+        case CheatType::Load16:
+        case CheatType::Load8:
+            instr.op = static_cast<GatewayOp>(static_cast<int>(GatewayOp::IncrementiveWrite32) +
+                                              static_cast<int>(line.type) -
+                                              static_cast<int>(CheatType::IncrementiveWrite32));
+            // These codes take their address from the value
+            instr.address = line.value;
+            break;
+        case CheatType::AddOffset:
+            instr.op = GatewayOp::AddOffset;
+            break;
+        case CheatType::Joker:
+            instr.op = GatewayOp::Joker;
+            break;
+        case CheatType::Patch: {
+            // The data is stored in the following lines, which are never run as codes
+            const std::size_t num_lines =
+                std::min<std::size_t>((static_cast<u64>(line.value) + 7) / 8,
+                                      cheat_lines.size() - i - 1);
+            const std::size_t num_bytes = std::min<std::size_t>(line.value, num_lines * 8);
+            instr.op = GatewayOp::Patch;
+            instr.target = static_cast<u32>(patch_data.size());
+            instr.count = static_cast<u32>(num_bytes);
+            for (std::size_t data_line = i + 1; data_line <= i + num_lines; ++data_line) {
+                const CheatLine& data = cheat_lines[data_line];
+                for (const u32 word : {data.first, data.value}) {
+                    for (u32 byte = 0; byte < 4; ++byte) {
+                        patch_data.push_back(static_cast<u8>(word >> (byte * 8)));
+                    }
+                }
+            }
+            patch_data.resize(instr.target + num_bytes);
+            i += num_lines;
             break;
         }
+        default:
+            // Invalid and unknown lines have no effect
+            continue;
         }
+        program.push_back(instr);
     }
+
+    ResolveConditionals(program);
+
+    // Without loops, execution only ever moves forward, so the offset at each instruction can be
+    // found in a single pass. Where paths with different offsets meet, the offset is unknown.
+    const bool has_loops = std::any_of(program.begin(), program.end(), [](const Instruction& i) {
+        return i.op == GatewayOp::Loop;
+    });
+    if (!has_loops) {
+        struct Offset {
+            bool reached = false;
+            bool known = false;
+            u32 value = 0;
+        };
+        std::vector<Offset> offsets(program.size() + 1);
+        const auto merge = [&offsets](std::size_t target, const Offset& offset) {
+            Offset& current = offsets[target];
+            if (!current.reached) {
+                current = offset;
+            } else if (!offset.known || !current.known || offset.value != current.value) {
+                current.known = false;
+            }
+        };
+        offsets[0] = {true, true, 0};
+        for (std::size_t i = 0; i < program.size(); ++i) {
+            Instruction& instr = program[i];
+            Offset offset = offsets[i];
+            switch (instr.op) {
+            case GatewayOp::Write32:
+            case GatewayOp::Write16:
+            case GatewayOp::Write8:
+            case GatewayOp::Patch:
+            case GatewayOp::Load32:
+            case GatewayOp::Load16:
+            case GatewayOp::Load8:
+            case GatewayOp::LoadOffset:
+                if (offset.known) {
+                    instr.address += offset.value;
+                    instr.static_address = true;
+                }
+                break;
+            case GatewayOp::IncrementiveWrite32:
+            case GatewayOp::IncrementiveWrite16:
+            case GatewayOp::IncrementiveWrite8:
+                if (offset.known) {
+                    instr.address += offset.value;
+                    instr.static_address = true;
+                    offset.value += 4 >> (static_cast<int>(instr.op) -
+                                          static_cast<int>(GatewayOp::IncrementiveWrite32));
+                }
+                break;
+            case GatewayOp::SetOffset:
+                offset.known = true;
+                offset.value = instr.value;
+                break;
+            case GatewayOp::AddOffset:
+                offset.value += instr.value;
+                break;
+            case GatewayOp::FullTerminator:
+                // Without loops, this always resets the offset
+                offset.known = true;
+                offset.value = 0;
+                break;
+            default:
+                if (IsConditional(instr.op)) {
+                    merge(instr.target, offset);
+                }
+                break;
+            }
+            if (instr.op == GatewayOp::LoadOffset) {
+                offset.known = false;
+            }
+            merge(i + 1, offset);
+        }
+
+        // Batch runs of writes to static addresses
+        std::vector<Instruction> batched;
+        batched.reserve(program.size());
+        for (std::size_t i = 0; i < program.size();) {
+            const auto is_static_write = [this](std::size_t index) {
+                const Instruction& instr = program[index];
+                return instr.static_address && instr.op >= GatewayOp::Write32 &&
+                       instr.op <= GatewayOp::Write8;
+            };
+            std::size_t end = i;
+            while (end < program.size() && is_static_write(end)) {
+                ++end;
+            }
+            if (end - i < 2) {
+                batched.push_back(program[i++]);
+                continue;
+            }
+            Instruction batch;
+            batch.op = GatewayOp::WriteBatch;
+            batch.target = static_cast<u32>(static_writes.size());
+            batch.count = static_cast<u32>(end - i);
+            for (; i < end; ++i) {
+                const u32 size = 4 >> (static_cast<int>(program[i].op) -
+                                       static_cast<int>(GatewayOp::Write32));
+                static_writes.push_back({program[i].address, program[i].value, size});
+            }
+            batched.push_back(batch);
+        }
+        program = std::move(batched);
+        ResolveConditionals(program);
+    }
+}
+
+void GatewayCheat::Execute(Environment& env) const {
+    State state;
+    CheatMemory memory(env.Memory());
+
+    const auto address = [&state](const Instruction& instr) {
+        return instr.static_address ? instr.address : instr.address + state.offset;
+    };
+    const auto compare16 = [&](const Instruction& instr) {
+        return static_cast<u16>(instr.mask & memory.Read<u16_le>(address(instr)));
+    };
+
+    for (state.current_line_nr = 0; state.current_line_nr < program.size();
+         state.current_line_nr++) {
+        const Instruction& instr = program[state.current_line_nr];
+        if (state.if_flag > 0) {
+            // Only reached when a loop jumps back while the if flag is set, otherwise failing
+            // conditionals skip straight to where the flag is cleared
+            if (IsConditional(instr.op)) {
+                state.if_flag++;
+            } else if (instr.op == GatewayOp::Terminator) {
+                TerminateOp(state);
+            } else if (instr.op == GatewayOp::FullTerminator) {
+                FullTerminateOp(state);
+            }
+            continue;
+        }
+
+        bool condition = true;
+        switch (instr.op) {
+        case GatewayOp::Write32:
+            memory.Update<u32_le>(env, address(instr), instr.value);
+            break;
+        case GatewayOp::Write16:
+            memory.Update<u16_le>(env, address(instr), static_cast<u16>(instr.value));
+            break;
+        case GatewayOp::Write8:
+            memory.Update<u8>(env, address(instr), static_cast<u8>(instr.value));
+            break;
+        case GatewayOp::WriteBatch:
+            for (u32 i = instr.target; i < instr.target + instr.count; ++i) {
+                const StaticWrite& write = static_writes[i];
+                if (write.size == 4) {
+                    memory.Update<u32_le>(env, write.address, write.value);
+                } else if (write.size == 2) {
+                    memory.Update<u16_le>(env, write.address, static_cast<u16>(write.value));
+                } else {
+                    memory.Update<u8>(env, write.address, static_cast<u8>(write.value));
+                }
+            }
+            break;
+        case GatewayOp::GreaterThan32:
+            condition = instr.value > memory.Read<u32_le>(address(instr));
+            break;
+        case GatewayOp::LessThan32:
+            condition = instr.value < memory.Read<u32_le>(address(instr));
+            break;
+        case GatewayOp::EqualTo32:
+            condition = instr.value == memory.Read<u32_le>(address(instr));
+            break;
+        case GatewayOp::NotEqualTo32:
+            condition = instr.value != memory.Read<u32_le>(address(instr));
+            break;
+        case GatewayOp::GreaterThan16WithMask:
+            condition = instr.value > compare16(instr);
+            break;
+        case GatewayOp::LessThan16WithMask:
+            condition = instr.value < compare16(instr);
+            break;
+        case GatewayOp::EqualTo16WithMask:
+            condition = instr.value == compare16(instr);
+            break;
+        case GatewayOp::NotEqualTo16WithMask:
+            condition = instr.value != compare16(instr);
+            break;
+        case GatewayOp::Joker:
+            condition = (env.GetPadState() & instr.value) == instr.value;
+            break;
+        case GatewayOp::LoadOffset:
+            state.offset = memory.Read<u32_le>(address(instr));
+            break;
+        case GatewayOp::Loop:
+            state.loop_flag = state.loop_count < instr.value;
+            state.loop_count++;
+            state.loop_back_line = state.current_line_nr;
+            break;
+        case GatewayOp::Terminator:
+            TerminateOp(state);
+            break;
+        case GatewayOp::LoopExecuteVariant:
+            LoopExecuteVariantOp(state);
+            break;
+        case GatewayOp::FullTerminator:
+            FullTerminateOp(state);
+            break;
+        case GatewayOp::SetOffset:
+            state.offset = instr.value;
+            break;
+        case GatewayOp::AddValue:
+            state.reg += instr.value;
+            break;
+        case GatewayOp::SetValue:
+            state.reg = instr.value;
+            break;
+        case GatewayOp::IncrementiveWrite32:
+            memory.Update<u32_le>(env, address(instr), state.reg);
+            state.offset += 4;
+            break;
+        case GatewayOp::IncrementiveWrite16:
+            memory.Update<u16_le>(env, address(instr), static_cast<u16>(state.reg));
+            state.offset += 2;
+            break;
+        case GatewayOp::IncrementiveWrite8:
+            memory.Update<u8>(env, address(instr), static_cast<u8>(state.reg));
+            state.offset += 1;
+            break;
+        case GatewayOp::Load32:
+            state.reg = memory.Read<u32_le>(address(instr));
+            break;
+        case GatewayOp::Load16:
+            state.reg = memory.Read<u16_le>(address(instr));
+            break;
+        case GatewayOp::Load8:
+            state.reg = memory.Read<u8>(address(instr));
+            break;
+        case GatewayOp::AddOffset:
+            state.offset += instr.value;
+            break;
+        case GatewayOp::Patch: {
+            VAddr addr = address(instr);
+            env.InvalidateCacheRange(addr, instr.count);
+            const u8* data = patch_data.data() + instr.target;
+            const u8* const end = data + instr.count;
+            for (; end - data >= 4; data += 4, addr += 4) {
+                u32_le word;
+                std::memcpy(&word, data, sizeof(word));
+                memory.Write<u32_le>(addr, word);
+            }
+            for (; data != end; ++data, ++addr) {
+                memory.Write<u8>(addr, *data);
+            }
+            break;
+        }
+        }
+
+        if (!condition) {
+            state.if_flag = instr.count;
+            state.current_line_nr = instr.target - 1;
+        }
+    }
+}
+
+void GatewayCheat::Execute(Core::System& system) const {
+    SystemEnvironment env(system);
+    Execute(env);
 }
 
 bool GatewayCheat::IsEnabled() const {
@@ -5,9 +5,16 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
 #include <memory>
+#include <vector>
+#include "common/common_types.h"
 #include "core/cheats/cheat_base.h"
 
+namespace Memory {
+class MemorySystem;
+}
+
 namespace Cheats {
 class GatewayCheat final : public CheatBase {
 public:
@@ -53,12 +60,30 @@ public:
         bool valid = true;
     };
 
+    /// The parts of the emulated system that cheats interact with
+    class Environment {
+    public:
+        virtual ~Environment() = default;
+        virtual Memory::MemorySystem& Memory() = 0;
+        /// Called after guest code may have been modified by the cheat
+        virtual void InvalidateCacheRange(VAddr address, std::size_t size) = 0;
+        /// Returns the state of the pad buttons, as reported by HID
+        virtual u32 GetPadState() = 0;
+    };
+
     GatewayCheat(std::string name, std::vector<CheatLine> cheat_lines, std::string comments);
     GatewayCheat(std::string name, std::string code, std::string comments);
     ~GatewayCheat();
 
     void Execute(Core::System& system) const override;
 
+    /// Runs the cheat using the bytecode compiled from its lines
+    void Execute(Environment& env) const;
+
+    /// Runs the cheat by interpreting its lines one at a time. Slower than Execute, but kept as a
+    /// reference for the compiled bytecode.
+    void ExecuteLineByLine(Environment& env) const;
+
     bool IsEnabled() const override;
     void SetEnabled(bool enabled) override;
 
@@ -78,9 +103,21 @@ public:
     static std::vector<std::unique_ptr<CheatBase>> LoadFile(const std::string& filepath);
 
 private:
+    struct Instruction;
+    struct StaticWrite;
+
+    /// Lowers the cheat lines into bytecode, see gateway_cheat.cpp for the format
+    void Compile();
+
     std::atomic<bool> enabled = false;
     const std::string name;
     std::vector<CheatLine> cheat_lines;
     const std::string comments;
+
+    std::vector<Instruction> program;
+    /// Writes to addresses known at compile time, referenced by batched write instructions
+    std::vector<StaticWrite> static_writes;
+    /// Data of the patch codes
+    std::vector<u8> patch_data;
 };
 } // namespace Cheats
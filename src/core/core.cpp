@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <memory>
 #include <stdexcept>
@@ -14,12 +16,14 @@
 #include "common/texture.h"
 #include "core/arm/arm_interface.h"
 #if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+#include <dynarmic/exclusive_monitor.h>
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #endif
 #include "core/arm/dyncom/arm_dyncom.h"
 #include "core/cheats/cheats.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/cpu_threads.h"
 #include "core/dumping/backend.h"
 #ifdef ENABLE_FFMPEG_VIDEO_DUMPER
 #include "core/dumping/ffmpeg_backend.h"
@@ -42,7 +46,9 @@
 #include "core/hw/hw.h"
 #include "core/hw/lcd.h"
 #include "core/loader/loader.h"
+#include "core/memory.h"
 #include "core/movie.h"
+#include "core/rewind_buffer.h"
 #include "core/rpc/rpc_server.h"
 #include "core/settings.h"
 #include "network/network.h"
@@ -137,10 +143,37 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         frame_limiter.WaitOnce();
         return ResultStatus::Success;
     }
+    case Signal::Rewind: {
+        try {
+            Rewind(param);
+        } catch (const std::exception& e) {
+            LOG_ERROR(Core, "Error rewinding: {}", e.what());
+            status_details = e.what();
+            return ResultStatus::ErrorSavestate;
+        }
+        frame_limiter.WaitOnce();
+        return ResultStatus::Success;
+    }
     default:
         break;
     }
 
+    // Movie keyframes are captured and restored here for the same reason as save states
+    try {
+        if (Movie::GetInstance().ProcessKeyframes()) {
+            frame_limiter.WaitOnce();
+            return ResultStatus::Success;
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR(Core, "Error restoring movie keyframe: {}", e.what());
+        status_details = e.what();
+        return ResultStatus::ErrorSavestate;
+    }
+
+    if (rewind_buffer) {
+        CaptureRewindSnapshot();
+    }
+
     // All cores should have executed the same amount of ticks. If this is not the case an event was
     // scheduled with a cycles_into_future smaller then the current downcount.
     // So we have to get those cores to the same global time first
@@ -197,27 +230,46 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
             kernel->GetThreadManager(cpu_core->GetID()).Reschedule();
             max_slice = std::min(max_slice, cpu_core->GetTimer().GetMaxSliceLength());
         }
-        for (auto& cpu_core : cpu_cores) {
-            cpu_core->GetTimer().SetNextSlice(max_slice);
-            auto start_ticks = cpu_core->GetTimer().GetTicks();
-            LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
-                      cpu_core->GetTimer().GetDowncount());
-            running_core = cpu_core.get();
-            kernel->SetRunningCPU(running_core);
-            // If we don't have a currently active thread then don't execute instructions,
-            // instead advance to the next event and try to yield to the next thread
-            if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
-                LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
-                cpu_core->GetTimer().Idle();
-                PrepareReschedule();
-            } else {
-                if (tight_loop) {
-                    cpu_core->Run();
+        if (cpu_threads && tight_loop) {
+            // All cores get the same slice and run it concurrently. Cores which end up behind are
+            // synced up by the delayed path above before the next slice, like in the serial case.
+            std::vector<ARM_Interface*> runnable_cores;
+            for (auto& cpu_core : cpu_cores) {
+                cpu_core->GetTimer().SetNextSlice(max_slice);
+                running_core = cpu_core.get();
+                kernel->SetRunningCPU(running_core);
+                if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
+                    LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+                    cpu_core->GetTimer().Idle();
+                    PrepareReschedule();
+                } else {
+                    runnable_cores.push_back(cpu_core.get());
+                }
+            }
+            cpu_threads->RunSlice(runnable_cores);
+        } else {
+            for (auto& cpu_core : cpu_cores) {
+                cpu_core->GetTimer().SetNextSlice(max_slice);
+                auto start_ticks = cpu_core->GetTimer().GetTicks();
+                LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
+                          cpu_core->GetTimer().GetDowncount());
+                running_core = cpu_core.get();
+                kernel->SetRunningCPU(running_core);
+                // If we don't have a currently active thread then don't execute instructions,
+                // instead advance to the next event and try to yield to the next thread
+                if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
+                    LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+                    cpu_core->GetTimer().Idle();
+                    PrepareReschedule();
                 } else {
-                    cpu_core->Step();
+                    if (tight_loop) {
+                        cpu_core->Run();
+                    } else {
+                        cpu_core->Step();
+                    }
                 }
+                max_slice = cpu_core->GetTimer().GetTicks() - start_ticks;
             }
-            max_slice = cpu_core->GetTimer().GetTicks() - start_ticks;
         }
     }
 
@@ -247,6 +299,15 @@ System::ResultStatus System::SingleStep() {
 }
 
 System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::string& filepath) {
+    using BootClock = std::chrono::steady_clock;
+    auto phase_start = BootClock::now();
+    std::chrono::microseconds loader_time{}, init_time{}, exec_time{}, post_load_time{};
+    const auto end_phase = [&phase_start](std::chrono::microseconds& duration) {
+        const auto now = BootClock::now();
+        duration = std::chrono::duration_cast<std::chrono::microseconds>(now - phase_start);
+        phase_start = now;
+    };
+
     FileUtil::SetCurrentRomPath(filepath);
     app_loader = Loader::GetLoader(filepath);
     if (!app_loader) {
@@ -277,6 +338,7 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
     if (Settings::values.is_new_3ds) {
         num_cores = 4;
     }
+    end_phase(loader_time);
     ResultStatus init_result{Init(emu_window, *system_mode.first, *n3ds_mode.first, num_cores)};
     if (init_result != ResultStatus::Success) {
         LOG_CRITICAL(Core, "Failed to initialize system (Error {})!",
@@ -285,6 +347,8 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
         return init_result;
     }
 
+    end_phase(init_time);
+
     telemetry_session->AddInitialInfo(*app_loader);
     std::shared_ptr<Kernel::Process> process;
     const Loader::ResultStatus load_result{app_loader->Load(process)};
@@ -302,6 +366,8 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
             return ResultStatus::ErrorLoader;
         }
     }
+    end_phase(exec_time);
+
     cheat_engine = std::make_unique<Cheats::CheatEngine>(*this);
     title_id = 0;
     if (app_loader->ReadProgramId(title_id) != Loader::ResultStatus::Success) {
@@ -320,6 +386,25 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
     if (Settings::values.preload_textures) {
         custom_tex_cache->PreloadTextures(*GetImageInterface());
     }
+    end_phase(post_load_time);
+
+    LOG_INFO(Core,
+             "Boot timings: loader {} us, system init {} us, executable load {} us, "
+             "post-load {} us",
+             loader_time.count(), init_time.count(), exec_time.count(), post_load_time.count());
+
+    if (Settings::values.enable_rewind) {
+        if (Settings::values.rewind_interval <= 0 || Settings::values.rewind_memory_limit <= 0) {
+            LOG_ERROR(Core,
+                      "Rewind is disabled, its interval of {} frames and memory limit of {} MiB "
+                      "have to be positive",
+                      Settings::values.rewind_interval, Settings::values.rewind_memory_limit);
+        } else {
+            rewind_interval = static_cast<u32>(Settings::values.rewind_interval);
+            rewind_buffer = std::make_unique<RewindBuffer>(
+                static_cast<std::size_t>(Settings::values.rewind_memory_limit) * 1024 * 1024);
+        }
+    }
 
     status = ResultStatus::Success;
     m_emu_window = &emu_window;
@@ -331,6 +416,13 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
     return status;
 }
 
+void System::SetRunningCore(ARM_Interface& core) {
+    if (running_core != &core) {
+        running_core = &core;
+        kernel->SetRunningCPU(running_core);
+    }
+}
+
 void System::PrepareReschedule() {
     running_core->PrepareReschedule();
     reschedule_pending = true;
@@ -341,6 +433,16 @@ PerfStats::Results System::GetAndResetPerfStats() {
                                   : PerfStats::Results{};
 }
 
+bool System::ExportFrameStatistics(const std::string& path) const {
+    return perf_stats && perf_stats->ExportFrameStatistics(path);
+}
+
+void System::ResetFrameStatistics() {
+    if (perf_stats) {
+        perf_stats->ResetFrameStatistics();
+    }
+}
+
 void System::Reschedule() {
     if (!reschedule_pending) {
         return;
@@ -364,11 +466,25 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window, u32 system_mo
     kernel = std::make_unique<Kernel::KernelSystem>(
         *memory, *timing, [this] { PrepareReschedule(); }, system_mode, num_cores, n3ds_mode);
 
+    // The interpreter accesses all memory through callbacks, so it wouldn't benefit from running
+    // the cores on their own threads, and the GDB stub expects a single running core
+    const bool use_cpu_threads = Settings::values.use_multi_core &&
+                                 Settings::values.use_cpu_jit && !GDBStub::IsServerEnabled();
+    if (Settings::values.use_multi_core && !use_cpu_threads) {
+        LOG_WARNING(Core, "Multi-core emulation requires the CPU JIT and no GDB stub");
+    }
+
     if (Settings::values.use_cpu_jit) {
 #if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+        // Cores running at the same time have to see the LDREX and STREX of each other
+        std::shared_ptr<Dynarmic::ExclusiveMonitor> exclusive_monitor;
+        if (use_cpu_threads) {
+            exclusive_monitor = std::make_shared<Dynarmic::ExclusiveMonitor>(num_cores);
+        }
         for (u32 i = 0; i < num_cores; ++i) {
-            cpu_cores.push_back(
-                std::make_shared<ARM_Dynarmic>(this, *memory, i, timing->GetTimer(i)));
+            cpu_cores.push_back(std::make_shared<ARM_Dynarmic>(this, *memory, i,
+                                                               timing->GetTimer(i),
+                                                               exclusive_monitor));
         }
 #else
         for (u32 i = 0; i < num_cores; ++i) {
@@ -388,6 +504,10 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window, u32 system_mo
     kernel->SetCPUs(cpu_cores);
     kernel->SetRunningCPU(cpu_cores[0].get());
 
+    if (use_cpu_threads) {
+        cpu_threads = std::make_unique<CPUThreads>(*this, num_cores);
+    }
+
     if (Settings::values.enable_dsp_lle) {
         dsp_core = std::make_unique<AudioCore::DspLle>(*memory,
                                                        Settings::values.enable_dsp_lle_multithread);
@@ -527,6 +647,23 @@ void System::Shutdown(bool is_deserializing) {
                                 perf_results.frametime * 1000.0);
     telemetry_session->AddField(Telemetry::FieldType::Performance, "Mean_Frametime_MS",
                                 perf_stats->GetMeanFrametime());
+    const auto frame_statistics = perf_stats->GetFrameStatistics();
+    telemetry_session->AddField(Telemetry::FieldType::Performance, "P99_Frametime_MS",
+                                frame_statistics.wall_time.p99);
+    telemetry_session->AddField(Telemetry::FieldType::Performance, "Stutters",
+                                frame_statistics.stutters);
+    LOG_INFO(Core,
+             "Frame time p50 {:.2f} ms, p95 {:.2f} ms, p99 {:.2f} ms, max {:.2f} ms, {} of {} "
+             "frames over {:.2f} ms",
+             frame_statistics.wall_time.p50, frame_statistics.wall_time.p95,
+             frame_statistics.wall_time.p99, frame_statistics.wall_time.max,
+             frame_statistics.stutters, frame_statistics.wall_time.frames,
+             frame_statistics.stutter_threshold);
+    for (const auto& cpu_core : cpu_cores) {
+        LOG_INFO(Core, "Core {} skipped {} ticks in idle loops", cpu_core->GetID(),
+                 cpu_core->GetTimer().GetIdleLoopSkippedTicks());
+    }
+    LOG_INFO(Core, "Page tables use {} KiB", memory->GetPageTableMemoryUsage() / 1024);
 
     // Shutdown emulation session
     VideoCore::Shutdown();
@@ -536,12 +673,25 @@ void System::Shutdown(bool is_deserializing) {
         perf_stats.reset();
         cheat_engine.reset();
         app_loader.reset();
+        if (num_rewind_captures != 0) {
+            const auto to_us = [](std::chrono::nanoseconds time) {
+                return std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+            };
+            LOG_INFO(Core, "Captured {} rewind snapshots in {} us on average, {} us at most",
+                     num_rewind_captures, to_us(rewind_capture_time) / num_rewind_captures,
+                     to_us(rewind_capture_max_time));
+        }
+        rewind_buffer.reset();
+        rewind_capture_time = {};
+        rewind_capture_max_time = {};
+        num_rewind_captures = 0;
     }
     telemetry_session.reset();
     rpc_server.reset();
     archive_manager.reset();
     service_manager.reset();
     dsp_core.reset();
+    cpu_threads.reset();
     cpu_cores.clear();
     kernel.reset();
     timing.reset();
@@ -579,6 +729,58 @@ void System::Reset() {
     }
 }
 
+void System::CaptureRewindSnapshot() {
+    const u64 frame = timing->GetGlobalTicks() / GPU::frame_ticks;
+    const auto newest_frame = rewind_buffer->GetNewestFrame();
+    // An earlier frame means that a save state was loaded, which starts a new timeline
+    if (newest_frame && frame >= *newest_frame && frame < *newest_frame + rewind_interval) {
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    try {
+        // The RAM is compared with the previous snapshot on worker threads while the rest of the
+        // state is serialized, so everything the GPU caches has to be in RAM before. Serializing
+        // flushes the rasterizer cache again, which then has nothing left to write back.
+        if (VideoCore::g_gpu_thread) {
+            VideoCore::g_gpu_thread->RetireAll();
+        }
+        Memory::RasterizerFlushAll();
+        rewind_buffer->BeginCapture(frame, RewindBuffer::GetSystemRegions(*memory));
+        rewind_buffer->FinishCapture(SerializeState(false));
+    } catch (const std::exception& e) {
+        LOG_ERROR(Core, "Disabling rewind, could not capture a snapshot: {}", e.what());
+        rewind_buffer.reset();
+        return;
+    }
+    const auto capture_time = std::chrono::steady_clock::now() - start;
+    rewind_capture_time += capture_time;
+    rewind_capture_max_time = std::max<std::chrono::nanoseconds>(rewind_capture_max_time,
+                                                                 capture_time);
+    ++num_rewind_captures;
+}
+
+void System::Rewind(u32 frames) {
+    if (!rewind_buffer) {
+        LOG_WARNING(Core, "Rewind is disabled");
+        return;
+    }
+    if (Network::GetRoomMember().lock()->IsConnected()) {
+        LOG_WARNING(Core, "Unable to rewind while connected to multiplayer");
+        return;
+    }
+
+    const u64 frame = timing->GetGlobalTicks() / GPU::frame_ticks;
+    auto state = rewind_buffer->Restore(frame > frames ? frame - frames : 0);
+    if (!state) {
+        LOG_WARNING(Core, "No snapshot is {} frames old", frames);
+        return;
+    }
+    DeserializeState(std::move(*state), false);
+    rewind_buffer->WriteMemory(RewindBuffer::GetSystemRegions(*memory));
+    LOG_INFO(Core, "Rewound from frame {} to frame {}", frame, *rewind_buffer->GetNewestFrame());
+}
+
 template <class Archive>
 void System::serialize(Archive& ar, const unsigned int file_version) {
 
@@ -599,9 +801,21 @@ void System::serialize(Archive& ar, const unsigned int file_version) {
         Init(*m_emu_window, *system_mode.first, *n3ds_mode.first, num_cores);
     }
 
+    // Interrupts of work still on the GPU thread are not part of the state, so signal them now
+    if (VideoCore::g_gpu_thread) {
+        VideoCore::g_gpu_thread->RetireAll();
+    }
+
     // flush on save, don't flush on load
-    bool should_flush = !Archive::is_loading::value;
-    Memory::RasterizerClearAll(should_flush);
+    if (Archive::is_loading::value) {
+        Memory::RasterizerClearAll(false);
+    } else if (!serialize_ram) {
+        // Rewind snapshots are captured every few frames. Clearing the rasterizer cache would make
+        // the next frames upload every surface again, so it is only written back to RAM.
+        Memory::RasterizerFlushAll();
+    } else {
+        Memory::RasterizerClearAll(true);
+    }
     ar&* timing.get();
     for (u32 i = 0; i < num_cores; i++) {
         ar&* cpu_cores[i].get();
@@ -620,6 +834,7 @@ void System::serialize(Archive& ar, const unsigned int file_version) {
         throw std::runtime_error("LLE audio not supported for save states");
     }
 
+    memory->SetSerializeRAM(serialize_ram);
     ar&* memory.get();
     ar&* kernel.get();
     VideoCore::serialize(ar, file_version);
@@ -631,8 +846,11 @@ void System::serialize(Archive& ar, const unsigned int file_version) {
     if (Archive::is_loading::value) {
         Service::GSP::SetGlobalModule(*this);
         memory->SetDSP(*dsp_core);
+        // The rasterizer cache is empty, but rewind snapshots still mark the pages it had cached
+        memory->RasterizerMarkRegionCached(Memory::VRAM_PADDR, Memory::VRAM_SIZE, false);
+        memory->RasterizerMarkRegionCached(Memory::FCRAM_PADDR, Memory::FCRAM_N3DS_SIZE, false);
         cheat_engine->Connect();
-        VideoCore::g_renderer->Sync();
+        VideoCore::RunOnGPUThread([] { VideoCore::g_renderer->Sync(); });
     }
 }
 
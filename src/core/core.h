@@ -4,9 +4,11 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 #include <boost/serialization/version.hpp>
 #include "common/common_types.h"
 #include "core/custom_tex_cache.h"
@@ -61,6 +63,8 @@ class RendererBase;
 
 namespace Core {
 
+class CPUThreads;
+class RewindBuffer;
 class Timing;
 
 class System {
@@ -120,7 +124,7 @@ public:
     /// Shutdown and then load again
     void Reset();
 
-    enum class Signal : u32 { None, Shutdown, Reset, Save, Load };
+    enum class Signal : u32 { None, Shutdown, Reset, Save, Load, Rewind };
 
     [[nodiscard]] bool SendSignal(Signal signal, u32 param = 0);
 
@@ -134,6 +138,11 @@ public:
         SendSignal(Signal::Shutdown);
     }
 
+    /// Request going back by at least the given number of frames, if rewinding is enabled
+    void RequestRewind(u32 frames) {
+        SendSignal(Signal::Rewind, frames);
+    }
+
     /**
      * Load an executable application.
      * @param emu_window Reference to the host-system window used for video output and keyboard
@@ -168,6 +177,15 @@ public:
 
     [[nodiscard]] PerfStats::Results GetAndResetPerfStats();
 
+    /**
+     * Writes the frame time statistics of the running emulation to a file.
+     * @return False if no emulation is running or the file could not be written
+     */
+    bool ExportFrameStatistics(const std::string& path) const;
+
+    /// Discards the frame times recorded so far, for example to skip a loading screen
+    void ResetFrameStatistics();
+
     /**
      * Gets a reference to the emulated CPU.
      * @returns A reference to the emulated CPU.
@@ -177,6 +195,17 @@ public:
         return *running_core;
     };
 
+    /// Makes the given core the one the kernel and HLE services act on behalf of
+    void SetRunningCore(ARM_Interface& core);
+
+    /**
+     * Gets the host threads the emulated cores run on, if they run in parallel.
+     * @returns A pointer to the CPU threads, or nullptr if the cores run on the emulation thread.
+     */
+    [[nodiscard]] CPUThreads* GetCPUThreads() const {
+        return cpu_threads.get();
+    }
+
     /**
      * Gets a reference to the emulated CPU.
      * @param core_id The id of the core requested.
@@ -305,7 +334,25 @@ public:
 
     void LoadState(u32 slot);
 
+    /// Serializes the emulated system into a compressed buffer
+    std::vector<u8> SaveStateBuffer() const;
+
+    /// Restores the emulated system from a buffer created by SaveStateBuffer
+    void LoadStateBuffer(std::vector<u8> buffer);
+
 private:
+    /// Serializes the emulated system, leaving out the contents of the emulated RAM if requested
+    std::vector<u8> SerializeState(bool include_ram) const;
+
+    /// Restores the emulated system from a buffer created by SerializeState
+    void DeserializeState(std::vector<u8> state, bool include_ram);
+
+    /// Adds a snapshot to the rewind buffer if the rewind interval has passed since the last one
+    void CaptureRewindSnapshot();
+
+    /// Restores the newest rewind snapshot that is at least the given number of frames old
+    void Rewind(u32 frames);
+
     /**
      * Initialize the emulated system.
      * @param emu_window Reference to the host-system window used for video output and keyboard
@@ -326,6 +373,9 @@ private:
     std::vector<std::shared_ptr<ARM_Interface>> cpu_cores;
     ARM_Interface* running_core = nullptr;
 
+    /// Host threads running the ARM11 cores in parallel, if enabled
+    std::unique_ptr<CPUThreads> cpu_threads;
+
     /// DSP core
     std::unique_ptr<AudioCore::DspInterface> dsp_core;
 
@@ -359,6 +409,19 @@ private:
 
     std::unique_ptr<Service::FS::ArchiveManager> archive_manager;
 
+    /// Snapshots to rewind to, if enabled
+    std::unique_ptr<RewindBuffer> rewind_buffer;
+    /// Frames between two rewind snapshots
+    u32 rewind_interval = 0;
+    /// Time spent capturing rewind snapshots, logged on shutdown
+    std::chrono::nanoseconds rewind_capture_time{};
+    std::chrono::nanoseconds rewind_capture_max_time{};
+    u64 num_rewind_captures = 0;
+
+    /// Whether the contents of the emulated RAM are serialized with the rest of the state. Rewind
+    /// snapshots leave them out, and only flush the rasterizer cache instead of clearing it.
+    mutable bool serialize_ram = true;
+
     std::unique_ptr<Memory::MemorySystem> memory;
     std::unique_ptr<Kernel::KernelSystem> kernel;
     std::unique_ptr<Timing> timing;
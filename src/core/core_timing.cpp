@@ -148,6 +148,10 @@ u64 Timing::Timer::GetIdleTicks() const {
     return static_cast<u64>(idled_cycles);
 }
 
+u64 Timing::Timer::GetIdleLoopSkippedTicks() const {
+    return idle_loop_skipped_cycles;
+}
+
 void Timing::Timer::ForceExceptionCheck(s64 cycles) {
     cycles = std::max<s64>(0, cycles);
     if (downcount > cycles) {
@@ -215,6 +219,14 @@ void Timing::Timer::Idle() {
     downcount = 0;
 }
 
+void Timing::Timer::SkipIdleLoop() {
+    // Counted apart from Idle(), so that skipped ticks are only reported once
+    if (downcount > 0) {
+        idle_loop_skipped_cycles += downcount;
+    }
+    downcount = 0;
+}
+
 s64 Timing::Timer::GetDowncount() const {
     return downcount;
 }
@@ -192,8 +192,12 @@ public:
 
         void Idle();
 
+        /// Skips the rest of the slice for a core that is spinning in an idle loop
+        void SkipIdleLoop();
+
         u64 GetTicks() const;
         u64 GetIdleTicks() const;
+        u64 GetIdleLoopSkippedTicks() const;
 
         void AddTicks(u64 ticks);
 
@@ -227,6 +231,8 @@ public:
         s64 downcount = MAX_SLICE_LENGTH;
         s64 executed_ticks = 0;
         u64 idled_cycles = 0;
+        // Total cycles skipped in idle loops, for statistics only
+        u64 idle_loop_skipped_cycles = 0;
         // Stores a scaling for the internal clockspeed. Changing this number results in
         // under/overclocking the guest cpu
         double cpu_clock_scale = 1.0;
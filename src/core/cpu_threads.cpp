@@ -0,0 +1,82 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "core/arm/arm_interface.h"
+#include "core/core.h"
+#include "core/cpu_threads.h"
+
+namespace Core {
+
+namespace {
+thread_local bool is_cpu_thread = false;
+} // Anonymous namespace
+
+MICROPROFILE_DEFINE(CPU_Requests, "CPU", "Serialized requests", MP_RGB(255, 128, 64));
+
+CPUThreads::CPUThreads(System& system, std::size_t num_cores)
+    : system{system}, workers{num_cores, "CPU"} {}
+
+CPUThreads::~CPUThreads() = default;
+
+void CPUThreads::RunSlice(const std::vector<ARM_Interface*>& cores) {
+    ASSERT(!is_cpu_thread);
+    if (cores.empty()) {
+        return;
+    }
+
+    running_cores = cores.size();
+    for (ARM_Interface* core : cores) {
+        workers.QueueWork([this, core] {
+            is_cpu_thread = true;
+            core->Run();
+
+            std::lock_guard lock{mutex};
+            if (--running_cores == 0) {
+                request_condition.notify_one();
+            }
+        });
+    }
+
+    std::unique_lock lock{mutex};
+    while (true) {
+        request_condition.wait(lock, [this] { return !requests.empty() || running_cores == 0; });
+        if (requests.empty()) {
+            break;
+        }
+
+        Request* request = requests.front();
+        requests.pop_front();
+        lock.unlock();
+        {
+            MICROPROFILE_SCOPE(CPU_Requests);
+            system.SetRunningCore(*request->core);
+            (*request->func)();
+        }
+        lock.lock();
+        request->done = true;
+        done_condition.notify_all();
+    }
+    lock.unlock();
+
+    // The counter is decremented before the task returns, so wait for the workers to be idle again
+    workers.WaitForRequests();
+}
+
+void CPUThreads::RunSerialized(ARM_Interface& core, const std::function<void()>& func) {
+    ASSERT(is_cpu_thread);
+    Request request{&core, &func, false};
+
+    std::unique_lock lock{mutex};
+    requests.push_back(&request);
+    request_condition.notify_one();
+    done_condition.wait(lock, [&request] { return request.done; });
+}
+
+bool CPUThreads::IsCPUThread() {
+    return is_cpu_thread;
+}
+
+} // namespace Core
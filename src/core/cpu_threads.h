@@ -0,0 +1,66 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "common/thread_worker.h"
+
+class ARM_Interface;
+
+namespace Core {
+
+class System;
+
+/**
+ * Runs the slices of the emulated ARM11 cores on separate host threads. The cores only run in
+ * parallel while inside their JIT: everything else they do, like SVCs and accesses to memory the
+ * JIT can't access directly, is forwarded to the emulation thread and handled there one request at
+ * a time, on behalf of the requesting core. The kernel, HLE services and the GPU therefore keep
+ * running on a single thread.
+ */
+class CPUThreads final {
+public:
+    CPUThreads(System& system, std::size_t num_cores);
+    ~CPUThreads();
+
+    /**
+     * Runs the current slice of every given core on its own host thread. Returns once all of them
+     * have used up their slice, servicing their requests in the meantime. Must be called from the
+     * emulation thread.
+     */
+    void RunSlice(const std::vector<ARM_Interface*>& cores);
+
+    /**
+     * Runs a function on the emulation thread on behalf of a core, blocking until it has finished.
+     * Must be called from a CPU thread.
+     */
+    void RunSerialized(ARM_Interface& core, const std::function<void()>& func);
+
+    /// Whether the calling host thread is running the slice of an emulated core
+    static bool IsCPUThread();
+
+private:
+    struct Request {
+        ARM_Interface* core;
+        const std::function<void()>* func;
+        bool done;
+    };
+
+    System& system;
+    Common::ThreadWorker workers;
+
+    std::mutex mutex;
+    std::condition_variable request_condition; ///< Signaled when a request is queued or a slice ends
+    std::condition_variable done_condition;    ///< Signaled when a request has been handled
+    std::deque<Request*> requests;
+    std::size_t running_cores = 0;
+};
+
+} // namespace Core
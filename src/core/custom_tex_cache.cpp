@@ -2,14 +2,61 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <bitset>
+#include <mutex>
+#include <thread>
 #include <fmt/format.h>
 #include "common/file_util.h"
 #include "common/texture.h"
+#include "common/thread_worker.h"
 #include "core.h"
 #include "core/custom_tex_cache.h"
 
 namespace Core {
-CustomTexCache::CustomTexCache() = default;
+
+static std::string GetTextureDirectory(u64 program_id) {
+    return fmt::format("{}textures/{:016X}/", FileUtil::GetUserPath(FileUtil::UserPath::LoadDir),
+                       program_id);
+}
+
+bool DecodeCustomTexture(Frontend::ImageInterface& image_interface, const std::string& path,
+                         CustomTexInfo& info) {
+    if (!image_interface.DecodePNG(info.tex, info.width, info.height, path)) {
+        LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path);
+        return false;
+    }
+
+    // Make sure the texture size is a power of 2
+    const std::bitset<32> width_bits(info.width);
+    const std::bitset<32> height_bits(info.height);
+    if (width_bits.count() != 1 || height_bits.count() != 1) {
+        LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path);
+        return false;
+    }
+
+    LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path);
+    Common::FlipRGBA8Texture(info.tex, info.width, info.height);
+    return true;
+}
+
+void DecodeCustomTextures(
+    Common::ThreadWorker& workers, Frontend::ImageInterface& image_interface,
+    const std::vector<CustomTexPathInfo>& textures,
+    const std::function<void(const CustomTexPathInfo&, CustomTexInfo&)>& callback) {
+    for (const auto& path_info : textures) {
+        workers.QueueWork([&image_interface, &callback, &path_info] {
+            CustomTexInfo info;
+            if (DecodeCustomTexture(image_interface, path_info.path, info)) {
+                callback(path_info, info);
+            }
+        });
+    }
+    workers.WaitForRequests();
+}
+
+CustomTexCache::CustomTexCache(std::size_t packed_cache_limit)
+    : packed_cache_limit(packed_cache_limit) {}
 
 CustomTexCache::~CustomTexCache() = default;
 
@@ -44,8 +91,7 @@ void CustomTexCache::FindCustomTextures(u64 program_id) {
     // Custom textures are currently stored as
     // [TitleID]/tex1_[width]x[height]_[64-bit hash]_[format].png
 
-    const std::string load_path = fmt::format(
-        "{}textures/{:016X}/", FileUtil::GetUserPath(FileUtil::UserPath::LoadDir), program_id);
+    const std::string load_path = GetTextureDirectory(program_id);
 
     if (FileUtil::Exists(load_path)) {
         FileUtil::FSTEntry texture_dir;
@@ -71,28 +117,78 @@ void CustomTexCache::FindCustomTextures(u64 program_id) {
             }
         }
     }
+
+    const std::string pack_path = load_path + CustomTexPack::FILE_NAME;
+    ClearPackedTextures();
+    if (FileUtil::Exists(pack_path) && texture_pack.Open(pack_path)) {
+        LOG_INFO(Render_OpenGL, "Opened texture pack with {} textures",
+                 texture_pack.NumTextures());
+    }
 }
 
 void CustomTexCache::PreloadTextures(Frontend::ImageInterface& image_interface) {
-    for (const auto& path : custom_texture_paths) {
-        const auto& path_info = path.second;
-        Core::CustomTexInfo tex_info;
-        if (image_interface.DecodePNG(tex_info.tex, tex_info.width, tex_info.height,
-                                      path_info.path)) {
-            // Make sure the texture size is a power of 2
-            std::bitset<32> width_bits(tex_info.width);
-            std::bitset<32> height_bits(tex_info.height);
-            if (width_bits.count() == 1 && height_bits.count() == 1) {
-                LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
-                Common::FlipRGBA8Texture(tex_info.tex, tex_info.width, tex_info.height);
-                CacheTexture(path_info.hash, tex_info.tex, tex_info.width, tex_info.height);
-            } else {
-                LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
-            }
-        } else {
-            LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
+    std::vector<CustomTexPathInfo> textures;
+    for (const auto& [hash, path_info] : custom_texture_paths) {
+        // Packed textures are paged in from the pack when they are used instead
+        if (!texture_pack.Contains(hash)) {
+            textures.push_back(path_info);
         }
     }
+
+    std::mutex cache_mutex;
+    DecodeCustomTextures(GetDecodeWorkers(), image_interface, textures,
+                         [this, &cache_mutex](const CustomTexPathInfo& path_info,
+                                              CustomTexInfo& info) {
+                             std::lock_guard lock{cache_mutex};
+                             custom_textures[path_info.hash] = std::move(info);
+                         });
+}
+
+bool CustomTexCache::LoadPackedTexture(u64 hash, CustomTexInfo& info) {
+    const auto it = packed_textures.find(hash);
+    if (it != packed_textures.end()) {
+        packed_lru.splice(packed_lru.begin(), packed_lru, it->second.lru_position);
+        info = it->second.info;
+        return true;
+    }
+
+    if (!texture_pack.Load(hash, info)) {
+        return false;
+    }
+
+    // Unlike preloaded textures, packs may hold more textures than fit in memory, so only the
+    // recently used ones are kept
+    packed_lru.push_front(hash);
+    packed_textures.emplace(hash, PackedTexture{info, packed_lru.begin()});
+    packed_textures_size += info.tex.size();
+    while (packed_textures_size > packed_cache_limit && packed_lru.size() > 1) {
+        const auto evicted = packed_textures.find(packed_lru.back());
+        packed_textures_size -= evicted->second.info.tex.size();
+        packed_textures.erase(evicted);
+        packed_lru.pop_back();
+    }
+    return true;
+}
+
+std::size_t CustomTexCache::GetPackedCacheSize() const {
+    return packed_textures_size;
+}
+
+std::size_t CustomTexCache::PackTextures(Frontend::ImageInterface& image_interface,
+                                         u64 program_id) {
+    std::vector<CustomTexPathInfo> textures;
+    for (const auto& [hash, path_info] : custom_texture_paths) {
+        textures.push_back(path_info);
+    }
+
+    // The pack being replaced must not stay mapped while it is rewritten
+    texture_pack.Close();
+    ClearPackedTextures();
+    const std::string pack_path = GetTextureDirectory(program_id) + CustomTexPack::FILE_NAME;
+    const std::size_t num_packed =
+        CustomTexPack::Create(pack_path, GetDecodeWorkers(), image_interface, textures);
+    texture_pack.Open(pack_path);
+    return num_packed;
 }
 
 bool CustomTexCache::CustomTextureExists(u64 hash) const {
@@ -106,4 +202,18 @@ const CustomTexPathInfo& CustomTexCache::LookupTexturePathInfo(u64 hash) const {
 bool CustomTexCache::IsTexturePathMapEmpty() const {
     return custom_texture_paths.size() == 0;
 }
+
+void CustomTexCache::ClearPackedTextures() {
+    packed_textures.clear();
+    packed_lru.clear();
+    packed_textures_size = 0;
+}
+
+Common::ThreadWorker& CustomTexCache::GetDecodeWorkers() {
+    if (!decode_workers) {
+        decode_workers = std::make_unique<Common::ThreadWorker>(
+            std::max(std::thread::hardware_concurrency(), 1u), "CustomTexDecode");
+    }
+    return *decode_workers;
+}
 } // namespace Core
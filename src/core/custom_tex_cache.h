@@ -4,11 +4,20 @@
 
 #pragma once
 
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include "common/common_types.h"
+#include "core/custom_tex_pack.h"
+
+namespace Common {
+class ThreadWorker;
+} // namespace Common
 
 namespace Frontend {
 class ImageInterface;
@@ -27,10 +36,35 @@ struct CustomTexPathInfo {
     u64 hash;
 };
 
+/**
+ * Decodes a custom texture from a PNG file and flips it for upload.
+ * @return True if the texture was decoded and its size is a power of 2, otherwise false
+ */
+bool DecodeCustomTexture(Frontend::ImageInterface& image_interface, const std::string& path,
+                         CustomTexInfo& info);
+
+/**
+ * Decodes custom textures from PNG files on a pool of worker threads.
+ * @param workers Worker threads to decode the textures on. Returns once all of its work is done.
+ * @param callback Called with each successfully decoded texture. It is called from the worker
+ * threads, so it must be thread-safe.
+ */
+void DecodeCustomTextures(
+    Common::ThreadWorker& workers, Frontend::ImageInterface& image_interface,
+    const std::vector<CustomTexPathInfo>& textures,
+    const std::function<void(const CustomTexPathInfo&, CustomTexInfo&)>& callback);
+
 // TODO: think of a better name for this class...
 class CustomTexCache {
 public:
-    explicit CustomTexCache();
+    /// Default limit of the memory used by decompressed packed textures
+    static constexpr std::size_t DefaultPackedCacheLimit = 256 * 1024 * 1024;
+
+    /**
+     * @param packed_cache_limit Limit of the memory used by decompressed packed textures. The least
+     * recently used ones are dropped beyond it, and decompressed again from the pack when needed.
+     */
+    explicit CustomTexCache(std::size_t packed_cache_limit = DefaultPackedCacheLimit);
     ~CustomTexCache();
 
     bool IsTextureDumped(u64 hash) const;
@@ -43,13 +77,34 @@ public:
     void AddTexturePath(u64 hash, const std::string& path);
     void FindCustomTextures(u64 program_id);
     void PreloadTextures(Frontend::ImageInterface& image_interface);
+    bool LoadPackedTexture(u64 hash, CustomTexInfo& info);
+    /// Returns the memory used by the decompressed packed textures that are kept
+    std::size_t GetPackedCacheSize() const;
+    std::size_t PackTextures(Frontend::ImageInterface& image_interface, u64 program_id);
     bool CustomTextureExists(u64 hash) const;
     const CustomTexPathInfo& LookupTexturePathInfo(u64 hash) const;
     bool IsTexturePathMapEmpty() const;
 
 private:
+    struct PackedTexture {
+        CustomTexInfo info;
+        std::list<u64>::iterator lru_position;
+    };
+
+    Common::ThreadWorker& GetDecodeWorkers();
+    void ClearPackedTextures();
+
     std::unordered_set<u64> dumped_textures;
     std::unordered_map<u64, CustomTexInfo> custom_textures;
     std::unordered_map<u64, CustomTexPathInfo> custom_texture_paths;
+    CustomTexPack texture_pack;
+    /// Decompressed packed textures, kept so that they aren't unpacked every time they are used
+    std::unordered_map<u64, PackedTexture> packed_textures;
+    /// Hashes of the decompressed packed textures, from the most to the least recently used
+    std::list<u64> packed_lru;
+    std::size_t packed_textures_size = 0;
+    const std::size_t packed_cache_limit;
+    /// Created on first use, so that no threads are started when custom textures are unused
+    std::unique_ptr<Common::ThreadWorker> decode_workers;
 };
 } // namespace Core
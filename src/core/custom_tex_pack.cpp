@@ -0,0 +1,218 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <mutex>
+#include "common/logging/log.h"
+#include "common/swap.h"
+#include "common/zstd_compression.h"
+#include "core/custom_tex_cache.h"
+#include "core/custom_tex_pack.h"
+
+namespace Core {
+
+namespace {
+
+constexpr std::array<u8, 4> PACK_MAGIC{{'C', 'T', 'P', 0x1A}};
+constexpr u32 PACK_VERSION = 1;
+
+enum class Compression : u32 {
+    None = 0,
+    Zstd = 1,
+};
+
+struct PackHeader {
+    std::array<u8, 4> magic;
+    u32_le version;
+    u32_le num_entries;
+    u32_le reserved;
+    u64_le index_offset;
+};
+static_assert(sizeof(PackHeader) == 24, "PackHeader has incorrect size");
+
+} // Anonymous namespace
+
+struct CustomTexPack::PackEntry {
+    u64_le hash;
+    u32_le width;
+    u32_le height;
+    u64_le offset;
+    u32_le size;
+    enum_le<Compression> compression;
+};
+
+CustomTexPack::CustomTexPack() = default;
+
+CustomTexPack::~CustomTexPack() = default;
+
+bool CustomTexPack::Open(const std::string& path) {
+    static_assert(sizeof(PackEntry) == 32, "PackEntry has incorrect size");
+
+    Close();
+    if (!file.Open(path)) {
+        return false;
+    }
+
+    PackHeader header;
+    if (file.Size() < sizeof(header)) {
+        LOG_ERROR(Render_OpenGL, "Texture pack {} is too small", path);
+        Close();
+        return false;
+    }
+    std::memcpy(&header, file.Data(), sizeof(header));
+
+    const u64 index_size = static_cast<u64>(header.num_entries) * sizeof(PackEntry);
+    if (header.magic != PACK_MAGIC || header.version != PACK_VERSION ||
+        header.index_offset % alignof(PackEntry) != 0 || header.index_offset > file.Size() ||
+        index_size > file.Size() - header.index_offset) {
+        LOG_ERROR(Render_OpenGL, "Texture pack {} is invalid", path);
+        Close();
+        return false;
+    }
+
+    entries = reinterpret_cast<const PackEntry*>(file.Data() + header.index_offset);
+    num_entries = header.num_entries;
+    return true;
+}
+
+void CustomTexPack::Close() {
+    file.Close();
+    entries = nullptr;
+    num_entries = 0;
+}
+
+bool CustomTexPack::Contains(u64 hash) const {
+    return FindEntry(hash) != nullptr;
+}
+
+bool CustomTexPack::Load(u64 hash, CustomTexInfo& info) const {
+    const PackEntry* entry = FindEntry(hash);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    const std::size_t tex_size = static_cast<std::size_t>(entry->width) * entry->height * 4;
+    if (entry->offset > file.Size() || entry->size > file.Size() - entry->offset) {
+        LOG_ERROR(Render_OpenGL, "Packed texture {:016X} is out of bounds", hash);
+        return false;
+    }
+
+    const u8* data = file.Data() + entry->offset;
+    switch (entry->compression) {
+    case Compression::None:
+        info.tex.assign(data, data + entry->size);
+        break;
+    case Compression::Zstd:
+        info.tex = Common::Compression::DecompressDataZSTD(data, entry->size);
+        break;
+    default:
+        info.tex.clear();
+        break;
+    }
+
+    if (info.tex.size() != tex_size) {
+        LOG_ERROR(Render_OpenGL, "Packed texture {:016X} is corrupted", hash);
+        return false;
+    }
+    info.width = entry->width;
+    info.height = entry->height;
+    return true;
+}
+
+const CustomTexPack::PackEntry* CustomTexPack::FindEntry(u64 hash) const {
+    const PackEntry* end = entries + num_entries;
+    const PackEntry* entry = std::lower_bound(
+        entries, end, hash, [](const PackEntry& entry, u64 hash) { return entry.hash < hash; });
+    return entry != end && entry->hash == hash ? entry : nullptr;
+}
+
+std::size_t CustomTexPack::Create(const std::string& path, Common::ThreadWorker& workers,
+                                  Frontend::ImageInterface& image_interface,
+                                  const std::vector<CustomTexPathInfo>& textures) {
+    // Write to a temporary file first so that an interrupted write never leaves a truncated pack
+    const std::string temp_path = path + ".tmp";
+    FileUtil::IOFile file(temp_path, "wb");
+    PackHeader header{};
+    if (file.WriteObject(header) != 1) {
+        LOG_ERROR(Render_OpenGL, "Failed to create texture pack {}", temp_path);
+        return 0;
+    }
+
+    std::vector<PackEntry> entries;
+    std::mutex file_mutex;
+    bool write_failed = false;
+    DecodeCustomTextures(workers, image_interface, textures, [&](const CustomTexPathInfo& path_info,
+                                                                 CustomTexInfo& info) {
+        std::vector<u8> compressed =
+            Common::Compression::CompressDataZSTDDefault(info.tex.data(), info.tex.size());
+        const bool use_compression = compressed.size() < info.tex.size();
+        const std::vector<u8>& data = use_compression ? compressed : info.tex;
+
+        std::lock_guard lock{file_mutex};
+        if (write_failed) {
+            return;
+        }
+        PackEntry entry;
+        entry.hash = path_info.hash;
+        entry.width = info.width;
+        entry.height = info.height;
+        entry.offset = file.Tell();
+        entry.size = static_cast<u32>(data.size());
+        entry.compression = use_compression ? Compression::Zstd : Compression::None;
+        if (file.WriteBytes(data.data(), data.size()) != data.size()) {
+            write_failed = true;
+            return;
+        }
+        entries.push_back(entry);
+    });
+
+    if (entries.empty() && !write_failed) {
+        LOG_ERROR(Render_OpenGL, "No custom textures could be packed");
+        file.Close();
+        FileUtil::Delete(temp_path);
+        return 0;
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const PackEntry& a, const PackEntry& b) { return a.hash < b.hash; });
+
+    // Align the index so that it can be accessed in place
+    const std::array<u8, alignof(PackEntry)> padding{};
+    const std::size_t padding_size =
+        (alignof(PackEntry) - file.Tell() % alignof(PackEntry)) % alignof(PackEntry);
+    if (file.WriteBytes(padding.data(), padding_size) != padding_size) {
+        write_failed = true;
+    }
+
+    header.magic = PACK_MAGIC;
+    header.version = PACK_VERSION;
+    header.num_entries = static_cast<u32>(entries.size());
+    header.index_offset = file.Tell();
+    if (file.WriteArray(entries.data(), entries.size()) != entries.size() ||
+        !file.Seek(0, SEEK_SET) || file.WriteObject(header) != 1) {
+        write_failed = true;
+    }
+
+    if (write_failed || !file.Flush() || !file.IsGood()) {
+        LOG_ERROR(Render_OpenGL, "Failed to write texture pack {}", temp_path);
+        file.Close();
+        FileUtil::Delete(temp_path);
+        return 0;
+    }
+    file.Close();
+
+    if (!FileUtil::RenameReplacing(temp_path, path)) {
+        LOG_ERROR(Render_OpenGL, "Failed to move texture pack into place at {}", path);
+        FileUtil::Delete(temp_path);
+        return 0;
+    }
+
+    LOG_INFO(Render_OpenGL, "Packed {} of {} custom textures into {}", entries.size(),
+             textures.size(), path);
+    return entries.size();
+}
+
+} // namespace Core
@@ -0,0 +1,90 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+
+namespace Common {
+class ThreadWorker;
+} // namespace Common
+
+namespace Frontend {
+class ImageInterface;
+} // namespace Frontend
+
+namespace Core {
+
+struct CustomTexInfo;
+struct CustomTexPathInfo;
+
+/**
+ * A set of custom textures packed into a single file. The file contains the pixel data of every
+ * texture as raw or zstd compressed RGBA8, already flipped for upload, followed by an index of the
+ * texture hashes sorted for binary search. The file is memory-mapped, so a texture is only paged
+ * in when it is loaded instead of the whole pack being held in memory.
+ */
+class CustomTexPack {
+public:
+    /// Name of the pack file in the custom texture directory of a title
+    static constexpr const char* FILE_NAME = "textures.pack";
+
+    CustomTexPack();
+    ~CustomTexPack();
+
+    /**
+     * Opens a texture pack.
+     * @param path Path of the pack file
+     * @return True if the pack was opened and its index is valid, otherwise false
+     */
+    bool Open(const std::string& path);
+
+    void Close();
+
+    [[nodiscard]] bool IsOpen() const {
+        return file.IsOpen();
+    }
+
+    [[nodiscard]] std::size_t NumTextures() const {
+        return num_entries;
+    }
+
+    [[nodiscard]] bool Contains(u64 hash) const;
+
+    /**
+     * Loads a texture from the pack.
+     * @param hash Hash of the texture
+     * @param info Texture info to load the texture into
+     * @return True if the texture was found and is valid, otherwise false
+     */
+    bool Load(u64 hash, CustomTexInfo& info) const;
+
+    /**
+     * Creates a texture pack from PNG custom textures. The textures are decoded and compressed on a
+     * pool of worker threads, and written to the pack as soon as they are ready.
+     * @param path Path of the pack file to create
+     * @param workers Worker threads used to decode and compress the textures
+     * @param image_interface Image interface used to decode the textures
+     * @param textures Textures to pack
+     * @return The number of packed textures, or 0 if no pack was written
+     */
+    static std::size_t Create(const std::string& path, Common::ThreadWorker& workers,
+                              Frontend::ImageInterface& image_interface,
+                              const std::vector<CustomTexPathInfo>& textures);
+
+private:
+    struct PackEntry;
+
+    const PackEntry* FindEntry(u64 hash) const;
+
+    FileUtil::MappedFile file;
+    const PackEntry* entries = nullptr;
+    std::size_t num_entries = 0;
+};
+
+} // namespace Core
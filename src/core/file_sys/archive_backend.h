@@ -186,6 +186,11 @@ public:
      */
     virtual u64 GetFreeBytes() const = 0;
 
+    /**
+     * Commit pending changes of the archive to the host file system
+     */
+    virtual void Commit() const {}
+
     u64 GetOpenDelayNs() {
         if (delay_generator != nullptr) {
             return delay_generator->GetOpenDelayNs();
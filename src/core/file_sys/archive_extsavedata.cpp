@@ -31,8 +31,9 @@ namespace FileSys {
 class FixSizeDiskFile : public DiskFile {
 public:
     FixSizeDiskFile(FileUtil::IOFile&& file, const Mode& mode,
-                    std::unique_ptr<DelayGenerator> delay_generator_)
-        : DiskFile(std::move(file), mode, std::move(delay_generator_)) {
+                    std::unique_ptr<DelayGenerator> delay_generator_,
+                    std::shared_ptr<WriteBackBuffer> write_back_)
+        : DiskFile(std::move(file), mode, std::move(delay_generator_), std::move(write_back_)) {
         size = GetSize();
     }
 
@@ -156,7 +157,8 @@ public:
         std::unique_ptr<DelayGenerator> delay_generator =
             std::make_unique<ExtSaveDataDelayGenerator>();
         auto disk_file =
-            std::make_unique<FixSizeDiskFile>(std::move(file), rwmode, std::move(delay_generator));
+            std::make_unique<FixSizeDiskFile>(std::move(file), rwmode, std::move(delay_generator),
+                                              GetWriteBackBuffer(full_path));
         return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
     }
 
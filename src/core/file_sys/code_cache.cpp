@@ -0,0 +1,107 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "common/swap.h"
+#include "common/zstd_compression.h"
+#include "core/file_sys/code_cache.h"
+
+namespace FileSys::CodeCache {
+
+namespace {
+
+constexpr std::array<u8, 4> CACHE_MAGIC{{'C', 'C', 'C', 0x1B}};
+constexpr u32 CACHE_VERSION = 1;
+
+struct CacheHeader {
+    std::array<u8, 4> magic;
+    u32_le version;
+    u64_le decompressed_size;
+    u64_le decompressed_hash;
+};
+static_assert(sizeof(CacheHeader) == 24, "CacheHeader has incorrect size");
+
+} // Anonymous namespace
+
+std::string GetCachePath(u64 title_id, u64 ncch_hash, u64 patch_hash) {
+    return fmt::format("{}code" DIR_SEP "{:016X}" DIR_SEP "{:016X}-{:016X}.bin",
+                       FileUtil::GetUserPath(FileUtil::UserPath::CacheDir), title_id, ncch_hash,
+                       patch_hash);
+}
+
+bool Load(const std::string& path, std::vector<u8>& code) {
+    FileUtil::IOFile file(path, "rb");
+    if (!file.IsOpen()) {
+        return false;
+    }
+
+    CacheHeader header;
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != CACHE_MAGIC || header.version != CACHE_VERSION) {
+        LOG_WARNING(Service_FS, "Ignoring invalid code cache file {}", path);
+        return false;
+    }
+
+    std::vector<u8> compressed(file.GetSize() - sizeof(header));
+    if (file.ReadBytes(compressed.data(), compressed.size()) != compressed.size()) {
+        LOG_WARNING(Service_FS, "Failed to read code cache file {}", path);
+        return false;
+    }
+
+    std::vector<u8> decompressed = Common::Compression::DecompressDataZSTD(compressed);
+    if (decompressed.size() != header.decompressed_size ||
+        Common::ComputeHash64(decompressed.data(), decompressed.size()) !=
+            header.decompressed_hash) {
+        LOG_WARNING(Service_FS, "Code cache file {} is corrupted", path);
+        return false;
+    }
+
+    code = std::move(decompressed);
+    return true;
+}
+
+void Store(const std::string& path, const std::vector<u8>& code) {
+    if (!FileUtil::CreateFullPath(path)) {
+        LOG_ERROR(Service_FS, "Failed to create code cache directory for {}", path);
+        return;
+    }
+
+    CacheHeader header;
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.decompressed_size = code.size();
+    header.decompressed_hash = Common::ComputeHash64(code.data(), code.size());
+
+    const std::vector<u8> compressed =
+        Common::Compression::CompressDataZSTDDefault(code.data(), code.size());
+
+    // Write to a temporary file first so that an interrupted write never leaves a truncated entry
+    const std::string temp_path = path + ".tmp";
+    {
+        FileUtil::IOFile file(temp_path, "wb");
+        if (file.WriteBytes(&header, sizeof(header)) != sizeof(header) ||
+            file.WriteBytes(compressed.data(), compressed.size()) != compressed.size()) {
+            LOG_ERROR(Service_FS, "Failed to write code cache file {}", temp_path);
+            file.Close();
+            FileUtil::Delete(temp_path);
+            return;
+        }
+    }
+
+    if (!FileUtil::Rename(temp_path, path)) {
+        LOG_ERROR(Service_FS, "Failed to move code cache file into place at {}", path);
+        FileUtil::Delete(temp_path);
+        return;
+    }
+
+    LOG_DEBUG(Service_FS, "Stored code image ({} bytes, {} compressed) in {}", code.size(),
+              compressed.size(), path);
+}
+
+} // namespace FileSys::CodeCache
@@ -0,0 +1,38 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+namespace FileSys::CodeCache {
+
+/**
+ * Gets the path of the cached code image for the given key. The cache is content-addressed, so a
+ * changed NCCH or patch simply results in a different file name.
+ * @param title_id Title ID of the application
+ * @param ncch_hash Hash identifying the NCCH contents the code was loaded from
+ * @param patch_hash Hash of the applied code patch, or 0 if none was applied
+ * @return Path of the cache file
+ */
+std::string GetCachePath(u64 title_id, u64 ncch_hash, u64 patch_hash);
+
+/**
+ * Loads a code image from the cache.
+ * @param path Path of the cache file, as returned by GetCachePath
+ * @param code Vector to read the decompressed and patched code image into
+ * @return True if the image was found and is valid, otherwise false
+ */
+bool Load(const std::string& path, std::vector<u8>& code);
+
+/**
+ * Stores a code image in the cache. Failures are logged and otherwise ignored.
+ * @param path Path of the cache file, as returned by GetCachePath
+ * @param code The decompressed and patched code image
+ */
+void Store(const std::string& path, const std::vector<u8>& code);
+
+} // namespace FileSys::CodeCache
@@ -4,11 +4,16 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <memory>
+#include <fmt/format.h>
 #include "common/archives.h"
+#include "common/common_paths.h"
 #include "common/common_types.h"
 #include "common/file_util.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
+#include "common/thread.h"
 #include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
 
@@ -20,11 +25,232 @@ SERIALIZE_EXPORT_IMPL(FileSys::DiskDirectory)
 
 namespace FileSys {
 
+WriteBackBuffer::WriteBackBuffer(std::string path_, std::string temp_path_, std::vector<u8> data_)
+    : path(std::move(path_)), temp_path(std::move(temp_path_)), data(std::move(data_)) {}
+
+WriteBackBuffer::~WriteBackBuffer() {
+    Flush();
+}
+
+std::size_t WriteBackBuffer::Read(u64 offset, std::size_t length, u8* buffer) const {
+    std::lock_guard lock{mutex};
+    if (offset >= data.size()) {
+        return 0;
+    }
+    length = std::min<std::size_t>(length, data.size() - offset);
+    std::memcpy(buffer, data.data() + offset, length);
+    return length;
+}
+
+std::size_t WriteBackBuffer::Write(u64 offset, std::size_t length, const u8* buffer) {
+    std::lock_guard lock{mutex};
+    if (offset + length > data.size()) {
+        data.resize(offset + length);
+    }
+    std::memcpy(data.data() + offset, buffer, length);
+    if (!dirty) {
+        dirty = true;
+        dirty_since = std::chrono::steady_clock::now();
+    }
+    return length;
+}
+
+u64 WriteBackBuffer::GetSize() const {
+    std::lock_guard lock{mutex};
+    return data.size();
+}
+
+void WriteBackBuffer::SetSize(u64 size) {
+    std::lock_guard lock{mutex};
+    data.resize(size);
+    if (!dirty) {
+        dirty = true;
+        dirty_since = std::chrono::steady_clock::now();
+    }
+}
+
+bool WriteBackBuffer::Flush() {
+    std::lock_guard lock{mutex};
+    return FlushLocked();
+}
+
+void WriteBackBuffer::FlushIfStale(std::chrono::steady_clock::time_point now,
+                                   std::chrono::milliseconds flush_interval) {
+    std::lock_guard lock{mutex};
+    if (dirty && now - dirty_since >= flush_interval) {
+        FlushLocked();
+    }
+}
+
+void WriteBackBuffer::Move(std::string path_, std::string temp_path_) {
+    std::lock_guard lock{mutex};
+    path = std::move(path_);
+    temp_path = std::move(temp_path_);
+}
+
+void WriteBackBuffer::Discard() {
+    std::lock_guard lock{mutex};
+    discarded = true;
+    dirty = false;
+}
+
+bool WriteBackBuffer::FlushLocked() {
+    if (!dirty || discarded) {
+        return true;
+    }
+
+    {
+        FileUtil::IOFile temp_file(temp_path, "wb");
+        if (!temp_file.IsOpen() ||
+            temp_file.WriteBytes(data.data(), data.size()) != data.size() || !temp_file.Flush()) {
+            LOG_ERROR(Service_FS, "Failed to write back {} through {}", path, temp_path);
+            temp_file.Close();
+            FileUtil::Delete(temp_path);
+            return false;
+        }
+    }
+
+    if (!FileUtil::RenameReplacing(temp_path, path)) {
+        LOG_ERROR(Service_FS, "Failed to replace {} with {}", path, temp_path);
+        return false;
+    }
+
+    LOG_TRACE(Service_FS, "Wrote back {} bytes to {}", data.size(), path);
+    dirty = false;
+    return true;
+}
+
+WriteBackCache::WriteBackCache(std::string temp_dir_, std::chrono::milliseconds flush_interval_)
+    : temp_dir(std::move(temp_dir_)), flush_interval(flush_interval_) {}
+
+WriteBackCache::~WriteBackCache() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    stop_condition.notify_all();
+    if (flush_thread.joinable()) {
+        flush_thread.join();
+    }
+    Flush();
+}
+
+std::shared_ptr<WriteBackBuffer> WriteBackCache::Open(const std::string& path) {
+    std::lock_guard lock{mutex};
+    auto& entry = buffers[path];
+    if (auto buffer = entry.lock()) {
+        return buffer;
+    }
+
+    FileUtil::IOFile file(path, "rb");
+    if (!file.IsOpen()) {
+        return nullptr;
+    }
+    std::vector<u8> data(file.GetSize());
+    if (file.ReadBytes(data.data(), data.size()) != data.size()) {
+        LOG_ERROR(Service_FS, "Failed to read {} into the write-back cache", path);
+        return nullptr;
+    }
+
+    auto buffer = std::make_shared<WriteBackBuffer>(path, GetTempPath(path), std::move(data));
+    entry = buffer;
+    if (!flush_thread.joinable()) {
+        flush_thread = std::thread(&WriteBackCache::FlushThread, this);
+    }
+    return buffer;
+}
+
+void WriteBackCache::Flush() {
+    std::lock_guard lock{mutex};
+    for (auto it = buffers.begin(); it != buffers.end();) {
+        if (auto buffer = it->second.lock()) {
+            buffer->Flush();
+            ++it;
+        } else {
+            it = buffers.erase(it);
+        }
+    }
+}
+
+/// Whether a host path is the given file or directory, or lies under it
+static bool IsSameOrUnder(const std::string& path, const std::string& parent) {
+    return path.compare(0, parent.size(), parent) == 0 &&
+           (path.size() == parent.size() || path[parent.size()] == DIR_SEP_CHR);
+}
+
+void WriteBackCache::Move(const std::string& src_path, const std::string& dest_path) {
+    const std::string src{FileUtil::RemoveTrailingSlash(src_path)};
+    const std::string dest{FileUtil::RemoveTrailingSlash(dest_path)};
+    std::lock_guard lock{mutex};
+    std::unordered_map<std::string, std::weak_ptr<WriteBackBuffer>> moved;
+    for (auto it = buffers.begin(); it != buffers.end();) {
+        if (!IsSameOrUnder(it->first, src)) {
+            ++it;
+            continue;
+        }
+        if (auto buffer = it->second.lock()) {
+            const std::string path = dest + it->first.substr(src.size());
+            buffer->Move(path, GetTempPath(path));
+            moved.emplace(path, buffer);
+        }
+        it = buffers.erase(it);
+    }
+    buffers.merge(moved);
+}
+
+void WriteBackCache::Remove(const std::string& path) {
+    const std::string removed{FileUtil::RemoveTrailingSlash(path)};
+    std::lock_guard lock{mutex};
+    for (auto it = buffers.begin(); it != buffers.end();) {
+        if (!IsSameOrUnder(it->first, removed)) {
+            ++it;
+            continue;
+        }
+        if (auto buffer = it->second.lock()) {
+            buffer->Discard();
+        }
+        it = buffers.erase(it);
+    }
+}
+
+std::string WriteBackCache::GetTempPath(const std::string& path) const {
+    return fmt::format("{}.writeback-{:016X}.tmp", temp_dir,
+                       Common::ComputeHash64(path.data(), path.size()));
+}
+
+void WriteBackCache::FlushThread() {
+    Common::SetCurrentThreadName("WriteBackCache");
+    // Looks for stale buffers often enough that they are written back soon after becoming stale
+    const auto check_interval = flush_interval / 4;
+    std::unique_lock lock{mutex};
+    while (!stop_condition.wait_for(lock, check_interval, [this] { return stop; })) {
+        std::vector<std::shared_ptr<WriteBackBuffer>> open_buffers;
+        for (const auto& [path, weak_buffer] : buffers) {
+            if (auto buffer = weak_buffer.lock()) {
+                open_buffers.push_back(std::move(buffer));
+            }
+        }
+
+        // Writing back doesn't block the guest opening other files of the archive
+        lock.unlock();
+        const auto now = std::chrono::steady_clock::now();
+        for (const auto& buffer : open_buffers) {
+            buffer->FlushIfStale(now, flush_interval);
+        }
+        open_buffers.clear();
+        lock.lock();
+    }
+}
+
 ResultVal<std::size_t> DiskFile::Read(const u64 offset, const std::size_t length,
                                       u8* buffer) const {
     if (!mode.read_flag)
         return ERROR_INVALID_OPEN_FLAGS;
 
+    if (write_back) {
+        return MakeResult<std::size_t>(write_back->Read(offset, length, buffer));
+    }
+
     file->Seek(offset, SEEK_SET);
     return MakeResult<std::size_t>(file->ReadBytes(buffer, length));
 }
@@ -34,6 +260,12 @@ ResultVal<std::size_t> DiskFile::Write(const u64 offset, const std::size_t lengt
     if (!mode.write_flag)
         return ERROR_INVALID_OPEN_FLAGS;
 
+    // The flush flag is deliberately ignored for write-back files, whose changes are written back
+    // when the file is closed, when the archive is committed or when they become stale.
+    if (write_back) {
+        return MakeResult<std::size_t>(write_back->Write(offset, length, buffer));
+    }
+
     file->Seek(offset, SEEK_SET);
     std::size_t written = file->WriteBytes(buffer, length);
     if (flush)
@@ -42,19 +274,36 @@ ResultVal<std::size_t> DiskFile::Write(const u64 offset, const std::size_t lengt
 }
 
 u64 DiskFile::GetSize() const {
+    if (write_back) {
+        return write_back->GetSize();
+    }
     return file->GetSize();
 }
 
 bool DiskFile::SetSize(const u64 size) const {
+    if (write_back) {
+        write_back->SetSize(size);
+        return true;
+    }
     file->Resize(size);
     file->Flush();
     return true;
 }
 
 bool DiskFile::Close() const {
+    if (write_back) {
+        return write_back->Flush();
+    }
     return file->Close();
 }
 
+void DiskFile::Flush() const {
+    if (write_back) {
+        return;
+    }
+    file->Flush();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 DiskDirectory::DiskDirectory(const std::string& path) {
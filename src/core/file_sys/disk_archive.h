@@ -4,9 +4,14 @@
 
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/unique_ptr.hpp>
@@ -23,6 +28,103 @@
 
 namespace FileSys {
 
+/**
+ * In-memory copy of a host file that coalesces writes to it. It is shared by every DiskFile of an
+ * archive which has the file open. Pending writes are written back by writing the whole file to a
+ * temporary file and renaming it over the original, so the host file is never left half-written.
+ */
+class WriteBackBuffer {
+public:
+    WriteBackBuffer(std::string path, std::string temp_path, std::vector<u8> data);
+    ~WriteBackBuffer();
+
+    std::size_t Read(u64 offset, std::size_t length, u8* buffer) const;
+    std::size_t Write(u64 offset, std::size_t length, const u8* buffer);
+    u64 GetSize() const;
+    void SetSize(u64 size);
+
+    /**
+     * Writes pending changes back to the host file
+     * @return true if there were no pending changes or they were written successfully
+     */
+    bool Flush();
+
+    /// Writes pending changes back if they are older than the given interval
+    void FlushIfStale(std::chrono::steady_clock::time_point now,
+                      std::chrono::milliseconds flush_interval);
+
+    /// Points the buffer to the new location of its file after it was renamed on the host
+    void Move(std::string path, std::string temp_path);
+
+    /// Stops writing back, for a file that was deleted on the host
+    void Discard();
+
+private:
+    bool FlushLocked();
+
+    mutable std::mutex mutex;
+    std::string path;
+    std::string temp_path;
+    std::vector<u8> data;
+    bool dirty = false;
+    bool discarded = false;
+    std::chrono::steady_clock::time_point dirty_since;
+};
+
+/// Per-archive registry of the write-back buffers of its open files, keyed by host path.
+class WriteBackCache {
+public:
+    /// Default age of pending writes at which they are written back
+    static constexpr std::chrono::milliseconds DefaultFlushInterval{2000};
+
+    /**
+     * @param temp_dir Directory for temporary files. It must be on the same host file system as
+     * the archive but outside of the part visible to the guest.
+     * @param flush_interval Pending writes are written back once they are older than this
+     */
+    explicit WriteBackCache(std::string temp_dir,
+                            std::chrono::milliseconds flush_interval = DefaultFlushInterval);
+    ~WriteBackCache();
+
+    /**
+     * Gets the write-back buffer of a host file, loading the file if it isn't cached yet.
+     * @param path Host path of the file
+     * @return The buffer, or nullptr if the file couldn't be read
+     */
+    std::shared_ptr<WriteBackBuffer> Open(const std::string& path);
+
+    /// Writes back the pending changes of every file in the archive.
+    void Flush();
+
+    /**
+     * Follows a rename of a file or directory on the host, which must happen after a Flush.
+     * Buffers of files at the old path and under it are moved to the new path.
+     */
+    void Move(const std::string& src_path, const std::string& dest_path);
+
+    /**
+     * Follows a deletion of a file or directory on the host, which must happen after a Flush.
+     * Buffers of the file and of files under it are never written back again.
+     */
+    void Remove(const std::string& path);
+
+private:
+    std::string GetTempPath(const std::string& path) const;
+
+    /// Body of the thread writing back stale buffers
+    void FlushThread();
+
+    const std::string temp_dir;
+    const std::chrono::milliseconds flush_interval;
+
+    std::mutex mutex;
+    std::unordered_map<std::string, std::weak_ptr<WriteBackBuffer>> buffers;
+
+    std::thread flush_thread;
+    std::condition_variable stop_condition;
+    bool stop = false;
+};
+
 class DiskFile : public FileBackend {
 public:
     DiskFile(FileUtil::IOFile&& file_, const Mode& mode_,
@@ -32,6 +134,20 @@ public:
         mode.hex = mode_.hex;
     }
 
+    /**
+     * Creates a DiskFile whose reads and writes go through a write-back buffer instead of the
+     * host file. The host file handle is only kept for serialization purposes and is closed.
+     */
+    DiskFile(FileUtil::IOFile&& file_, const Mode& mode_,
+             std::unique_ptr<DelayGenerator> delay_generator_,
+             std::shared_ptr<WriteBackBuffer> write_back_)
+        : DiskFile(std::move(file_), mode_, std::move(delay_generator_)) {
+        write_back = std::move(write_back_);
+        if (write_back) {
+            file->Close();
+        }
+    }
+
     ResultVal<std::size_t> Read(u64 offset, std::size_t length, u8* buffer) const override;
     ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                  const u8* buffer) override;
@@ -39,19 +155,23 @@ public:
     bool SetSize(u64 size) const override;
     bool Close() const override;
 
-    void Flush() const override {
-        file->Flush();
-    }
+    void Flush() const override;
 
 protected:
     Mode mode;
     std::unique_ptr<FileUtil::IOFile> file;
+    std::shared_ptr<WriteBackBuffer> write_back;
 
 private:
     DiskFile() = default;
 
     template <class Archive>
     void serialize(Archive& ar, const unsigned int) {
+        // Write-back buffers are not part of the state: pending writes are written back here and
+        // the file goes back to writing through once the state is loaded.
+        if (Archive::is_saving::value && write_back) {
+            write_back->Flush();
+        }
         ar& boost::serialization::base_object<FileBackend>(*this);
         ar& mode.hex;
         ar& file;
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
 #include <cstring>
 #include <memory>
@@ -9,8 +10,10 @@
 #include <cryptopp/modes.h>
 #include <cryptopp/sha.h>
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "core/core.h"
+#include "core/file_sys/code_cache.h"
 #include "core/file_sys/layered_fs.h"
 #include "core/file_sys/ncch_container.h"
 #include "core/file_sys/patch.h"
@@ -572,10 +575,11 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
     return Loader::ResultStatus::ErrorNotUsed;
 }
 
-Loader::ResultStatus NCCHContainer::ApplyCodePatch(std::vector<u8>& code) const {
+Loader::ResultStatus NCCHContainer::ReadCodePatch(std::vector<u8>& patch,
+                                                  PatchFunction& patch_fn) const {
     struct PatchLocation {
         std::string path;
-        bool (*patch_fn)(const std::vector<u8>& patch, std::vector<u8>& code);
+        PatchFunction patch_fn;
     };
 
     const auto mods_path =
@@ -595,21 +599,90 @@ Loader::ResultStatus NCCHContainer::ApplyCodePatch(std::vector<u8>& code) const
         if (!file)
             continue;
 
-        std::vector<u8> patch(file.GetSize());
+        patch.resize(file.GetSize());
         if (file.ReadBytes(patch.data(), patch.size()) != patch.size())
             return Loader::ResultStatus::Error;
 
         LOG_INFO(Service_FS, "File {} patching code.bin", info.path);
-        if (!info.patch_fn(patch, code))
-            return Loader::ResultStatus::Error;
-
+        patch_fn = info.patch_fn;
         return Loader::ResultStatus::Success;
     }
     return Loader::ResultStatus::ErrorNotUsed;
 }
 
-Loader::ResultStatus NCCHContainer::LoadOverrideExeFSSection(const char* name,
-                                                             std::vector<u8>& buffer) {
+Loader::ResultStatus NCCHContainer::ApplyCodePatch(std::vector<u8>& code) const {
+    std::vector<u8> patch;
+    PatchFunction patch_fn;
+    const Loader::ResultStatus result = ReadCodePatch(patch, patch_fn);
+    if (result != Loader::ResultStatus::Success)
+        return result;
+
+    if (!patch_fn(patch, code))
+        return Loader::ResultStatus::Error;
+
+    return Loader::ResultStatus::Success;
+}
+
+Loader::ResultStatus NCCHContainer::LoadCode(std::vector<u8>& code, u32 bss_size) {
+    Loader::ResultStatus result = Load();
+    if (result != Loader::ResultStatus::Success)
+        return result;
+
+    std::vector<u8> patch;
+    PatchFunction patch_fn = nullptr;
+    result = ReadCodePatch(patch, patch_fn);
+    if (result != Loader::ResultStatus::Success && result != Loader::ResultStatus::ErrorNotUsed)
+        return result;
+
+    // Overridden sections are read from loose files which are neither encrypted nor compressed,
+    // and they can change without the NCCH changing, so only cache code read from the ExeFS.
+    const std::vector<std::string> override_paths = GetOverrideExeFSSectionPaths(".code");
+    const bool has_code_override =
+        std::any_of(override_paths.begin(), override_paths.end(),
+                    [](const std::string& path) { return FileUtil::Exists(path); });
+    std::string cache_path;
+    if (!is_tainted && has_exefs && !has_code_override) {
+        // The NCCH header contains the signature and the ExeFS header contains the SHA-256 of
+        // every section, which together identify the .code contents. The exheader determines
+        // the .bss layout.
+        std::vector<u8> key(sizeof(ncch_header) + sizeof(exefs_header) + sizeof(exheader_header) +
+                            sizeof(bss_size));
+        u8* key_data = key.data();
+        std::memcpy(key_data, &ncch_header, sizeof(ncch_header));
+        key_data += sizeof(ncch_header);
+        std::memcpy(key_data, &exefs_header, sizeof(exefs_header));
+        key_data += sizeof(exefs_header);
+        std::memcpy(key_data, &exheader_header, sizeof(exheader_header));
+        key_data += sizeof(exheader_header);
+        std::memcpy(key_data, &bss_size, sizeof(bss_size));
+
+        const u64 ncch_hash = Common::ComputeHash64(key.data(), key.size());
+        const u64 patch_hash = patch_fn ? Common::ComputeHash64(patch.data(), patch.size()) : 0;
+        cache_path = CodeCache::GetCachePath(ncch_header.program_id, ncch_hash, patch_hash);
+
+        if (CodeCache::Load(cache_path, code)) {
+            LOG_INFO(Service_FS, "Loaded code image from cache {}", cache_path);
+            return Loader::ResultStatus::Success;
+        }
+    }
+
+    result = LoadSectionExeFS(".code", code);
+    if (result != Loader::ResultStatus::Success)
+        return result;
+
+    code.resize(code.size() + bss_size, 0);
+
+    // Apply patches now that the entire codeset (including .bss) has been allocated
+    if (patch_fn && !patch_fn(patch, code))
+        return Loader::ResultStatus::Error;
+
+    if (!cache_path.empty()) {
+        CodeCache::Store(cache_path, code);
+    }
+    return Loader::ResultStatus::Success;
+}
+
+std::vector<std::string> NCCHContainer::GetOverrideExeFSSectionPaths(const char* name) const {
     std::string override_name;
 
     // Map our section name to the extracted equivalent
@@ -622,16 +695,23 @@ Loader::ResultStatus NCCHContainer::LoadOverrideExeFSSection(const char* name,
     else if (!strcmp(name, "logo"))
         override_name = "logo.bcma.lz";
     else
-        return Loader::ResultStatus::Error;
+        return {};
 
     const auto mods_path =
         fmt::format("{}mods/{:016X}/", FileUtil::GetUserPath(FileUtil::UserPath::LoadDir),
                     GetModId(ncch_header.program_id));
-    const std::array<std::string, 3> override_paths{{
+    return {
         mods_path + "exefs/" + override_name,
         mods_path + override_name,
         filepath + ".exefsdir/" + override_name,
-    }};
+    };
+}
+
+Loader::ResultStatus NCCHContainer::LoadOverrideExeFSSection(const char* name,
+                                                             std::vector<u8>& buffer) {
+    const std::vector<std::string> override_paths = GetOverrideExeFSSectionPaths(name);
+    if (override_paths.empty())
+        return Loader::ResultStatus::Error;
 
     for (const auto& path : override_paths) {
         FileUtil::IOFile section_file(path, "rb");
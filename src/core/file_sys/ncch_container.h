@@ -323,6 +323,16 @@ public:
      */
     Loader::ResultStatus ApplyCodePatch(std::vector<u8>& code) const;
 
+    /**
+     * Loads the final .code image: decompressed, with .bss allocated and patches applied.
+     * The result is cached on disk, so subsequent boots of the same title skip decryption,
+     * decompression and patching entirely.
+     * @param code Vector to read the code image into
+     * @param bss_size Size of the .bss region to append to the code, in bytes
+     * @return ResultStatus result of function
+     */
+    Loader::ResultStatus LoadCode(std::vector<u8>& code, u32 bss_size);
+
     /**
      * Checks whether the NCCH container contains an ExeFS
      * @return bool check result
@@ -346,6 +356,23 @@ public:
     ExHeader_Header exheader_header;
 
 private:
+    using PatchFunction = bool (*)(const std::vector<u8>& patch, std::vector<u8>& code);
+
+    /**
+     * Reads the patch for .code (if it exists).
+     * @param patch Vector to read the patch into
+     * @param patch_fn Set to the function used to apply the patch
+     * @return ResultStatus success if a patch was read, ErrorNotUsed if no patch was found
+     */
+    Loader::ResultStatus ReadCodePatch(std::vector<u8>& patch, PatchFunction& patch_fn) const;
+
+    /**
+     * Gets the paths of the loose files that can override an ExeFS section.
+     * @param name Name of the section, such as .code
+     * @return Paths in order of priority, or an empty vector if the section can't be overridden
+     */
+    std::vector<std::string> GetOverrideExeFSSectionPaths(const char* name) const;
+
     bool has_header = false;
     bool has_exheader = false;
     bool has_exefs = false;
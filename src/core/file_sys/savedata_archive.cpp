@@ -3,11 +3,13 @@
 // Refer to the license.txt file included.
 
 #include "common/archives.h"
+#include "common/common_paths.h"
 #include "common/file_util.h"
 #include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/path_parser.h"
 #include "core/file_sys/savedata_archive.h"
+#include "core/settings.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // FileSys namespace
@@ -38,6 +40,35 @@ public:
     SERIALIZE_DELAY_GENERATOR
 };
 
+SaveDataArchive::SaveDataArchive() = default;
+
+SaveDataArchive::SaveDataArchive(const std::string& mount_point_) : mount_point(mount_point_) {
+    CreateWriteBackCache();
+}
+
+SaveDataArchive::~SaveDataArchive() = default;
+
+void SaveDataArchive::CreateWriteBackCache() {
+    // Temporary files are placed next to the mount point so that they are never visible to the
+    // guest while staying on the same host file system
+    const std::string temp_dir =
+        std::string(FileUtil::GetParentPath(FileUtil::RemoveTrailingSlash(mount_point))) + DIR_SEP;
+    write_back_cache = std::make_shared<WriteBackCache>(temp_dir);
+}
+
+std::shared_ptr<WriteBackBuffer> SaveDataArchive::GetWriteBackBuffer(
+    const std::string& full_path) const {
+    // Read-only handles share the buffer too, so that they see writes that are still pending
+    if (!Settings::values.write_back_save_data) {
+        return nullptr;
+    }
+    return write_back_cache->Open(full_path);
+}
+
+void SaveDataArchive::Commit() const {
+    write_back_cache->Flush();
+}
+
 ResultVal<std::unique_ptr<FileBackend>> SaveDataArchive::OpenFile(const Path& path,
                                                                   const Mode& mode) const {
     LOG_DEBUG(Service_FS, "called path={} mode={:01X}", path.DebugStr(), mode.hex);
@@ -93,7 +124,8 @@ ResultVal<std::unique_ptr<FileBackend>> SaveDataArchive::OpenFile(const Path& pa
     }
 
     std::unique_ptr<DelayGenerator> delay_generator = std::make_unique<SaveDataDelayGenerator>();
-    auto disk_file = std::make_unique<DiskFile>(std::move(file), mode, std::move(delay_generator));
+    auto disk_file = std::make_unique<DiskFile>(std::move(file), mode, std::move(delay_generator),
+                                                GetWriteBackBuffer(full_path));
     return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
 }
 
@@ -123,7 +155,9 @@ ResultCode SaveDataArchive::DeleteFile(const Path& path) const {
         break; // Expected 'success' case
     }
 
+    write_back_cache->Flush();
     if (FileUtil::Delete(full_path)) {
+        write_back_cache->Remove(full_path);
         return RESULT_SUCCESS;
     }
 
@@ -150,7 +184,9 @@ ResultCode SaveDataArchive::RenameFile(const Path& src_path, const Path& dest_pa
     const auto src_path_full = path_parser_src.BuildHostPath(mount_point);
     const auto dest_path_full = path_parser_dest.BuildHostPath(mount_point);
 
+    write_back_cache->Flush();
     if (FileUtil::Rename(src_path_full, dest_path_full)) {
+        write_back_cache->Move(src_path_full, dest_path_full);
         return RESULT_SUCCESS;
     }
 
@@ -200,12 +236,19 @@ static ResultCode DeleteDirectoryHelper(const Path& path, const std::string& mou
 }
 
 ResultCode SaveDataArchive::DeleteDirectory(const Path& path) const {
+    write_back_cache->Flush();
     return DeleteDirectoryHelper(path, mount_point, FileUtil::DeleteDir);
 }
 
 ResultCode SaveDataArchive::DeleteDirectoryRecursively(const Path& path) const {
-    return DeleteDirectoryHelper(
-        path, mount_point, [](const std::string& p) { return FileUtil::DeleteDirRecursively(p); });
+    write_back_cache->Flush();
+    return DeleteDirectoryHelper(path, mount_point, [this](const std::string& p) {
+        if (!FileUtil::DeleteDirRecursively(p)) {
+            return false;
+        }
+        write_back_cache->Remove(p);
+        return true;
+    });
 }
 
 ResultCode SaveDataArchive::CreateFile(const FileSys::Path& path, u64 size) const {
@@ -309,7 +352,9 @@ ResultCode SaveDataArchive::RenameDirectory(const Path& src_path, const Path& de
     const auto src_path_full = path_parser_src.BuildHostPath(mount_point);
     const auto dest_path_full = path_parser_dest.BuildHostPath(mount_point);
 
+    write_back_cache->Flush();
     if (FileUtil::Rename(src_path_full, dest_path_full)) {
+        write_back_cache->Move(src_path_full, dest_path_full);
         return RESULT_SUCCESS;
     }
 
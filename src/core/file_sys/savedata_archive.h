@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include "core/file_sys/archive_backend.h"
 #include "core/file_sys/directory_backend.h"
@@ -15,10 +16,14 @@
 
 namespace FileSys {
 
+class WriteBackBuffer;
+class WriteBackCache;
+
 /// Archive backend for general save data archive type (SaveData and SystemSaveData)
 class SaveDataArchive : public ArchiveBackend {
 public:
-    explicit SaveDataArchive(const std::string& mount_point_) : mount_point(mount_point_) {}
+    explicit SaveDataArchive(const std::string& mount_point_);
+    ~SaveDataArchive() override;
 
     std::string GetName() const override {
         return "SaveDataArchive: " + mount_point;
@@ -35,16 +40,31 @@ public:
     ResultCode RenameDirectory(const Path& src_path, const Path& dest_path) const override;
     ResultVal<std::unique_ptr<DirectoryBackend>> OpenDirectory(const Path& path) const override;
     u64 GetFreeBytes() const override;
+    void Commit() const override;
 
 protected:
+    /**
+     * Gets the write-back buffer of a host file of this archive.
+     * @return The buffer, or nullptr if write-back caching is disabled
+     */
+    std::shared_ptr<WriteBackBuffer> GetWriteBackBuffer(const std::string& full_path) const;
+
     std::string mount_point;
-    SaveDataArchive() = default;
+    std::shared_ptr<WriteBackCache> write_back_cache;
+
+    SaveDataArchive();
 
 private:
+    /// Creates the write-back cache of the archive once the mount point is known
+    void CreateWriteBackCache();
+
     template <class Archive>
     void serialize(Archive& ar, const unsigned int) {
         ar& boost::serialization::base_object<ArchiveBackend>(*this);
         ar& mount_point;
+        if (Archive::is_loading::value) {
+            CreateWriteBackCache();
+        }
     }
     friend class boost::serialization::access;
 };
@@ -0,0 +1,489 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "common/string_util.h"
+#include "common/swap.h"
+#include "common/thread_worker.h"
+#include "common/zstd_compression.h"
+#include "core/game_library.h"
+#include "core/hle/service/am/am.h"
+#include "core/hle/service/fs/archive.h"
+#include "core/hw/aes/key.h"
+#include "core/loader/loader.h"
+
+namespace Core {
+
+namespace {
+
+constexpr std::array<u8, 4> INDEX_MAGIC{{'C', 'G', 'L', 0x1B}};
+constexpr u32 INDEX_VERSION = 1;
+
+struct IndexHeader {
+    std::array<u8, 4> magic;
+    u32_le version;
+    u64_le decompressed_size;
+    u64_le decompressed_hash;
+};
+static_assert(sizeof(IndexHeader) == 24, "IndexHeader has incorrect size");
+
+/// Returns the title ID of the update of a title, if it can have one
+std::optional<u64> GetUpdateTitleId(u64 program_id) {
+    if (program_id == 0 || (program_id & ~0x00040000FFFFFFFF) != 0) {
+        return std::nullopt;
+    }
+    return program_id | 0x0000000E00000000;
+}
+
+class IndexWriter {
+public:
+    template <typename T>
+    void Write(T value) {
+        const std::size_t offset = data.size();
+        data.resize(offset + sizeof(T));
+        std::memcpy(data.data() + offset, &value, sizeof(T));
+    }
+
+    void WriteBytes(const void* bytes, std::size_t size) {
+        Write<u32_le>(static_cast<u32>(size));
+        const auto* begin = static_cast<const u8*>(bytes);
+        data.insert(data.end(), begin, begin + size);
+    }
+
+    std::vector<u8> data;
+};
+
+class IndexReader {
+public:
+    explicit IndexReader(const std::vector<u8>& data) : data(data) {}
+
+    template <typename T>
+    bool Read(T& value) {
+        if (data.size() - offset < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+
+    template <typename Container>
+    bool ReadBytes(Container& bytes) {
+        u32_le size;
+        if (!Read(size) || data.size() - offset < size) {
+            return false;
+        }
+        bytes.assign(data.begin() + offset, data.begin() + offset + size);
+        offset += size;
+        return true;
+    }
+
+    bool AtEnd() const {
+        return offset == data.size();
+    }
+
+private:
+    const std::vector<u8>& data;
+    std::size_t offset = 0;
+};
+
+} // Anonymous namespace
+
+bool GameLibraryEntry::HasValidSMDH() const {
+    return Loader::IsValidSMDH(smdh);
+}
+
+std::string GameLibraryEntry::GetShortTitle(Loader::SMDH::TitleLanguage language) const {
+    if (!HasValidSMDH()) {
+        return {};
+    }
+    Loader::SMDH data;
+    std::memcpy(&data, smdh.data(), sizeof(data));
+    const auto title = data.GetShortTitle(language);
+    const auto end = std::find(title.begin(), title.end(), u16{0});
+    return Common::UTF16ToUTF8(std::u16string(title.begin(), end));
+}
+
+std::string GameLibraryEntry::GetCompatibilityKey() const {
+    return fmt::format("{:016X}", program_id);
+}
+
+GameLibrary::GameLibrary(std::string index_path_)
+    : index_path(std::move(index_path_)),
+      // Probing mostly waits for the storage, so use more threads than there are cores
+      workers(std::make_unique<Common::ThreadWorker>(
+          std::max(std::thread::hardware_concurrency() * 2, 8u), "GameLibrary")) {}
+
+GameLibrary::~GameLibrary() = default;
+
+std::string GameLibrary::GetDefaultIndexPath() {
+    return FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) + "game_library.bin";
+}
+
+bool GameLibrary::IsSupportedExtension(const std::string& path) {
+    std::string extension;
+    Common::SplitPath(path, nullptr, nullptr, &extension);
+    if (extension.empty()) {
+        return false;
+    }
+    extension = Common::ToLower(extension.substr(1));
+    return std::find(SUPPORTED_EXTENSIONS.begin(), SUPPORTED_EXTENSIONS.end(), extension) !=
+           SUPPORTED_EXTENSIONS.end();
+}
+
+std::vector<GameLibraryEntry> GameLibrary::Scan(const std::string& directory,
+                                                unsigned int recursion,
+                                                std::vector<std::string>* subdirectories,
+                                                const EntryCallback& on_entry) {
+    // The keys are otherwise loaded by the first NCCH that needs them, which isn't thread-safe
+    HW::AES::InitKeys();
+
+    {
+        std::lock_guard lock{mutex};
+        if (!index_loaded) {
+            LoadIndex();
+            index_loaded = true;
+        }
+        scanned_directories.push_back(directory + DIR_SEP);
+    }
+
+    struct Result {
+        std::optional<GameLibraryEntry> entry;
+        bool done = false;
+    };
+
+    // The files are probed while the directories are still being listed. A deque doesn't move
+    // its elements when it grows, so the workers can fill them in the meantime.
+    std::deque<Result> results;
+    std::mutex results_mutex;
+    std::condition_variable result_done;
+    std::vector<GameLibraryEntry> entries;
+    std::size_t num_delivered = 0;
+
+    // Passes the probed files to on_entry in the order they were found, optionally waiting for
+    // the files that are still being probed
+    const auto deliver = [&](bool wait) {
+        while (num_delivered < results.size()) {
+            Result& result = results[num_delivered];
+            {
+                std::unique_lock lock{results_mutex};
+                if (!wait && !result.done) {
+                    return;
+                }
+                result_done.wait(lock, [&result] { return result.done; });
+            }
+            if (result.entry) {
+                entries.push_back(std::move(*result.entry));
+                if (on_entry) {
+                    on_entry(entries.back());
+                }
+            }
+            ++num_delivered;
+        }
+    };
+
+    ScanDirectory(directory, recursion, subdirectories, [&](std::string path) {
+        Result* result = &results.emplace_back();
+        workers->QueueWork([&, result, path = std::move(path)] {
+            std::optional<GameLibraryEntry> entry;
+            if (!cancelled) {
+                entry = GetEntry(path);
+            }
+            // Notified with the mutex held, as the scan may return as soon as the last one is done
+            std::lock_guard lock{results_mutex};
+            result->entry = std::move(entry);
+            result->done = true;
+            result_done.notify_all();
+        });
+        deliver(false);
+    });
+    deliver(true);
+    return entries;
+}
+
+void GameLibrary::Cancel() {
+    cancelled = true;
+}
+
+bool GameLibrary::SaveIndex() {
+    std::lock_guard lock{mutex};
+    if (!cancelled) {
+        // Drop the files that were removed from the scanned directories
+        for (auto it = index.begin(); it != index.end();) {
+            const bool in_scanned_directory = std::any_of(
+                scanned_directories.begin(), scanned_directories.end(),
+                [&it](const std::string& directory) {
+                    return it->first.compare(0, directory.size(), directory) == 0;
+                });
+            if (!it->second.seen && in_scanned_directory) {
+                it = index.erase(it);
+                index_changed = true;
+            } else {
+                ++it;
+            }
+        }
+    }
+    if (!index_changed) {
+        return true;
+    }
+
+    IndexWriter writer;
+    writer.Write<u64_le>(index.size());
+    for (const auto& [path, entry] : index) {
+        writer.WriteBytes(path.data(), path.size());
+        writer.Write<u64_le>(entry.entry.size);
+        writer.Write<s64_le>(entry.entry.modification_time);
+        writer.Write<u8>(entry.bootable);
+        writer.Write<u32_le>(static_cast<u32>(entry.entry.file_type));
+        writer.Write<u64_le>(entry.entry.program_id);
+        writer.Write<u64_le>(entry.entry.extdata_id);
+        writer.WriteBytes(entry.entry.smdh.data(), entry.entry.smdh.size());
+        writer.Write<u8>(entry.has_update_title);
+        writer.WriteBytes(entry.update_path.data(), entry.update_path.size());
+        writer.Write<u64_le>(entry.update_size);
+        writer.Write<s64_le>(entry.update_modification_time);
+    }
+
+    IndexHeader header;
+    header.magic = INDEX_MAGIC;
+    header.version = INDEX_VERSION;
+    header.decompressed_size = writer.data.size();
+    header.decompressed_hash = Common::ComputeHash64(writer.data.data(), writer.data.size());
+    const std::vector<u8> compressed =
+        Common::Compression::CompressDataZSTDDefault(writer.data.data(), writer.data.size());
+
+    if (!FileUtil::CreateFullPath(index_path)) {
+        LOG_ERROR(Loader, "Failed to create game library index directory for {}", index_path);
+        return false;
+    }
+    // Write to a temporary file first so that an interrupted write never leaves a truncated index
+    const std::string temp_path = index_path + ".tmp";
+    {
+        FileUtil::IOFile file(temp_path, "wb");
+        if (file.WriteBytes(&header, sizeof(header)) != sizeof(header) ||
+            file.WriteBytes(compressed.data(), compressed.size()) != compressed.size()) {
+            LOG_ERROR(Loader, "Failed to write game library index {}", temp_path);
+            file.Close();
+            FileUtil::Delete(temp_path);
+            return false;
+        }
+    }
+    if (!FileUtil::RenameReplacing(temp_path, index_path)) {
+        LOG_ERROR(Loader, "Failed to move game library index into place at {}", index_path);
+        FileUtil::Delete(temp_path);
+        return false;
+    }
+
+    index_changed = false;
+    LOG_DEBUG(Loader, "Stored {} files in game library index {}", index.size(), index_path);
+    return true;
+}
+
+GameLibrary::Stats GameLibrary::GetStats() const {
+    std::lock_guard lock{mutex};
+    return stats;
+}
+
+void GameLibrary::LoadIndex() {
+    FileUtil::IOFile file(index_path, "rb");
+    if (!file.IsOpen()) {
+        return;
+    }
+
+    IndexHeader header;
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != INDEX_MAGIC || header.version != INDEX_VERSION) {
+        LOG_WARNING(Loader, "Ignoring invalid game library index {}", index_path);
+        return;
+    }
+
+    std::vector<u8> compressed(file.GetSize() - sizeof(header));
+    if (file.ReadBytes(compressed.data(), compressed.size()) != compressed.size()) {
+        LOG_WARNING(Loader, "Failed to read game library index {}", index_path);
+        return;
+    }
+
+    const std::vector<u8> data = Common::Compression::DecompressDataZSTD(compressed);
+    if (data.size() != header.decompressed_size ||
+        Common::ComputeHash64(data.data(), data.size()) != header.decompressed_hash) {
+        LOG_WARNING(Loader, "Game library index {} is corrupted", index_path);
+        return;
+    }
+
+    IndexReader reader(data);
+    u64_le num_entries;
+    bool valid = reader.Read(num_entries);
+    std::unordered_map<std::string, IndexEntry> entries;
+    for (u64 i = 0; valid && i < num_entries; ++i) {
+        std::string path;
+        IndexEntry entry;
+        u64_le size, program_id, extdata_id, update_size;
+        s64_le modification_time, update_modification_time;
+        u8 bootable, has_update_title;
+        u32_le file_type;
+        valid = reader.ReadBytes(path) && reader.Read(size) && reader.Read(modification_time) &&
+                reader.Read(bootable) && reader.Read(file_type) && reader.Read(program_id) &&
+                reader.Read(extdata_id) && reader.ReadBytes(entry.entry.smdh) &&
+                reader.Read(has_update_title) && reader.ReadBytes(entry.update_path) &&
+                reader.Read(update_size) && reader.Read(update_modification_time);
+        entry.entry.path = path;
+        entry.entry.size = size;
+        entry.entry.modification_time = modification_time;
+        entry.entry.file_type = static_cast<Loader::FileType>(static_cast<u32>(file_type));
+        entry.entry.program_id = program_id;
+        entry.entry.extdata_id = extdata_id;
+        entry.bootable = bootable != 0;
+        entry.has_update_title = has_update_title != 0;
+        entry.update_size = update_size;
+        entry.update_modification_time = update_modification_time;
+        entries.emplace(std::move(path), std::move(entry));
+    }
+    if (!valid || !reader.AtEnd()) {
+        LOG_WARNING(Loader, "Game library index {} is malformed", index_path);
+        return;
+    }
+
+    index = std::move(entries);
+    LOG_DEBUG(Loader, "Loaded {} files from game library index {}", index.size(), index_path);
+}
+
+void GameLibrary::ScanDirectory(const std::string& directory, unsigned int recursion,
+                                std::vector<std::string>* subdirectories,
+                                const std::function<void(std::string)>& on_candidate) {
+    const auto callback = [&](u64*, const std::string& parent, const std::string& name) {
+        if (cancelled) {
+            // Breaks the callback loop.
+            return false;
+        }
+
+        std::string path = parent + DIR_SEP + name;
+        if (IsSupportedExtension(name)) {
+            // Whether it is a regular file is checked by the workers, saving a stat here
+            on_candidate(std::move(path));
+        } else if (recursion > 0 && FileUtil::IsDirectory(path)) {
+            if (subdirectories) {
+                subdirectories->push_back(path);
+            }
+            ScanDirectory(path, recursion - 1, subdirectories, on_candidate);
+        }
+        return true;
+    };
+    FileUtil::ForeachDirectoryEntry(nullptr, directory, callback);
+}
+
+std::optional<GameLibraryEntry> GameLibrary::GetEntry(const std::string& path) {
+    const std::optional<FileUtil::FileStatus> status = FileUtil::GetFileStatus(path);
+    if (!status) {
+        return std::nullopt;
+    }
+
+    std::optional<IndexEntry> cached;
+    {
+        std::lock_guard lock{mutex};
+        const auto it = index.find(path);
+        if (it != index.end() && it->second.entry.size == status->size &&
+            it->second.entry.modification_time == status->modification_time) {
+            it->second.seen = true;
+            cached = it->second;
+        }
+    }
+    if (cached && !(cached->bootable && IsUpdateChanged(*cached))) {
+        if (!cached->bootable) {
+            return std::nullopt;
+        }
+        std::lock_guard lock{mutex};
+        ++stats.num_games;
+        return std::move(cached->entry);
+    }
+
+    IndexEntry probed;
+    probed.entry.path = path;
+    probed.entry.size = status->size;
+    probed.entry.modification_time = status->modification_time;
+    probed.seen = true;
+    Probe(probed);
+
+    std::lock_guard lock{mutex};
+    ++stats.num_probed;
+    index_changed = true;
+    index[path] = probed;
+    if (!probed.bootable) {
+        return std::nullopt;
+    }
+    ++stats.num_games;
+    return std::move(probed.entry);
+}
+
+bool GameLibrary::IsUpdateChanged(const IndexEntry& entry) {
+    const std::optional<u64> update_id = GetUpdateTitleId(entry.entry.program_id);
+    if (!update_id) {
+        return false;
+    }
+    // Finding the content of the update means reading its TMD, so only check that the update
+    // found before is still there unchanged, and that there still is none otherwise.
+    const bool has_update_title =
+        FileUtil::Exists(Service::AM::GetTitlePath(Service::FS::MediaType::SDMC, *update_id));
+    if (has_update_title != entry.has_update_title) {
+        return true;
+    }
+    if (!has_update_title) {
+        return false;
+    }
+    const FileUtil::FileStatus update_status =
+        FileUtil::GetFileStatus(entry.update_path).value_or(FileUtil::FileStatus{0, 0});
+    return update_status.size != entry.update_size ||
+           update_status.modification_time != entry.update_modification_time;
+}
+
+void GameLibrary::Probe(IndexEntry& entry) {
+    std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(entry.entry.path);
+    if (!loader) {
+        return;
+    }
+
+    bool executable = false;
+    const auto res = loader->IsExecutable(executable);
+    if (!executable && res != Loader::ResultStatus::ErrorEncrypted) {
+        return;
+    }
+    entry.bootable = true;
+    entry.entry.file_type = loader->GetFileType();
+    loader->ReadProgramId(entry.entry.program_id);
+    loader->ReadExtdataId(entry.entry.extdata_id);
+
+    // Look for an update icon if available
+    if (const std::optional<u64> update_id = GetUpdateTitleId(entry.entry.program_id)) {
+        entry.has_update_title =
+            FileUtil::Exists(Service::AM::GetTitlePath(Service::FS::MediaType::SDMC, *update_id));
+        if (entry.has_update_title) {
+            entry.update_path =
+                Service::AM::GetTitleContentPath(Service::FS::MediaType::SDMC, *update_id);
+            if (const auto update_status = FileUtil::GetFileStatus(entry.update_path)) {
+                entry.update_size = update_status->size;
+                entry.update_modification_time = update_status->modification_time;
+                if (const auto update_loader = Loader::GetLoader(entry.update_path)) {
+                    update_loader->ReadIcon(entry.entry.smdh);
+                }
+            }
+        }
+    }
+
+    if (!Loader::IsValidSMDH(entry.entry.smdh)) {
+        // Read the original smdh if there is no valid update smdh
+        entry.entry.smdh.clear();
+        loader->ReadIcon(entry.entry.smdh);
+    }
+}
+
+} // namespace Core
@@ -0,0 +1,157 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "core/loader/smdh.h"
+
+namespace Common {
+class ThreadWorker;
+} // namespace Common
+
+namespace Loader {
+enum class FileType;
+} // namespace Loader
+
+namespace Core {
+
+/// Metadata of a bootable file found in a game directory
+struct GameLibraryEntry {
+    std::string path;
+    u64 size = 0;
+    /// Last modification time of the file, in seconds since the epoch
+    s64 modification_time = 0;
+
+    Loader::FileType file_type{};
+    u64 program_id = 0;
+    u64 extdata_id = 0;
+    /// SMDH of the installed update if it has a valid one, otherwise of the file itself
+    std::vector<u8> smdh;
+
+    [[nodiscard]] bool HasValidSMDH() const;
+
+    /// Returns the short title in the given language, or an empty string without a valid SMDH
+    [[nodiscard]] std::string GetShortTitle(Loader::SMDH::TitleLanguage language) const;
+
+    /// Returns the key of the title in the compatibility list
+    [[nodiscard]] std::string GetCompatibilityKey() const;
+};
+
+/**
+ * Finds the bootable files in game directories and reads their metadata. The metadata is kept in
+ * an on-disk index keyed by path, size and modification time, so that later scans only open the
+ * files that are new or have changed. Files are stat'ed and probed on a pool of worker threads,
+ * as the latency of every file access adds up on network storage.
+ */
+class GameLibrary {
+public:
+    /// Extensions of the bootable files, without the leading dot
+    static constexpr std::array<const char*, 7> SUPPORTED_EXTENSIONS{
+        {"3ds", "3dsx", "elf", "axf", "cci", "cxi", "app"}};
+
+    /// Receives the bootable files found by a scan
+    using EntryCallback = std::function<void(const GameLibraryEntry& entry)>;
+
+    struct Stats {
+        /// Number of bootable files found
+        std::size_t num_games = 0;
+        /// Number of files that were opened because the index had no current entry for them
+        std::size_t num_probed = 0;
+    };
+
+    /**
+     * @param index_path Path of the index file. The index is loaded by the first scan, and an
+     *                   invalid or missing index is treated as empty.
+     */
+    explicit GameLibrary(std::string index_path = GetDefaultIndexPath());
+    ~GameLibrary();
+
+    GameLibrary(const GameLibrary&) = delete;
+    GameLibrary& operator=(const GameLibrary&) = delete;
+
+    /// Returns the path of the index shared by the frontends, in the cache directory
+    static std::string GetDefaultIndexPath();
+
+    /// Returns true if the file extension is one of a bootable file, e.g. ".3ds"
+    static bool IsSupportedExtension(const std::string& path);
+
+    /**
+     * Scans a directory for bootable files.
+     * @param directory Directory to scan
+     * @param recursion Number of levels of subdirectories to scan as well
+     * @param subdirectories If not null, the scanned subdirectories are appended to it
+     * @param on_entry If set, called on the calling thread with every bootable file as soon as it
+     *                 and the files found before it were probed, while the scan continues
+     * @return The bootable files in the order they were found in the directories
+     */
+    std::vector<GameLibraryEntry> Scan(const std::string& directory, unsigned int recursion,
+                                       std::vector<std::string>* subdirectories = nullptr,
+                                       const EntryCallback& on_entry = {});
+
+    /// Makes running and later scans return early. Thread-safe.
+    void Cancel();
+
+    /**
+     * Writes the index if a scan changed it. Entries of files that were not found by any scan
+     * since the index was loaded are dropped, unless a scan was cancelled.
+     * @return True if the index is up to date on disk
+     */
+    bool SaveIndex();
+
+    Stats GetStats() const;
+
+private:
+    /// Index entry, which is also kept for files that turned out not to be bootable
+    struct IndexEntry {
+        GameLibraryEntry entry;
+        bool bootable = false;
+        /// State of the installed update the SMDH may come from when the entry was probed
+        bool has_update_title = false;
+        std::string update_path;
+        u64 update_size = 0;
+        s64 update_modification_time = 0;
+        /// Whether a scan found the file since the index was loaded
+        bool seen = false;
+    };
+
+    /// Loads the index from disk, with the mutex held
+    void LoadIndex();
+
+    /// Lists a directory tree, passing the paths of the possibly bootable files to on_candidate
+    void ScanDirectory(const std::string& directory, unsigned int recursion,
+                       std::vector<std::string>* subdirectories,
+                       const std::function<void(std::string)>& on_candidate);
+
+    /// Returns the current metadata of a file, from the index if possible
+    std::optional<GameLibraryEntry> GetEntry(const std::string& path);
+
+    /// Returns true if the installed update of the title changed since the entry was probed
+    static bool IsUpdateChanged(const IndexEntry& entry);
+
+    /// Opens a file and reads its metadata into the entry
+    static void Probe(IndexEntry& entry);
+
+    std::string index_path;
+    std::unique_ptr<Common::ThreadWorker> workers;
+    std::atomic_bool cancelled{false};
+
+    mutable std::mutex mutex;
+    bool index_loaded = false;
+    std::unordered_map<std::string, IndexEntry> index;
+    bool index_changed = false;
+    std::vector<std::string> scanned_directories;
+    Stats stats;
+};
+
+} // namespace Core
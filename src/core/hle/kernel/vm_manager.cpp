@@ -52,7 +52,8 @@ void VMManager::Reset() {
     // Initialize the map with a single free region covering the entire managed space.
     VirtualMemoryArea initial_vma;
     initial_vma.size = MAX_ADDRESS;
-    vma_map.emplace(initial_vma.base, initial_vma);
+    const VMAIter initial_iter = vma_map.emplace(initial_vma.base, initial_vma).first;
+    IndexRange(initial_vma.base, initial_vma.size, initial_iter);
 
     page_table->Clear();
 
@@ -62,17 +63,28 @@ void VMManager::Reset() {
 VMManager::VMAHandle VMManager::FindVMA(VAddr target) const {
     if (target >= MAX_ADDRESS) {
         return vma_map.end();
-    } else {
-        return std::prev(vma_map.upper_bound(target));
     }
+    const IndexNode& node = vma_index[target / INDEX_NODE_SIZE];
+    if (!node.pages) {
+        return node.vma;
+    }
+    return (*node.pages)[(target / Memory::PAGE_SIZE) % INDEX_NODE_PAGES];
+}
+
+VMManager::VMAHandle VMManager::FindVMAFrom(VAddr target) const {
+    const VMAHandle vma = FindVMA(target);
+    if (vma == vma_map.end() || vma->second.base == target) {
+        return vma;
+    }
+    return std::next(vma);
 }
 
 ResultVal<VAddr> VMManager::MapBackingMemoryToBase(VAddr base, u32 region_size, MemoryRef memory,
                                                    u32 size, MemoryState state) {
     ASSERT(!is_locked);
 
-    // Find the first Free VMA.
-    VMAHandle vma_handle = std::find_if(vma_map.begin(), vma_map.end(), [&](const auto& vma) {
+    // Find the first Free VMA. VMAs before the one containing the base all end before it.
+    VMAHandle vma_handle = std::find_if(FindVMA(base), vma_map.cend(), [&](const auto& vma) {
         if (vma.second.type != VMAType::Free)
             return false;
 
@@ -145,7 +157,7 @@ ResultCode VMManager::ChangeMemoryState(VAddr target, u32 size, MemoryState expe
 
     VAddr target_end = target + size;
     VMAIter begin_vma = StripIterConstness(FindVMA(target));
-    VMAIter i_end = vma_map.lower_bound(target_end);
+    VMAHandle i_end = FindVMAFrom(target_end);
 
     if (begin_vma == vma_map.end())
         return ERR_INVALID_ADDRESS;
@@ -305,7 +317,7 @@ ResultVal<VMManager::VMAIter> VMManager::CarveVMARange(VAddr target, u32 size) {
     ASSERT(size > 0);
 
     VMAIter begin_vma = StripIterConstness(FindVMA(target));
-    const VMAIter i_end = vma_map.lower_bound(target_end);
+    const VMAIter i_end = StripIterConstness(FindVMAFrom(target_end));
     if (std::any_of(begin_vma, i_end,
                     [](const auto& entry) { return entry.second.type == VMAType::Free; })) {
         return ERR_INVALID_ADDRESS_STATE;
@@ -349,13 +361,16 @@ VMManager::VMAIter VMManager::SplitVMA(VMAIter vma_handle, u32 offset_in_vma) {
 
     ASSERT(old_vma.CanBeMergedWith(new_vma));
 
-    return vma_map.emplace_hint(std::next(vma_handle), new_vma.base, new_vma);
+    const VMAIter new_iter = vma_map.emplace_hint(std::next(vma_handle), new_vma.base, new_vma);
+    IndexRange(new_vma.base, new_vma.size, new_iter);
+    return new_iter;
 }
 
 VMManager::VMAIter VMManager::MergeAdjacent(VMAIter iter) {
     const VMAIter next_vma = std::next(iter);
     if (next_vma != vma_map.end() && iter->second.CanBeMergedWith(next_vma->second)) {
         iter->second.size += next_vma->second.size;
+        IndexRange(next_vma->second.base, next_vma->second.size, iter);
         vma_map.erase(next_vma);
     }
 
@@ -363,6 +378,7 @@ VMManager::VMAIter VMManager::MergeAdjacent(VMAIter iter) {
         VMAIter prev_vma = std::prev(iter);
         if (prev_vma->second.CanBeMergedWith(iter->second)) {
             prev_vma->second.size += iter->second.size;
+            IndexRange(iter->second.base, iter->second.size, prev_vma);
             vma_map.erase(iter);
             iter = prev_vma;
         }
@@ -385,6 +401,37 @@ void VMManager::UpdatePageTableForVMA(const VirtualMemoryArea& vma) {
     }
 }
 
+void VMManager::IndexRange(VAddr base, u32 size, VMAIter vma) {
+    u32 page = base / Memory::PAGE_SIZE;
+    const u32 end = page + size / Memory::PAGE_SIZE;
+    while (page != end) {
+        IndexNode& node = vma_index[page / INDEX_NODE_PAGES];
+        const u32 offset = page % INDEX_NODE_PAGES;
+        const u32 count = std::min(end - page, INDEX_NODE_PAGES - offset);
+        page += count;
+
+        if (count == INDEX_NODE_PAGES) {
+            node.vma = vma;
+            node.pages.reset();
+            continue;
+        }
+        if (!node.pages) {
+            node.pages = std::make_unique<std::array<VMAIter, INDEX_NODE_PAGES>>();
+            node.pages->fill(node.vma);
+        }
+        std::fill_n(node.pages->begin() + offset, count, vma);
+        // Collapse the node again once a merge leaves a single VMA in it
+        if (node.pages->front() == node.pages->back() &&
+            std::all_of(node.pages->begin(), node.pages->end(),
+                        [first = node.pages->front()](const VMAIter& page_vma) {
+                            return page_vma == first;
+                        })) {
+            node.vma = node.pages->front();
+            node.pages.reset();
+        }
+    }
+}
+
 ResultVal<std::vector<std::pair<MemoryRef, u32>>> VMManager::GetBackingBlocksForRange(VAddr address,
                                                                                       u32 size) {
     std::vector<std::pair<MemoryRef, u32>> backing_blocks;
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <map>
 #include <memory>
 #include <utility>
@@ -140,6 +141,9 @@ public:
     /// Finds the VMA in which the given address is included in, or `vma_map.end()`.
     VMAHandle FindVMA(VAddr target) const;
 
+    /// Finds the first VMA starting at or after the given address, like `vma_map.lower_bound`.
+    VMAHandle FindVMAFrom(VAddr target) const;
+
     // TODO(yuriks): Should these functions actually return the handle?
 
     /**
@@ -220,6 +224,19 @@ public:
 private:
     using VMAIter = decltype(vma_map)::iterator;
 
+    /// Number of pages covered by each node of the VMA index
+    static constexpr u32 INDEX_NODE_PAGES = 1024;
+    static constexpr u32 INDEX_NODE_SIZE = INDEX_NODE_PAGES * Memory::PAGE_SIZE;
+
+    /**
+     * A node of the VMA index, covering INDEX_NODE_PAGES consecutive pages. Nodes inside a single
+     * VMA only store that VMA, and only nodes where VMAs meet store the VMA of each page.
+     */
+    struct IndexNode {
+        VMAIter vma;
+        std::unique_ptr<std::array<VMAIter, INDEX_NODE_PAGES>> pages;
+    };
+
     /// Converts a VMAHandle to a mutable VMAIter.
     VMAIter StripIterConstness(const VMAHandle& iter);
 
@@ -253,8 +270,17 @@ private:
     /// Updates the pages corresponding to this VMA so they match the VMA's attributes.
     void UpdatePageTableForVMA(const VirtualMemoryArea& vma);
 
+    /// Points the index entries of the given range at a VMA.
+    void IndexRange(VAddr base, u32 size, VMAIter vma);
+
     Memory::MemorySystem& memory;
 
+    /**
+     * Two-level index from page numbers to the VMAs containing them, which lets FindVMA avoid
+     * searching vma_map. It is kept in sync with vma_map whenever VMAs are split or merged.
+     */
+    std::array<IndexNode, MAX_ADDRESS / INDEX_NODE_SIZE> vma_index;
+
     // When locked, ChangeMemoryState calls will be ignored, other modification calls will hit an
     // assert. VMManager locks itself after deserialization.
     bool is_locked{};
@@ -264,6 +290,9 @@ private:
         ar& vma_map;
         ar& page_table;
         if (Archive::is_loading::value) {
+            for (auto iter = vma_map.begin(); iter != vma_map.end(); ++iter) {
+                IndexRange(iter->second.base, iter->second.size, iter);
+            }
             is_locked = true;
         }
     }
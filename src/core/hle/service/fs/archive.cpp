@@ -210,6 +210,24 @@ ResultVal<u64> ArchiveManager::GetFreeBytesInArchive(ArchiveHandle archive_handl
     return MakeResult(archive->GetFreeBytes());
 }
 
+ResultCode ArchiveManager::ControlArchive(ArchiveHandle archive_handle, u32 action) {
+    const ArchiveBackend* archive = GetArchive(archive_handle);
+    if (archive == nullptr) {
+        return FileSys::ERR_INVALID_ARCHIVE_HANDLE;
+    }
+
+    switch (action) {
+    case 0: // Commit save data
+        archive->Commit();
+        break;
+    default:
+        LOG_WARNING(Service_FS, "(STUBBED) Unknown action {} on archive {}", action,
+                    archive->GetName());
+        break;
+    }
+    return RESULT_SUCCESS;
+}
+
 ResultCode ArchiveManager::FormatArchive(ArchiveIdCode id_code,
                                          const FileSys::ArchiveFormatInfo& format_info,
                                          const FileSys::Path& path, u64 program_id) {
@@ -184,6 +184,14 @@ public:
      */
     ResultVal<u64> GetFreeBytesInArchive(ArchiveHandle archive_handle);
 
+    /**
+     * Performs a control action on an Archive
+     * @param archive_handle Handle to an open Archive object
+     * @param action The action to perform
+     * @return Result of the operation
+     */
+    ResultCode ControlArchive(ArchiveHandle archive_handle, u32 action);
+
     /**
      * Erases the contents of the physical folder that contains the archive
      * identified by the specified id code and path
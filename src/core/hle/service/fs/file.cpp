@@ -2,9 +2,12 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <condition_variable>
 #include <boost/serialization/unique_ptr.hpp>
+#include <boost/serialization/vector.hpp>
 #include "common/archives.h"
 #include "common/logging/log.h"
+#include "common/thread_worker.h"
 #include "core/core.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/file_backend.h"
@@ -14,12 +17,93 @@
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/server_session.h"
 #include "core/hle/service/fs/file.h"
+#include "core/settings.h"
 
 SERIALIZE_EXPORT_IMPL(Service::FS::File)
 SERIALIZE_EXPORT_IMPL(Service::FS::FileSessionSlot)
 
 namespace Service::FS {
 
+/// Reads smaller than this are not worth a round trip through the I/O thread pool
+constexpr u32 AsyncReadThreshold = 0x4000;
+
+static Common::ThreadWorker& GetIOWorker() {
+    static Common::ThreadWorker worker(2, "FS:IO");
+    return worker;
+}
+
+/**
+ * Completes a File::Read whose host I/O was issued on the I/O thread pool. The client thread sleeps
+ * for the modeled read latency while the host read runs, and the reply is written when it wakes up.
+ */
+class File::AsyncReadCallback : public Kernel::HLERequestContext::WakeupCallback {
+public:
+    AsyncReadCallback(u32 buffer_id_, std::size_t length) : buffer_id(buffer_id_), data(length) {}
+
+    /// Performs the host read. This runs on an I/O worker thread.
+    void Execute(File& file, u64 offset) {
+        const ResultVal<std::size_t> read = [&] {
+            std::lock_guard lock{file.backend_mutex};
+            return file.backend->Read(offset, data.size(), data.data());
+        }();
+
+        std::lock_guard lock{mutex};
+        result = read.Code();
+        bytes_read = read.Succeeded() ? *read : 0;
+        completed = true;
+        condition.notify_all();
+    }
+
+    void WakeUp(std::shared_ptr<Kernel::Thread> thread, Kernel::HLERequestContext& ctx,
+                Kernel::ThreadWakeupReason reason) override {
+        // Only blocks if the host I/O took longer than the modeled latency
+        WaitForCompletion();
+
+        auto& buffer = ctx.GetMappedBuffer(buffer_id);
+        IPC::RequestBuilder rb(ctx, 0x0802, 2, 2);
+        if (result.IsError()) {
+            rb.Push(result);
+            rb.Push<u32>(0);
+        } else {
+            buffer.Write(data.data(), 0, bytes_read);
+            rb.Push(RESULT_SUCCESS);
+            rb.Push<u32>(static_cast<u32>(bytes_read));
+        }
+        rb.PushMappedBuffer(buffer);
+    }
+
+private:
+    AsyncReadCallback() : completed(true) {}
+
+    void WaitForCompletion() {
+        std::unique_lock lock{mutex};
+        condition.wait(lock, [this] { return completed; });
+    }
+
+    u32 buffer_id = 0;
+    std::vector<u8> data;
+    ResultCode result = RESULT_SUCCESS;
+    std::size_t bytes_read = 0;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool completed = false;
+
+    template <class Archive>
+    void serialize(Archive& ar, const unsigned int) {
+        // The host read cannot be serialized while in flight, so let it finish first
+        if (Archive::is_saving::value) {
+            WaitForCompletion();
+        }
+        ar& boost::serialization::base_object<Kernel::HLERequestContext::WakeupCallback>(*this);
+        ar& buffer_id;
+        ar& data;
+        ar& result.raw;
+        ar& bytes_read;
+    }
+    friend class boost::serialization::access;
+};
+
 template <class Archive>
 void File::serialize(Archive& ar, const unsigned int) {
     ar& boost::serialization::base_object<Kernel::SessionRequestHandler>(*this);
@@ -61,6 +145,7 @@ void File::Read(Kernel::HLERequestContext& ctx) {
     LOG_TRACE(Service_FS, "Read {}: offset=0x{:x} length=0x{:08X}", GetName(), offset, length);
 
     const FileSessionSlot* file = GetSessionData(ctx.Session());
+    std::unique_lock lock{backend_mutex};
 
     if (file->subfile && length > file->size) {
         LOG_WARNING(Service_FS, "Trying to read beyond the subfile size, truncating");
@@ -76,6 +161,22 @@ void File::Read(Kernel::HLERequestContext& ctx) {
                   offset, length, backend->GetSize());
     }
 
+    std::chrono::nanoseconds read_timeout_ns{backend->GetReadDelayNs(length)};
+
+    // Issue large reads on the I/O thread pool so that the host I/O overlaps with the modeled
+    // latency instead of blocking the emulation thread.
+    if (Settings::values.async_file_reads && length >= AsyncReadThreshold &&
+        read_timeout_ns.count() > 0) {
+        lock.unlock();
+        auto callback = std::make_shared<AsyncReadCallback>(buffer.GetId(), length);
+        GetIOWorker().QueueWork(
+            [self = std::static_pointer_cast<File>(shared_from_this()), callback, offset] {
+                callback->Execute(*self, offset);
+            });
+        ctx.SleepClientThread("file::read", read_timeout_ns, callback);
+        return;
+    }
+
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
 
     std::vector<u8> data(length);
@@ -90,7 +191,6 @@ void File::Read(Kernel::HLERequestContext& ctx) {
     }
     rb.PushMappedBuffer(buffer);
 
-    std::chrono::nanoseconds read_timeout_ns{backend->GetReadDelayNs(length)};
     ctx.SleepClientThread("file::read", read_timeout_ns, nullptr);
 }
 
@@ -117,6 +217,7 @@ void File::Write(Kernel::HLERequestContext& ctx) {
 
     std::vector<u8> data(length);
     buffer.Read(data.data(), 0, data.size());
+    std::lock_guard lock{backend_mutex};
     ResultVal<std::size_t> written = backend->Write(offset, data.size(), flush != 0, data.data());
 
     // Update file size
@@ -157,6 +258,7 @@ void File::SetSize(Kernel::HLERequestContext& ctx) {
     }
 
     file->size = size;
+    std::lock_guard lock{backend_mutex};
     backend->SetSize(size);
     rb.Push(RESULT_SUCCESS);
 }
@@ -169,7 +271,10 @@ void File::Close(Kernel::HLERequestContext& ctx) {
         LOG_WARNING(Service_FS, "Closing File backend but {} clients still connected",
                     connected_sessions.size());
 
-    backend->Close();
+    {
+        std::lock_guard lock{backend_mutex};
+        backend->Close();
+    }
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
 }
@@ -187,7 +292,10 @@ void File::Flush(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    backend->Flush();
+    {
+        std::lock_guard lock{backend_mutex};
+        backend->Flush();
+    }
     rb.Push(RESULT_SUCCESS);
 }
 
@@ -224,7 +332,10 @@ void File::OpenLinkFile(Kernel::HLERequestContext& ctx) {
 
     slot->priority = original_file->priority;
     slot->offset = 0;
-    slot->size = backend->GetSize();
+    {
+        std::lock_guard lock{backend_mutex};
+        slot->size = backend->GetSize();
+    }
     slot->subfile = false;
 
     rb.Push(RESULT_SUCCESS);
@@ -282,7 +393,10 @@ std::shared_ptr<Kernel::ClientSession> File::Connect() {
     FileSessionSlot* slot = GetSessionData(std::move(server));
     slot->priority = 0;
     slot->offset = 0;
-    slot->size = backend->GetSize();
+    {
+        std::lock_guard lock{backend_mutex};
+        slot->size = backend->GetSize();
+    }
     slot->subfile = false;
 
     return client;
@@ -301,3 +415,5 @@ std::size_t File::GetSessionFileSize(std::shared_ptr<Kernel::ServerSession> sess
 }
 
 } // namespace Service::FS
+
+SERIALIZE_EXPORT_IMPL(Service::FS::File::AsyncReadCallback)
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <boost/serialization/base_object.hpp>
 #include "core/file_sys/archive_backend.h"
 #include "core/global.h"
@@ -61,6 +62,8 @@ public:
     // OpenSubFile.
     std::size_t GetSessionFileSize(std::shared_ptr<Kernel::ServerSession> session);
 
+    class AsyncReadCallback;
+
 private:
     void Read(Kernel::HLERequestContext& ctx);
     void Write(Kernel::HLERequestContext& ctx);
@@ -75,6 +78,9 @@ private:
 
     Kernel::KernelSystem& kernel;
 
+    /// Serializes access to the backend between the emulation thread and in-flight async reads
+    std::mutex backend_mutex;
+
     File(Kernel::KernelSystem& kernel);
     File();
 
@@ -87,3 +93,4 @@ private:
 
 BOOST_CLASS_EXPORT_KEY(Service::FS::FileSessionSlot)
 BOOST_CLASS_EXPORT_KEY(Service::FS::File)
+BOOST_CLASS_EXPORT_KEY(Service::FS::File::AsyncReadCallback)
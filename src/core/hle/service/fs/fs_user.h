@@ -230,6 +230,26 @@ private:
      */
     void OpenArchive(Kernel::HLERequestContext& ctx);
 
+    /**
+     * FS_User::ControlArchive service function
+     *  Inputs:
+     *      0 : 0x080D0144
+     *      1 : Archive handle low word
+     *      2 : Archive handle high word
+     *      3 : Action
+     *      4 : Input size
+     *      5 : Output size
+     *      6 : (InputSize << 4) | 0xA
+     *      7 : Input pointer
+     *      8 : (OutputSize << 4) | 0xC
+     *      9 : Output pointer
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     *      2 : (OutputSize << 4) | 0xC
+     *      3 : Output pointer
+     */
+    void ControlArchive(Kernel::HLERequestContext& ctx);
+
     /**
      * FS_User::CloseArchive service function
      *  Inputs:
@@ -7,12 +7,18 @@
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/shared_memory.h"
 #include "core/hle/service/gsp/gsp.h"
+#include "video_core/gpu_thread.h"
 
 namespace Service::GSP {
 
 static std::weak_ptr<GSP_GPU> gsp_gpu;
 
 void SignalInterrupt(InterruptId interrupt_id) {
+    // Interrupts raised by the GPU thread are signaled once the emulated CPU retires its work
+    if (VideoCore::GPUThread::DeferToCPU([interrupt_id] { SignalInterrupt(interrupt_id); })) {
+        return;
+    }
+
     auto gpu = gsp_gpu.lock();
     ASSERT(gpu != nullptr);
     return gpu->SignalInterrupt(interrupt_id);
@@ -6,6 +6,7 @@
 #include "common/archives.h"
 #include "common/bit_field.h"
 #include "common/microprofile.h"
+#include "common/microprofile_trace.h"
 #include "common/swap.h"
 #include "core/core.h"
 #include "core/hle/ipc.h"
@@ -311,6 +312,7 @@ ResultCode SetBufferSwap(u32 screen_id, const FrameBufferInfo& info) {
         Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::BufferSwapped, nullptr);
 
     if (screen_id == 0) {
+        Common::ProfileTrace::Collect();
         MicroProfileFlip();
         Core::System::GetInstance().perf_stats->EndGameFrame();
     }
@@ -2,7 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #ifdef ENABLE_WEB_SERVICE
 #include <LUrlParser.h>
 #endif
@@ -10,10 +12,13 @@
 #include <cryptopp/modes.h>
 #include "common/archives.h"
 #include "common/assert.h"
+#include "common/thread_worker.h"
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/file_sys/archive_ncch.h"
 #include "core/file_sys/file_backend.h"
 #include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/event.h"
 #include "core/hle/kernel/ipc.h"
 #include "core/hle/romfs.h"
 #include "core/hle/service/fs/archive.h"
@@ -21,6 +26,8 @@
 #include "core/hw/aes/key.h"
 
 SERIALIZE_EXPORT_IMPL(Service::HTTP::HTTP_C)
+SERVICE_CONSTRUCT_IMPL(Service::HTTP::HTTP_C)
+SERIALIZE_EXPORT_IMPL(Service::HTTP::HTTP_C::AsyncReceive)
 SERIALIZE_EXPORT_IMPL(Service::HTTP::SessionData)
 
 namespace Service::HTTP {
@@ -56,46 +63,44 @@ const ResultCode ERROR_WRONG_CERT_HANDLE = // 0xD8A0A0C9
     ResultCode(201, ErrorModule::HTTP, ErrorSummary::InvalidState, ErrorLevel::Permanent);
 const ResultCode ERROR_CERT_ALREADY_SET = // 0xD8A0A03D
     ResultCode(61, ErrorModule::HTTP, ErrorSummary::InvalidState, ErrorLevel::Permanent);
+const ResultCode ERROR_WRONG_REQUEST_STATE = // 0xD8A0A016
+    ResultCode(ErrCodes::InvalidRequestState, ErrorModule::HTTP, ErrorSummary::InvalidState,
+               ErrorLevel::Permanent);
+const ResultCode ERROR_BUFFER_SMALL = // 0xD840A02B
+    ResultCode(43, ErrorModule::HTTP, ErrorSummary::WouldBlock, ErrorLevel::Permanent);
+const ResultCode ERROR_TIMEOUT = // 0xD820A069
+    ResultCode(105, ErrorModule::HTTP, ErrorSummary::NothingHappened, ErrorLevel::Permanent);
+
+/// Number of threads sending the requests of every context
+constexpr std::size_t NumRequestWorkers = 3;
 
-void Context::MakeRequest() {
-    ASSERT(state == RequestState::NotStarted);
+/// How often the contexts are checked for the data of pending receive calls
+constexpr int ReceiveCheckIntervalUs = 500;
+
+/// Amount of response data buffered for a context before its worker waits for the guest to read
+constexpr std::size_t MaxBufferedResponseSize = 1024 * 1024;
 
 #ifdef ENABLE_WEB_SERVICE
-    LUrlParser::clParseURL parsedUrl = LUrlParser::clParseURL::ParseURL(url);
-    int port;
-    std::unique_ptr<httplib::Client> client;
-    if (parsedUrl.m_Scheme == "http") {
-        if (!parsedUrl.GetPort(&port)) {
-            port = 80;
-        }
-        // TODO(B3N30): Support for setting timeout
-        // Figure out what the default timeout on 3DS is
-        client = std::make_unique<httplib::Client>(parsedUrl.m_Host.c_str(), port);
-    } else {
-        if (!parsedUrl.GetPort(&port)) {
-            port = 443;
-        }
-        // TODO(B3N30): Support for setting timeout
-        // Figure out what the default timeout on 3DS is
-
-        auto ssl_client = std::make_unique<httplib::SSLClient>(parsedUrl.m_Host, port);
-        SSL_CTX* ctx = ssl_client->ssl_context();
-        client = std::move(ssl_client);
-
-        if (auto client_cert = ssl_config.client_cert_ctx.lock()) {
-            SSL_CTX_use_certificate_ASN1(ctx, static_cast<int>(client_cert->certificate.size()),
-                                         client_cert->certificate.data());
-            SSL_CTX_use_PrivateKey_ASN1(EVP_PKEY_RSA, ctx, client_cert->private_key.data(),
-                                        static_cast<long>(client_cert->private_key.size()));
-        }
+void Context::MakeRequest(ConnectionPool& pool) {
+    ASSERT(state == RequestState::InProgress);
 
-        // TODO(B3N30): Check for SSLOptions-Bits and set the verify method accordingly
-        // https://www.3dbrew.org/wiki/SSL_Services#SSLOpt
-        // Hack: Since for now RootCerts are not implemented we set the VerifyMode to None.
-        SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, NULL);
+    if (request_canceller.IsCancelled()) {
+        std::lock_guard lock{response_mutex};
+        response_complete = true;
+        return;
     }
 
-    state = RequestState::InProgress;
+    LUrlParser::clParseURL parsedUrl = LUrlParser::clParseURL::ParseURL(url);
+    ConnectionPool::Endpoint endpoint;
+    endpoint.ssl = parsedUrl.m_Scheme != "http";
+    endpoint.host = parsedUrl.m_Host;
+    if (!parsedUrl.GetPort(&endpoint.port)) {
+        endpoint.port = endpoint.ssl ? 443 : 80;
+    }
+    if (auto client_cert = ssl_config.client_cert_ctx.lock(); client_cert && endpoint.ssl) {
+        endpoint.client_cert = client_cert->certificate;
+        endpoint.client_key = client_cert->private_key;
+    }
 
     static const std::unordered_map<RequestMethod, std::string> request_method_strings{
         {RequestMethod::Get, "GET"},       {RequestMethod::Post, "POST"},
@@ -106,20 +111,42 @@ void Context::MakeRequest() {
 
     httplib::Request request;
     request.method = request_method_strings.at(method);
-    request.path = url;
+    request.path = "/" + parsedUrl.m_Path;
+    if (!parsedUrl.m_Query.empty()) {
+        request.path += "?" + parsedUrl.m_Query;
+    }
     // TODO(B3N30): Add post data body
     request.progress = [this](u64 current, u64 total) -> bool {
-        // TODO(B3N30): Is there a state that shows response header are available
         current_download_size_bytes = current;
         total_download_size_bytes = total;
         return true;
     };
+    request.response_handler = [this](const httplib::Response&) {
+        // The guest can start receiving the body once the headers arrived
+        state = RequestState::ReadyToDownloadContent;
+        return true;
+    };
+    request.content_receiver = [this](const char* data, std::size_t length) {
+        std::unique_lock lock{response_mutex};
+        // Stop reading from the connection until the guest catches up, unless a receive call
+        // waits for more data than is buffered
+        response_cv.wait(lock, [this] {
+            return request_canceller.IsCancelled() ||
+                   response_available < std::max(MaxBufferedResponseSize, response_requested);
+        });
+        if (request_canceller.IsCancelled()) {
+            return false;
+        }
+        response_chunks.emplace_back(data, data + length);
+        response_available += length;
+        return true;
+    };
 
     for (const auto& header : headers) {
         request.headers.emplace(header.name, header.value);
     }
 
-    if (!client->send(request, response)) {
+    if (!pool.Send(endpoint, request, response, &request_canceller)) {
         LOG_ERROR(Service_HTTP, "Request failed");
         state = RequestState::TimedOut;
     } else {
@@ -127,12 +154,54 @@ void Context::MakeRequest() {
         // TODO(B3N30): Verify this state on HW
         state = RequestState::ReadyToDownloadContent;
     }
-#else
-    LOG_ERROR(Service_HTTP, "Tried to make request but WebServices is not enabled in this build");
-    state = RequestState::TimedOut;
+
+    std::lock_guard lock{response_mutex};
+    response_complete = true;
+}
+#endif
+
+void Context::CancelRequest() {
+#ifdef ENABLE_WEB_SERVICE
+    request_canceller.Cancel();
+    // Wakes the worker if it waits for the guest to read the response
+    std::lock_guard lock{response_mutex};
+    response_cv.notify_all();
 #endif
 }
 
+bool Context::IsResponseDataReady(std::size_t size) {
+    std::lock_guard lock{response_mutex};
+    if (size != response_requested) {
+        response_requested = size;
+        response_cv.notify_all();
+    }
+    return response_available >= size || response_complete;
+}
+
+std::size_t Context::ReadResponseData(Kernel::MappedBuffer& buffer, std::size_t size) {
+    std::lock_guard lock{response_mutex};
+    std::size_t written = 0;
+    while (written < size && !response_chunks.empty()) {
+        const std::vector<u8>& chunk = response_chunks.front();
+        const std::size_t length = std::min(size - written, chunk.size() - response_chunk_offset);
+        buffer.Write(chunk.data() + response_chunk_offset, written, length);
+        written += length;
+        response_chunk_offset += length;
+        if (response_chunk_offset == chunk.size()) {
+            response_chunks.pop_front();
+            response_chunk_offset = 0;
+        }
+    }
+    response_available -= written;
+    response_cv.notify_all();
+    return written;
+}
+
+bool Context::IsResponseDataRead() {
+    std::lock_guard lock{response_mutex};
+    return response_complete && response_available == 0;
+}
+
 void HTTP_C::Initialize(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x1, 1, 4);
     const u32 shmem_size = rp.Pop<u32>();
@@ -242,10 +311,7 @@ void HTTP_C::BeginRequest(Kernel::HLERequestContext& ctx) {
     // trying to enqueue any more will either fail (BeginRequestAsync), or block (BeginRequest)
     // Note that you only can have 8 Contexts at a time. So this difference shouldn't matter
     // Then there are 3? worker threads that pop the requests from the queue and send them
-    // For now make every request async in it's own thread.
-
-    itr->second.request_future =
-        std::async(std::launch::async, &Context::MakeRequest, std::ref(itr->second));
+    QueueRequest(itr->second);
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
@@ -295,15 +361,200 @@ void HTTP_C::BeginRequestAsync(Kernel::HLERequestContext& ctx) {
     // trying to enqueue any more will either fail (BeginRequestAsync), or block (BeginRequest)
     // Note that you only can have 8 Contexts at a time. So this difference shouldn't matter
     // Then there are 3? worker threads that pop the requests from the queue and send them
-    // For now make every request async in it's own thread.
-
-    itr->second.request_future =
-        std::async(std::launch::async, &Context::MakeRequest, std::ref(itr->second));
+    QueueRequest(itr->second);
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
 }
 
+void HTTP_C::ReceiveData(Kernel::HLERequestContext& ctx) {
+    ReceiveDataImpl(ctx, false);
+}
+
+void HTTP_C::ReceiveDataTimeout(Kernel::HLERequestContext& ctx) {
+    ReceiveDataImpl(ctx, true);
+}
+
+/**
+ * Completes a receive call whose client thread slept until enough of the response data arrived.
+ * The requests in progress can't be saved, so neither can the receive calls waiting for them.
+ */
+class HTTP_C::AsyncReceive final : public Kernel::HLERequestContext::WakeupCallback {
+public:
+    AsyncReceive(HTTP_C& http_, bool timeout_) : http(&http_), timeout(timeout_) {}
+
+    void WakeUp(std::shared_ptr<Kernel::Thread> thread, Kernel::HLERequestContext& ctx,
+                Kernel::ThreadWakeupReason reason) override {
+        if (http == nullptr) {
+            // The request in progress is gone, so the call fails. The call is still in the
+            // command buffer, as the response is only written here.
+            LOG_ERROR(Service_HTTP, "ReceiveData was restored from a savestate");
+            IPC::RequestParser rp(ctx, timeout ? 0xC : 0xB, timeout ? 4 : 2, 2);
+            rp.Skip(timeout ? 4 : 2, false);
+            Kernel::MappedBuffer& buffer = rp.PopMappedBuffer();
+            IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
+            rb.Push(ERROR_WRONG_REQUEST_STATE);
+            rb.PushMappedBuffer(buffer);
+            return;
+        }
+        if (reason == Kernel::ThreadWakeupReason::Timeout) {
+            http->pending_receives.erase(id);
+        }
+        http->FinishReceiveData(ctx, timeout);
+    }
+
+    u64 id = 0;
+
+private:
+    AsyncReceive() = default;
+
+    HTTP_C* http = nullptr;
+    bool timeout = false;
+
+    template <class Archive>
+    void serialize(Archive& ar, const unsigned int) {
+        ar& boost::serialization::base_object<Kernel::HLERequestContext::WakeupCallback>(*this);
+        ar& timeout;
+    }
+    friend class boost::serialization::access;
+};
+
+void HTTP_C::ReceiveDataImpl(Kernel::HLERequestContext& ctx, bool timeout) {
+    IPC::RequestParser rp(ctx, timeout ? 0xC : 0xB, timeout ? 4 : 2, 2);
+    const Context::Handle context_handle = rp.Pop<u32>();
+    const u32 buffer_size = rp.Pop<u32>();
+    // Values that don't fit are negative, which means no timeout
+    std::chrono::nanoseconds timeout_duration{-1};
+    if (timeout) {
+        timeout_duration = std::chrono::nanoseconds(static_cast<s64>(rp.Pop<u64>()));
+    }
+    Kernel::MappedBuffer& buffer = rp.PopMappedBuffer();
+
+    LOG_DEBUG(Service_HTTP, "called, context_id={} buffer_size={}", context_handle, buffer_size);
+
+    auto* session_data = GetSessionData(ctx.Session());
+    ASSERT(session_data);
+
+    if (!session_data->initialized) {
+        LOG_ERROR(Service_HTTP, "Tried to receive data on an uninitialized session");
+        IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
+        rb.Push(ERROR_STATE_ERROR);
+        rb.PushMappedBuffer(buffer);
+        return;
+    }
+
+    if (session_data->current_http_context != context_handle) {
+        LOG_ERROR(Service_HTTP,
+                  "Tried to receive data on a mismatched session input context={} session "
+                  "context={}",
+                  context_handle, session_data->current_http_context.value_or(0));
+        IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
+        rb.Push(ERROR_STATE_ERROR);
+        rb.PushMappedBuffer(buffer);
+        return;
+    }
+
+    auto itr = contexts.find(context_handle);
+    ASSERT(itr != contexts.end());
+    Context& http_context = *itr->second;
+
+    if (http_context.state == RequestState::NotStarted) {
+        LOG_ERROR(Service_HTTP, "Tried to receive data before beginning the request");
+        IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
+        rb.Push(ERROR_WRONG_REQUEST_STATE);
+        rb.PushMappedBuffer(buffer);
+        return;
+    }
+
+    // The body is copied as it arrives, so that the guest doesn't wait for the whole response
+    const std::size_t size = std::min<std::size_t>(buffer_size, buffer.GetSize());
+    if (http_context.IsResponseDataReady(size) || timeout_duration.count() == 0) {
+        FinishReceiveData(ctx, timeout);
+        return;
+    }
+
+    auto call = std::make_shared<AsyncReceive>(*this, timeout);
+    call->id = next_receive_id++;
+    auto event = ctx.SleepClientThread("http_c::ReceiveData", timeout_duration, call);
+    pending_receives.emplace(call->id, PendingReceive{context_handle, size, std::move(event)});
+
+    if (!receive_event_scheduled) {
+        receive_event_scheduled = true;
+        system.CoreTiming().ScheduleEvent(usToCycles(ReceiveCheckIntervalUs), receive_event);
+    }
+}
+
+void HTTP_C::FinishReceiveData(Kernel::HLERequestContext& ctx, bool timeout) {
+    IPC::RequestParser rp(ctx, timeout ? 0xC : 0xB, timeout ? 4 : 2, 2);
+    const Context::Handle context_handle = rp.Pop<u32>();
+    const u32 buffer_size = rp.Pop<u32>();
+    if (timeout) {
+        rp.Skip(2, false);
+    }
+    Kernel::MappedBuffer& buffer = rp.PopMappedBuffer();
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
+
+    const auto itr = contexts.find(context_handle);
+    if (itr == contexts.end()) {
+        LOG_ERROR(Service_HTTP, "Context {} was closed while receiving data", context_handle);
+        rb.Push(ERROR_WRONG_REQUEST_STATE);
+        rb.PushMappedBuffer(buffer);
+        return;
+    }
+    Context& http_context = *itr->second;
+
+    const std::size_t size = std::min<std::size_t>(buffer_size, buffer.GetSize());
+    if (!http_context.IsResponseDataReady(size)) {
+        rb.Push(ERROR_TIMEOUT);
+    } else {
+        http_context.ReadResponseData(buffer, size);
+        if (http_context.state == RequestState::TimedOut) {
+            rb.Push(ERROR_WRONG_REQUEST_STATE);
+        } else if (!http_context.IsResponseDataRead()) {
+            // There is more data than the buffer can hold
+            rb.Push(ERROR_BUFFER_SMALL);
+        } else {
+            rb.Push(RESULT_SUCCESS);
+        }
+    }
+    rb.PushMappedBuffer(buffer);
+}
+
+void HTTP_C::WakeReceivedData(s64 cycles_late) {
+    for (auto it = pending_receives.begin(); it != pending_receives.end();) {
+        const auto context = contexts.find(it->second.context_handle);
+        if (context == contexts.end() || context->second->IsResponseDataReady(it->second.size)) {
+            it->second.event->Signal();
+            it = pending_receives.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    receive_event_scheduled = !pending_receives.empty();
+    if (receive_event_scheduled) {
+        system.CoreTiming().ScheduleEvent(usToCycles(ReceiveCheckIntervalUs) - cycles_late,
+                                          receive_event);
+    }
+}
+
+void HTTP_C::QueueRequest(const std::shared_ptr<Context>& context) {
+    ASSERT(context->state == RequestState::NotStarted);
+    context->state = RequestState::InProgress;
+
+#ifdef ENABLE_WEB_SERVICE
+    if (!request_workers) {
+        request_workers = std::make_unique<Common::ThreadWorker>(NumRequestWorkers, "HTTP:C");
+    }
+    request_workers->QueueWork([context, pool = connection_pool] { context->MakeRequest(*pool); });
+#else
+    LOG_ERROR(Service_HTTP, "Tried to make request but WebServices is not enabled in this build");
+    context->state = RequestState::TimedOut;
+    std::lock_guard lock{context->response_mutex};
+    context->response_complete = true;
+#endif
+}
+
 void HTTP_C::CreateContext(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x2, 2, 2);
     const u32 url_size = rp.Pop<u32>();
@@ -360,14 +611,14 @@ void HTTP_C::CreateContext(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    contexts.try_emplace(++context_counter);
-    contexts[context_counter].url = std::move(url);
-    contexts[context_counter].method = method;
-    contexts[context_counter].state = RequestState::NotStarted;
+    contexts.emplace(++context_counter, std::make_shared<Context>());
+    contexts[context_counter]->url = std::move(url);
+    contexts[context_counter]->method = method;
+    contexts[context_counter]->state = RequestState::NotStarted;
     // TODO(Subv): Find a correct default value for this field.
-    contexts[context_counter].socket_buffer_size = 0;
-    contexts[context_counter].handle = context_counter;
-    contexts[context_counter].session_id = session_data->session_id;
+    contexts[context_counter]->socket_buffer_size = 0;
+    contexts[context_counter]->handle = context_counter;
+    contexts[context_counter]->session_id = session_data->session_id;
 
     session_data->num_http_contexts++;
 
@@ -409,7 +660,8 @@ void HTTP_C::CloseContext(Kernel::HLERequestContext& ctx) {
     // TODO(Subv): What happens if you try to close a context that's currently being used?
     // TODO(Subv): Make sure that only the session that created the context can close it.
 
-    // Note that this will block if a request is still in progress
+    // A request that is still in progress is aborted, its worker drops the context afterwards
+    itr->second->CancelRequest();
     contexts.erase(itr);
     session_data->num_http_contexts--;
 
@@ -471,7 +723,7 @@ void HTTP_C::AddRequestHeader(Kernel::HLERequestContext& ctx) {
     auto itr = contexts.find(context_handle);
     ASSERT(itr != contexts.end());
 
-    if (itr->second.state != RequestState::NotStarted) {
+    if (itr->second->state != RequestState::NotStarted) {
         LOG_ERROR(Service_HTTP,
                   "Tried to add a request header on a context that has already been started.");
         IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
@@ -481,12 +733,12 @@ void HTTP_C::AddRequestHeader(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    ASSERT(std::find_if(itr->second.headers.begin(), itr->second.headers.end(),
+    ASSERT(std::find_if(itr->second->headers.begin(), itr->second->headers.end(),
                         [&name](const Context::RequestHeader& m) -> bool {
                             return m.name == name;
-                        }) == itr->second.headers.end());
+                        }) == itr->second->headers.end());
 
-    itr->second.headers.emplace_back(name, value);
+    itr->second->headers.emplace_back(name, value);
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
     rb.Push(RESULT_SUCCESS);
@@ -547,7 +799,7 @@ void HTTP_C::AddPostDataAscii(Kernel::HLERequestContext& ctx) {
     auto itr = contexts.find(context_handle);
     ASSERT(itr != contexts.end());
 
-    if (itr->second.state != RequestState::NotStarted) {
+    if (itr->second->state != RequestState::NotStarted) {
         LOG_ERROR(Service_HTTP,
                   "Tried to add post data on a context that has already been started.");
         IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
@@ -557,11 +809,11 @@ void HTTP_C::AddPostDataAscii(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    ASSERT(std::find_if(itr->second.post_data.begin(), itr->second.post_data.end(),
+    ASSERT(std::find_if(itr->second->post_data.begin(), itr->second->post_data.end(),
                         [&name](const Context::PostData& m) -> bool { return m.name == name; }) ==
-           itr->second.post_data.end());
+           itr->second->post_data.end());
 
-    itr->second.post_data.emplace_back(name, value);
+    itr->second->post_data.emplace_back(name, value);
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
     rb.Push(RESULT_SUCCESS);
@@ -616,7 +868,7 @@ void HTTP_C::SetClientCertContext(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    if (http_context_itr->second.ssl_config.client_cert_ctx.lock()) {
+    if (http_context_itr->second->ssl_config.client_cert_ctx.lock()) {
         LOG_ERROR(Service_HTTP,
                   "Tried to set a client cert to a context that already has a client cert");
         IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
@@ -624,7 +876,7 @@ void HTTP_C::SetClientCertContext(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    if (http_context_itr->second.state != RequestState::NotStarted) {
+    if (http_context_itr->second->state != RequestState::NotStarted) {
         LOG_ERROR(Service_HTTP,
                   "Tried to set a client cert on a context that has already been started.");
         IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
@@ -633,7 +885,7 @@ void HTTP_C::SetClientCertContext(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    http_context_itr->second.ssl_config.client_cert_ctx = cert_context_itr->second;
+    http_context_itr->second->ssl_config.client_cert_ctx = cert_context_itr->second;
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
 }
@@ -886,7 +1138,7 @@ void HTTP_C::DecryptClCertA() {
     ClCertA.init = true;
 }
 
-HTTP_C::HTTP_C() : ServiceFramework("http:C", 32) {
+HTTP_C::HTTP_C(Core::System& system) : ServiceFramework("http:C", 32), system(system) {
     static const FunctionInfo functions[] = {
         {0x00010044, &HTTP_C::Initialize, "Initialize"},
         {0x00020082, &HTTP_C::CreateContext, "CreateContext"},
@@ -898,8 +1150,8 @@ HTTP_C::HTTP_C() : ServiceFramework("http:C", 32) {
         {0x00080042, &HTTP_C::InitializeConnectionSession, "InitializeConnectionSession"},
         {0x00090040, &HTTP_C::BeginRequest, "BeginRequest"},
         {0x000A0040, &HTTP_C::BeginRequestAsync, "BeginRequestAsync"},
-        {0x000B0082, nullptr, "ReceiveData"},
-        {0x000C0102, nullptr, "ReceiveDataTimeout"},
+        {0x000B0082, &HTTP_C::ReceiveData, "ReceiveData"},
+        {0x000C0102, &HTTP_C::ReceiveDataTimeout, "ReceiveDataTimeout"},
         {0x000D0146, nullptr, "SetProxy"},
         {0x000E0040, nullptr, "SetProxyDefault"},
         {0x000F00C4, nullptr, "SetBasicAuthorization"},
@@ -948,10 +1200,28 @@ HTTP_C::HTTP_C() : ServiceFramework("http:C", 32) {
     RegisterHandlers(functions);
 
     DecryptClCertA();
+
+#ifdef ENABLE_WEB_SERVICE
+    connection_pool = std::make_shared<ConnectionPool>();
+#endif
+
+    receive_event = system.CoreTiming().RegisterEvent(
+        "HTTP_C::WakeReceivedData",
+        [this](u64 userdata, s64 cycles_late) { WakeReceivedData(cycles_late); });
+}
+
+HTTP_C::~HTTP_C() {
+    // The client threads of the pending receive calls are not woken up anymore
+    pending_receives.clear();
+    // Drop the queued requests and abort the ones in progress instead of waiting for them
+    for (auto& [handle, context] : contexts) {
+        context->CancelRequest();
+    }
+    request_workers.reset();
 }
 
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
-    std::make_shared<HTTP_C>()->InstallAsService(service_manager);
+    std::make_shared<HTTP_C>(system)->InstallAsService(service_manager);
 }
 } // namespace Service::HTTP
@@ -4,8 +4,10 @@
 
 #pragma once
 
-#include <future>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <unordered_map>
@@ -17,21 +19,29 @@
 #include <boost/serialization/unordered_map.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/weak_ptr.hpp>
+#include "core/hle/kernel/shared_memory.h"
 #ifdef ENABLE_WEB_SERVICE
-#if defined(__ANDROID__)
-#include <ifaddrs.h>
-#endif
-#include <httplib.h>
+#include "core/hle/service/http_connection_pool.h"
 #endif
-#include "core/hle/kernel/shared_memory.h"
 #include "core/hle/service/service.h"
 
+namespace Common {
+class ThreadWorker;
+}
+
 namespace Core {
 class System;
+struct TimingEventType;
+} // namespace Core
+
+namespace Kernel {
+class Event;
 }
 
 namespace Service::HTTP {
 
+class ConnectionPool;
+
 enum class RequestMethod : u8 {
     None = 0x0,
     Get = 0x1,
@@ -121,7 +131,29 @@ public:
     Context(const Context&) = delete;
     Context& operator=(const Context&) = delete;
 
-    void MakeRequest();
+#ifdef ENABLE_WEB_SERVICE
+    /// Sends the request and receives the response, on one of the request workers
+    void MakeRequest(ConnectionPool& pool);
+#endif
+
+    /**
+     * Makes the worker stop sending the request or receiving its response. A request that is in
+     * progress is aborted by shutting down its connection.
+     */
+    void CancelRequest();
+
+    /**
+     * Returns whether enough of the response body was received to fill a guest buffer of the given
+     * size, or the whole response was received. The worker keeps receiving until that much is
+     * buffered, even past the usual limit.
+     */
+    bool IsResponseDataReady(std::size_t size);
+
+    /// Moves up to size bytes of the received response body into a guest buffer
+    std::size_t ReadResponseData(Kernel::MappedBuffer& buffer, std::size_t size);
+
+    /// Returns whether the whole response body was received and read by the guest
+    bool IsResponseDataRead();
 
     struct Proxy {
         std::string url;
@@ -210,12 +242,29 @@ public:
     std::vector<RequestHeader> headers;
     std::vector<PostData> post_data;
 
-    std::future<void> request_future;
     std::atomic<u64> current_download_size_bytes;
     std::atomic<u64> total_download_size_bytes;
 #ifdef ENABLE_WEB_SERVICE
+    /// Status and headers of the response, the body is streamed to response_chunks instead
     httplib::Response response;
 #endif
+
+    std::mutex response_mutex;
+    /// Signaled when the guest read response data or wants more, and when the request is cancelled
+    std::condition_variable response_cv;
+    /// Parts of the response body that were received but not read by the guest yet
+    std::deque<std::vector<u8>> response_chunks;
+    /// Number of bytes of the first chunk that were read already
+    std::size_t response_chunk_offset = 0;
+    /// Number of bytes in response_chunks that were not read yet
+    std::size_t response_available = 0;
+    /// Size of the buffer of the last receive call of the guest
+    std::size_t response_requested = 0;
+    /// Whether the worker finished the request, successfully or not
+    bool response_complete = false;
+#ifdef ENABLE_WEB_SERVICE
+    RequestCanceller request_canceller;
+#endif
 };
 
 struct SessionData : public Kernel::SessionRequestHandler::SessionDataBase {
@@ -250,7 +299,10 @@ private:
 
 class HTTP_C final : public ServiceFramework<HTTP_C, SessionData> {
 public:
-    HTTP_C();
+    explicit HTTP_C(Core::System& system);
+    ~HTTP_C();
+
+    class AsyncReceive;
 
 private:
     /**
@@ -317,6 +369,50 @@ private:
      */
     void BeginRequestAsync(Kernel::HLERequestContext& ctx);
 
+    /**
+     * HTTP_C::ReceiveData service function
+     *  Inputs:
+     *      1 : Context handle
+     *      2 : Buffer size
+     *      3 : (BufferSize<<4) | 12
+     *      4 : Buffer data pointer
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     *      2 : (BufferSize<<4) | 12
+     *      3 : Buffer data pointer
+     */
+    void ReceiveData(Kernel::HLERequestContext& ctx);
+
+    /**
+     * HTTP_C::ReceiveDataTimeout service function
+     *  Inputs:
+     *      1 : Context handle
+     *      2 : Buffer size
+     *      3-4 : u64 Timeout in nanoseconds
+     *      5 : (BufferSize<<4) | 12
+     *      6 : Buffer data pointer
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     *      2 : (BufferSize<<4) | 12
+     *      3 : Buffer data pointer
+     */
+    void ReceiveDataTimeout(Kernel::HLERequestContext& ctx);
+
+    /**
+     * Receives response data, like ReceiveData and ReceiveDataTimeout. Until enough of the
+     * response arrived, the client thread sleeps instead of blocking the emulator thread.
+     */
+    void ReceiveDataImpl(Kernel::HLERequestContext& ctx, bool timeout);
+
+    /// Moves the received data into the buffer of a ReceiveData call and writes its response
+    void FinishReceiveData(Kernel::HLERequestContext& ctx, bool timeout);
+
+    /// Wakes up the client threads of the receive calls whose data arrived
+    void WakeReceivedData(s64 cycles_late);
+
+    /// Queues the request of a context to the request workers
+    void QueueRequest(const std::shared_ptr<Context>& context);
+
     /**
      * HTTP_C::AddRequestHeader service function
      *  Inputs:
@@ -421,8 +517,9 @@ private:
     /// The next handle number to use when a new ClientCert context is created.
     ClientCertContext::Handle client_certs_counter = 0;
 
-    /// Global list of HTTP contexts currently opened.
-    std::unordered_map<Context::Handle, Context> contexts;
+    /// Global list of HTTP contexts currently opened. The request workers share the contexts of
+    /// the requests in progress, so that closing a context doesn't wait for its request.
+    std::unordered_map<Context::Handle, std::shared_ptr<Context>> contexts;
 
     /// Global list of  ClientCert contexts currently opened.
     std::unordered_map<ClientCertContext::Handle, std::shared_ptr<ClientCertContext>> client_certs;
@@ -433,6 +530,26 @@ private:
         bool init = false;
     } ClCertA;
 
+    /// Connections kept open between requests, shared by every context
+    std::shared_ptr<ConnectionPool> connection_pool;
+
+    /// Threads that send the requests, created on the first request. Like on the 3DS, there are
+    /// only a few of them and the other requests wait in a queue.
+    std::unique_ptr<Common::ThreadWorker> request_workers;
+
+    /// A receive call whose client thread sleeps until the response data arrived
+    struct PendingReceive {
+        Context::Handle context_handle;
+        std::size_t size;
+        std::shared_ptr<Kernel::Event> event;
+    };
+
+    Core::System& system;
+    Core::TimingEventType* receive_event = nullptr;
+    bool receive_event_scheduled = false;
+    u64 next_receive_id = 0;
+    std::unordered_map<u64, PendingReceive> pending_receives;
+
 private:
     template <class Archive>
     void serialize(Archive& ar, const unsigned int) {
@@ -456,5 +573,7 @@ void InstallInterfaces(Core::System& system);
 
 } // namespace Service::HTTP
 
+SERVICE_CONSTRUCT(Service::HTTP::HTTP_C)
 BOOST_CLASS_EXPORT_KEY(Service::HTTP::HTTP_C)
+BOOST_CLASS_EXPORT_KEY(Service::HTTP::HTTP_C::AsyncReceive)
 BOOST_CLASS_EXPORT_KEY(Service::HTTP::SessionData)
@@ -0,0 +1,373 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include <fmt/format.h>
+#ifndef _WIN32
+#include <netinet/tcp.h>
+#endif
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "core/hle/service/http_connection_pool.h"
+
+namespace Service::HTTP {
+
+/// Maximum number of idle connections kept open per endpoint
+constexpr std::size_t MaxIdleConnections = 4;
+/// Idle connections older than this are not reused, as the server has likely closed them
+constexpr std::chrono::seconds IdleTimeout{30};
+// TODO(B3N30): Figure out what the default timeout on 3DS is
+constexpr time_t ConnectTimeoutSec = 300;
+
+struct ConnectionPool::Connection {
+    socket_t socket = INVALID_SOCKET;
+    SSL* ssl = nullptr;
+    std::chrono::steady_clock::time_point idle_since;
+};
+
+struct ConnectionPool::Host {
+    ~Host() {
+        for (Connection& connection : idle) {
+            Close(connection);
+        }
+        if (session) {
+            SSL_SESSION_free(session);
+        }
+        if (ssl_context) {
+            SSL_CTX_free(ssl_context);
+        }
+    }
+
+    SSL_CTX* ssl_context = nullptr;
+    /// Session of the last TLS connection, used to resume it in new connections
+    SSL_SESSION* session = nullptr;
+    std::vector<Connection> idle;
+};
+
+static std::string GetEndpointKey(const ConnectionPool::Endpoint& endpoint) {
+    // Connections presenting different client certificates can't be shared
+    const u64 cert_hash =
+        Common::ComputeHash64(endpoint.client_cert.data(), endpoint.client_cert.size());
+    return fmt::format("{}://{}:{}#{:016x}", endpoint.ssl ? "https" : "http", endpoint.host,
+                       endpoint.port, cert_hash);
+}
+
+static bool WriteAll(httplib::Stream& stream, const std::string& data) {
+    std::size_t written = 0;
+    while (written < data.size()) {
+        const int result = stream.write(data.data() + written, data.size() - written);
+        if (result <= 0) {
+            return false;
+        }
+        written += static_cast<std::size_t>(result);
+    }
+    return true;
+}
+
+static std::string FormatRequestHead(const ConnectionPool::Endpoint& endpoint,
+                                     const httplib::Request& request) {
+    std::string head = fmt::format("{} {} HTTP/1.1\r\n", request.method, request.path);
+    if (!request.has_header("Host")) {
+        const bool default_port = endpoint.port == (endpoint.ssl ? 443 : 80);
+        head += default_port ? fmt::format("Host: {}\r\n", endpoint.host)
+                             : fmt::format("Host: {}:{}\r\n", endpoint.host, endpoint.port);
+    }
+    if (!request.has_header("Accept")) {
+        head += "Accept: */*\r\n";
+    }
+    if (!request.has_header("Content-Length")) {
+        head += fmt::format("Content-Length: {}\r\n", request.body.size());
+    }
+    for (const auto& [name, value] : request.headers) {
+        head += fmt::format("{}: {}\r\n", name, value);
+    }
+    head += "\r\n";
+    return head;
+}
+
+/// Returns whether sending a request again has the same effect as sending it once
+static bool IsIdempotent(const std::string& method) {
+    return method == "GET" || method == "HEAD" || method == "PUT" || method == "DELETE" ||
+           method == "OPTIONS" || method == "TRACE";
+}
+
+/// Parses a status line such as "HTTP/1.1 200 OK"
+static bool ParseStatusLine(const std::string& line, httplib::Response& response) {
+    if (line.size() < 12 || line.compare(0, 7, "HTTP/1.") != 0 || line[8] != ' ') {
+        return false;
+    }
+    response.version = line.substr(0, 8);
+    response.status = std::atoi(line.c_str() + 9);
+    return response.status != 0;
+}
+
+void RequestCanceller::Cancel() {
+    std::lock_guard lock{mutex};
+    cancelled = true;
+    if (socket != INVALID_SOCKET) {
+        httplib::detail::shutdown_socket(socket);
+    }
+}
+
+bool RequestCanceller::IsCancelled() const {
+    std::lock_guard lock{mutex};
+    return cancelled;
+}
+
+bool RequestCanceller::Attach(socket_t connection_socket) {
+    std::lock_guard lock{mutex};
+    if (cancelled) {
+        return false;
+    }
+    socket = connection_socket;
+    return true;
+}
+
+void RequestCanceller::Detach() {
+    std::lock_guard lock{mutex};
+    socket = INVALID_SOCKET;
+}
+
+ConnectionPool::ConnectionPool() = default;
+
+ConnectionPool::~ConnectionPool() = default;
+
+bool ConnectionPool::Send(const Endpoint& endpoint, const httplib::Request& request,
+                          httplib::Response& response, RequestCanceller* canceller) {
+    // A server may close an idle connection at any time, which is only noticed when the request
+    // is sent on it. The request is sent again on another connection in that case, unless the
+    // server may have acted on it already and sending it twice would not be safe.
+    const bool can_retry = IsIdempotent(request.method);
+    while (true) {
+        response = httplib::Response();
+        if (canceller && canceller->IsCancelled()) {
+            return false;
+        }
+        bool reused = false;
+        std::optional<Connection> connection = Acquire(endpoint, reused);
+        if (!connection) {
+            return false;
+        }
+        if (canceller && !canceller->Attach(connection->socket)) {
+            Close(*connection);
+            return false;
+        }
+
+        bool received_response = false;
+        bool keep_alive = false;
+        const bool success = Exchange(*connection, endpoint, request, response,
+                                      received_response, keep_alive);
+        if (canceller) {
+            canceller->Detach();
+        }
+        if (success) {
+            Release(endpoint, *connection, keep_alive);
+        } else {
+            Close(*connection);
+        }
+        if (success || !reused || received_response || !can_retry) {
+            return success;
+        }
+    }
+}
+
+ConnectionPool::Stats ConnectionPool::GetStats() const {
+    std::lock_guard lock{mutex};
+    return stats;
+}
+
+std::optional<ConnectionPool::Connection> ConnectionPool::Acquire(const Endpoint& endpoint,
+                                                                  bool& reused) {
+    SSL_CTX* ssl_context = nullptr;
+    SSL_SESSION* session = nullptr;
+    {
+        std::lock_guard lock{mutex};
+        Host& host = GetHost(endpoint);
+        const auto now = std::chrono::steady_clock::now();
+        while (!host.idle.empty()) {
+            Connection connection = host.idle.back();
+            host.idle.pop_back();
+            // An idle connection is only readable when the server closed it
+            if (now - connection.idle_since < IdleTimeout &&
+                httplib::detail::select_read(connection.socket, 0, 0) == 0) {
+                ++stats.connections_reused;
+                reused = true;
+                return connection;
+            }
+            Close(connection);
+        }
+        ssl_context = host.ssl_context;
+        if (host.session) {
+            session = host.session;
+            SSL_SESSION_up_ref(session);
+        }
+    }
+
+    Connection connection;
+    connection.socket = httplib::detail::create_client_socket(
+        endpoint.host.c_str(), endpoint.port, ConnectTimeoutSec, std::string());
+    if (connection.socket == INVALID_SOCKET) {
+        LOG_ERROR(Service_HTTP, "Failed to connect to {}:{}", endpoint.host, endpoint.port);
+        if (session) {
+            SSL_SESSION_free(session);
+        }
+        return std::nullopt;
+    }
+
+    // The request head and body are written separately, don't wait for an ACK in between
+    const int no_delay = 1;
+    setsockopt(connection.socket, IPPROTO_TCP, TCP_NODELAY,
+               reinterpret_cast<const char*>(&no_delay), sizeof(no_delay));
+
+    bool resumed = false;
+    if (endpoint.ssl) {
+        connection.ssl = SSL_new(ssl_context);
+        BIO* bio = BIO_new_socket(static_cast<int>(connection.socket), BIO_NOCLOSE);
+        SSL_set_bio(connection.ssl, bio, bio);
+        SSL_set_tlsext_host_name(connection.ssl, endpoint.host.c_str());
+        if (session) {
+            SSL_set_session(connection.ssl, session);
+            SSL_SESSION_free(session);
+        }
+        if (SSL_connect(connection.ssl) != 1) {
+            LOG_ERROR(Service_HTTP, "TLS handshake with {}:{} failed", endpoint.host,
+                      endpoint.port);
+            Close(connection);
+            return std::nullopt;
+        }
+        resumed = SSL_session_reused(connection.ssl) != 0;
+    }
+
+    std::lock_guard lock{mutex};
+    ++stats.connections_opened;
+    if (resumed) {
+        ++stats.sessions_resumed;
+    }
+    reused = false;
+    return connection;
+}
+
+void ConnectionPool::Release(const Endpoint& endpoint, Connection connection, bool keep_alive) {
+    std::lock_guard lock{mutex};
+    Host& host = GetHost(endpoint);
+    if (connection.ssl) {
+        // With TLS 1.3 the session tickets arrive after the handshake, so take it now
+        if (SSL_SESSION* session = SSL_get1_session(connection.ssl)) {
+            if (host.session) {
+                SSL_SESSION_free(host.session);
+            }
+            host.session = session;
+        }
+    }
+    if (!keep_alive) {
+        Close(connection);
+        return;
+    }
+    if (host.idle.size() >= MaxIdleConnections) {
+        Close(host.idle.front());
+        host.idle.erase(host.idle.begin());
+    }
+    connection.idle_since = std::chrono::steady_clock::now();
+    host.idle.push_back(connection);
+}
+
+bool ConnectionPool::Exchange(Connection& connection, const Endpoint& endpoint,
+                              const httplib::Request& request, httplib::Response& response,
+                              bool& received_response, bool& keep_alive) {
+    std::unique_ptr<httplib::Stream> stream;
+    if (connection.ssl) {
+        stream = std::make_unique<httplib::detail::SSLSocketStream>(
+            connection.socket, connection.ssl, CPPHTTPLIB_READ_TIMEOUT_SECOND,
+            CPPHTTPLIB_READ_TIMEOUT_USECOND);
+    } else {
+        stream = std::make_unique<httplib::detail::SocketStream>(
+            connection.socket, CPPHTTPLIB_READ_TIMEOUT_SECOND, CPPHTTPLIB_READ_TIMEOUT_USECOND);
+    }
+
+    if (!WriteAll(*stream, FormatRequestHead(endpoint, request)) ||
+        !WriteAll(*stream, request.body)) {
+        return false;
+    }
+
+    std::array<char, 2048> buffer;
+    httplib::detail::stream_line_reader line_reader(*stream, buffer.data(), buffer.size());
+    if (!line_reader.getline()) {
+        return false;
+    }
+    received_response = true;
+    if (!ParseStatusLine(std::string(line_reader.ptr(), line_reader.size()), response) ||
+        !httplib::detail::read_headers(*stream, response.headers)) {
+        return false;
+    }
+
+    const bool has_body = request.method != "HEAD" && response.status >= 200 &&
+                          response.status != 204 && response.status != 304;
+    // Without a length, the end of the body is where the server closes the connection
+    const bool has_length = !has_body ||
+                            httplib::detail::is_chunked_transfer_encoding(response.headers) ||
+                            response.has_header("Content-Length");
+    keep_alive = response.version == "HTTP/1.1" && has_length &&
+                 response.get_header_value("Connection") != "close";
+
+    if (request.response_handler && !request.response_handler(response)) {
+        return false;
+    }
+    if (!has_body) {
+        return true;
+    }
+
+    httplib::ContentReceiver receiver = request.content_receiver;
+    if (!receiver) {
+        receiver = [&response](const char* data, std::size_t length) {
+            response.body.append(data, length);
+            return true;
+        };
+    }
+    int status = 0;
+    return httplib::detail::read_content(*stream, response,
+                                         std::numeric_limits<std::size_t>::max(), status,
+                                         request.progress, receiver);
+}
+
+ConnectionPool::Host& ConnectionPool::GetHost(const Endpoint& endpoint) {
+    auto& host = hosts[GetEndpointKey(endpoint)];
+    if (host) {
+        return *host;
+    }
+
+    host = std::make_unique<Host>();
+    if (endpoint.ssl) {
+        host->ssl_context = SSL_CTX_new(SSLv23_client_method());
+        SSL_CTX_set_session_cache_mode(host->ssl_context, SSL_SESS_CACHE_CLIENT);
+        if (!endpoint.client_cert.empty()) {
+            SSL_CTX_use_certificate_ASN1(host->ssl_context,
+                                         static_cast<int>(endpoint.client_cert.size()),
+                                         endpoint.client_cert.data());
+            SSL_CTX_use_PrivateKey_ASN1(EVP_PKEY_RSA, host->ssl_context,
+                                        endpoint.client_key.data(),
+                                        static_cast<long>(endpoint.client_key.size()));
+        }
+
+        // TODO(B3N30): Check for SSLOptions-Bits and set the verify method accordingly
+        // https://www.3dbrew.org/wiki/SSL_Services#SSLOpt
+        // Hack: Since for now RootCerts are not implemented we set the VerifyMode to None.
+        SSL_CTX_set_verify(host->ssl_context, SSL_VERIFY_NONE, nullptr);
+    }
+    return *host;
+}
+
+void ConnectionPool::Close(Connection& connection) {
+    if (connection.ssl) {
+        SSL_shutdown(connection.ssl);
+        SSL_free(connection.ssl);
+        connection.ssl = nullptr;
+    }
+    httplib::detail::close_socket(connection.socket);
+    connection.socket = INVALID_SOCKET;
+}
+
+} // namespace Service::HTTP
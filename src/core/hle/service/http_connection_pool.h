@@ -0,0 +1,117 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#if defined(__ANDROID__)
+#include <ifaddrs.h>
+#endif
+#include <httplib.h>
+#include "common/common_types.h"
+
+namespace Service::HTTP {
+
+/**
+ * Aborts a request sent by ConnectionPool::Send from another thread. The connection of the request
+ * is shut down, so that the blocking reads and writes on it fail right away.
+ */
+class RequestCanceller {
+public:
+    void Cancel();
+
+    bool IsCancelled() const;
+
+private:
+    friend class ConnectionPool;
+
+    /// Sets the connection the request is sent on, returns false if the request was cancelled
+    bool Attach(socket_t connection_socket);
+
+    void Detach();
+
+    mutable std::mutex mutex;
+    socket_t socket = INVALID_SOCKET;
+    bool cancelled = false;
+};
+
+/**
+ * Sends HTTP requests over persistent connections. The connection of a finished request is kept
+ * open when the server allows it, so that the next request to the same host skips the TCP and TLS
+ * handshakes. New TLS connections to a host resume the TLS session of the previous one.
+ *
+ * httplib::Client closes its connection after every call to send, which is why the requests are
+ * written and the responses read here with the stream helpers of httplib instead.
+ */
+class ConnectionPool {
+public:
+    struct Endpoint {
+        bool ssl;
+        std::string host;
+        int port;
+        /// DER encoded client certificate and private key presented during the TLS handshake
+        std::vector<u8> client_cert;
+        std::vector<u8> client_key;
+    };
+
+    struct Stats {
+        u64 connections_opened = 0;
+        u64 connections_reused = 0;
+        u64 sessions_resumed = 0;
+    };
+
+    ConnectionPool();
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    /**
+     * Sends a request and reads its response, like httplib::Client::send. The response_handler,
+     * content_receiver and progress callbacks of the request are called the same way. Without a
+     * content_receiver, the body is stored in the response. Idempotent requests that fail on a
+     * reused connection before any response arrives are sent again on a new connection.
+     * @param request Request with a path in origin form, e.g. "/index.html?a=b"
+     * @param canceller Lets another thread abort the request, may be null
+     * @return False if the request failed, was cancelled or was aborted by one of its callbacks
+     */
+    bool Send(const Endpoint& endpoint, const httplib::Request& request,
+              httplib::Response& response, RequestCanceller* canceller = nullptr);
+
+    Stats GetStats() const;
+
+private:
+    struct Connection;
+    struct Host;
+
+    /// Returns an idle connection to the endpoint, or opens a new one
+    std::optional<Connection> Acquire(const Endpoint& endpoint, bool& reused);
+
+    /**
+     * Takes the TLS session of a connection after a successful request, and keeps the connection
+     * for the next request to the endpoint if the server allows it.
+     */
+    void Release(const Endpoint& endpoint, Connection connection, bool keep_alive);
+
+    /// Writes the request and reads the response on a connection
+    bool Exchange(Connection& connection, const Endpoint& endpoint,
+                  const httplib::Request& request, httplib::Response& response,
+                  bool& received_response, bool& keep_alive);
+
+    /// Returns the state of an endpoint, with the mutex held
+    Host& GetHost(const Endpoint& endpoint);
+
+    static void Close(Connection& connection);
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, std::unique_ptr<Host>> hosts;
+    Stats stats;
+};
+
+} // namespace Service::HTTP
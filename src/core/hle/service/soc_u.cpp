@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <optional>
 #include <type_traits>
 #include <vector>
 #include "common/archives.h"
@@ -14,8 +15,11 @@
 #include "common/scope_exit.h"
 #include "common/swap.h"
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/event.h"
 #include "core/hle/kernel/shared_memory.h"
+#include "core/hle/kernel/thread.h"
 #include "core/hle/result.h"
 #include "core/hle/service/soc_u.h"
 
@@ -55,6 +59,8 @@
 #endif
 
 SERIALIZE_EXPORT_IMPL(Service::SOC::SOC_U)
+SERIALIZE_EXPORT_IMPL(Service::SOC::SOC_U::AsyncSocketCall)
+SERVICE_CONSTRUCT_IMPL(Service::SOC::SOC_U)
 
 namespace Service::SOC {
 
@@ -351,9 +357,141 @@ struct CTRAddrInfo {
 
 static_assert(sizeof(CTRAddrInfo) == 0x130, "Size of CTRAddrInfo is not correct");
 
+/// How often the calls completed by the socket reactor are checked for while there are any
+constexpr int CompletionCheckIntervalUs = 500;
+
+/// Makes a host socket non-blocking, calls that have to block are waited for by the reactor instead
+static void SetHostNonBlocking(u32 socket_handle) {
+#ifdef _WIN32
+    unsigned long non_blocking = 1;
+    ioctlsocket(socket_handle, FIONBIO, &non_blocking);
+#else
+    ::fcntl(socket_handle, F_SETFL, ::fcntl(socket_handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+/// Returns whether a host error means that the call would have blocked
+static bool WouldBlock(int error) {
+    return error == ERRNO(EAGAIN) || error == ERRNO(EWOULDBLOCK);
+}
+
+/**
+ * Completes a socket call whose client thread slept until the socket reactor completed it. The
+ * host sockets can't be saved, so neither can the calls in flight.
+ */
+class SOC_U::AsyncSocketCall final : public Kernel::HLERequestContext::WakeupCallback {
+public:
+    AsyncSocketCall(SOC_U& soc_, Attempt attempt_, Reply reply_, SocketClosed socket_closed_)
+        : soc(&soc_), attempt(std::move(attempt_)), reply(std::move(reply_)),
+          socket_closed(std::move(socket_closed_)) {}
+
+    void WakeUp(std::shared_ptr<Kernel::Thread> thread, Kernel::HLERequestContext& ctx,
+                Kernel::ThreadWakeupReason reason) override {
+        if (soc == nullptr) {
+            // The host sockets are gone, so the call fails like on a closed socket. The request is
+            // still in the command buffer, as the response is only written here.
+            LOG_ERROR(Service_SOC, "Socket call was restored from a savestate");
+            const IPC::Header header{ctx.CommandBuffer()[0]};
+            IPC::RequestBuilder rb(ctx, static_cast<u16>(header.command_id), 2, 0);
+            rb.Push(RESULT_SUCCESS);
+            rb.Push(TranslateError(ERRNO(EBADF)));
+            return;
+        }
+        if (reason == Kernel::ThreadWakeupReason::Timeout) {
+            // The result is whatever the call returns at the time it times out
+            soc->reactor->Cancel(id);
+            soc->pending_calls.erase(id);
+            attempt();
+        }
+        reply(ctx, error);
+    }
+
+    /// Interrupts the call as one of its sockets is being closed
+    void Interrupt(u32 socket_handle, s32 interrupt_error) {
+        if (socket_closed) {
+            socket_closed(socket_handle);
+            attempt();
+        } else {
+            error = interrupt_error;
+        }
+    }
+
+    u64 id = 0;
+
+private:
+    AsyncSocketCall() = default;
+
+    SOC_U* soc = nullptr;
+    Attempt attempt;
+    Reply reply;
+    SocketClosed socket_closed;
+    s32 error = 0; ///< Error to return instead of the result of the call, if it was interrupted
+
+    template <class Archive>
+    void serialize(Archive& ar, const unsigned int) {
+        ar& boost::serialization::base_object<Kernel::HLERequestContext::WakeupCallback>(*this);
+    }
+    friend class boost::serialization::access;
+};
+
+void SOC_U::PerformCall(Kernel::HLERequestContext& ctx, const std::string& name, bool blocking,
+                        std::vector<SocketReactor::Wait> waits, std::chrono::nanoseconds timeout,
+                        Attempt attempt, Reply reply, SocketClosed socket_closed) {
+    if (attempt() || !blocking) {
+        reply(ctx, 0);
+        return;
+    }
+
+    auto call = std::make_shared<AsyncSocketCall>(*this, attempt, std::move(reply),
+                                                  std::move(socket_closed));
+    call->id = reactor->Submit(waits, std::move(attempt));
+    auto event = ctx.SleepClientThread("soc_u::" + name, timeout, call);
+    pending_calls.emplace(call->id, PendingCall{std::move(event), std::move(call)});
+
+    if (!completion_event_scheduled) {
+        completion_event_scheduled = true;
+        system.CoreTiming().ScheduleEvent(usToCycles(CompletionCheckIntervalUs), completion_event);
+    }
+}
+
+void SOC_U::InterruptCalls(u32 socket_handle, s32 error) {
+    for (const u64 id : reactor->CancelSocket(socket_handle)) {
+        const auto it = pending_calls.find(id);
+        if (it == pending_calls.end()) {
+            continue;
+        }
+        it->second.call->Interrupt(socket_handle, error);
+        it->second.event->Signal();
+        pending_calls.erase(it);
+    }
+}
+
+void SOC_U::WakeCompletedCalls(s64 cycles_late) {
+    for (const u64 id : reactor->PopCompleted()) {
+        const auto it = pending_calls.find(id);
+        if (it != pending_calls.end()) {
+            it->second.event->Signal();
+            pending_calls.erase(it);
+        }
+    }
+
+    completion_event_scheduled = !pending_calls.empty();
+    if (completion_event_scheduled) {
+        system.CoreTiming().ScheduleEvent(usToCycles(CompletionCheckIntervalUs) - cycles_late,
+                                          completion_event);
+    }
+}
+
+bool SOC_U::IsBlocking(u32 socket_handle) const {
+    const auto it = open_sockets.find(socket_handle);
+    return it != open_sockets.end() && it->second.blocking;
+}
+
 void SOC_U::CleanupSockets() {
-    for (auto sock : open_sockets)
+    for (auto sock : open_sockets) {
+        InterruptCalls(sock.second.socket_fd, TranslateError(ERRNO(EBADF)));
         closesocket(sock.second.socket_fd);
+    }
     open_sockets.clear();
 }
 
@@ -387,8 +525,10 @@ void SOC_U::Socket(Kernel::HLERequestContext& ctx) {
 
     u32 ret = static_cast<u32>(::socket(domain, type, protocol));
 
-    if ((s32)ret != SOCKET_ERROR_VALUE)
+    if ((s32)ret != SOCKET_ERROR_VALUE) {
+        SetHostNonBlocking(ret);
         open_sockets[ret] = {ret, true};
+    }
 
     if ((s32)ret == SOCKET_ERROR_VALUE)
         ret = TranslateError(GET_ERRNO);
@@ -433,50 +573,19 @@ void SOC_U::Fcntl(Kernel::HLERequestContext& ctx) {
         rb.Push(posix_ret);
     });
 
+    auto iter = open_sockets.find(socket_handle);
+    if (iter == open_sockets.end()) {
+        posix_ret = TranslateError(ERRNO(EBADF));
+        return;
+    }
+
     if (ctr_cmd == 3) { // F_GETFL
-#ifdef _WIN32
         posix_ret = 0;
-        auto iter = open_sockets.find(socket_handle);
-        if (iter != open_sockets.end() && iter->second.blocking == false)
+        if (iter->second.blocking == false)
             posix_ret |= 4; // O_NONBLOCK
-#else
-        int ret = ::fcntl(socket_handle, F_GETFL, 0);
-        if (ret == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
-        posix_ret = 0;
-        if (ret & O_NONBLOCK)
-            posix_ret |= 4; // O_NONBLOCK
-#endif
     } else if (ctr_cmd == 4) { // F_SETFL
-#ifdef _WIN32
-        unsigned long tmp = (ctr_arg & 4 /* O_NONBLOCK */) ? 1 : 0;
-        int ret = ioctlsocket(socket_handle, FIONBIO, &tmp);
-        if (ret == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
-        auto iter = open_sockets.find(socket_handle);
-        if (iter != open_sockets.end())
-            iter->second.blocking = (tmp == 0);
-#else
-        int flags = ::fcntl(socket_handle, F_GETFL, 0);
-        if (flags == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
-
-        flags &= ~O_NONBLOCK;
-        if (ctr_arg & 4) // O_NONBLOCK
-            flags |= O_NONBLOCK;
-
-        int ret = ::fcntl(socket_handle, F_SETFL, flags);
-        if (ret == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
-#endif
+        // The host socket stays non-blocking, blocking calls are waited for by the reactor
+        iter->second.blocking = (ctr_arg & 4 /* O_NONBLOCK */) == 0;
     } else {
         LOG_ERROR(Service_SOC, "Unsupported command ({}) in fcntl call", ctr_cmd);
         posix_ret = TranslateError(EINVAL); // TODO: Find the correct error
@@ -500,34 +609,46 @@ void SOC_U::Listen(Kernel::HLERequestContext& ctx) {
 }
 
 void SOC_U::Accept(Kernel::HLERequestContext& ctx) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp(ctx, 0x04, 2, 2);
     const auto socket_handle = rp.Pop<u32>();
     [[maybe_unused]] const auto max_addr_len = static_cast<socklen_t>(rp.Pop<u32>());
     rp.PopPID();
-    sockaddr addr;
-    socklen_t addr_len = sizeof(addr);
-    u32 ret = static_cast<u32>(::accept(socket_handle, &addr, &addr_len));
 
-    if (static_cast<s32>(ret) != SOCKET_ERROR_VALUE) {
-        open_sockets[ret] = {ret, true};
-    }
+    struct AcceptResult {
+        u32 ret;
+        int error;
+        sockaddr addr;
+    };
+    const auto result = std::make_shared<AcceptResult>();
 
-    CTRSockAddr ctr_addr;
-    std::vector<u8> ctr_addr_buf(sizeof(ctr_addr));
-    if (static_cast<s32>(ret) == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(GET_ERRNO);
-    } else {
-        ctr_addr = CTRSockAddr::FromPlatform(addr);
-        std::memcpy(ctr_addr_buf.data(), &ctr_addr, sizeof(ctr_addr));
-    }
+    const auto attempt = [socket_handle, result] {
+        socklen_t addr_len = sizeof(result->addr);
+        result->ret = static_cast<u32>(::accept(socket_handle, &result->addr, &addr_len));
+        result->error = static_cast<s32>(result->ret) == SOCKET_ERROR_VALUE ? GET_ERRNO : 0;
+        return !WouldBlock(result->error);
+    };
+    const auto reply = [this, result](Kernel::HLERequestContext& ctx, s32 error) {
+        u32 ret = result->ret;
+        std::vector<u8> ctr_addr_buf(sizeof(CTRSockAddr));
+        if (error != 0) {
+            ret = error;
+        } else if (static_cast<s32>(ret) == SOCKET_ERROR_VALUE) {
+            ret = TranslateError(result->error);
+        } else {
+            SetHostNonBlocking(ret);
+            open_sockets[ret] = {ret, true};
+            const CTRSockAddr ctr_addr = CTRSockAddr::FromPlatform(result->addr);
+            std::memcpy(ctr_addr_buf.data(), &ctr_addr, sizeof(ctr_addr));
+        }
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.PushStaticBuffer(std::move(ctr_addr_buf), 0);
+        IPC::RequestBuilder rb(ctx, 0x04, 2, 2);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(ret);
+        rb.PushStaticBuffer(std::move(ctr_addr_buf), 0);
+    };
+
+    PerformCall(ctx, "accept", IsBlocking(socket_handle), {{socket_handle, SocketReactor::Read}},
+                std::chrono::nanoseconds(-1), attempt, reply);
 }
 
 void SOC_U::GetHostId(Kernel::HLERequestContext& ctx) {
@@ -557,6 +678,8 @@ void SOC_U::Close(Kernel::HLERequestContext& ctx) {
     s32 ret = 0;
     open_sockets.erase(socket_handle);
 
+    // Calls that are blocked on the socket fail once it's closed
+    InterruptCalls(socket_handle, TranslateError(ERRNO(EBADF)));
     ret = closesocket(socket_handle);
 
     if (ret != 0)
@@ -577,24 +700,84 @@ void SOC_U::SendTo(Kernel::HLERequestContext& ctx) {
     auto input_buff = rp.PopStaticBuffer();
     auto dest_addr_buff = rp.PopStaticBuffer();
 
-    s32 ret = -1;
+    struct SendResult {
+        std::vector<u8> data;
+        std::optional<sockaddr> dest_addr;
+        s32 ret = -1;
+        int error = 0;
+    };
+    const auto result = std::make_shared<SendResult>();
+    result->data = std::move(input_buff);
     if (addr_len > 0) {
         CTRSockAddr ctr_dest_addr;
         std::memcpy(&ctr_dest_addr, dest_addr_buff.data(), sizeof(ctr_dest_addr));
-        sockaddr dest_addr = CTRSockAddr::ToPlatform(ctr_dest_addr);
-        ret = ::sendto(socket_handle, reinterpret_cast<const char*>(input_buff.data()), len, flags,
-                       &dest_addr, sizeof(dest_addr));
-    } else {
-        ret = ::sendto(socket_handle, reinterpret_cast<const char*>(input_buff.data()), len, flags,
-                       nullptr, 0);
+        result->dest_addr = CTRSockAddr::ToPlatform(ctr_dest_addr);
     }
 
-    if (ret == SOCKET_ERROR_VALUE)
-        ret = TranslateError(GET_ERRNO);
+    const auto attempt = [socket_handle, len, flags, result] {
+        const auto data = reinterpret_cast<const char*>(result->data.data());
+        if (result->dest_addr) {
+            result->ret = ::sendto(socket_handle, data, len, flags, &*result->dest_addr,
+                                   sizeof(*result->dest_addr));
+        } else {
+            result->ret = ::sendto(socket_handle, data, len, flags, nullptr, 0);
+        }
+        result->error = result->ret == SOCKET_ERROR_VALUE ? GET_ERRNO : 0;
+        return !WouldBlock(result->error);
+    };
+    const auto reply = [result](Kernel::HLERequestContext& ctx, s32 error) {
+        s32 ret = result->ret;
+        if (error != 0) {
+            ret = error;
+        } else if (ret == SOCKET_ERROR_VALUE) {
+            ret = TranslateError(result->error);
+        }
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
+        IPC::RequestBuilder rb(ctx, 0x0A, 2, 0);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(ret);
+    };
+
+    PerformCall(ctx, "sendto", IsBlocking(socket_handle), {{socket_handle, SocketReactor::Write}},
+                std::chrono::nanoseconds(-1), attempt, reply);
+}
+
+/// Result of a recvfrom call, which is filled on the thread that performs it
+struct RecvResult {
+    std::vector<u8> data;
+    sockaddr addr;
+    socklen_t addr_len = 0;
+    s32 ret = -1;
+    int error = 0;
+};
+
+/// Attempts a recvfrom call on a non-blocking host socket, returns false if it would block
+static bool AttemptRecvFrom(u32 socket_handle, u32 flags, bool get_addr, RecvResult& result) {
+    auto data = reinterpret_cast<char*>(result.data.data());
+    const auto len = static_cast<u32>(result.data.size());
+    if (get_addr) {
+        // Only get src adr if input adr available
+        result.addr_len = sizeof(result.addr);
+        result.ret = ::recvfrom(socket_handle, data, len, flags, &result.addr, &result.addr_len);
+    } else {
+        result.addr_len = 0;
+        result.ret = ::recvfrom(socket_handle, data, len, flags, NULL, 0);
+    }
+    result.error = result.ret == SOCKET_ERROR_VALUE ? GET_ERRNO : 0;
+    return !WouldBlock(result.error);
+}
+
+/// Converts the source address of a recvfrom call, or returns nothing if it wasn't requested
+static std::vector<u8> GetRecvFromAddress(const RecvResult& result, bool get_addr) {
+    if (!get_addr) {
+        return {};
+    }
+    std::vector<u8> addr_buff(sizeof(CTRSockAddr));
+    if (result.ret >= 0 && result.addr_len > 0) {
+        const CTRSockAddr ctr_src_addr = CTRSockAddr::FromPlatform(result.addr);
+        std::memcpy(addr_buff.data(), &ctr_src_addr, sizeof(ctr_src_addr));
+    }
+    return addr_buff;
 }
 
 void SOC_U::RecvFromOther(Kernel::HLERequestContext& ctx) {
@@ -606,43 +789,38 @@ void SOC_U::RecvFromOther(Kernel::HLERequestContext& ctx) {
     rp.PopPID();
     auto& buffer = rp.PopMappedBuffer();
 
-    CTRSockAddr ctr_src_addr;
-    std::vector<u8> output_buff(len);
-    std::vector<u8> addr_buff(sizeof(ctr_src_addr));
-    sockaddr src_addr;
-    socklen_t src_addr_len = sizeof(src_addr);
+    const auto result = std::make_shared<RecvResult>();
+    result->data.resize(len);
+    const bool get_addr = addr_len > 0;
 
-    s32 ret = -1;
-    if (addr_len > 0) {
-        ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
-                         &src_addr, &src_addr_len);
-        if (ret >= 0 && src_addr_len > 0) {
-            ctr_src_addr = CTRSockAddr::FromPlatform(src_addr);
-            std::memcpy(addr_buff.data(), &ctr_src_addr, sizeof(ctr_src_addr));
+    const auto attempt = [socket_handle, flags, get_addr, result] {
+        return AttemptRecvFrom(socket_handle, flags, get_addr, *result);
+    };
+    const auto reply = [result, get_addr, buffer_id = buffer.GetId()](
+                           Kernel::HLERequestContext& ctx, s32 error) {
+        auto& buffer = ctx.GetMappedBuffer(buffer_id);
+        s32 ret = result->ret;
+        if (error != 0) {
+            ret = error;
+        } else if (ret == SOCKET_ERROR_VALUE) {
+            ret = TranslateError(result->error);
+        } else {
+            buffer.Write(result->data.data(), 0, ret);
         }
-    } else {
-        ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
-                         NULL, 0);
-        addr_buff.resize(0);
-    }
 
-    if (ret == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(GET_ERRNO);
-    } else {
-        buffer.Write(output_buff.data(), 0, ret);
-    }
+        IPC::RequestBuilder rb(ctx, 0x07, 2, 4);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(ret);
+        rb.PushStaticBuffer(GetRecvFromAddress(*result, get_addr && error == 0), 0);
+        rb.PushMappedBuffer(buffer);
+    };
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 4);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.PushStaticBuffer(std::move(addr_buff), 0);
-    rb.PushMappedBuffer(buffer);
+    PerformCall(ctx, "recvfrom_other", IsBlocking(socket_handle),
+                {{socket_handle, SocketReactor::Read}}, std::chrono::nanoseconds(-1), attempt,
+                reply);
 }
 
 void SOC_U::RecvFrom(Kernel::HLERequestContext& ctx) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp(ctx, 0x08, 4, 2);
     u32 socket_handle = rp.Pop<u32>();
     u32 len = rp.Pop<u32>();
@@ -650,42 +828,39 @@ void SOC_U::RecvFrom(Kernel::HLERequestContext& ctx) {
     u32 addr_len = rp.Pop<u32>();
     rp.PopPID();
 
-    CTRSockAddr ctr_src_addr;
-    std::vector<u8> output_buff(len);
-    std::vector<u8> addr_buff(sizeof(ctr_src_addr));
-    sockaddr src_addr;
-    socklen_t src_addr_len = sizeof(src_addr);
+    const auto result = std::make_shared<RecvResult>();
+    result->data.resize(len);
+    const bool get_addr = addr_len > 0;
 
-    s32 ret = -1;
-    if (addr_len > 0) {
-        // Only get src adr if input adr available
-        ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
-                         &src_addr, &src_addr_len);
-        if (ret >= 0 && src_addr_len > 0) {
-            ctr_src_addr = CTRSockAddr::FromPlatform(src_addr);
-            std::memcpy(addr_buff.data(), &ctr_src_addr, sizeof(ctr_src_addr));
+    const auto attempt = [socket_handle, flags, get_addr, result] {
+        return AttemptRecvFrom(socket_handle, flags, get_addr, *result);
+    };
+    const auto reply = [result, get_addr](Kernel::HLERequestContext& ctx, s32 error) {
+        s32 ret = result->ret;
+        s32 total_received = ret;
+        if (error != 0) {
+            ret = error;
+            total_received = 0;
+        } else if (ret == SOCKET_ERROR_VALUE) {
+            ret = TranslateError(result->error);
+            total_received = 0;
         }
-    } else {
-        ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
-                         NULL, 0);
-        addr_buff.resize(0);
-    }
 
-    s32 total_received = ret;
-    if (ret == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(GET_ERRNO);
-        total_received = 0;
-    }
+        // Write only the data we received to avoid overwriting parts of the buffer with zeros
+        std::vector<u8> output_buff = std::move(result->data);
+        output_buff.resize(total_received);
 
-    // Write only the data we received to avoid overwriting parts of the buffer with zeros
-    output_buff.resize(total_received);
+        IPC::RequestBuilder rb(ctx, 0x08, 3, 4);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(ret);
+        rb.Push(total_received);
+        rb.PushStaticBuffer(std::move(output_buff), 0);
+        rb.PushStaticBuffer(GetRecvFromAddress(*result, get_addr && error == 0), 1);
+    };
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(3, 4);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.Push(total_received);
-    rb.PushStaticBuffer(std::move(output_buff), 0);
-    rb.PushStaticBuffer(std::move(addr_buff), 1);
+    PerformCall(ctx, "recvfrom", IsBlocking(socket_handle),
+                {{socket_handle, SocketReactor::Read}}, std::chrono::nanoseconds(-1), attempt,
+                reply);
 }
 
 void SOC_U::Poll(Kernel::HLERequestContext& ctx) {
@@ -698,28 +873,93 @@ void SOC_U::Poll(Kernel::HLERequestContext& ctx) {
     std::vector<CTRPollFD> ctr_fds(nfds);
     std::memcpy(ctr_fds.data(), input_fds.data(), nfds * sizeof(CTRPollFD));
 
+    struct PollResult {
+        std::vector<pollfd> fds;
+        std::vector<bool> closed; ///< Whether the socket was closed while polling
+        s32 ret = 0;
+        int error = 0;
+    };
+    const auto result = std::make_shared<PollResult>();
+
     // The 3ds_pollfd and the pollfd structures may be different (Windows/Linux have different
     // sizes)
     // so we have to copy the data
-    std::vector<pollfd> platform_pollfd(nfds);
-    std::transform(ctr_fds.begin(), ctr_fds.end(), platform_pollfd.begin(), CTRPollFD::ToPlatform);
+    result->fds.resize(nfds);
+    std::transform(ctr_fds.begin(), ctr_fds.end(), result->fds.begin(), CTRPollFD::ToPlatform);
+    result->closed.resize(nfds);
+
+    std::vector<SocketReactor::Wait> waits;
+    for (u32 i = 0; i < nfds; ++i) {
+        // Negative descriptors are ignored, like poll does
+        if (static_cast<s32>(ctr_fds[i].fd) < 0) {
+            continue;
+        }
+        const pollfd& fd = result->fds[i];
+        u32 events = 0;
+        if (fd.events & POLLIN) {
+            events |= SocketReactor::Read;
+        }
+        if (fd.events & POLLOUT) {
+            events |= SocketReactor::Write;
+        }
+        if (fd.events & POLLPRI) {
+            events |= SocketReactor::Priority;
+        }
+        waits.push_back({static_cast<u32>(fd.fd), events});
+    }
 
-    s32 ret = ::poll(platform_pollfd.data(), nfds, timeout);
+    // The host call never waits, the reactor waits for the sockets instead
+    const auto attempt = [result, nfds] {
+        // Sockets closed while polling are skipped, and reported as invalid like poll does
+        std::vector<pollfd> fds = result->fds;
+        for (u32 i = 0; i < nfds; ++i) {
+            if (result->closed[i]) {
+                fds[i].fd = static_cast<decltype(fds[i].fd)>(-1);
+            }
+        }
+        result->ret = ::poll(fds.data(), nfds, 0);
+        result->error = result->ret == SOCKET_ERROR_VALUE ? GET_ERRNO : 0;
+        for (u32 i = 0; i < nfds; ++i) {
+            result->fds[i].revents = result->closed[i] ? POLLNVAL : fds[i].revents;
+            if (result->closed[i] && result->ret != SOCKET_ERROR_VALUE) {
+                ++result->ret;
+            }
+        }
+        return result->ret != 0;
+    };
+    const auto socket_closed = [result, nfds](u32 socket_handle) {
+        for (u32 i = 0; i < nfds; ++i) {
+            if (static_cast<u32>(result->fds[i].fd) == socket_handle) {
+                result->closed[i] = true;
+            }
+        }
+    };
+    const auto reply = [result, nfds](Kernel::HLERequestContext& ctx, s32 error) {
+        s32 ret = result->ret;
+        if (error != 0) {
+            ret = error;
+        } else if (ret == SOCKET_ERROR_VALUE) {
+            ret = TranslateError(result->error);
+        }
 
-    // Now update the output pollfd structure
-    std::transform(platform_pollfd.begin(), platform_pollfd.end(), ctr_fds.begin(),
-                   CTRPollFD::FromPlatform);
+        // Now update the output pollfd structure
+        std::vector<CTRPollFD> ctr_fds(nfds);
+        std::transform(result->fds.begin(), result->fds.end(), ctr_fds.begin(),
+                       CTRPollFD::FromPlatform);
 
-    std::vector<u8> output_fds(nfds * sizeof(CTRPollFD));
-    std::memcpy(output_fds.data(), ctr_fds.data(), nfds * sizeof(CTRPollFD));
+        std::vector<u8> output_fds(nfds * sizeof(CTRPollFD));
+        std::memcpy(output_fds.data(), ctr_fds.data(), nfds * sizeof(CTRPollFD));
 
-    if (ret == SOCKET_ERROR_VALUE)
-        ret = TranslateError(GET_ERRNO);
+        IPC::RequestBuilder rb(ctx, 0x14, 2, 2);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(ret);
+        rb.PushStaticBuffer(std::move(output_fds), 0);
+    };
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.PushStaticBuffer(std::move(output_fds), 0);
+    const std::chrono::nanoseconds timeout_ns =
+        timeout < 0 ? std::chrono::nanoseconds(-1) : std::chrono::milliseconds(timeout);
+    PerformCall(ctx, "poll", timeout != 0, std::move(waits), timeout_ns, attempt, reply,
+                socket_closed);
 }
 
 void SOC_U::GetSockName(Kernel::HLERequestContext& ctx) {
@@ -785,9 +1025,6 @@ void SOC_U::GetPeerName(Kernel::HLERequestContext& ctx) {
 }
 
 void SOC_U::Connect(Kernel::HLERequestContext& ctx) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp(ctx, 0x06, 2, 4);
     const auto socket_handle = rp.Pop<u32>();
     [[maybe_unused]] const auto input_addr_len = rp.Pop<u32>();
@@ -797,14 +1034,41 @@ void SOC_U::Connect(Kernel::HLERequestContext& ctx) {
     CTRSockAddr ctr_input_addr;
     std::memcpy(&ctr_input_addr, input_addr_buf.data(), sizeof(ctr_input_addr));
 
-    sockaddr input_addr = CTRSockAddr::ToPlatform(ctr_input_addr);
-    s32 ret = ::connect(socket_handle, &input_addr, sizeof(input_addr));
-    if (ret != 0)
-        ret = TranslateError(GET_ERRNO);
+    struct ConnectResult {
+        bool started = false;
+        int error = 0;
+    };
+    const auto result = std::make_shared<ConnectResult>();
+
+    const auto attempt = [socket_handle, result,
+                          input_addr = CTRSockAddr::ToPlatform(ctr_input_addr)] {
+        if (!result->started) {
+            result->started = true;
+            const s32 ret = ::connect(socket_handle, &input_addr, sizeof(input_addr));
+            result->error = ret != 0 ? GET_ERRNO : 0;
+            return result->error != ERRNO(EINPROGRESS) && !WouldBlock(result->error);
+        }
+        // The connection attempt finished once the socket is writable
+        int error = 0;
+        socklen_t error_len = sizeof(error);
+        ::getsockopt(socket_handle, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error),
+                     &error_len);
+        result->error = error;
+        return true;
+    };
+    const auto reply = [result](Kernel::HLERequestContext& ctx, s32 error) {
+        s32 ret = error;
+        if (ret == 0 && result->error != 0) {
+            ret = TranslateError(result->error);
+        }
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
+        IPC::RequestBuilder rb(ctx, 0x06, 2, 0);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(ret);
+    };
+
+    PerformCall(ctx, "connect", IsBlocking(socket_handle), {{socket_handle, SocketReactor::Write}},
+                std::chrono::nanoseconds(-1), attempt, reply);
 }
 
 void SOC_U::InitializeSockets(Kernel::HLERequestContext& ctx) {
@@ -980,7 +1244,7 @@ void SOC_U::GetNameInfoImpl(Kernel::HLERequestContext& ctx) {
     rb.PushStaticBuffer(std::move(serv), 1);
 }
 
-SOC_U::SOC_U() : ServiceFramework("soc:U") {
+SOC_U::SOC_U(Core::System& system) : ServiceFramework("soc:U"), system(system) {
     static const FunctionInfo functions[] = {
         {0x00010044, &SOC_U::InitializeSockets, "InitializeSockets"},
         {0x000200C2, &SOC_U::Socket, "Socket"},
@@ -1023,10 +1287,18 @@ SOC_U::SOC_U() : ServiceFramework("soc:U") {
     WSADATA data;
     WSAStartup(MAKEWORD(2, 2), &data);
 #endif
+
+    reactor = std::make_unique<SocketReactor>();
+    completion_event = system.CoreTiming().RegisterEvent(
+        "SOC_U::WakeCompletedCalls",
+        [this](u64 userdata, s64 cycles_late) { WakeCompletedCalls(cycles_late); });
 }
 
 SOC_U::~SOC_U() {
+    // The client threads of the pending calls are not woken up anymore
+    pending_calls.clear();
     CleanupSockets();
+    reactor.reset();
 #ifdef _WIN32
     WSACleanup();
 #endif
@@ -1034,7 +1306,7 @@ SOC_U::~SOC_U() {
 
 void InstallInterfaces(Core::System& system) {
     auto& service_manager = system.ServiceManager();
-    std::make_shared<SOC_U>()->InstallAsService(service_manager);
+    std::make_shared<SOC_U>(system)->InstallAsService(service_manager);
 }
 
 } // namespace Service::SOC
@@ -4,12 +4,23 @@
 
 #pragma once
 
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
 #include <boost/serialization/unordered_map.hpp>
 #include "core/hle/service/service.h"
+#include "core/hle/service/socket_reactor.h"
 
 namespace Core {
 class System;
+struct TimingEventType;
+} // namespace Core
+
+namespace Kernel {
+class Event;
 }
 
 namespace Service::SOC {
@@ -17,7 +28,7 @@ namespace Service::SOC {
 /// Holds information about a particular socket
 struct SocketHolder {
     u32 socket_fd; ///< The socket descriptor
-    bool blocking; ///< Whether the socket is blocking or not, it is only read on Windows.
+    bool blocking; ///< Whether the socket is blocking for the guest, the host socket never is
 
 private:
     template <class Archive>
@@ -30,10 +41,24 @@ private:
 
 class SOC_U final : public ServiceFramework<SOC_U> {
 public:
-    SOC_U();
+    explicit SOC_U(Core::System& system);
     ~SOC_U();
 
+    class AsyncSocketCall;
+
 private:
+    /// Attempts a socket call on the non-blocking host socket, returns false if it would block
+    using Attempt = std::function<bool()>;
+
+    /// Writes the response of a socket call, with the error to return instead of its result if any
+    using Reply = std::function<void(Kernel::HLERequestContext& ctx, s32 error)>;
+
+    /**
+     * Handles one of the sockets of a pending call being closed, for calls that report it as
+     * their result instead of failing
+     */
+    using SocketClosed = std::function<void(u32 socket_handle)>;
+
     void Socket(Kernel::HLERequestContext& ctx);
     void Bind(Kernel::HLERequestContext& ctx);
     void Fcntl(Kernel::HLERequestContext& ctx);
@@ -62,6 +87,46 @@ private:
     /// Close all open sockets
     void CleanupSockets();
 
+    /// Returns whether the guest expects calls on the socket to block
+    bool IsBlocking(u32 socket_handle) const;
+
+    /**
+     * Performs a socket call without blocking the emulator. The call is attempted right away, and
+     * if it would block on a blocking socket, the client thread sleeps until the socket reactor
+     * completes it.
+     * @param name Name of the call, for debugging purposes
+     * @param blocking Whether the call blocks until it completes
+     * @param waits Sockets and events that the call waits for
+     * @param timeout Time after which the call is attempted one last time, or -1 to wait forever
+     * @param attempt Attempts the call, on the emulator thread or the reactor thread
+     * @param reply Writes the response once the call completed, on the emulator thread
+     * @param socket_closed Called instead of failing the call if one of its sockets is closed
+     */
+    void PerformCall(Kernel::HLERequestContext& ctx, const std::string& name, bool blocking,
+                     std::vector<SocketReactor::Wait> waits, std::chrono::nanoseconds timeout,
+                     Attempt attempt, Reply reply, SocketClosed socket_closed = {});
+
+    /**
+     * Cancels the pending calls on a socket, which then return the given error unless they handle
+     * the socket being closed themselves
+     */
+    void InterruptCalls(u32 socket_handle, s32 error);
+
+    /// Wakes up the client threads of the calls the reactor completed
+    void WakeCompletedCalls(s64 cycles_late);
+
+    /// A call that waits for the socket reactor
+    struct PendingCall {
+        std::shared_ptr<Kernel::Event> event;
+        std::shared_ptr<AsyncSocketCall> call;
+    };
+
+    Core::System& system;
+    std::unique_ptr<SocketReactor> reactor;
+    Core::TimingEventType* completion_event = nullptr;
+    bool completion_event_scheduled = false;
+    std::unordered_map<u64, PendingCall> pending_calls;
+
     /// Holds info about the currently open sockets
     std::unordered_map<u32, SocketHolder> open_sockets;
 
@@ -77,4 +142,6 @@ void InstallInterfaces(Core::System& system);
 
 } // namespace Service::SOC
 
+SERVICE_CONSTRUCT(Service::SOC::SOC_U)
 BOOST_CLASS_EXPORT_KEY(Service::SOC::SOC_U)
+BOOST_CLASS_EXPORT_KEY(Service::SOC::SOC_U::AsyncSocketCall)
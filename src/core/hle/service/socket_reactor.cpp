@@ -0,0 +1,357 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <utility>
+#include "common/logging/log.h"
+#include "common/thread.h"
+#include "core/hle/service/socket_reactor.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace Service::SOC {
+
+#ifdef __linux__
+
+/// Waits for the sockets with epoll, and is woken up through an eventfd
+class SocketReactor::Poller {
+public:
+    Poller() {
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = WakeTag;
+        if (epoll_fd == -1 || wake_fd == -1 ||
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event) != 0) {
+            LOG_CRITICAL(Service_SOC, "Failed to create the socket reactor: {}", errno);
+        }
+    }
+
+    ~Poller() {
+        close(wake_fd);
+        close(epoll_fd);
+    }
+
+    void Update(u32 socket, u32 events) {
+        const auto it = registered.find(socket);
+        if (events == 0) {
+            if (it != registered.end()) {
+                // Closed sockets were removed from the epoll set already
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, static_cast<int>(socket), nullptr);
+                registered.erase(it);
+            }
+            return;
+        }
+
+        epoll_event event{};
+        event.events = ((events & Read) ? EPOLLIN : 0u) | ((events & Write) ? EPOLLOUT : 0u) |
+                       ((events & Priority) ? EPOLLPRI : 0u) | EPOLLERR | EPOLLHUP;
+        event.data.u64 = socket;
+        const int fd = static_cast<int>(socket);
+        if (it == registered.end() || epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) != 0) {
+            if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+                LOG_ERROR(Service_SOC, "Failed to wait for socket {}: {}", socket, errno);
+            }
+        }
+        registered[socket] = events;
+    }
+
+    void Wake() {
+        const u64 value = 1;
+        [[maybe_unused]] const auto written = write(wake_fd, &value, sizeof(value));
+    }
+
+    std::vector<Wait> WaitForEvents() {
+        std::array<epoll_event, 64> events;
+        const int count = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), -1);
+        std::vector<Wait> ready;
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.u64 == WakeTag) {
+                u64 value;
+                [[maybe_unused]] const auto read_bytes = read(wake_fd, &value, sizeof(value));
+                continue;
+            }
+            u32 ready_events = 0;
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                ready_events |= Read;
+            }
+            if (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+                ready_events |= Write;
+            }
+            if (events[i].events & (EPOLLPRI | EPOLLERR | EPOLLHUP)) {
+                ready_events |= Priority;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                ready_events |= Error;
+            }
+            ready.push_back({static_cast<u32>(events[i].data.u64), ready_events});
+        }
+        return ready;
+    }
+
+private:
+    static constexpr u64 WakeTag = ~0ULL;
+
+    int epoll_fd = -1;
+    int wake_fd = -1;
+    std::unordered_map<u32, u32> registered;
+};
+
+#else
+
+#ifdef _WIN32
+#define poll(x, y, z) WSAPoll(x, y, z)
+#else
+#define closesocket(x) close(x)
+#endif
+
+/**
+ * Waits for the sockets with poll, and is woken up by a loopback UDP socket that sends to itself,
+ * as WSAPoll only works with sockets.
+ */
+class SocketReactor::Poller {
+public:
+    Poller() {
+        wake_socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t addr_len = sizeof(addr);
+        if (::bind(wake_socket, reinterpret_cast<sockaddr*>(&addr), addr_len) != 0 ||
+            ::getsockname(wake_socket, reinterpret_cast<sockaddr*>(&addr), &addr_len) != 0 ||
+            ::connect(wake_socket, reinterpret_cast<sockaddr*>(&addr), addr_len) != 0) {
+            LOG_CRITICAL(Service_SOC, "Failed to create the socket reactor");
+        }
+#ifdef _WIN32
+        unsigned long non_blocking = 1;
+        ioctlsocket(wake_socket, FIONBIO, &non_blocking);
+#else
+        fcntl(wake_socket, F_SETFL, fcntl(wake_socket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    }
+
+    ~Poller() {
+        closesocket(wake_socket);
+    }
+
+    void Update(u32 socket, u32 events) {
+        {
+            std::lock_guard lock{registered_mutex};
+            if (events == 0) {
+                registered.erase(socket);
+            } else {
+                registered[socket] = events;
+            }
+        }
+        // The sockets to poll are only read before polling
+        Wake();
+    }
+
+    void Wake() {
+        const char value = 0;
+        ::send(wake_socket, &value, sizeof(value), 0);
+    }
+
+    std::vector<Wait> WaitForEvents() {
+        std::vector<pollfd> fds;
+        {
+            std::lock_guard lock{registered_mutex};
+            fds.reserve(registered.size() + 1);
+            for (const auto& [socket, events] : registered) {
+                pollfd fd{};
+                fd.fd = socket;
+                // Errors and hangups are reported without asking for them
+                fd.events = ((events & Read) ? POLLIN : 0) | ((events & Write) ? POLLOUT : 0) |
+                            ((events & Priority) ? POLLPRI : 0);
+                fds.push_back(fd);
+            }
+        }
+        pollfd wake_fd{};
+        wake_fd.fd = wake_socket;
+        wake_fd.events = POLLIN;
+        fds.push_back(wake_fd);
+
+        std::vector<Wait> ready;
+        if (poll(fds.data(), static_cast<unsigned long>(fds.size()), -1) <= 0) {
+            return ready;
+        }
+        if (fds.back().revents != 0) {
+            char buffer[64];
+            while (::recv(wake_socket, buffer, sizeof(buffer), 0) > 0) {
+            }
+        }
+        fds.pop_back();
+        for (const pollfd& fd : fds) {
+            u32 ready_events = 0;
+            if (fd.revents & (POLLIN | POLLERR | POLLHUP | POLLNVAL)) {
+                ready_events |= Read;
+            }
+            if (fd.revents & (POLLOUT | POLLERR | POLLHUP | POLLNVAL)) {
+                ready_events |= Write;
+            }
+            if (fd.revents & (POLLPRI | POLLERR | POLLHUP | POLLNVAL)) {
+                ready_events |= Priority;
+            }
+            if (fd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                ready_events |= Error;
+            }
+            if (ready_events != 0) {
+                ready.push_back({static_cast<u32>(fd.fd), ready_events});
+            }
+        }
+        return ready;
+    }
+
+private:
+#ifdef _WIN32
+    SOCKET wake_socket;
+#else
+    int wake_socket;
+#endif
+    std::mutex registered_mutex;
+    std::unordered_map<u32, u32> registered;
+};
+
+#undef poll
+#undef closesocket
+
+#endif
+
+SocketReactor::SocketReactor()
+    : poller(std::make_unique<Poller>()), thread(&SocketReactor::ThreadLoop, this) {}
+
+SocketReactor::~SocketReactor() {
+    {
+        std::lock_guard lock{mutex};
+        running = false;
+    }
+    poller->Wake();
+    thread.join();
+}
+
+u64 SocketReactor::Submit(const std::vector<Wait>& waits, Operation operation) {
+    std::lock_guard lock{mutex};
+    const u64 id = next_id++;
+    operations.emplace(id, PendingOperation{waits, std::move(operation)});
+    for (const Wait& wait : waits) {
+        socket_operations[wait.socket].push_back(id);
+        UpdateSocket(wait.socket);
+    }
+    return id;
+}
+
+bool SocketReactor::Cancel(u64 id) {
+    std::lock_guard lock{mutex};
+    if (operations.count(id) == 0) {
+        return false;
+    }
+    RemoveOperation(id);
+    return true;
+}
+
+std::vector<u64> SocketReactor::CancelSocket(u32 socket) {
+    std::lock_guard lock{mutex};
+    const auto it = socket_operations.find(socket);
+    if (it == socket_operations.end()) {
+        return {};
+    }
+    const std::vector<u64> ids = it->second;
+    for (const u64 id : ids) {
+        RemoveOperation(id);
+    }
+    return ids;
+}
+
+std::vector<u64> SocketReactor::PopCompleted() {
+    std::lock_guard lock{mutex};
+    return std::exchange(completed, {});
+}
+
+std::size_t SocketReactor::NumPending() const {
+    std::lock_guard lock{mutex};
+    return operations.size();
+}
+
+void SocketReactor::ThreadLoop() {
+    Common::SetCurrentThreadName("SocketReactor");
+    while (true) {
+        const std::vector<Wait> ready = poller->WaitForEvents();
+
+        std::lock_guard lock{mutex};
+        if (!running) {
+            return;
+        }
+        for (const Wait& socket : ready) {
+            const auto it = socket_operations.find(socket.socket);
+            if (it == socket_operations.end()) {
+                continue;
+            }
+            // Completing an operation changes the list
+            const std::vector<u64> ids = it->second;
+            for (const u64 id : ids) {
+                const auto op = operations.find(id);
+                if (op == operations.end()) {
+                    continue;
+                }
+                const bool waits_for_event = std::any_of(
+                    op->second.waits.begin(), op->second.waits.end(), [&socket](const Wait& wait) {
+                        return wait.socket == socket.socket &&
+                               ((wait.events | Error) & socket.events) != 0;
+                    });
+                if (waits_for_event && op->second.operation()) {
+                    RemoveOperation(id);
+                    completed.push_back(id);
+                }
+            }
+        }
+    }
+}
+
+void SocketReactor::RemoveOperation(u64 id) {
+    const auto op = operations.find(id);
+    for (const Wait& wait : op->second.waits) {
+        auto& ids = socket_operations[wait.socket];
+        ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+        UpdateSocket(wait.socket);
+    }
+    operations.erase(op);
+}
+
+void SocketReactor::UpdateSocket(u32 socket) {
+    const auto it = socket_operations.find(socket);
+    u32 events = 0;
+    if (it != socket_operations.end()) {
+        for (const u64 id : it->second) {
+            for (const Wait& wait : operations.at(id).waits) {
+                if (wait.socket == socket) {
+                    // Sockets are waited for even without events, for their errors and hangups
+                    events |= wait.events | Error;
+                }
+            }
+        }
+        if (it->second.empty()) {
+            socket_operations.erase(it);
+        }
+    }
+    poller->Update(socket, events);
+}
+
+} // namespace Service::SOC
@@ -0,0 +1,101 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Service::SOC {
+
+/**
+ * Waits for host sockets to become ready on a dedicated thread, so that the socket calls the guest
+ * expects to block don't block the emulator. It uses epoll on Linux, and poll elsewhere.
+ *
+ * An operation waits for events on any number of sockets. Whenever one of them is ready, the
+ * operation is attempted on the reactor thread, and it completes once an attempt succeeds. The
+ * completed operations are collected with PopCompleted.
+ */
+class SocketReactor {
+public:
+    /// Events of a socket to wait for
+    enum Events : u32 {
+        Read = 1 << 0,
+        Write = 1 << 1,
+        Priority = 1 << 2, ///< Out-of-band data, like POLLPRI
+        Error = 1 << 3,    ///< Errors and hangups, which are always waited for, like poll does
+    };
+
+    struct Wait {
+        u32 socket;
+        u32 events;
+    };
+
+    /**
+     * Attempts the operation on non-blocking sockets.
+     * @return False if it would still block
+     */
+    using Operation = std::function<bool()>;
+
+    SocketReactor();
+    ~SocketReactor();
+
+    SocketReactor(const SocketReactor&) = delete;
+    SocketReactor& operator=(const SocketReactor&) = delete;
+
+    /**
+     * Starts waiting for the sockets of an operation. It should have been attempted once already.
+     * @return Id of the operation
+     */
+    u64 Submit(const std::vector<Wait>& waits, Operation operation);
+
+    /**
+     * Stops an operation that hasn't completed yet. It isn't running anymore once this returns.
+     * @return False if the operation completed already, or the id is unknown
+     */
+    bool Cancel(u64 id);
+
+    /// Cancels the operations that wait for a socket, and returns their ids
+    std::vector<u64> CancelSocket(u32 socket);
+
+    /// Returns the operations that completed since the last call
+    std::vector<u64> PopCompleted();
+
+    /// Returns the number of operations that haven't completed yet
+    std::size_t NumPending() const;
+
+private:
+    class Poller;
+
+    struct PendingOperation {
+        std::vector<Wait> waits;
+        Operation operation;
+    };
+
+    void ThreadLoop();
+
+    /// Removes an operation and its waits, with the mutex held
+    void RemoveOperation(u64 id);
+
+    /// Tells the poller which events of a socket are waited for, with the mutex held
+    void UpdateSocket(u32 socket);
+
+    std::unique_ptr<Poller> poller;
+
+    mutable std::mutex mutex;
+    u64 next_id = 1;
+    std::unordered_map<u64, PendingOperation> operations;
+    std::unordered_map<u32, std::vector<u64>> socket_operations;
+    std::vector<u64> completed;
+    bool running = true;
+
+    std::thread thread;
+};
+
+} // namespace Service::SOC
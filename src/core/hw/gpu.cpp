@@ -3,18 +3,20 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <functional>
+#include <mutex>
 #include <numeric>
 #include <type_traits>
+#include <vector>
 #include "common/alignment.h"
-#include "common/color.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
-#include "common/vector_math.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/service/gsp/gsp.h"
 #include "core/hw/gpu.h"
+#include "core/hw/gpu_transfer.h"
 #include "core/hw/hw.h"
 #include "core/memory.h"
 #include "core/tracer/recorder.h"
@@ -22,7 +24,6 @@
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
-#include "video_core/utils.h"
 #include "video_core/video_core.h"
 
 namespace GPU {
@@ -32,6 +33,57 @@ Memory::MemorySystem* g_memory;
 
 /// Event id for CoreTiming
 static Core::TimingEventType* vblank_event;
+static Core::TimingEventType* gpu_thread_retire_event;
+
+/// Emulated time between submitting work to the GPU thread and retiring it, which signals its
+/// interrupts. The CPU only waits for the GPU thread if the work has not run by then.
+constexpr u64 gpu_thread_latency_ticks = BASE_CLOCK_RATE_ARM11 / 10000; // 100us
+
+/// Fence of the last frame submitted to the GPU thread
+static u64 gpu_thread_frame_fence = 0;
+
+/// Guards the registers against the work running on the GPU thread, which updates status bits
+static std::mutex regs_mutex;
+
+/// Physical memory that is accessed by work of the GPU
+struct MemoryRange {
+    PAddr start;
+    u32 size;
+};
+
+/**
+ * Runs work of the GPU on the GPU thread if there is one, otherwise right away. The pages of the
+ * given memory ranges are fenced until the work is retired, so CPU accesses to them wait for it.
+ * @return The fence of the work, or 0 if it already ran
+ */
+static u64 SubmitWork(std::function<void()> work, std::vector<MemoryRange> ranges) {
+    if (!VideoCore::g_gpu_thread) {
+        work();
+        return 0;
+    }
+    for (const auto& range : ranges) {
+        g_memory->MarkRegionInUseByGPU(range.start, range.size, true);
+    }
+    const u64 fence = VideoCore::g_gpu_thread->Push([work = std::move(work), ranges] {
+        work();
+        // The CPU uses the page tables without locking them, so they are only updated on the
+        // emulated CPU thread, which runs this when retiring the work
+        VideoCore::GPUThread::DeferToCPU([ranges] {
+            for (const auto& range : ranges) {
+                g_memory->MarkRegionInUseByGPU(range.start, range.size, false);
+            }
+        });
+    });
+    Core::System::GetInstance().CoreTiming().ScheduleEvent(gpu_thread_latency_ticks,
+                                                           gpu_thread_retire_event, fence);
+    return fence;
+}
+
+static void GPUThreadRetireCallback(u64 fence, s64 cycles_late) {
+    if (VideoCore::g_gpu_thread) {
+        VideoCore::g_gpu_thread->Retire(fence);
+    }
+}
 
 template <typename T>
 inline void Read(T& var, const u32 raw_addr) {
@@ -44,32 +96,10 @@ inline void Read(T& var, const u32 raw_addr) {
         return;
     }
 
+    std::lock_guard lock{regs_mutex};
     var = g_regs[addr / 4];
 }
 
-static Common::Vec4<u8> DecodePixel(Regs::PixelFormat input_format, const u8* src_pixel) {
-    switch (input_format) {
-    case Regs::PixelFormat::RGBA8:
-        return Color::DecodeRGBA8(src_pixel);
-
-    case Regs::PixelFormat::RGB8:
-        return Color::DecodeRGB8(src_pixel);
-
-    case Regs::PixelFormat::RGB565:
-        return Color::DecodeRGB565(src_pixel);
-
-    case Regs::PixelFormat::RGB5A1:
-        return Color::DecodeRGB5A1(src_pixel);
-
-    case Regs::PixelFormat::RGBA4:
-        return Color::DecodeRGBA4(src_pixel);
-
-    default:
-        LOG_ERROR(HW_GPU, "Unknown source framebuffer format {:x}", input_format);
-        return {0, 0, 0, 0};
-    }
-}
-
 MICROPROFILE_DEFINE(GPU_DisplayTransfer, "GPU", "DisplayTransfer", MP_RGB(100, 100, 255));
 MICROPROFILE_DEFINE(GPU_CmdlistProcessing, "GPU", "Cmdlist Processing", MP_RGB(100, 255, 100));
 
@@ -103,27 +133,7 @@ static void MemoryFill(const Regs::MemoryFillConfig& config) {
     Memory::RasterizerInvalidateRegion(config.GetStartAddress(),
                                        config.GetEndAddress() - config.GetStartAddress());
 
-    if (config.fill_24bit) {
-        // fill with 24-bit values
-        for (u8* ptr = start; ptr < end; ptr += 3) {
-            ptr[0] = config.value_24bit_r;
-            ptr[1] = config.value_24bit_g;
-            ptr[2] = config.value_24bit_b;
-        }
-    } else if (config.fill_32bit) {
-        // fill with 32-bit values
-        if (end > start) {
-            u32 value = config.value_32bit;
-            std::size_t len = (end - start) / sizeof(u32);
-            for (std::size_t i = 0; i < len; ++i)
-                memcpy(&start[i * sizeof(u32)], &value, sizeof(u32));
-        }
-    } else {
-        // fill with 16-bit values
-        u16 value_16bit = config.value_16bit.Value();
-        for (u8* ptr = start; ptr < end; ptr += sizeof(u16))
-            memcpy(ptr, &value_16bit, sizeof(u16));
-    }
+    SoftwareMemoryFill(config, start, end);
 }
 
 static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
@@ -193,113 +203,7 @@ static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
     Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), input_size);
     Memory::RasterizerInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
 
-    for (u32 y = 0; y < output_height; ++y) {
-        for (u32 x = 0; x < output_width; ++x) {
-            Common::Vec4<u8> src_color;
-
-            // Calculate the [x,y] position of the input image
-            // based on the current output position and the scale
-            u32 input_x = x << horizontal_scale;
-            u32 input_y = y << vertical_scale;
-
-            u32 output_y;
-            if (config.flip_vertically) {
-                // Flip the y value of the output data,
-                // we do this after calculating the [x,y] position of the input image
-                // to account for the scaling options.
-                output_y = output_height - y - 1;
-            } else {
-                output_y = y;
-            }
-
-            u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
-            u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
-            u32 src_offset;
-            u32 dst_offset;
-
-            if (config.input_linear) {
-                if (!config.dont_swizzle) {
-                    // Interpret the input as linear and the output as tiled
-                    u32 coarse_y = output_y & ~7;
-                    u32 stride = output_width * dst_bytes_per_pixel;
-
-                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
-                                 coarse_y * stride;
-                } else {
-                    // Both input and output are linear
-                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
-                }
-            } else {
-                if (!config.dont_swizzle) {
-                    // Interpret the input as tiled and the output as linear
-                    u32 coarse_y = input_y & ~7;
-                    u32 stride = config.input_width * src_bytes_per_pixel;
-
-                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
-                                 coarse_y * stride;
-                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
-                } else {
-                    // Both input and output are tiled
-                    u32 out_coarse_y = output_y & ~7;
-                    u32 out_stride = output_width * dst_bytes_per_pixel;
-
-                    u32 in_coarse_y = input_y & ~7;
-                    u32 in_stride = config.input_width * src_bytes_per_pixel;
-
-                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
-                                 in_coarse_y * in_stride;
-                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
-                                 out_coarse_y * out_stride;
-                }
-            }
-
-            const u8* src_pixel = src_pointer + src_offset;
-            src_color = DecodePixel(config.input_format, src_pixel);
-            if (config.scaling == config.ScaleX) {
-                Common::Vec4<u8> pixel =
-                    DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
-                src_color = ((src_color + pixel) / 2).Cast<u8>();
-            } else if (config.scaling == config.ScaleXY) {
-                Common::Vec4<u8> pixel1 =
-                    DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
-                Common::Vec4<u8> pixel2 =
-                    DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
-                Common::Vec4<u8> pixel3 =
-                    DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
-                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
-            }
-
-            u8* dst_pixel = dst_pointer + dst_offset;
-            switch (config.output_format) {
-            case Regs::PixelFormat::RGBA8:
-                Color::EncodeRGBA8(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB8:
-                Color::EncodeRGB8(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB565:
-                Color::EncodeRGB565(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB5A1:
-                Color::EncodeRGB5A1(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGBA4:
-                Color::EncodeRGBA4(src_color, dst_pixel);
-                break;
-
-            default:
-                LOG_ERROR(HW_GPU, "Unknown destination framebuffer format {:x}",
-                          static_cast<u32>(config.output_format.Value()));
-                break;
-            }
-        }
-    }
+    SoftwareDisplayTransfer(config, src_pointer, dst_pointer);
 }
 
 static void TextureCopy(const Regs::DisplayTransferConfig& config) {
@@ -384,6 +288,53 @@ static void TextureCopy(const Regs::DisplayTransferConfig& config) {
     }
 }
 
+/// Copies registers that the work running on the GPU thread can update
+template <typename T>
+static T CopyRegs(const T& regs) {
+    std::lock_guard lock{regs_mutex};
+    return regs;
+}
+
+/// Returns the memory that a memory fill writes
+static std::vector<MemoryRange> GetMemoryFillRanges(const Regs::MemoryFillConfig& config) {
+    const PAddr start_addr = config.GetStartAddress();
+    const PAddr end_addr = config.GetEndAddress();
+    if (end_addr <= start_addr) {
+        return {};
+    }
+    return {{start_addr, end_addr - start_addr}};
+}
+
+/// Returns the memory that a display transfer or texture copy reads and writes
+static std::vector<MemoryRange> GetTransferRanges(const Regs::DisplayTransferConfig& config) {
+    const PAddr src_addr = config.GetPhysicalInputAddress();
+    const PAddr dst_addr = config.GetPhysicalOutputAddress();
+    if (!config.is_texture_copy) {
+        const u32 input_size = config.input_width * config.input_height *
+                               GPU::Regs::BytesPerPixel(config.input_format);
+        const u32 output_size = config.output_width * config.output_height *
+                                GPU::Regs::BytesPerPixel(config.output_format);
+        return {{src_addr, input_size}, {dst_addr, output_size}};
+    }
+
+    const u32 size = Common::AlignDown(config.texture_copy.size, 16);
+    const u32 input_gap = config.texture_copy.input_gap * 16;
+    const u32 output_gap = config.texture_copy.output_gap * 16;
+    const u32 input_width = input_gap == 0 ? size : config.texture_copy.input_width * 16;
+    const u32 output_width = output_gap == 0 ? size : config.texture_copy.output_width * 16;
+    if (size == 0 || input_width == 0 || output_width == 0) {
+        return {};
+    }
+
+    // Includes the gap after the last line, which is not accessed but keeps this simple
+    const auto GetLinesSize = [size](u32 width, u32 gap) {
+        const u64 lines = (u64{size} + width - 1) / width;
+        return static_cast<u32>(std::min<u64>(lines * (width + gap), UINT32_MAX));
+    };
+    return {{src_addr, GetLinesSize(input_width, input_gap)},
+            {dst_addr, GetLinesSize(output_width, output_gap)}};
+}
+
 template <typename T>
 inline void Write(u32 addr, const T data) {
     addr -= HW::VADDR_GPU;
@@ -395,84 +346,125 @@ inline void Write(u32 addr, const T data) {
         return;
     }
 
-    g_regs[index] = static_cast<u32>(data);
+    {
+        std::lock_guard lock{regs_mutex};
+        g_regs[index] = static_cast<u32>(data);
+    }
 
+    // The status bits are updated by the work once it ran, which may be on the GPU thread. The
+    // registers are not locked while submitting it, as it runs right away without a GPU thread.
     switch (index) {
 
     // Memory fills are triggered once the fill value is written.
     case GPU_REG_INDEX(memory_fill_config[0].trigger):
     case GPU_REG_INDEX(memory_fill_config[1].trigger): {
         const bool is_second_filler = (index != GPU_REG_INDEX(memory_fill_config[0].trigger));
-        auto& config = g_regs.memory_fill_config[is_second_filler];
+        const auto config = CopyRegs(g_regs.memory_fill_config[is_second_filler]);
 
         if (config.trigger) {
-            MemoryFill(config);
-            LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}", config.GetStartAddress(),
-                      config.GetEndAddress());
-
-            // It seems that it won't signal interrupt if "address_start" is zero.
-            // TODO: hwtest this
-            if (config.GetStartAddress() != 0) {
-                if (!is_second_filler) {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
-                } else {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
-                }
-            }
-
-            // Reset "trigger" flag and set the "finish" flag
-            // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
-            config.trigger.Assign(0);
-            config.finished.Assign(1);
+            SubmitWork(
+                [config, is_second_filler] {
+                    MemoryFill(config);
+                    LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}",
+                              config.GetStartAddress(), config.GetEndAddress());
+
+                    // Reset "trigger" flag and set the "finish" flag
+                    // NOTE: This was confirmed to happen on hardware even if "address_start" is
+                    // zero.
+                    {
+                        std::lock_guard lock{regs_mutex};
+                        auto& regs_config = g_regs.memory_fill_config[is_second_filler];
+                        regs_config.trigger.Assign(0);
+                        regs_config.finished.Assign(1);
+                    }
+
+                    // It seems that it won't signal interrupt if "address_start" is zero.
+                    // TODO: hwtest this
+                    if (config.GetStartAddress() != 0) {
+                        if (!is_second_filler) {
+                            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
+                        } else {
+                            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
+                        }
+                    }
+                },
+                GetMemoryFillRanges(config));
         }
         break;
     }
 
     case GPU_REG_INDEX(display_transfer_config.trigger): {
-        MICROPROFILE_SCOPE(GPU_DisplayTransfer);
+        const auto config = CopyRegs(g_regs.display_transfer_config);
 
-        const auto& config = g_regs.display_transfer_config;
         if (config.trigger & 1) {
-
-            if (Pica::g_debug_context)
-                Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::IncomingDisplayTransfer,
-                                               nullptr);
-
-            if (config.is_texture_copy) {
-                TextureCopy(config);
-                LOG_TRACE(HW_GPU,
-                          "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
-                          "{:#010X}({}+{}), flags {:#010X}",
-                          config.texture_copy.size, config.GetPhysicalInputAddress(),
-                          config.texture_copy.input_width * 16, config.texture_copy.input_gap * 16,
-                          config.GetPhysicalOutputAddress(), config.texture_copy.output_width * 16,
-                          config.texture_copy.output_gap * 16, config.flags);
-            } else {
-                DisplayTransfer(config);
-                LOG_TRACE(HW_GPU,
-                          "DisplayTransfer: {:#010X}({}x{})-> "
-                          "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
-                          config.GetPhysicalInputAddress(), config.input_width.Value(),
-                          config.input_height.Value(), config.GetPhysicalOutputAddress(),
-                          config.output_width.Value(), config.output_height.Value(),
-                          static_cast<u32>(config.output_format.Value()), config.flags);
-            }
-
-            g_regs.display_transfer_config.trigger = 0;
-            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
+            SubmitWork(
+                [config] {
+                    MICROPROFILE_SCOPE(GPU_DisplayTransfer);
+
+                    if (Pica::g_debug_context)
+                        Pica::g_debug_context->OnEvent(
+                            Pica::DebugContext::Event::IncomingDisplayTransfer, nullptr);
+
+                    if (config.is_texture_copy) {
+                        TextureCopy(config);
+                        LOG_TRACE(HW_GPU,
+                                  "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
+                                  "{:#010X}({}+{}), flags {:#010X}",
+                                  config.texture_copy.size, config.GetPhysicalInputAddress(),
+                                  config.texture_copy.input_width * 16,
+                                  config.texture_copy.input_gap * 16,
+                                  config.GetPhysicalOutputAddress(),
+                                  config.texture_copy.output_width * 16,
+                                  config.texture_copy.output_gap * 16, config.flags);
+                    } else {
+                        DisplayTransfer(config);
+                        LOG_TRACE(HW_GPU,
+                                  "DisplayTransfer: {:#010X}({}x{})-> "
+                                  "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
+                                  config.GetPhysicalInputAddress(), config.input_width.Value(),
+                                  config.input_height.Value(), config.GetPhysicalOutputAddress(),
+                                  config.output_width.Value(), config.output_height.Value(),
+                                  static_cast<u32>(config.output_format.Value()), config.flags);
+                    }
+
+                    {
+                        std::lock_guard lock{regs_mutex};
+                        g_regs.display_transfer_config.trigger = 0;
+                    }
+
+                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
+                },
+                GetTransferRanges(config));
         }
         break;
     }
 
     // Seems like writing to this register triggers processing
     case GPU_REG_INDEX(command_processor_config.trigger): {
-        const auto& config = g_regs.command_processor_config;
-        if (config.trigger & 1) {
-            MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
+        const auto config = CopyRegs(g_regs.command_processor_config);
 
-            Pica::CommandProcessor::ProcessCommandList(config.GetPhysicalAddress(), config.size);
-
-            g_regs.command_processor_config.trigger = 0;
+        if (config.trigger & 1) {
+            // Only the command list itself is fenced. The vertex, index and texture data that
+            // the commands read belong to the GPU until the guest receives the interrupt of the
+            // list, like on hardware, and that interrupt is only signaled once the list ran.
+            const PAddr address = config.GetPhysicalAddress();
+            const u64 fence = SubmitWork(
+                [address, size = config.size] {
+                    MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
+
+                    Pica::CommandProcessor::ProcessCommandList(address, size);
+
+                    std::lock_guard lock{regs_mutex};
+                    g_regs.command_processor_config.trigger = 0;
+                },
+                {{address, config.size}});
+
+            // The software renderer writes the render targets to emulated memory directly, and
+            // which memory that is depends on the commands, so the CPU can't access memory until
+            // they ran. The hardware renderer caches the render targets instead.
+            if (fence != 0 && !VideoCore::g_hw_renderer_enabled) {
+                VideoCore::g_gpu_thread->WaitForFence(fence);
+            }
         }
         break;
     }
@@ -504,7 +496,22 @@ template void Write<u8>(u32 addr, const u8 data);
 
 /// Update hardware
 static void VBlankCallback(u64 userdata, s64 cycles_late) {
-    VideoCore::g_renderer->SwapBuffers();
+    auto& system = Core::System::GetInstance();
+    const auto present_begin = Core::PerfStats::Clock::now();
+    if (VideoCore::g_gpu_thread) {
+        // Keep at most one frame in flight, so that the CPU does not run ahead of what is shown
+        VideoCore::g_gpu_thread->WaitForFence(gpu_thread_frame_fence);
+        gpu_thread_frame_fence =
+            VideoCore::g_gpu_thread->Push([] { VideoCore::g_renderer->SwapBuffers(); });
+    } else {
+        VideoCore::g_renderer->SwapBuffers();
+    }
+    system.perf_stats->AddFrameGPUTime(Core::PerfStats::Clock::now() - present_begin);
+
+    system.perf_stats->EndSystemFrame();
+    VideoCore::g_renderer->GetRenderWindow().PollEvents();
+    system.frame_limiter.DoFrameLimiting(system.CoreTiming().GetGlobalTimeUs());
+    system.perf_stats->BeginSystemFrame();
 
     // Signal to GSP that GPU interrupt has occurred
     // TODO(yuriks): hwtest to determine if PDC0 is for the Top screen and PDC1 for the Sub
@@ -515,7 +522,7 @@ static void VBlankCallback(u64 userdata, s64 cycles_late) {
     Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PDC1);
 
     // Reschedule recurrent event
-    Core::System::GetInstance().CoreTiming().ScheduleEvent(frame_ticks - cycles_late, vblank_event);
+    system.CoreTiming().ScheduleEvent(frame_ticks - cycles_late, vblank_event);
 }
 
 /// Initialize hardware
@@ -552,6 +559,9 @@ void Init(Memory::MemorySystem& memory) {
     Core::Timing& timing = Core::System::GetInstance().CoreTiming();
     vblank_event = timing.RegisterEvent("GPU::VBlankCallback", VBlankCallback);
     timing.ScheduleEvent(frame_ticks, vblank_event);
+    gpu_thread_retire_event =
+        timing.RegisterEvent("GPU::GPUThreadRetireCallback", GPUThreadRetireCallback);
+    gpu_thread_frame_fence = 0;
 
     LOG_DEBUG(HW_GPU, "initialized OK");
 }
@@ -0,0 +1,379 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "common/color.h"
+#include "common/logging/log.h"
+#include "common/vector_math.h"
+#include "core/hw/gpu_transfer.h"
+#include "video_core/utils.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
+namespace GPU {
+
+namespace {
+
+using PixelFormat = Regs::PixelFormat;
+using ScalingMode = Regs::DisplayTransferConfig::ScalingMode;
+
+struct TransferParams {
+    const u8* src;
+    u8* dst;
+    u32 input_width;
+    u32 output_width;
+    u32 output_height;
+    bool flip_vertically;
+};
+
+using TransferKernel = void (*)(const TransferParams&);
+
+template <PixelFormat format>
+constexpr u32 BytesPerPixel =
+    format == PixelFormat::RGBA8 ? 4 : format == PixelFormat::RGB8 ? 3 : 2;
+
+template <PixelFormat format>
+Common::Vec4<u8> DecodePixel(const u8* src_pixel) {
+    if constexpr (format == PixelFormat::RGBA8) {
+        return Color::DecodeRGBA8(src_pixel);
+    } else if constexpr (format == PixelFormat::RGB8) {
+        return Color::DecodeRGB8(src_pixel);
+    } else if constexpr (format == PixelFormat::RGB565) {
+        return Color::DecodeRGB565(src_pixel);
+    } else if constexpr (format == PixelFormat::RGB5A1) {
+        return Color::DecodeRGB5A1(src_pixel);
+    } else {
+        return Color::DecodeRGBA4(src_pixel);
+    }
+}
+
+template <PixelFormat format>
+void EncodePixel(const Common::Vec4<u8>& color, u8* dst_pixel) {
+    if constexpr (format == PixelFormat::RGBA8) {
+        Color::EncodeRGBA8(color, dst_pixel);
+    } else if constexpr (format == PixelFormat::RGB8) {
+        Color::EncodeRGB8(color, dst_pixel);
+    } else if constexpr (format == PixelFormat::RGB565) {
+        Color::EncodeRGB565(color, dst_pixel);
+    } else if constexpr (format == PixelFormat::RGB5A1) {
+        Color::EncodeRGB5A1(color, dst_pixel);
+    } else {
+        Color::EncodeRGBA4(color, dst_pixel);
+    }
+}
+
+/// Averages each channel of a 2x2 block of RGBA8 pixels, stored as 4 consecutive pixels
+void BoxFilterRGBA8(const u8* src, u32* dst) {
+    u8 result[4];
+    for (std::size_t channel = 0; channel < 4; ++channel) {
+        const u8* pixels = src + channel;
+        result[channel] = static_cast<u8>((pixels[0] + pixels[4] + pixels[8] + pixels[12]) / 4);
+    }
+    std::memcpy(dst, result, sizeof(result));
+}
+
+/// Averages each channel of two 2x2 blocks of RGBA8 pixels, stored as 8 consecutive pixels
+void BoxFilterRGBA8x2(const u8* src, u32* dst) {
+#ifdef ARCHITECTURE_x86_64
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i block0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    const __m128i block1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+    // Add the channels of pixels 0 and 2 as well as 1 and 3 of each block in 16 bits
+    const __m128i sum0 =
+        _mm_add_epi16(_mm_unpacklo_epi8(block0, zero), _mm_unpackhi_epi8(block0, zero));
+    const __m128i sum1 =
+        _mm_add_epi16(_mm_unpacklo_epi8(block1, zero), _mm_unpackhi_epi8(block1, zero));
+    // Then add the two halves, which leaves one sum per block
+    const __m128i sum =
+        _mm_add_epi16(_mm_unpacklo_epi64(sum0, sum1), _mm_unpackhi_epi64(sum0, sum1));
+    const __m128i average = _mm_srli_epi16(sum, 2);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(average, average));
+#else
+    BoxFilterRGBA8(src, dst);
+    BoxFilterRGBA8(src + 16, dst + 1);
+#endif
+}
+
+/// Converts a raw RGBA8 pixel to RGB565
+u16 RGBA8ToRGB565(u32 pixel) {
+    return static_cast<u16>(((pixel >> 16) & 0xF800) | ((pixel >> 13) & 0x07E0) |
+                            ((pixel >> 11) & 0x001F));
+}
+
+/// Encodes a row of raw RGBA8 pixels in the given format
+template <PixelFormat format>
+void EncodeRowRGBA8(const u32* row, u32 width, u8* dst) {
+    if constexpr (format == PixelFormat::RGBA8) {
+        std::memcpy(dst, row, width * sizeof(u32));
+    } else if constexpr (format == PixelFormat::RGB8) {
+        u32 x = 0;
+        // Drop the alpha byte of each pixel and pack four pixels into 12 bytes
+        for (; x + 4 <= width; x += 4) {
+            const u64 low = (row[x] >> 8) | (static_cast<u64>(row[x + 1] >> 8) << 24) |
+                            (static_cast<u64>(row[x + 2] >> 8) << 48);
+            const u32 high = (row[x + 2] >> 24) | ((row[x + 3] >> 8) << 8);
+            std::memcpy(dst + x * 3, &low, sizeof(low));
+            std::memcpy(dst + x * 3 + 8, &high, sizeof(high));
+        }
+        for (; x < width; ++x) {
+            const u32 pixel = row[x] >> 8;
+            std::memcpy(dst + x * 3, &pixel, 3);
+        }
+    } else {
+        static_assert(format == PixelFormat::RGB565);
+        u32 x = 0;
+#ifdef ARCHITECTURE_x86_64
+        const __m128i red_mask = _mm_set1_epi32(0xF800);
+        const __m128i green_mask = _mm_set1_epi32(0x07E0);
+        const __m128i blue_mask = _mm_set1_epi32(0x001F);
+        for (; x + 4 <= width; x += 4) {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+            __m128i result = _mm_or_si128(
+                _mm_or_si128(_mm_and_si128(_mm_srli_epi32(pixels, 16), red_mask),
+                             _mm_and_si128(_mm_srli_epi32(pixels, 13), green_mask)),
+                _mm_and_si128(_mm_srli_epi32(pixels, 11), blue_mask));
+            // Sign extend the results so that the signed saturation of packs keeps them intact
+            result = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x * 2),
+                             _mm_packs_epi32(result, result));
+        }
+#endif
+        for (; x < width; ++x) {
+            const u16 pixel = RGBA8ToRGB565(row[x]);
+            std::memcpy(dst + x * 2, &pixel, sizeof(pixel));
+        }
+    }
+}
+
+/**
+ * Transfers one row of a tiled RGBA8 image. The pixels are first gathered from the tiles into a
+ * linear row, which is then converted as a whole.
+ */
+template <PixelFormat format, bool downscale>
+void TransferRowRGBA8(const u8* src_tile_row, u32 input_y, u32 width, u32* row, u8* dst) {
+    u32 x = 0;
+    if constexpr (downscale) {
+        // The 2x2 blocks of four horizontally adjacent output pixels are stored in two runs of
+        // two blocks each
+        for (; x + 4 <= width; x += 4) {
+            const u8* tile = src_tile_row + VideoCore::GetMortonOffset(x * 2, input_y, 4);
+            BoxFilterRGBA8x2(tile, row + x);
+            BoxFilterRGBA8x2(tile + 16 * 4, row + x + 2);
+        }
+        for (; x < width; ++x) {
+            BoxFilterRGBA8(src_tile_row + VideoCore::GetMortonOffset(x * 2, input_y, 4), row + x);
+        }
+    } else {
+        // Each row of a tile is stored as four pairs of adjacent pixels
+        for (; x + 8 <= width; x += 8) {
+            const u8* tile = src_tile_row + VideoCore::GetMortonOffset(x, input_y, 4);
+            std::memcpy(row + x, tile, 8);
+            std::memcpy(row + x + 2, tile + 4 * 4, 8);
+            std::memcpy(row + x + 4, tile + 16 * 4, 8);
+            std::memcpy(row + x + 6, tile + 20 * 4, 8);
+        }
+        for (; x < width; ++x) {
+            std::memcpy(row + x, src_tile_row + VideoCore::GetMortonOffset(x, input_y, 4), 4);
+        }
+    }
+    EncodeRowRGBA8<format>(row, width, dst);
+}
+
+template <PixelFormat input_format, PixelFormat output_format, ScalingMode scaling, bool src_tiled,
+          bool dst_tiled>
+void Transfer(const TransferParams& params) {
+    constexpr u32 src_bytes_per_pixel = BytesPerPixel<input_format>;
+    constexpr u32 dst_bytes_per_pixel = BytesPerPixel<output_format>;
+    constexpr u32 horizontal_scale = scaling != ScalingMode::NoScale ? 1 : 0;
+    constexpr u32 vertical_scale = scaling == ScalingMode::ScaleXY ? 1 : 0;
+    // Framebuffer copies from a tiled RGBA8 render target have a vectorized path
+    constexpr bool use_rgba8_rows =
+        input_format == PixelFormat::RGBA8 && src_tiled && !dst_tiled &&
+        scaling != ScalingMode::ScaleX &&
+        (output_format == PixelFormat::RGBA8 || output_format == PixelFormat::RGB8 ||
+         output_format == PixelFormat::RGB565);
+
+    const u32 src_stride = params.input_width * src_bytes_per_pixel;
+    const u32 dst_stride = params.output_width * dst_bytes_per_pixel;
+
+    std::vector<u32> row;
+    if constexpr (use_rgba8_rows) {
+        row.resize(params.output_width);
+    }
+
+    for (u32 y = 0; y < params.output_height; ++y) {
+        const u32 input_y = y << vertical_scale;
+        // Flip the y value of the output data after calculating the position in the input image,
+        // to account for the scaling options.
+        const u32 output_y = params.flip_vertically ? params.output_height - y - 1 : y;
+
+        const u8* src_row = params.src + (src_tiled ? input_y & ~7 : input_y) * src_stride;
+        u8* dst_row = params.dst + (dst_tiled ? output_y & ~7 : output_y) * dst_stride;
+
+        if constexpr (use_rgba8_rows) {
+            TransferRowRGBA8<output_format, scaling == ScalingMode::ScaleXY>(
+                src_row, input_y, params.output_width, row.data(), dst_row);
+            continue;
+        }
+
+        for (u32 x = 0; x < params.output_width; ++x) {
+            const u32 input_x = x << horizontal_scale;
+
+            const u8* src_pixel =
+                src_row + (src_tiled ? VideoCore::GetMortonOffset(input_x, input_y,
+                                                                  src_bytes_per_pixel)
+                                     : input_x * src_bytes_per_pixel);
+            u8* dst_pixel = dst_row + (dst_tiled ? VideoCore::GetMortonOffset(
+                                                       x, output_y, dst_bytes_per_pixel)
+                                                 : x * dst_bytes_per_pixel);
+
+            Common::Vec4<u8> src_color = DecodePixel<input_format>(src_pixel);
+            if constexpr (scaling == ScalingMode::ScaleX) {
+                const Common::Vec4<u8> pixel =
+                    DecodePixel<input_format>(src_pixel + src_bytes_per_pixel);
+                src_color = ((src_color + pixel) / 2).Cast<u8>();
+            } else if constexpr (scaling == ScalingMode::ScaleXY) {
+                const Common::Vec4<u8> pixel1 =
+                    DecodePixel<input_format>(src_pixel + 1 * src_bytes_per_pixel);
+                const Common::Vec4<u8> pixel2 =
+                    DecodePixel<input_format>(src_pixel + 2 * src_bytes_per_pixel);
+                const Common::Vec4<u8> pixel3 =
+                    DecodePixel<input_format>(src_pixel + 3 * src_bytes_per_pixel);
+                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
+            }
+
+            EncodePixel<output_format>(src_color, dst_pixel);
+        }
+    }
+}
+
+/// Writes zeros to every output pixel, which is what pixels of an unknown format decode to
+void ClearOutput(const TransferParams& params, u32 dst_bytes_per_pixel, bool dst_tiled) {
+    const u32 dst_stride = params.output_width * dst_bytes_per_pixel;
+    for (u32 y = 0; y < params.output_height; ++y) {
+        u8* dst_row = params.dst + (dst_tiled ? y & ~7 : y) * dst_stride;
+        if (!dst_tiled) {
+            std::memset(dst_row, 0, dst_stride);
+            continue;
+        }
+        for (u32 x = 0; x < params.output_width; ++x) {
+            std::memset(dst_row + VideoCore::GetMortonOffset(x, y, dst_bytes_per_pixel), 0,
+                        dst_bytes_per_pixel);
+        }
+    }
+}
+
+constexpr std::size_t NumFormats = 5;
+
+// Layouts supported by the display transfer engine. Scaling is only implemented for tiled input.
+constexpr std::size_t NumModes = 8;
+
+constexpr std::size_t GetModeIndex(ScalingMode scaling, bool src_tiled, bool dst_tiled) {
+    if (scaling == ScalingMode::NoScale) {
+        return (src_tiled ? 2 : 0) + (dst_tiled ? 1 : 0);
+    }
+    return 2 + scaling * 2 + (dst_tiled ? 1 : 0);
+}
+
+template <std::size_t index>
+constexpr TransferKernel GetKernel() {
+    constexpr auto input_format = static_cast<PixelFormat>(index / (NumFormats * NumModes));
+    constexpr auto output_format = static_cast<PixelFormat>(index / NumModes % NumFormats);
+    constexpr std::size_t mode = index % NumModes;
+    constexpr auto scaling =
+        mode < 4 ? ScalingMode::NoScale : mode < 6 ? ScalingMode::ScaleX : ScalingMode::ScaleXY;
+    constexpr bool src_tiled = mode >= 2;
+    constexpr bool dst_tiled = (mode & 1) != 0;
+    static_assert(GetModeIndex(scaling, src_tiled, dst_tiled) == mode);
+    return &Transfer<input_format, output_format, scaling, src_tiled, dst_tiled>;
+}
+
+template <std::size_t... indices>
+constexpr std::array<TransferKernel, sizeof...(indices)> MakeKernelTable(
+    std::index_sequence<indices...>) {
+    return {GetKernel<indices>()...};
+}
+
+constexpr auto kernel_table =
+    MakeKernelTable(std::make_index_sequence<NumFormats * NumFormats * NumModes>{});
+
+/// Fills size bytes at dst by repeating the value of the given size
+void FillPattern(u8* dst, std::size_t size, const u8* value, std::size_t value_size) {
+    // The buffer size is a multiple of every value size and of the vector width, so that the
+    // fixed size copies below compile to a few vector stores
+    std::array<u8, 192> buffer;
+    for (std::size_t i = 0; i < buffer.size(); ++i) {
+        buffer[i] = value[i % value_size];
+    }
+    for (; size >= buffer.size(); size -= buffer.size(), dst += buffer.size()) {
+        std::memcpy(dst, buffer.data(), buffer.size());
+    }
+    std::memcpy(dst, buffer.data(), size);
+}
+
+} // Anonymous namespace
+
+void SoftwareDisplayTransfer(const Regs::DisplayTransferConfig& config, const u8* src_pointer,
+                             u8* dst_pointer) {
+    const auto input_format = static_cast<std::size_t>(config.input_format.Value());
+    const auto output_format = static_cast<std::size_t>(config.output_format.Value());
+    if (output_format >= NumFormats) {
+        LOG_ERROR(HW_GPU, "Unknown destination framebuffer format {:x}", output_format);
+        return;
+    }
+
+    const auto scaling = static_cast<ScalingMode>(config.scaling.Value());
+    const bool src_tiled = !config.input_linear;
+    // The output is tiled if exactly one of linear input and swizzling is enabled
+    const bool dst_tiled = config.input_linear != config.dont_swizzle;
+    ASSERT(src_tiled || scaling == ScalingMode::NoScale);
+
+    const int horizontal_scale = scaling != ScalingMode::NoScale ? 1 : 0;
+    const int vertical_scale = scaling == ScalingMode::ScaleXY ? 1 : 0;
+
+    const TransferParams params{
+        src_pointer,
+        dst_pointer,
+        config.input_width,
+        config.output_width >> horizontal_scale,
+        config.output_height >> vertical_scale,
+        config.flip_vertically != 0,
+    };
+
+    if (input_format >= NumFormats) {
+        LOG_ERROR(HW_GPU, "Unknown source framebuffer format {:x}", input_format);
+        ClearOutput(params, Regs::BytesPerPixel(config.output_format), dst_tiled);
+        return;
+    }
+
+    const std::size_t index = (input_format * NumFormats + output_format) * NumModes +
+                              GetModeIndex(scaling, src_tiled, dst_tiled);
+    kernel_table[index](params);
+}
+
+void SoftwareMemoryFill(const Regs::MemoryFillConfig& config, u8* start, u8* end) {
+    const std::size_t size = end - start;
+    if (config.fill_24bit) {
+        // Whole values are written, even if the last one goes past the end
+        const u8 value[3] = {static_cast<u8>(config.value_24bit_r),
+                             static_cast<u8>(config.value_24bit_g),
+                             static_cast<u8>(config.value_24bit_b)};
+        FillPattern(start, (size + 2) / 3 * 3, value, sizeof(value));
+    } else if (config.fill_32bit) {
+        const u32 value = config.value_32bit;
+        FillPattern(start, size / sizeof(u32) * sizeof(u32), reinterpret_cast<const u8*>(&value),
+                    sizeof(value));
+    } else {
+        const u16 value = static_cast<u16>(config.value_16bit.Value());
+        FillPattern(start, (size + 1) / sizeof(u16) * sizeof(u16),
+                    reinterpret_cast<const u8*>(&value), sizeof(value));
+    }
+}
+
+} // namespace GPU
@@ -0,0 +1,30 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+#include "core/hw/gpu.h"
+
+namespace GPU {
+
+/**
+ * Performs a display transfer in software. The configuration must have been validated already,
+ * in particular scaling is only supported for tiled input.
+ * @param config Display transfer configuration
+ * @param src_pointer Pointer to the input image
+ * @param dst_pointer Pointer to the output image
+ */
+void SoftwareDisplayTransfer(const Regs::DisplayTransferConfig& config, const u8* src_pointer,
+                             u8* dst_pointer);
+
+/**
+ * Performs a memory fill in software.
+ * @param config Memory fill configuration
+ * @param start Pointer to the first byte to fill
+ * @param end Pointer past the last byte to fill
+ */
+void SoftwareMemoryFill(const Regs::MemoryFillConfig& config, u8* start, u8* end);
+
+} // namespace GPU
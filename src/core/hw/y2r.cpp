@@ -5,16 +5,25 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/common_types.h"
+#include "common/thread_worker.h"
 #include "common/vector_math.h"
 #include "core/core.h"
 #include "core/hle/service/y2r_u.h"
 #include "core/hw/y2r.h"
 #include "core/memory.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+
 namespace HW::Y2R {
 
 using namespace Service::Y2R;
@@ -100,6 +109,41 @@ static void ReceiveData(Memory::MemorySystem& memory, u8* output, ConversionBuff
     }
 }
 
+/// Receives the input data of one strip into a buffer laid out like the internal buffer of the
+/// hardware: the Y plane is followed by the U and V planes, or just the interleaved YUYV data.
+static void ReceiveStrip(Memory::MemorySystem& memory, ConversionConfiguration& cvt, u8* buffer,
+                         std::size_t row_data_size) {
+    u8* input_Y = buffer;
+    u8* input_U = input_Y + 8 * cvt.input_line_width;
+    u8* input_V = input_U + 8 * cvt.input_line_width / 2;
+
+    switch (cvt.input_format) {
+    case InputFormat::YUV422_Indiv8:
+        ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 2);
+        ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 2);
+        break;
+    case InputFormat::YUV420_Indiv8:
+        ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 4);
+        ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 4);
+        break;
+    case InputFormat::YUV422_Indiv16:
+        ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 2);
+        ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 2);
+        break;
+    case InputFormat::YUV420_Indiv16:
+        ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 4);
+        ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 4);
+        break;
+    case InputFormat::YUYV422_Interleaved:
+        ReceiveData<1>(memory, input_Y, cvt.src_YUYV, row_data_size * 2);
+        break;
+    }
+}
+
 /// Convert intermediate RGB32 format to the final output format while simulating an outgoing CDMA
 /// transfer.
 static void SendData(Memory::MemorySystem& memory, const u32* input, ConversionBuffer& buf,
@@ -210,6 +254,413 @@ static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, in
     }
 }
 
+/// Conversions with at least this many strips are split across worker threads
+static constexpr std::size_t MIN_PARALLEL_STRIPS = 8;
+
+static Common::ThreadWorker& GetWorker() {
+    static Common::ThreadWorker worker(std::max(std::thread::hardware_concurrency(), 2u) - 1,
+                                       "Y2R");
+    return worker;
+}
+
+static std::size_t OutputBytesPerPixel(OutputFormat output_format) {
+    switch (output_format) {
+    case OutputFormat::RGBA8:
+        return 4;
+    case OutputFormat::RGB8:
+        return 3;
+    case OutputFormat::RGB5A1:
+    case OutputFormat::RGB565:
+        return 2;
+    }
+    UNREACHABLE();
+}
+
+/**
+ * Computes the order in which the pixels of a strip are sent to the output, as the index of each
+ * pixel in the converted strip. This runs the tile rotation and remapping of the scalar path on
+ * pixel indices instead of colors, so both paths always agree.
+ * @return The order, or an empty vector if the pixels are sent in the order they are converted
+ */
+static std::vector<u16> MakeOutputOrder(const ConversionConfiguration& cvt,
+                                        unsigned int row_height) {
+    const std::size_t num_tiles = cvt.input_line_width / 8;
+    const u8* tile_remap =
+        cvt.block_alignment == BlockAlignment::Block8x8 ? morton_lut : linear_lut;
+
+    std::vector<u32> output(8 * cvt.input_line_width);
+    u32* output_buffer = output.data();
+    ImageTile tile;
+    ImageTile tmp_tile{};
+
+    for (std::size_t i = 0; i < num_tiles; ++i) {
+        const bool reverse =
+            cvt.rotation == Rotation::Clockwise_180 || cvt.rotation == Rotation::Clockwise_270;
+        const std::size_t tile_index = reverse ? num_tiles - i - 1 : i;
+        for (std::size_t y = 0; y < 8; ++y) {
+            for (std::size_t x = 0; x < 8; ++x) {
+                tile[y * 8 + x] = static_cast<u32>(y * cvt.input_line_width + tile_index * 8 + x);
+            }
+        }
+
+        int image_strip_width = 8;
+        int output_stride = 8 * row_height;
+        switch (cvt.rotation) {
+        case Rotation::None:
+            RotateTile0(tile, tmp_tile, row_height, tile_remap);
+            image_strip_width = cvt.input_line_width;
+            output_stride = 8;
+            break;
+        case Rotation::Clockwise_90:
+            RotateTile90(tile, tmp_tile, row_height, tile_remap);
+            break;
+        case Rotation::Clockwise_180:
+            RotateTile180(tile, tmp_tile, row_height, tile_remap);
+            image_strip_width = cvt.input_line_width;
+            output_stride = 8;
+            break;
+        case Rotation::Clockwise_270:
+            RotateTile270(tile, tmp_tile, row_height, tile_remap);
+            break;
+        }
+
+        switch (cvt.block_alignment) {
+        case BlockAlignment::Linear:
+            WriteTileToOutput(output_buffer, tmp_tile, row_height, image_strip_width);
+            output_buffer += output_stride;
+            break;
+        case BlockAlignment::Block8x8:
+            WriteTileToOutput(output_buffer, tmp_tile, 8, 8);
+            output_buffer += TILE_SIZE;
+            break;
+        }
+    }
+
+    const std::size_t num_pixels = row_height * cvt.input_line_width;
+    std::vector<u16> order(output.begin(), output.begin() + num_pixels);
+    for (std::size_t i = 0; i < num_pixels; ++i) {
+        if (order[i] != i) {
+            return order;
+        }
+    }
+    return {};
+}
+
+/// Returns the range of guest memory touched by transferring the given amount of bytes
+static std::pair<VAddr, VAddr> GetTransferRange(const ConversionBuffer& buf, std::size_t size) {
+    const std::size_t num_units = (size + buf.transfer_unit - 1) / buf.transfer_unit;
+    // Add a unit to account for the last pixel of a unit crossing its end
+    return {buf.address, static_cast<VAddr>(buf.address + (num_units + 1) *
+                                                              (buf.transfer_unit + buf.gap))};
+}
+
+/// Checks whether sending the output of a strip could overwrite the input of a later strip
+static bool OutputOverlapsInput(const ConversionConfiguration& cvt) {
+    const std::size_t num_pixels = cvt.input_line_width * cvt.input_lines;
+    const auto output =
+        GetTransferRange(cvt.dst, num_pixels * OutputBytesPerPixel(cvt.output_format));
+    const auto overlaps = [&output](std::pair<VAddr, VAddr> input) {
+        return input.first < output.second && output.first < input.second;
+    };
+
+    std::size_t sample_size = 1;
+    std::size_t chroma_size = num_pixels / 2;
+    switch (cvt.input_format) {
+    case InputFormat::YUV422_Indiv8:
+        break;
+    case InputFormat::YUV420_Indiv8:
+        chroma_size = num_pixels / 4;
+        break;
+    case InputFormat::YUV422_Indiv16:
+        sample_size = 2;
+        break;
+    case InputFormat::YUV420_Indiv16:
+        sample_size = 2;
+        chroma_size = num_pixels / 4;
+        break;
+    case InputFormat::YUYV422_Interleaved:
+        return overlaps(GetTransferRange(cvt.src_YUYV, num_pixels * 2));
+    }
+    return overlaps(GetTransferRange(cvt.src_Y, num_pixels * sample_size)) ||
+           overlaps(GetTransferRange(cvt.src_U, chroma_size * sample_size)) ||
+           overlaps(GetTransferRange(cvt.src_V, chroma_size * sample_size));
+}
+
+/// Converts one YUV sample to RGB32, exactly like ConvertYUVToRGB
+static u32 ConvertPixel(s32 Y, s32 U, s32 V, const CoefficientSet& c) {
+    const s32 cY = c[0] * Y;
+    s32 r = cY + c[1] * V;
+    s32 g = cY - c[2] * V - c[3] * U;
+    s32 b = cY + c[4] * U;
+
+    const s32 rounding_offset = 0x18;
+    r = (r >> 3) + c[5] + rounding_offset;
+    g = (g >> 3) + c[6] + rounding_offset;
+    b = (b >> 3) + c[7] + rounding_offset;
+
+    return ((u32)std::clamp(r >> 5, 0, 0xFF) << 24) | ((u32)std::clamp(g >> 5, 0, 0xFF) << 16) |
+           ((u32)std::clamp(b >> 5, 0, 0xFF) << 8);
+}
+
+#ifdef ARCHITECTURE_x86_64
+/// Converts 8 YUV samples, given as 16-bit lanes, to RGB32
+static void ConvertPixels(__m128i Y, __m128i U, __m128i V, const CoefficientSet& c, u32* output) {
+    const auto pair = [](s16 low, s16 high) {
+        return _mm_set1_epi32(static_cast<s32>((static_cast<u32>(static_cast<u16>(high)) << 16) |
+                                               static_cast<u16>(low)));
+    };
+    const __m128i coef_r = pair(c[0], c[1]);
+    const __m128i coef_y = pair(c[0], 0);
+    const __m128i coef_g = pair(c[2], c[3]);
+    const __m128i coef_b = pair(c[0], c[4]);
+    const __m128i offset_r = _mm_set1_epi32(c[5] + 0x18);
+    const __m128i offset_g = _mm_set1_epi32(c[6] + 0x18);
+    const __m128i offset_b = _mm_set1_epi32(c[7] + 0x18);
+
+    // Each half holds 4 pixels. The products are summed pairwise in 32 bits by pmaddwd.
+    const auto channels = [&](__m128i YV, __m128i YU, __m128i VU, __m128i& r, __m128i& g,
+                              __m128i& b) {
+        r = _mm_madd_epi16(YV, coef_r);
+        g = _mm_sub_epi32(_mm_madd_epi16(YV, coef_y), _mm_madd_epi16(VU, coef_g));
+        b = _mm_madd_epi16(YU, coef_b);
+        r = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(r, 3), offset_r), 5);
+        g = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(g, 3), offset_g), 5);
+        b = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(b, 3), offset_b), 5);
+    };
+    __m128i r_low, g_low, b_low, r_high, g_high, b_high;
+    channels(_mm_unpacklo_epi16(Y, V), _mm_unpacklo_epi16(Y, U), _mm_unpacklo_epi16(V, U), r_low,
+             g_low, b_low);
+    channels(_mm_unpackhi_epi16(Y, V), _mm_unpackhi_epi16(Y, U), _mm_unpackhi_epi16(V, U), r_high,
+             g_high, b_high);
+
+    // The saturating packs clamp the channels to [0, 255]
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i r = _mm_packus_epi16(_mm_packs_epi32(r_low, r_high), zero);
+    const __m128i g = _mm_packus_epi16(_mm_packs_epi32(g_low, g_high), zero);
+    const __m128i b = _mm_packus_epi16(_mm_packs_epi32(b_low, b_high), zero);
+    const __m128i b0 = _mm_unpacklo_epi8(zero, b);
+    const __m128i rg = _mm_unpacklo_epi8(g, r);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_unpacklo_epi16(b0, rg));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 4), _mm_unpackhi_epi16(b0, rg));
+}
+
+/// Loads 8 bytes and widens them to 16-bit lanes
+static __m128i LoadSamples(const u8* input) {
+    return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(input)),
+                             _mm_setzero_si128());
+}
+
+/// Loads 4 bytes, duplicates each of them and widens them to 16-bit lanes
+static __m128i LoadChromaSamples(const u8* input) {
+    u32 samples;
+    std::memcpy(&samples, input, sizeof(samples));
+    const __m128i bytes = _mm_cvtsi32_si128(static_cast<s32>(samples));
+    return _mm_unpacklo_epi8(_mm_unpacklo_epi8(bytes, bytes), _mm_setzero_si128());
+}
+#endif
+
+/// Converts a strip received by ReceiveStrip to RGB32, in raster order
+template <InputFormat input_format>
+static void ConvertStripToRGB(const u8* input, unsigned int width, unsigned int height,
+                              const CoefficientSet& coefficients, u32* output) {
+    constexpr bool is_420 = input_format == InputFormat::YUV420_Indiv8 ||
+                            input_format == InputFormat::YUV420_Indiv16;
+    for (unsigned int y = 0; y < height; ++y) {
+        u32* output_row = output + y * width;
+        if constexpr (input_format == InputFormat::YUYV422_Interleaved) {
+            const u8* row = input + y * width * 2;
+            unsigned int x = 0;
+#ifdef ARCHITECTURE_x86_64
+            const __m128i low_bytes = _mm_set1_epi16(0xFF);
+            for (; x < width; x += 8) {
+                const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 2));
+                const __m128i luma = _mm_and_si128(data, low_bytes);
+                const __m128i chroma = _mm_srli_epi16(data, 8);
+                // The chroma lanes alternate between U and V, each shared by two pixels
+                const __m128i U = _mm_shufflehi_epi16(_mm_shufflelo_epi16(chroma, 0xA0), 0xA0);
+                const __m128i V = _mm_shufflehi_epi16(_mm_shufflelo_epi16(chroma, 0xF5), 0xF5);
+                ConvertPixels(luma, U, V, coefficients, output_row + x);
+            }
+#endif
+            for (; x < width; ++x) {
+                const u8* pair = row + (x & ~1u) * 2;
+                output_row[x] = ConvertPixel(row[x * 2], pair[1], pair[3], coefficients);
+            }
+        } else {
+            const u8* row_Y = input + y * width;
+            const std::size_t chroma_offset = (is_420 ? y / 2 : y) * width / 2;
+            const u8* row_U = input + 8 * width + chroma_offset;
+            const u8* row_V = input + 12 * width + chroma_offset;
+            unsigned int x = 0;
+#ifdef ARCHITECTURE_x86_64
+            for (; x < width; x += 8) {
+                ConvertPixels(LoadSamples(row_Y + x), LoadChromaSamples(row_U + x / 2),
+                              LoadChromaSamples(row_V + x / 2), coefficients, output_row + x);
+            }
+#endif
+            for (; x < width; ++x) {
+                output_row[x] = ConvertPixel(row_Y[x], row_U[x / 2], row_V[x / 2], coefficients);
+            }
+        }
+    }
+}
+
+/// Encodes an RGB32 color and an alpha value in the given output format
+template <OutputFormat output_format>
+static void EncodePixel(u32 color, u8 alpha, u8* output) {
+    if constexpr (output_format == OutputFormat::RGBA8) {
+        const u32 pixel = color | alpha;
+        std::memcpy(output, &pixel, sizeof(pixel));
+    } else if constexpr (output_format == OutputFormat::RGB8) {
+        const u32 pixel = color >> 8;
+        std::memcpy(output, &pixel, 3);
+    } else if constexpr (output_format == OutputFormat::RGB5A1) {
+        const u16 pixel = static_cast<u16>(((color >> 16) & 0xF800) | ((color >> 13) & 0x07C0) |
+                                           ((color >> 10) & 0x003E) | (alpha >> 7));
+        std::memcpy(output, &pixel, sizeof(pixel));
+    } else {
+        const u16 pixel = static_cast<u16>(((color >> 16) & 0xF800) | ((color >> 13) & 0x07E0) |
+                                           ((color >> 11) & 0x001F));
+        std::memcpy(output, &pixel, sizeof(pixel));
+    }
+}
+
+/**
+ * Encodes the converted pixels of a strip in the output format, in the order they are sent.
+ * @param input Converted pixels in raster order
+ * @param order Raster index of each output pixel, or nullptr if the order is the same
+ */
+template <OutputFormat output_format>
+static void EncodeStrip(const u32* input, const u16* order, std::size_t num_pixels, u8 alpha,
+                        u8* output) {
+    std::size_t i = 0;
+    std::array<u32, 4> colors;
+    const auto load = [&](std::size_t index) {
+        for (std::size_t j = 0; j < 4; ++j) {
+            colors[j] = order ? input[order[index + j]] : input[index + j];
+        }
+    };
+
+    if constexpr (output_format == OutputFormat::RGB8) {
+        // Pack four pixels into 12 bytes
+        for (; i + 4 <= num_pixels; i += 4) {
+            load(i);
+            const u64 low = (colors[0] >> 8) | (static_cast<u64>(colors[1] >> 8) << 24) |
+                            (static_cast<u64>(colors[2] >> 8) << 48);
+            const u32 high = (colors[2] >> 24) | ((colors[3] >> 8) << 8);
+            std::memcpy(output + i * 3, &low, sizeof(low));
+            std::memcpy(output + i * 3 + 8, &high, sizeof(high));
+        }
+    }
+#ifdef ARCHITECTURE_x86_64
+    if constexpr (output_format == OutputFormat::RGBA8) {
+        const __m128i alpha_value = _mm_set1_epi32(alpha);
+        for (; i + 4 <= num_pixels; i += 4) {
+            load(i);
+            const __m128i color = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colors.data()));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4),
+                             _mm_or_si128(color, alpha_value));
+        }
+    }
+    if constexpr (output_format == OutputFormat::RGB5A1 || output_format == OutputFormat::RGB565) {
+        constexpr bool has_alpha = output_format == OutputFormat::RGB5A1;
+        constexpr int blue_shift = has_alpha ? 10 : 11;
+        const __m128i red_mask = _mm_set1_epi32(0xF800);
+        const __m128i green_mask = _mm_set1_epi32(has_alpha ? 0x07C0 : 0x07E0);
+        const __m128i blue_mask = _mm_set1_epi32(has_alpha ? 0x003E : 0x001F);
+        const __m128i alpha_bit = _mm_set1_epi32(has_alpha ? alpha >> 7 : 0);
+        for (; i + 4 <= num_pixels; i += 4) {
+            load(i);
+            const __m128i color = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colors.data()));
+            __m128i result = _mm_and_si128(_mm_srli_epi32(color, 16), red_mask);
+            const __m128i green = _mm_and_si128(_mm_srli_epi32(color, 13), green_mask);
+            const __m128i blue = _mm_and_si128(_mm_srli_epi32(color, blue_shift), blue_mask);
+            result = _mm_or_si128(_mm_or_si128(result, green), blue);
+            result = _mm_or_si128(result, alpha_bit);
+            // Sign extend the results so that the signed saturation of packs keeps them intact
+            result = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(output + i * 2),
+                             _mm_packs_epi32(result, result));
+        }
+    }
+#endif
+
+    constexpr std::size_t bytes_per_pixel = output_format == OutputFormat::RGBA8  ? 4
+                                            : output_format == OutputFormat::RGB8 ? 3
+                                                                                  : 2;
+    for (; i < num_pixels; ++i) {
+        EncodePixel<output_format>(order ? input[order[i]] : input[i], alpha,
+                                   output + i * bytes_per_pixel);
+    }
+}
+
+/// Converts a strip received by ReceiveStrip to the encoded output stream
+static void ConvertStrip(const ConversionConfiguration& cvt, const u8* input,
+                         unsigned int row_height, const std::vector<u16>& order, u8* output) {
+    std::array<u32, MAX_TILES * TILE_SIZE> rgb;
+    const unsigned int width = cvt.input_line_width;
+
+    switch (cvt.input_format) {
+    case InputFormat::YUV422_Indiv8:
+    case InputFormat::YUV422_Indiv16:
+        ConvertStripToRGB<InputFormat::YUV422_Indiv8>(input, width, row_height, cvt.coefficients,
+                                                      rgb.data());
+        break;
+    case InputFormat::YUV420_Indiv8:
+    case InputFormat::YUV420_Indiv16:
+        ConvertStripToRGB<InputFormat::YUV420_Indiv8>(input, width, row_height, cvt.coefficients,
+                                                      rgb.data());
+        break;
+    case InputFormat::YUYV422_Interleaved:
+        ConvertStripToRGB<InputFormat::YUYV422_Interleaved>(input, width, row_height,
+                                                            cvt.coefficients, rgb.data());
+        break;
+    default:
+        // Unknown formats read no samples, so every pixel is converted from zero
+        std::fill_n(rgb.begin(), width * row_height, ConvertPixel(0, 0, 0, cvt.coefficients));
+        break;
+    }
+
+    const u16* order_data = order.empty() ? nullptr : order.data();
+    const std::size_t num_pixels = row_height * width;
+    const u8 alpha = static_cast<u8>(cvt.alpha);
+    switch (cvt.output_format) {
+    case OutputFormat::RGBA8:
+        EncodeStrip<OutputFormat::RGBA8>(rgb.data(), order_data, num_pixels, alpha, output);
+        break;
+    case OutputFormat::RGB8:
+        EncodeStrip<OutputFormat::RGB8>(rgb.data(), order_data, num_pixels, alpha, output);
+        break;
+    case OutputFormat::RGB5A1:
+        EncodeStrip<OutputFormat::RGB5A1>(rgb.data(), order_data, num_pixels, alpha, output);
+        break;
+    case OutputFormat::RGB565:
+        EncodeStrip<OutputFormat::RGB565>(rgb.data(), order_data, num_pixels, alpha, output);
+        break;
+    }
+}
+
+/// Simulates an outgoing CDMA transfer of already encoded pixels, like SendData
+static void SendEncodedData(Memory::MemorySystem& memory, const u8* input, ConversionBuffer& buf,
+                            std::size_t num_pixels, std::size_t bytes_per_pixel) {
+    u8* output = memory.GetPointer(buf.address);
+
+    // Like in SendData, a transfer unit always ends on a whole pixel
+    const std::size_t unit_size =
+        (buf.transfer_unit + bytes_per_pixel - 1) / bytes_per_pixel * bytes_per_pixel;
+    std::size_t remaining = num_pixels * bytes_per_pixel;
+    while (remaining > 0) {
+        const std::size_t size = std::min(unit_size, remaining);
+        std::memcpy(output, input, size);
+        input += size;
+        remaining -= size;
+
+        output += size + buf.gap;
+        buf.address += buf.transfer_unit + buf.gap;
+        buf.image_size -= buf.transfer_unit;
+    }
+}
+
 /**
  * Performs a Y2R colorspace conversion.
  *
@@ -243,10 +694,11 @@ static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, in
  * - The final data is then CDMAed out to main memory and the next image strip is processed. This
  *   offers the same flexibility as the input stage.
  *
- * In this implementation, to avoid the combinatorial explosion of parameter combinations, common
- * intermediate formats are used and where possible tables or parameters are used instead of
- * diverging code paths to keep the amount of branches in check. Some steps are also merged to
- * increase efficiency.
+ * In this implementation, the order in which the pixels of a strip are sent out is computed once
+ * per conversion, so that rotation and tiling are fused into the output format conversion. The
+ * colorspace conversion and output format conversion are vectorized where possible. Since strips
+ * are independent, the strips of large conversions are converted on several worker threads, unless
+ * the output overlaps the input and a strip could overwrite the input of a later one.
  *
  * Output for all valid settings combinations matches hardware, however output in some edge-cases
  * differs:
@@ -261,6 +713,73 @@ static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, in
  * so they are believed to be invalid configurations anyway.
  */
 void PerformConversion(Memory::MemorySystem& memory, ConversionConfiguration& cvt) {
+    ASSERT(cvt.input_line_width % 8 == 0);
+    ASSERT(cvt.block_alignment != BlockAlignment::Block8x8 || cvt.input_lines % 8 == 0);
+    const unsigned int width = cvt.input_line_width;
+    ASSERT(width / 8 <= MAX_TILES);
+    if (cvt.input_lines == 0) {
+        return;
+    }
+
+    const std::size_t num_strips = (cvt.input_lines + 7) / 8;
+    const unsigned int last_height = cvt.input_lines - (cvt.input_lines - 1) / 8 * 8;
+    const auto strip_height = [&](std::size_t strip) {
+        return strip == num_strips - 1 ? last_height : 8u;
+    };
+    const std::vector<u16> order = MakeOutputOrder(cvt, 8);
+    const std::vector<u16> last_order =
+        last_height == 8 ? order : MakeOutputOrder(cvt, last_height);
+
+    const std::size_t batch_size =
+        num_strips >= MIN_PARALLEL_STRIPS && !OutputOverlapsInput(cvt) ? num_strips : 1;
+    const std::size_t bytes_per_pixel = OutputBytesPerPixel(cvt.output_format);
+    // Large enough for the Y, U and V planes of a strip, or its interleaved YUYV data
+    const std::size_t input_size = 16 * width;
+    const std::size_t output_size = 8 * width * bytes_per_pixel;
+    std::vector<u8> input(batch_size * input_size);
+    std::vector<u8> output(batch_size * output_size);
+
+    for (std::size_t first = 0; first < num_strips; first += batch_size) {
+        const std::size_t count = std::min(batch_size, num_strips - first);
+        for (std::size_t i = 0; i < count; ++i) {
+            ReceiveStrip(memory, cvt, &input[i * input_size], strip_height(first + i) * width);
+        }
+
+        const auto convert = [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                const unsigned int height = strip_height(first + i);
+                ConvertStrip(cvt, &input[i * input_size], height,
+                             height == 8 ? order : last_order, &output[i * output_size]);
+            }
+        };
+        if (count < MIN_PARALLEL_STRIPS) {
+            convert(0, count);
+        } else {
+            auto& worker = GetWorker();
+            const std::size_t num_chunks = std::min(worker.NumWorkers() + 1, count);
+            const std::size_t chunk_size = (count + num_chunks - 1) / num_chunks;
+            for (std::size_t chunk = 1; chunk < num_chunks; ++chunk) {
+                const std::size_t begin = std::min(chunk * chunk_size, count);
+                const std::size_t end = std::min(begin + chunk_size, count);
+                worker.QueueWork([&convert, begin, end] { convert(begin, end); });
+            }
+            // Convert the first chunk on this thread while the workers handle the rest
+            convert(0, std::min(chunk_size, count));
+            worker.WaitForRequests();
+        }
+
+        for (std::size_t i = 0; i < count; ++i) {
+            SendEncodedData(memory, &output[i * output_size], cvt.dst,
+                            strip_height(first + i) * width, bytes_per_pixel);
+        }
+    }
+}
+
+/**
+ * Performs a Y2R colorspace conversion one pixel at a time. This is the straightforward
+ * implementation of the steps described above, kept as a reference for PerformConversion.
+ */
+void PerformConversionScalar(Memory::MemorySystem& memory, ConversionConfiguration& cvt) {
     ASSERT(cvt.input_line_width % 8 == 0);
     ASSERT(cvt.block_alignment != BlockAlignment::Block8x8 || cvt.input_lines % 8 == 0);
     // Tiles per row
@@ -294,34 +813,7 @@ void PerformConversion(Memory::MemorySystem& memory, ConversionConfiguration& cv
         u8* input_Y = data_buffer.get();
         u8* input_U = input_Y + 8 * cvt.input_line_width;
         u8* input_V = input_U + 8 * cvt.input_line_width / 2;
-
-        switch (cvt.input_format) {
-        case InputFormat::YUV422_Indiv8:
-            ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 2);
-            ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 2);
-            break;
-        case InputFormat::YUV420_Indiv8:
-            ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 4);
-            ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 4);
-            break;
-        case InputFormat::YUV422_Indiv16:
-            ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 2);
-            ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 2);
-            break;
-        case InputFormat::YUV420_Indiv16:
-            ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 4);
-            ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 4);
-            break;
-        case InputFormat::YUYV422_Interleaved:
-            input_U = nullptr;
-            input_V = nullptr;
-            ReceiveData<1>(memory, input_Y, cvt.src_YUYV, row_data_size * 2);
-            break;
-        }
+        ReceiveStrip(memory, cvt, input_Y, row_data_size);
 
         // Note(yuriks): If additional optimization is required, input_format can be moved to a
         // template parameter, so that its dispatch can be moved to outside the inner loop.
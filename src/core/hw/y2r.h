@@ -14,4 +14,8 @@ struct ConversionConfiguration;
 
 namespace HW::Y2R {
 void PerformConversion(Memory::MemorySystem& memory, Service::Y2R::ConversionConfiguration& cvt);
+
+/// Reference implementation of PerformConversion that processes one pixel at a time
+void PerformConversionScalar(Memory::MemorySystem& memory,
+                             Service::Y2R::ConversionConfiguration& cvt);
 } // namespace HW::Y2R
@@ -4,6 +4,8 @@
 
 #include <array>
 #include <cstring>
+#include <mutex>
+#include <unordered_map>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/binary_object.hpp>
 #include "audio_core/dsp_interface.h"
@@ -32,8 +34,13 @@ namespace Memory {
 
 void PageTable::Clear() {
     pointers.raw.fill(nullptr);
-    pointers.refs.fill(MemoryRef());
-    attributes.fill(PageType::Unmapped);
+    pointers.refs.Clear();
+    attributes.Clear();
+}
+
+std::size_t PageTable::GetMemoryUsage() const {
+    return sizeof(pointers.raw) + pointers.refs.GetMemoryUsage() + attributes.GetMemoryUsage() +
+           special_regions.capacity() * sizeof(SpecialRegion);
 }
 
 class RasterizerCacheMarker {
@@ -44,7 +51,24 @@ public:
             *p = cached;
     }
 
+    /// Counts the work queued on the GPU thread that accesses the page
+    void MarkInUseByGPU(VAddr addr, bool in_use) {
+        const VAddr page = addr & ~PAGE_MASK;
+        if (in_use) {
+            ++gpu_pages[page];
+            return;
+        }
+        const auto it = gpu_pages.find(page);
+        ASSERT(it != gpu_pages.end());
+        if (--it->second == 0) {
+            gpu_pages.erase(it);
+        }
+    }
+
     bool IsCached(VAddr addr) {
+        if (!gpu_pages.empty() && gpu_pages.count(addr & ~PAGE_MASK)) {
+            return true;
+        }
         bool* p = At(addr);
         if (p)
             return *p;
@@ -68,6 +92,8 @@ private:
     std::array<bool, VRAM_SIZE / PAGE_SIZE> vram{};
     std::array<bool, LINEAR_HEAP_SIZE / PAGE_SIZE> linear_heap{};
     std::array<bool, NEW_LINEAR_HEAP_SIZE / PAGE_SIZE> new_linear_heap{};
+    /// Not serialized, as the GPU thread is idle while the state is saved
+    std::unordered_map<VAddr, u32> gpu_pages;
 
     static_assert(sizeof(bool) == 1);
     friend class boost::serialization::access;
@@ -90,9 +116,14 @@ public:
     std::shared_ptr<PageTable> current_page_table = nullptr;
     RasterizerCacheMarker cache_marker;
     std::vector<std::shared_ptr<PageTable>> page_table_list;
+    /// Guards the page tables against the rasterizer cache, which can run on the GPU thread
+    std::mutex page_table_mutex;
 
     AudioCore::DspInterface* dsp = nullptr;
 
+    /// Whether the contents of the RAM are serialized, not serialized itself
+    bool serialize_ram = true;
+
     std::shared_ptr<BackingMem> fcram_mem;
     std::shared_ptr<BackingMem> vram_mem;
     std::shared_ptr<BackingMem> n3ds_extra_ram_mem;
@@ -151,11 +182,13 @@ private:
     void serialize(Archive& ar, const unsigned int file_version) {
         bool save_n3ds_ram = Settings::values.is_new_3ds;
         ar& save_n3ds_ram;
-        ar& boost::serialization::make_binary_object(vram.get(), Memory::VRAM_SIZE);
-        ar& boost::serialization::make_binary_object(
-            fcram.get(), save_n3ds_ram ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE);
-        ar& boost::serialization::make_binary_object(
-            n3ds_extra_ram.get(), save_n3ds_ram ? Memory::N3DS_EXTRA_RAM_SIZE : 0);
+        if (serialize_ram) {
+            ar& boost::serialization::make_binary_object(vram.get(), Memory::VRAM_SIZE);
+            ar& boost::serialization::make_binary_object(
+                fcram.get(), save_n3ds_ram ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE);
+            ar& boost::serialization::make_binary_object(
+                n3ds_extra_ram.get(), save_n3ds_ram ? Memory::N3DS_EXTRA_RAM_SIZE : 0);
+        }
         ar& cache_marker;
         ar& page_table_list;
         // dsp is set from Core::System at startup
@@ -226,6 +259,7 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef
     RasterizerFlushVirtualRegion(base << PAGE_BITS, size * PAGE_SIZE,
                                  FlushMode::FlushAndInvalidate);
 
+    std::lock_guard lock{impl->page_table_mutex};
     u32 end = base + size;
     while (base != end) {
         ASSERT_MSG(base < PAGE_TABLE_NUM_ENTRIES, "out of range mapping at {:08X}", base);
@@ -280,16 +314,26 @@ MemoryRef MemorySystem::GetPointerForRasterizerCache(VAddr addr) const {
 }
 
 void MemorySystem::RegisterPageTable(std::shared_ptr<PageTable> page_table) {
+    std::lock_guard lock{impl->page_table_mutex};
     impl->page_table_list.push_back(page_table);
 }
 
 void MemorySystem::UnregisterPageTable(std::shared_ptr<PageTable> page_table) {
+    std::lock_guard lock{impl->page_table_mutex};
     auto it = std::find(impl->page_table_list.begin(), impl->page_table_list.end(), page_table);
     if (it != impl->page_table_list.end()) {
         impl->page_table_list.erase(it);
     }
 }
 
+std::size_t MemorySystem::GetPageTableMemoryUsage() const {
+    std::size_t usage = 0;
+    for (const auto& page_table : impl->page_table_list) {
+        usage += page_table->GetMemoryUsage();
+    }
+    return usage;
+}
+
 /**
  * This function should only be called for virtual addreses with attribute `PageType::Special`.
  */
@@ -525,18 +569,44 @@ static std::vector<VAddr> PhysicalToVirtualAddressForRasterizer(PAddr addr) {
 }
 
 void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached) {
-    if (start == 0) {
+    UpdateCachedPages(start, size,
+                      [this, cached](VAddr vaddr) { impl->cache_marker.Mark(vaddr, cached); });
+}
+
+void MemorySystem::MarkRegionInUseByGPU(PAddr start, u32 size, bool in_use) {
+    // The GPU only accesses VRAM and FCRAM, anything else is an invalid address it doesn't touch
+    const auto IsInside = [start, size](PAddr region_start, PAddr region_end) {
+        return start >= region_start && u64{start} + size <= region_end;
+    };
+    if (!IsInside(VRAM_PADDR, VRAM_PADDR_END) && !IsInside(FCRAM_PADDR, FCRAM_N3DS_PADDR_END)) {
+        return;
+    }
+    UpdateCachedPages(start, size, [this, in_use](VAddr vaddr) {
+        impl->cache_marker.MarkInUseByGPU(vaddr, in_use);
+    });
+}
+
+template <typename F>
+void MemorySystem::UpdateCachedPages(PAddr start, u32 size, F&& update) {
+    if (start == 0 || size == 0) {
         return;
     }
 
     u32 num_pages = ((start + size - 1) >> PAGE_BITS) - (start >> PAGE_BITS) + 1;
     PAddr paddr = start;
 
+    std::lock_guard lock{impl->page_table_mutex};
     for (unsigned i = 0; i < num_pages; ++i, paddr += PAGE_SIZE) {
         for (VAddr vaddr : PhysicalToVirtualAddressForRasterizer(paddr)) {
-            impl->cache_marker.Mark(vaddr, cached);
+            const bool was_cached = impl->cache_marker.IsCached(vaddr);
+            update(vaddr);
+            const bool cached = impl->cache_marker.IsCached(vaddr);
+            if (cached == was_cached) {
+                // The page is still cached for the rasterizer or for queued GPU work
+                continue;
+            }
             for (auto page_table : impl->page_table_list) {
-                PageType& page_type = page_table->attributes[vaddr >> PAGE_BITS];
+                const PageType page_type = page_table->attributes[vaddr >> PAGE_BITS];
 
                 if (cached) {
                     // Switch page type to cached if now cached
@@ -546,7 +616,8 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
                         // address space, for example, a system module need not have a VRAM mapping.
                         break;
                     case PageType::Memory:
-                        page_type = PageType::RasterizerCachedMemory;
+                        page_table->attributes[vaddr >> PAGE_BITS] =
+                            PageType::RasterizerCachedMemory;
                         page_table->pointers[vaddr >> PAGE_BITS] = nullptr;
                         break;
                     default:
@@ -560,7 +631,7 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
                         // address space, for example, a system module need not have a VRAM mapping.
                         break;
                     case PageType::RasterizerCachedMemory: {
-                        page_type = PageType::Memory;
+                        page_table->attributes[vaddr >> PAGE_BITS] = PageType::Memory;
                         page_table->pointers[vaddr >> PAGE_BITS] =
                             GetPointerForRasterizerCache(vaddr & ~PAGE_MASK);
                         break;
@@ -579,7 +650,9 @@ void RasterizerFlushRegion(PAddr start, u32 size) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
+    VideoCore::RunOnGPUThread([start, size] {
+        VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
+    });
 }
 
 void RasterizerInvalidateRegion(PAddr start, u32 size) {
@@ -587,7 +660,9 @@ void RasterizerInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->InvalidateRegion(start, size);
+    VideoCore::RunOnGPUThread([start, size] {
+        VideoCore::g_renderer->Rasterizer()->InvalidateRegion(start, size);
+    });
 }
 
 void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
@@ -597,7 +672,9 @@ void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
+    VideoCore::RunOnGPUThread([start, size] {
+        VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
+    });
 }
 
 void RasterizerClearAll(bool flush) {
@@ -607,7 +684,15 @@ void RasterizerClearAll(bool flush) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->ClearAll(flush);
+    VideoCore::RunOnGPUThread([flush] { VideoCore::g_renderer->Rasterizer()->ClearAll(flush); });
+}
+
+void RasterizerFlushAll() {
+    if (VideoCore::g_renderer == nullptr) {
+        return;
+    }
+
+    VideoCore::RunOnGPUThread([] { VideoCore::g_renderer->Rasterizer()->FlushAll(); });
 }
 
 void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
@@ -630,18 +715,20 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
         PAddr physical_start = paddr_region_start + (overlap_start - region_start);
         u32 overlap_size = overlap_end - overlap_start;
 
-        auto* rasterizer = VideoCore::g_renderer->Rasterizer();
-        switch (mode) {
-        case FlushMode::Flush:
-            rasterizer->FlushRegion(physical_start, overlap_size);
-            break;
-        case FlushMode::Invalidate:
-            rasterizer->InvalidateRegion(physical_start, overlap_size);
-            break;
-        case FlushMode::FlushAndInvalidate:
-            rasterizer->FlushAndInvalidateRegion(physical_start, overlap_size);
-            break;
-        }
+        VideoCore::RunOnGPUThread([mode, physical_start, overlap_size] {
+            auto* rasterizer = VideoCore::g_renderer->Rasterizer();
+            switch (mode) {
+            case FlushMode::Flush:
+                rasterizer->FlushRegion(physical_start, overlap_size);
+                break;
+            case FlushMode::Invalidate:
+                rasterizer->InvalidateRegion(physical_start, overlap_size);
+                break;
+            case FlushMode::FlushAndInvalidate:
+                rasterizer->FlushAndInvalidateRegion(physical_start, overlap_size);
+                break;
+            }
+        });
     };
 
     CheckRegion(LINEAR_HEAP_VADDR, LINEAR_HEAP_VADDR_END, FCRAM_PADDR);
@@ -954,4 +1041,8 @@ void MemorySystem::SetDSP(AudioCore::DspInterface& dsp) {
     impl->dsp = &dsp;
 }
 
+void MemorySystem::SetSerializeRAM(bool serialize_ram) {
+    impl->serialize_ram = serialize_ram;
+}
+
 } // namespace Memory
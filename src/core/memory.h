@@ -4,12 +4,15 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 #include <boost/serialization/array.hpp>
+#include <boost/serialization/split_member.hpp>
 #include <boost/serialization/vector.hpp>
 #include "common/common_types.h"
 #include "common/memory_ref.h"
@@ -66,6 +69,118 @@ private:
     friend class boost::serialization::access;
 };
 
+/**
+ * An array with an entry per page that only allocates storage for blocks of pages that have been
+ * written to, since a process only maps a small part of its address space. Entries that were never
+ * written read as empty, and writing an empty value to an unallocated block does not allocate it.
+ */
+template <typename T>
+class SparsePageArray {
+public:
+    static constexpr std::size_t BLOCK_BITS = 8;
+    static constexpr std::size_t BLOCK_SIZE = std::size_t{1} << BLOCK_BITS;
+    static constexpr std::size_t NUM_BLOCKS = PAGE_TABLE_NUM_ENTRIES >> BLOCK_BITS;
+
+    /// Proxy that allows the array to be used like a plain array of T
+    class Entry {
+    public:
+        Entry(SparsePageArray& array_, std::size_t idx_) : array(array_), idx(idx_) {}
+
+        Entry& operator=(T value) {
+            array.Set(idx, std::move(value));
+            return *this;
+        }
+
+        operator const T&() const {
+            return array.Get(idx);
+        }
+
+    private:
+        SparsePageArray& array;
+        std::size_t idx;
+    };
+
+    const T& Get(std::size_t idx) const {
+        const auto& block = blocks[idx >> BLOCK_BITS];
+        return block ? (*block)[idx & (BLOCK_SIZE - 1)] : empty_value;
+    }
+
+    void Set(std::size_t idx, T value) {
+        auto& block = blocks[idx >> BLOCK_BITS];
+        if (!block) {
+            if (IsEmpty(value)) {
+                return;
+            }
+            block = std::make_unique<Block>();
+        }
+        (*block)[idx & (BLOCK_SIZE - 1)] = std::move(value);
+    }
+
+    Entry operator[](std::size_t idx) {
+        return Entry(*this, idx);
+    }
+
+    const T& operator[](std::size_t idx) const {
+        return Get(idx);
+    }
+
+    /// Frees every block, resetting all entries to empty
+    void Clear() {
+        for (auto& block : blocks) {
+            block.reset();
+        }
+    }
+
+    /// Returns the amount of host memory used by the array, in bytes
+    std::size_t GetMemoryUsage() const {
+        const auto num_allocated = std::count_if(
+            blocks.begin(), blocks.end(), [](const auto& block) { return block != nullptr; });
+        return sizeof(*this) + static_cast<std::size_t>(num_allocated) * sizeof(Block);
+    }
+
+private:
+    using Block = std::array<T, BLOCK_SIZE>;
+
+    static bool IsEmpty(const T& value) {
+        if constexpr (std::is_enum_v<T>) {
+            return value == T{};
+        } else {
+            return !value;
+        }
+    }
+
+    std::array<std::unique_ptr<Block>, NUM_BLOCKS> blocks;
+    static inline const T empty_value{};
+
+    template <class Archive>
+    void save(Archive& ar, const unsigned int) const {
+        for (const auto& block : blocks) {
+            const bool allocated = block != nullptr;
+            ar << allocated;
+            if (allocated) {
+                ar << *block;
+            }
+        }
+    }
+
+    template <class Archive>
+    void load(Archive& ar, const unsigned int) {
+        for (auto& block : blocks) {
+            bool allocated;
+            ar >> allocated;
+            if (allocated) {
+                block = std::make_unique<Block>();
+                ar >> *block;
+            } else {
+                block.reset();
+            }
+        }
+    }
+
+    BOOST_SERIALIZATION_SPLIT_MEMBER()
+    friend class boost::serialization::access;
+};
+
 /**
  * A (reasonably) fast way of allowing switchable and remappable process address spaces. It loosely
  * mimics the way a real CPU page table works, but instead is optimized for minimal decoding and
@@ -79,7 +194,8 @@ struct PageTable {
      */
 
     // The reason for this rigmarole is to keep the 'raw' and 'refs' arrays in sync.
-    // We need 'raw' for dynarmic and 'refs' for serialization
+    // We need 'raw' for dynarmic and 'refs' for serialization. Only 'raw' is a flat array, since
+    // that is what dynarmic indexes directly; 'refs' is sparse to keep the page table small.
     struct Pointers {
 
         struct Entry {
@@ -87,7 +203,7 @@ struct PageTable {
 
             Entry& operator=(MemoryRef value) {
                 pointers.raw[idx] = value.GetPtr();
-                pointers.refs[idx] = std::move(value);
+                pointers.refs.Set(idx, std::move(value));
                 return *this;
             }
 
@@ -107,7 +223,7 @@ struct PageTable {
     private:
         std::array<u8*, PAGE_TABLE_NUM_ENTRIES> raw;
 
-        std::array<MemoryRef, PAGE_TABLE_NUM_ENTRIES> refs;
+        SparsePageArray<MemoryRef> refs;
 
         friend struct PageTable;
     };
@@ -123,7 +239,7 @@ struct PageTable {
      * Array of fine grained page attributes. If it is set to any value other than `Memory`, then
      * the corresponding entry in `pointers` MUST be set to null.
      */
-    std::array<PageType, PAGE_TABLE_NUM_ENTRIES> attributes;
+    SparsePageArray<PageType> attributes;
 
     std::array<u8*, PAGE_TABLE_NUM_ENTRIES>& GetPointerArray() {
         return pointers.raw;
@@ -131,6 +247,9 @@ struct PageTable {
 
     void Clear();
 
+    /// Returns the approximate amount of host memory used by this page table, in bytes
+    std::size_t GetMemoryUsage() const;
+
 private:
     template <class Archive>
     void serialize(Archive& ar, const unsigned int) {
@@ -138,7 +257,8 @@ private:
         ar& special_regions;
         ar& attributes;
         for (std::size_t i = 0; i < PAGE_TABLE_NUM_ENTRIES; i++) {
-            pointers.raw[i] = pointers.refs[i].GetPtr();
+            MemoryRef ref = pointers.refs.Get(i);
+            pointers.raw[i] = ref.GetPtr();
         }
     }
     friend class boost::serialization::access;
@@ -281,6 +401,9 @@ enum class FlushMode {
  */
 void RasterizerClearAll(bool flush);
 
+/// Flushes all memory in the rasterizer cache to RAM, keeping the cached resources
+void RasterizerFlushAll();
+
 /**
  * Flushes and invalidates any externally cached rasterizer resources touching the given virtual
  * address region.
@@ -375,8 +498,25 @@ public:
     /// Unregisters page table for rasterizer cache marking
     void UnregisterPageTable(std::shared_ptr<PageTable> page_table);
 
+    /// Returns the amount of host memory used by the registered page tables, in bytes
+    std::size_t GetPageTableMemoryUsage() const;
+
     void SetDSP(AudioCore::DspInterface& dsp);
 
+    /**
+     * Sets whether the contents of FCRAM, VRAM and the N3DS extra RAM are serialized, which they
+     * are by default. Rewind snapshots store them on their own.
+     */
+    void SetSerializeRAM(bool serialize_ram);
+
+    /**
+     * Marks the pages touching the region as accessed by work queued on the GPU thread. CPU
+     * accesses to them are handled like accesses to rasterizer-cached pages, which waits for the
+     * queued work to finish. Marks are counted, so each one has to be undone once. Must be called
+     * on the emulated CPU thread, as the CPU uses the page tables without locking them.
+     */
+    void MarkRegionInUseByGPU(PAddr start, u32 size, bool in_use);
+
 private:
     template <typename T>
     T Read(const VAddr vaddr);
@@ -392,6 +532,11 @@ private:
      */
     MemoryRef GetPointerForRasterizerCache(VAddr addr) const;
 
+    /// Applies update to each page touching the region and switches the pages whose cached state
+    /// it changed
+    template <typename F>
+    void UpdateCachedPages(PAddr start, u32 size, F&& update);
+
     void MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef memory, PageType type);
 
     class Impl;
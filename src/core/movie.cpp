@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <vector>
@@ -20,6 +21,8 @@
 #include "core/hle/service/ir/extra_hid.h"
 #include "core/hle/service/ir/ir_rst.h"
 #include "core/movie.h"
+#include "core/settings.h"
+#include "video_core/video_core.h"
 
 namespace Core {
 
@@ -33,7 +36,9 @@ enum class ControllerStateType : u8 {
     Accelerometer,
     Gyroscope,
     IrRst,
-    ExtraHidResponse
+    ExtraHidResponse,
+
+    Count
 };
 
 #pragma pack(push, 1)
@@ -106,11 +111,25 @@ struct ControllerState {
         } extra_hid_response;
     };
 };
-static_assert(sizeof(ControllerState) == 7, "ControllerState should be 7 bytes");
+static_assert(sizeof(ControllerState) == MovieCodec::InputSize,
+              "ControllerState should be 7 bytes");
+static_assert(static_cast<u8>(ControllerStateType::PadAndCircle) ==
+                  MovieCodec::PadAndCircleType &&
+              static_cast<u8>(ControllerStateType::Count) == MovieCodec::NumInputTypes,
+              "ControllerStateType doesn't match the movie codec");
 #pragma pack(pop)
 
 constexpr std::array<u8, 4> header_magic_bytes{{'C', 'T', 'M', 0x1B}};
 
+/// Movies recorded before the format was versioned have a version of 0 and store raw input
+constexpr u32 movie_version = 2;
+
+/// Number of frames encoded in each independently decodable block of input
+constexpr u64 FramesPerBlock = 256;
+
+/// A frame starts at every pad update, which happens this many times per second of emulated time
+constexpr u64 FramesPerSecond = 234;
+
 #pragma pack(push, 1)
 struct CTMHeader {
     std::array<u8, 4> filetype;  /// Unique Identifier to check the file type (always "CTM"0x1B)
@@ -118,9 +137,26 @@ struct CTMHeader {
     std::array<u8, 20> revision; /// Git hash of the revision this movie was created with
     u64_le clock_init_time;      /// The init time of the system clock
 
-    std::array<u8, 216> reserved; /// Make heading 256 bytes so it has consistent size
+    u32_le version;            /// Version of the format, see movie_version
+    u32_le frames_per_block;   /// Number of frames in each block of encoded input
+    u64_le frame_count;        /// Total number of frames in the movie
+    u64_le input_size;         /// Size of the input once decoded
+    u64_le encoded_input_size; /// Size of the encoded input
+    u64_le block_count;        /// Number of entries in the block index
+    u64_le keyframe_count;     /// Number of entries in the keyframe table
+
+    std::array<u8, 168> reserved; /// Make heading 256 bytes so it has consistent size
 };
 static_assert(sizeof(CTMHeader) == 256, "CTMHeader should be 256 bytes");
+
+/// Follows the header and the block index, which maps every FramesPerBlock-th frame to the block of
+/// input that starts there. Is itself followed by the encoded input and the keyframe states
+struct CTMKeyframeEntry {
+    u64_le frame;  /// Frame at which the keyframe was captured
+    u64_le offset; /// Offset of the compressed save state in the file
+    u64_le size;   /// Size of the compressed save state
+};
+static_assert(sizeof(CTMKeyframeEntry) == 24, "CTMKeyframeEntry should be 24 bytes");
 #pragma pack(pop)
 
 bool Movie::IsPlayingInput() const {
@@ -130,6 +166,77 @@ bool Movie::IsRecordingInput() const {
     return play_mode == PlayMode::Recording;
 }
 
+u64 Movie::GetCurrentFrame() const {
+    return current_frame;
+}
+
+u64 Movie::GetFrameCount() const {
+    return frame_count;
+}
+
+bool Movie::IsFrameStart(std::size_t offset) const {
+    // Every frame starts with a pad update, except for inputs recorded before the first one
+    return offset == 0 ||
+           recorded_input[offset] == static_cast<u8>(ControllerStateType::PadAndCircle);
+}
+
+void Movie::BeginPlaybackFrame() {
+    if (seek_frame && *seek_frame == current_frame) {
+        LOG_INFO(Movie, "Reached frame {}", current_frame);
+        seek_frame.reset();
+        VideoCore::g_turbo_until_trigger = false;
+        seek_callback();
+    }
+    ++current_frame;
+}
+
+void Movie::BeginRecordingFrame() {
+    if (current_frame % FramesPerBlock == 0) {
+        block_index.resize(current_frame / FramesPerBlock);
+        block_index.push_back(current_byte);
+    }
+    if (keyframe_interval != 0 && current_frame % keyframe_interval == 0) {
+        keyframe_requested = true;
+    }
+    ++current_frame;
+    frame_count = current_frame;
+}
+
+void Movie::RebuildIndex() {
+    block_index.clear();
+    frame_count = 0;
+    for (std::size_t offset = 0; offset + sizeof(ControllerState) <= recorded_input.size();
+         offset += sizeof(ControllerState)) {
+        if (!IsFrameStart(offset)) {
+            continue;
+        }
+        if (frame_count % FramesPerBlock == 0) {
+            block_index.push_back(offset);
+        }
+        ++frame_count;
+    }
+}
+
+void Movie::OnInputRestored(bool has_current_frame) {
+    RebuildIndex();
+    if (!has_current_frame) {
+        current_frame = 0;
+        for (std::size_t offset = 0; offset < current_byte; offset += sizeof(ControllerState)) {
+            if (IsFrameStart(offset)) {
+                ++current_frame;
+            }
+        }
+    }
+    if (IsRecordingInput()) {
+        // Keyframes past this point belong to input that is about to be recorded over
+        keyframes.erase(std::remove_if(keyframes.begin(), keyframes.end(),
+                                       [this](const Keyframe& keyframe) {
+                                           return keyframe.frame > current_frame;
+                                       }),
+                        keyframes.end());
+    }
+}
+
 void Movie::CheckInputEnd() {
     if (current_byte + sizeof(ControllerState) > recorded_input.size()) {
         LOG_INFO(Movie, "Playback finished");
@@ -263,6 +370,9 @@ void Movie::Play(Service::IR::ExtraHIDResponse& extra_hid_response) {
 }
 
 void Movie::Record(const ControllerState& controller_state) {
+    if (current_byte == 0 || controller_state.type == ControllerStateType::PadAndCircle) {
+        BeginRecordingFrame();
+    }
     recorded_input.resize(current_byte + sizeof(ControllerState));
     std::memcpy(&recorded_input[current_byte], &controller_state, sizeof(ControllerState));
     current_byte += sizeof(ControllerState);
@@ -364,6 +474,11 @@ Movie::ValidationResult Movie::ValidateHeader(const CTMHeader& header, u64 progr
         return ValidationResult::Invalid;
     }
 
+    if (header.version > movie_version) {
+        LOG_ERROR(Movie, "Movie format version {} is not supported", header.version);
+        return ValidationResult::Invalid;
+    }
+
     std::string revision = fmt::format("{:02x}", fmt::join(header.revision, ""));
 
     if (!program_id)
@@ -402,8 +517,46 @@ void Movie::SaveMovie() {
                            new CryptoPP::HexDecoder(new CryptoPP::StringSink(rev_bytes)));
     std::memcpy(header.revision.data(), rev_bytes.data(), sizeof(CTMHeader::revision));
 
+    std::vector<MovieCodec::BlockIndexEntry> block_entries;
+    const std::vector<u8> encoded_input =
+        MovieCodec::EncodeInput(recorded_input, block_index, block_entries);
+
+    std::vector<CTMKeyframeEntry> keyframe_entries(keyframes.size());
+    u64 keyframe_offset = sizeof(CTMHeader) +
+                          block_entries.size() * sizeof(MovieCodec::BlockIndexEntry) +
+                          keyframe_entries.size() * sizeof(CTMKeyframeEntry) +
+                          encoded_input.size();
+    for (std::size_t i = 0; i < keyframes.size(); ++i) {
+        keyframe_entries[i].frame = keyframes[i].frame;
+        keyframe_entries[i].offset = keyframe_offset;
+        keyframe_entries[i].size = keyframes[i].size;
+        keyframe_offset += keyframes[i].size;
+    }
+
+    header.version = movie_version;
+    header.frames_per_block = static_cast<u32>(FramesPerBlock);
+    header.frame_count = frame_count;
+    header.input_size = recorded_input.size();
+    header.encoded_input_size = encoded_input.size();
+    header.block_count = block_entries.size();
+    header.keyframe_count = keyframe_entries.size();
+
     save_record.WriteBytes(&header, sizeof(CTMHeader));
-    save_record.WriteBytes(recorded_input.data(), recorded_input.size());
+    save_record.WriteArray(block_entries.data(), block_entries.size());
+    save_record.WriteArray(keyframe_entries.data(), keyframe_entries.size());
+    save_record.WriteBytes(encoded_input.data(), encoded_input.size());
+    std::vector<u8> state;
+    for (const auto& keyframe : keyframes) {
+        state.resize(keyframe.size);
+        if (!keyframe_file.Seek(keyframe.offset, SEEK_SET) ||
+            keyframe_file.ReadBytes(state.data(), state.size()) != state.size()) {
+            LOG_ERROR(Movie, "Unable to read keyframe at frame {} back", keyframe.frame);
+        }
+        save_record.WriteBytes(state.data(), state.size());
+    }
+
+    LOG_INFO(Movie, "Saved {} frames ({} bytes of input encoded in {}) and {} keyframes",
+             frame_count, recorded_input.size(), encoded_input.size(), keyframes.size());
 
     if (!save_record.IsGood()) {
         LOG_ERROR(Movie, "Error saving movie");
@@ -420,10 +573,20 @@ void Movie::StartPlayback(const std::string& movie_file,
         CTMHeader header;
         save_record.ReadArray(&header, 1);
         if (ValidateHeader(header) != ValidationResult::Invalid) {
+            if (header.version == 0) {
+                recorded_input.resize(size - sizeof(CTMHeader));
+                save_record.ReadArray(recorded_input.data(), recorded_input.size());
+                RebuildIndex();
+                keyframes.clear();
+            } else if (!LoadInput(save_record, header)) {
+                LOG_ERROR(Movie, "Failed to playback movie: '{}' is corrupted", movie_file);
+                recorded_input.clear();
+                return;
+            }
             play_mode = PlayMode::Playing;
-            recorded_input.resize(size - sizeof(CTMHeader));
-            save_record.ReadArray(recorded_input.data(), recorded_input.size());
+            play_movie_file = movie_file;
             current_byte = 0;
+            current_frame = 0;
             playback_completion_callback = completion_callback;
         }
     } else {
@@ -431,10 +594,134 @@ void Movie::StartPlayback(const std::string& movie_file,
     }
 }
 
+bool Movie::LoadInput(FileUtil::IOFile& file, const CTMHeader& header) {
+    const u64 tables_size = header.block_count * sizeof(MovieCodec::BlockIndexEntry) +
+                            header.keyframe_count * sizeof(CTMKeyframeEntry);
+    if (header.block_count > file.GetSize() || header.keyframe_count > file.GetSize() ||
+        sizeof(CTMHeader) + tables_size + header.encoded_input_size > file.GetSize()) {
+        return false;
+    }
+
+    std::vector<MovieCodec::BlockIndexEntry> block_entries(header.block_count);
+    std::vector<CTMKeyframeEntry> keyframe_entries(header.keyframe_count);
+    std::vector<u8> encoded_input(header.encoded_input_size);
+    if (file.ReadArray(block_entries.data(), block_entries.size()) != block_entries.size() ||
+        file.ReadArray(keyframe_entries.data(), keyframe_entries.size()) !=
+            keyframe_entries.size() ||
+        file.ReadBytes(encoded_input.data(), encoded_input.size()) != encoded_input.size()) {
+        return false;
+    }
+
+    if (!MovieCodec::DecodeInput(encoded_input, block_entries, header.frames_per_block,
+                                 header.input_size, recorded_input, block_index)) {
+        return false;
+    }
+
+    keyframes.clear();
+    for (const auto& entry : keyframe_entries) {
+        keyframes.push_back({entry.frame, entry.offset, entry.size});
+    }
+    frame_count = header.frame_count;
+    return true;
+}
+
+void Movie::CaptureKeyframe() {
+    keyframe_requested = false;
+    capturing_keyframe = true;
+    try {
+        const std::vector<u8> state = Core::System::GetInstance().SaveStateBuffer();
+        // Keyframes are too large to keep in memory until the movie is saved
+        if (!keyframe_file.IsOpen()) {
+            keyframe_file = FileUtil::IOFile(record_movie_file + ".keyframes", "w+b");
+            if (!keyframe_file.IsOpen()) {
+                throw std::runtime_error("Unable to create the keyframe spill file");
+            }
+        }
+        keyframe_file.Seek(0, SEEK_END);
+        const Keyframe keyframe{current_frame, keyframe_file.Tell(), state.size()};
+        if (keyframe_file.WriteBytes(state.data(), state.size()) != state.size()) {
+            throw std::runtime_error("Unable to write to the keyframe spill file");
+        }
+        LOG_DEBUG(Movie, "Captured keyframe at frame {} ({} bytes)", keyframe.frame,
+                  keyframe.size);
+        keyframes.push_back(keyframe);
+    } catch (const std::exception& e) {
+        LOG_ERROR(Movie, "Failed to capture keyframe at frame {}: {}", current_frame, e.what());
+    }
+    capturing_keyframe = false;
+}
+
+bool Movie::RestoreKeyframe(const Keyframe& keyframe, u64 frame) {
+    std::vector<u8> state(keyframe.size);
+    FileUtil::IOFile file(play_movie_file, "rb");
+    if (!file.Seek(keyframe.offset, SEEK_SET) ||
+        file.ReadBytes(state.data(), state.size()) != state.size()) {
+        LOG_ERROR(Movie, "Unable to read keyframe at frame {} from '{}'", keyframe.frame,
+                  play_movie_file);
+        return false;
+    }
+
+    LOG_INFO(Movie, "Restoring keyframe at frame {}, {} frames before frame {}", keyframe.frame,
+             frame - keyframe.frame, frame);
+    Core::System::GetInstance().LoadStateBuffer(std::move(state));
+    return true;
+}
+
+bool Movie::SeekToFrame(u64 frame, std::function<void()> reached_callback) {
+    if (!IsPlayingInput()) {
+        LOG_ERROR(Movie, "Seeking is only possible while playing back a movie");
+        return false;
+    }
+    if (frame >= frame_count) {
+        LOG_ERROR(Movie, "Unable to seek to frame {}: the movie only has {} frames", frame,
+                  frame_count);
+        return false;
+    }
+
+    std::lock_guard lock{seek_mutex};
+    requested_seek_frame = frame;
+    requested_seek_callback = std::move(reached_callback);
+    seek_requested = true;
+    return true;
+}
+
+bool Movie::ProcessKeyframes() {
+    if (keyframe_requested && IsRecordingInput()) {
+        CaptureKeyframe();
+    }
+    if (!seek_requested.exchange(false) || !IsPlayingInput()) {
+        return false;
+    }
+
+    u64 frame;
+    {
+        std::lock_guard lock{seek_mutex};
+        frame = requested_seek_frame;
+        seek_callback = std::move(requested_seek_callback);
+    }
+
+    const MovieCodec::SeekPlan plan = MovieCodec::PlanSeek(keyframes, current_frame, frame);
+    if (!plan.reachable) {
+        LOG_ERROR(Movie, "Unable to seek to frame {}: no keyframe precedes it", frame);
+        return false;
+    }
+    const bool restored = plan.keyframe != nullptr;
+    if (restored && !RestoreKeyframe(*plan.keyframe, frame)) {
+        return false;
+    }
+    seek_frame = frame;
+    // Frames aren't presented until the frame is reached, but they are still rendered so that the
+    // replayed input leads to the same state
+    VideoCore::g_turbo_until_trigger = true;
+    return restored;
+}
+
 void Movie::StartRecording(const std::string& movie_file) {
     LOG_INFO(Movie, "Enabling Movie recording");
     play_mode = PlayMode::Recording;
     record_movie_file = movie_file;
+    keyframe_interval =
+        static_cast<u64>(std::max(Settings::values.movie_keyframe_interval, 0)) * FramesPerSecond;
 }
 
 static boost::optional<CTMHeader> ReadHeader(const std::string& movie_file) {
@@ -493,8 +780,21 @@ void Movie::Shutdown() {
 
     play_mode = PlayMode::None;
     recorded_input.resize(0);
+    if (keyframe_file.IsOpen()) {
+        keyframe_file.Close();
+        FileUtil::Delete(record_movie_file + ".keyframes");
+    }
     record_movie_file.clear();
+    play_movie_file.clear();
     current_byte = 0;
+    current_frame = 0;
+    frame_count = 0;
+    block_index.clear();
+    keyframes.clear();
+    keyframe_requested = false;
+    seek_requested = false;
+    seek_frame.reset();
+    VideoCore::g_turbo_until_trigger = false;
     init_time = 0;
 }
 
@@ -502,6 +802,9 @@ template <typename... Targs>
 void Movie::Handle(Targs&... Fargs) {
     if (IsPlayingInput()) {
         ASSERT(current_byte + sizeof(ControllerState) <= recorded_input.size());
+        if (IsFrameStart(current_byte)) {
+            BeginPlaybackFrame();
+        }
         Play(Fargs...);
         CheckInputEnd();
     } else if (IsRecordingInput()) {
@@ -4,9 +4,17 @@
 
 #pragma once
 
+#include <atomic>
 #include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
 #include "common/common_types.h"
+#include "common/file_util.h"
+#include "core/movie_codec.h"
 
 namespace Service {
 namespace HID {
@@ -60,6 +68,30 @@ public:
 
     void Shutdown();
 
+    /// Gets the number of frames whose input has been played back or recorded so far
+    u64 GetCurrentFrame() const;
+
+    /// Gets the total number of frames in the movie
+    u64 GetFrameCount() const;
+
+    /**
+     * Requests playback to continue from the given frame. At the next safe point the closest
+     * keyframe at or before the frame is restored, unless the frame is ahead and playback is
+     * already past that keyframe. The remaining input up to the frame is then replayed as usual,
+     * so the cost of a seek is bounded by the keyframe interval rather than the movie's length.
+     * @param frame The frame whose input should be the next one played back
+     * @param reached_callback Called on the emulation thread once the frame has been reached
+     * @returns Whether the request was accepted
+     */
+    bool SeekToFrame(u64 frame, std::function<void()> reached_callback = [] {});
+
+    /**
+     * Captures or restores the keyframes that were requested since the last call. Must only be
+     * called between emulation slices, where the emulated state can be saved consistently.
+     * @returns Whether a keyframe was restored, replacing the emulated state
+     */
+    bool ProcessKeyframes();
+
     /**
      * When recording: Takes a copy of the given input states so they can be used for playback
      * When playing: Replaces the given input states with the ones stored in the playback file
@@ -102,8 +134,20 @@ public:
 private:
     static Movie s_instance;
 
+    using Keyframe = MovieCodec::Keyframe;
+
     void CheckInputEnd();
 
+    bool IsFrameStart(std::size_t offset) const;
+    void BeginPlaybackFrame();
+    void BeginRecordingFrame();
+    void RebuildIndex();
+    void OnInputRestored(bool has_current_frame);
+
+    bool LoadInput(FileUtil::IOFile& file, const CTMHeader& header);
+    void CaptureKeyframe();
+    bool RestoreKeyframe(const Keyframe& keyframe, u64 frame);
+
     template <typename... Targs>
     void Handle(Targs&... Fargs);
 
@@ -134,15 +178,48 @@ private:
     std::function<void()> playback_completion_callback;
     std::size_t current_byte = 0;
 
+    u64 current_frame = 0; ///< Number of frames whose first input has been handled
+    u64 frame_count = 0;
+    std::vector<std::size_t> block_index; ///< Offset of the first input of each block of frames
+    std::vector<Keyframe> keyframes;
+    std::string play_movie_file;
+    /// Holds the keyframes captured while recording until the movie is saved
+    FileUtil::IOFile keyframe_file;
+    u64 keyframe_interval = 0; ///< Frames between keyframes while recording, 0 if disabled
+
+    bool keyframe_requested = false;
+    bool capturing_keyframe = false;
+
+    std::mutex seek_mutex;
+    std::atomic<bool> seek_requested{false};
+    u64 requested_seek_frame = 0;
+    std::function<void()> requested_seek_callback;
+    std::optional<u64> seek_frame;
+    std::function<void()> seek_callback;
+
     template <class Archive>
-    void serialize(Archive& ar, const unsigned int) {
+    void serialize(Archive& ar, const unsigned int file_version) {
         // Only serialize what's needed to make savestates useful for TAS:
         u64 _current_byte = static_cast<u64>(current_byte);
         ar& _current_byte;
         current_byte = static_cast<std::size_t>(_current_byte);
-        ar& recorded_input;
+        bool has_input = true;
+        if (file_version >= 1) {
+            ar& current_frame;
+            // Keyframes are stored in the movie itself, so they don't need a copy of the input
+            has_input = !capturing_keyframe;
+            ar& has_input;
+        }
+        if (has_input) {
+            ar& recorded_input;
+        }
         ar& init_time;
+        if (Archive::is_loading::value && has_input) {
+            OnInputRestored(file_version >= 1);
+        }
     }
     friend class boost::serialization::access;
 };
-} // namespace Core
\ No newline at end of file
+} // namespace Core
+
+BOOST_CLASS_VERSION(Core::Movie, 1)
\ No newline at end of file
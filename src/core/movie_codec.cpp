@@ -0,0 +1,221 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include "common/assert.h"
+#include "core/movie_codec.h"
+
+namespace Core::MovieCodec {
+
+namespace {
+
+/**
+ * Tag of a run of frames that are identical to the previous one, followed by the run length.
+ * Every other tag holds the type of an input in its low 3 bits and a mask of the words that changed
+ * since the last input of that type in the following 3 bits. The changed words follow the tag as
+ * zigzag-encoded deltas.
+ */
+constexpr u8 RepeatFrameTag = 0x7;
+
+/// The payload of every input is treated as three little endian words
+using InputWords = std::array<u16, 3>;
+
+void WriteVarint(std::vector<u8>& out, u32 value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<u8>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<u8>(value));
+}
+
+bool ReadVarint(const u8* in, std::size_t size, std::size_t& pos, u32& value) {
+    value = 0;
+    for (u32 shift = 0; shift < 32; shift += 7) {
+        if (pos >= size) {
+            return false;
+        }
+        const u8 byte = in[pos++];
+        value |= static_cast<u32>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+u32 ZigZagEncode(s16 value) {
+    return value >= 0 ? static_cast<u32>(value) * 2 : static_cast<u32>(-(value + 1)) * 2 + 1;
+}
+
+s16 ZigZagDecode(u32 value) {
+    return static_cast<s16>((value & 1) ? -static_cast<s32>(value >> 1) - 1
+                                        : static_cast<s32>(value >> 1));
+}
+
+InputWords GetInputWords(const u8* input) {
+    InputWords words;
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        words[i] = static_cast<u16>(input[1 + i * 2] | (input[2 + i * 2] << 8));
+    }
+    return words;
+}
+
+} // Anonymous namespace
+
+void EncodeBlock(const u8* input, std::size_t size, std::vector<u8>& out) {
+    std::array<InputWords, NumInputTypes> previous{};
+    std::size_t last_frame = 0;
+    std::size_t last_frame_size = 0;
+    u32 repeats = 0;
+
+    const auto flush_repeats = [&] {
+        if (repeats > 0) {
+            out.push_back(RepeatFrameTag);
+            WriteVarint(out, repeats);
+            repeats = 0;
+        }
+    };
+
+    std::size_t frame = 0;
+    while (frame < size) {
+        std::size_t frame_end = frame + InputSize;
+        while (frame_end < size && input[frame_end] != PadAndCircleType) {
+            frame_end += InputSize;
+        }
+        const std::size_t frame_size = frame_end - frame;
+
+        if (frame_size == last_frame_size &&
+            std::memcmp(input + frame, input + last_frame, frame_size) == 0) {
+            ++repeats;
+        } else {
+            flush_repeats();
+            for (std::size_t offset = frame; offset < frame_end; offset += InputSize) {
+                const u8 type = input[offset];
+                ASSERT(type < previous.size());
+
+                const InputWords words = GetInputWords(input + offset);
+                u8 tag = type;
+                for (std::size_t i = 0; i < words.size(); ++i) {
+                    if (words[i] != previous[type][i]) {
+                        tag |= static_cast<u8>(1 << (3 + i));
+                    }
+                }
+                out.push_back(tag);
+                for (std::size_t i = 0; i < words.size(); ++i) {
+                    if (words[i] != previous[type][i]) {
+                        const auto delta = static_cast<s16>(words[i] - previous[type][i]);
+                        WriteVarint(out, ZigZagEncode(delta));
+                    }
+                }
+                previous[type] = words;
+            }
+        }
+
+        last_frame = frame;
+        last_frame_size = frame_size;
+        frame = frame_end;
+    }
+    flush_repeats();
+}
+
+bool DecodeBlock(const u8* in, std::size_t size, u64 max_repeats, std::vector<u8>& out) {
+    std::array<InputWords, NumInputTypes> previous{};
+    const std::size_t block_start = out.size();
+    std::size_t frame_start = block_start;
+
+    std::size_t pos = 0;
+    while (pos < size) {
+        const u8 tag = in[pos++];
+        if (tag == RepeatFrameTag) {
+            u32 repeats;
+            const std::size_t frame_size = out.size() - frame_start;
+            if (!ReadVarint(in, size, pos, repeats) || repeats > max_repeats || frame_size == 0) {
+                return false;
+            }
+            for (u32 i = 0; i < repeats; ++i) {
+                frame_start = out.size();
+                out.resize(frame_start + frame_size);
+                std::memcpy(&out[frame_start], &out[frame_start - frame_size], frame_size);
+            }
+            continue;
+        }
+
+        const u8 type = tag & 0x7;
+        if (type >= previous.size()) {
+            return false;
+        }
+        if (type == PadAndCircleType && out.size() > block_start) {
+            frame_start = out.size();
+        }
+
+        InputWords& words = previous[type];
+        for (std::size_t i = 0; i < words.size(); ++i) {
+            if (tag & (1 << (3 + i))) {
+                u32 delta;
+                if (!ReadVarint(in, size, pos, delta)) {
+                    return false;
+                }
+                words[i] = static_cast<u16>(words[i] + ZigZagDecode(delta));
+            }
+        }
+
+        out.push_back(type);
+        for (const u16 word : words) {
+            out.push_back(static_cast<u8>(word));
+            out.push_back(static_cast<u8>(word >> 8));
+        }
+    }
+    return true;
+}
+
+std::vector<u8> EncodeInput(const std::vector<u8>& input,
+                            const std::vector<std::size_t>& block_index,
+                            std::vector<BlockIndexEntry>& entries) {
+    std::vector<u8> encoded_input;
+    entries.resize(block_index.size());
+    for (std::size_t i = 0; i < block_index.size(); ++i) {
+        const std::size_t end = i + 1 < block_index.size() ? block_index[i + 1] : input.size();
+        entries[i].offset = encoded_input.size();
+        entries[i].input_offset = block_index[i];
+        EncodeBlock(input.data() + block_index[i], end - block_index[i], encoded_input);
+    }
+    return encoded_input;
+}
+
+bool DecodeInput(const std::vector<u8>& encoded_input, const std::vector<BlockIndexEntry>& entries,
+                 u64 frames_per_block, u64 input_size, std::vector<u8>& input,
+                 std::vector<std::size_t>& block_index) {
+    input.clear();
+    input.reserve(input_size);
+    block_index.clear();
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const u64 begin = entries[i].offset;
+        const u64 end = i + 1 < entries.size() ? entries[i + 1].offset : encoded_input.size();
+        if (begin > end || end > encoded_input.size() || entries[i].input_offset != input.size()) {
+            return false;
+        }
+        block_index.push_back(input.size());
+        if (!DecodeBlock(encoded_input.data() + begin, end - begin, frames_per_block, input)) {
+            return false;
+        }
+    }
+    return input.size() == input_size && input.size() % InputSize == 0;
+}
+
+SeekPlan PlanSeek(const std::vector<Keyframe>& keyframes, u64 current_frame, u64 frame) {
+    const auto next = std::upper_bound(
+        keyframes.begin(), keyframes.end(), frame,
+        [](u64 value, const Keyframe& keyframe) { return value < keyframe.frame; });
+    const Keyframe* closest = next == keyframes.begin() ? nullptr : &*std::prev(next);
+
+    // Playing on is cheaper than restoring a keyframe that is further away from the frame
+    if (current_frame <= frame && (closest == nullptr || closest->frame <= current_frame)) {
+        return {true, nullptr};
+    }
+    return {closest != nullptr, closest};
+}
+
+} // namespace Core::MovieCodec
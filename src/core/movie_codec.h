@@ -0,0 +1,94 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "common/common_types.h"
+#include "common/swap.h"
+
+/**
+ * Encoding of the input stored in movies. The input is split into blocks of frames that can be
+ * decoded independently, so that playback can start at a keyframe without decoding everything
+ * before it.
+ */
+namespace Core::MovieCodec {
+
+/// Size of every input, which is a Movie ControllerState
+constexpr std::size_t InputSize = 7;
+
+/// Type of the pad input, which starts every frame
+constexpr u8 PadAndCircleType = 0;
+
+/// Number of input types
+constexpr u8 NumInputTypes = 6;
+
+#pragma pack(push, 1)
+/// Maps every block of frames to its encoded input
+struct BlockIndexEntry {
+    u64_le offset;       /// Offset of the block in the encoded input
+    u64_le input_offset; /// Offset of the first input of the block once decoded
+};
+static_assert(sizeof(BlockIndexEntry) == 16, "BlockIndexEntry should be 16 bytes");
+#pragma pack(pop)
+
+/// Save state captured while recording, from which playback can continue
+struct Keyframe {
+    u64 frame;  ///< Number of frames played back or recorded when the keyframe was captured
+    u64 offset; ///< Offset of the compressed state in the movie file, or in the spill file
+    u64 size;   ///< Size of the compressed state
+};
+
+/**
+ * Encodes a block of raw input. Frames that repeat the previous frame are run-length encoded, and
+ * every other input is delta encoded against the previous input of the same type.
+ */
+void EncodeBlock(const u8* input, std::size_t size, std::vector<u8>& out);
+
+/**
+ * Decodes a block of input encoded by EncodeBlock, appending it to out.
+ * @param max_repeats Maximum length of a run of repeated frames, which is the size of a block
+ * @returns False if the encoded input is corrupted
+ */
+bool DecodeBlock(const u8* in, std::size_t size, u64 max_repeats, std::vector<u8>& out);
+
+/**
+ * Encodes raw input block by block.
+ * @param block_index Offset of the first input of each block
+ * @param entries Receives the index of the encoded blocks
+ * @returns The encoded input
+ */
+std::vector<u8> EncodeInput(const std::vector<u8>& input,
+                            const std::vector<std::size_t>& block_index,
+                            std::vector<BlockIndexEntry>& entries);
+
+/**
+ * Decodes input encoded by EncodeInput, validating it against its index.
+ * @param frames_per_block Number of frames in each block
+ * @param input_size Size of the input once decoded
+ * @param input Receives the decoded input
+ * @param block_index Receives the offset of the first input of each block
+ * @returns False if the encoded input or its index are corrupted
+ */
+bool DecodeInput(const std::vector<u8>& encoded_input, const std::vector<BlockIndexEntry>& entries,
+                 u64 frames_per_block, u64 input_size, std::vector<u8>& input,
+                 std::vector<std::size_t>& block_index);
+
+/// How playback reaches a frame that is seeked to
+struct SeekPlan {
+    bool reachable;           ///< Whether the frame can be reached at all
+    const Keyframe* keyframe; ///< Keyframe to restore first, or null to play on
+};
+
+/**
+ * Plans a seek. The closest keyframe at or before the frame is restored, unless the frame is ahead
+ * and playback is already past that keyframe, as playing on is cheaper then.
+ * @param keyframes Keyframes of the movie, ordered by frame
+ * @param current_frame Number of frames played back so far
+ * @param frame The frame whose input should be the next one played back
+ */
+SeekPlan PlanSeek(const std::vector<Keyframe>& keyframes, u64 current_frame, u64 frame);
+
+} // namespace Core::MovieCodec
@@ -11,9 +11,11 @@
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 #include "common/file_util.h"
+#include "common/logging/log.h"
 #include "core/hw/gpu.h"
 #include "core/perf_stats.h"
 #include "core/settings.h"
+#include "video_core/video_core.h"
 
 using namespace std::chrono_literals;
 using DoubleSecs = std::chrono::duration<double, std::chrono::seconds::period>;
@@ -24,6 +26,9 @@ using std::chrono::microseconds;
 // booting that we shouldn't account for
 constexpr std::size_t IgnoreFrames = 5;
 
+/// Wall time above which a frame counts as a stutter, two frames at the refresh rate of the screens
+constexpr double StutterThresholdMs = 2 * 1000.0 / GPU::SCREEN_REFRESH_RATE;
+
 namespace Core {
 
 PerfStats::PerfStats(u64 title_id) : title_id(title_id) {}
@@ -43,6 +48,9 @@ PerfStats::~PerfStats() {
         fmt::format("{}/{:%F-%H-%M}_{:016X}.csv", path, *std::localtime(&t), title_id);
     FileUtil::IOFile file(filename, "w");
     file.WriteString(stream.str());
+
+    ExportFrameStatistics(
+        fmt::format("{}/{:%F-%H-%M}_{:016X}_summary.json", path, *std::localtime(&t), title_id));
 }
 
 void PerfStats::BeginSystemFrame() {
@@ -63,6 +71,23 @@ void PerfStats::EndSystemFrame() {
     accumulated_frametime += frame_time;
     system_frames += 1;
 
+    if (++total_system_frames > IgnoreFrames) {
+        const auto to_us = [](Clock::duration duration) {
+            const s64 us = duration_cast<microseconds>(duration).count();
+            return static_cast<u64>(std::max<s64>(us, 0));
+        };
+        const u64 wall_time_us = to_us(frame_end - previous_frame_end);
+        wall_time_histogram.Record(wall_time_us);
+        if (wall_time_us > StutterThresholdMs * 1000.0) {
+            ++stutters;
+        }
+        // The time spent presenting is part of the frame, but is recorded on its own
+        emulation_time_histogram.Record(to_us(frame_time - frame_gpu_time));
+        gpu_time_histogram.Record(to_us(frame_gpu_time));
+        frame_limiting_histogram.Record(to_us(frame_begin - previous_frame_end));
+    }
+    frame_gpu_time = Clock::duration::zero();
+
     previous_frame_length = frame_end - previous_frame_end;
     previous_frame_end = frame_end;
 }
@@ -73,6 +98,91 @@ void PerfStats::EndGameFrame() {
     game_frames += 1;
 }
 
+void PerfStats::AddFrameGPUTime(Clock::duration time) {
+    std::lock_guard lock{object_mutex};
+
+    frame_gpu_time += time;
+}
+
+PerfStats::FrameStatistics PerfStats::GetFrameStatistics() const {
+    std::lock_guard lock{object_mutex};
+
+    const auto distribution = [](const Common::Histogram& histogram) {
+        return FrameTimeDistribution{
+            histogram.Count(),
+            histogram.Mean() / 1000.0,
+            histogram.Percentile(0.5) / 1000.0,
+            histogram.Percentile(0.95) / 1000.0,
+            histogram.Percentile(0.99) / 1000.0,
+            histogram.Max() / 1000.0,
+        };
+    };
+
+    FrameStatistics statistics{};
+    statistics.wall_time = distribution(wall_time_histogram);
+    statistics.emulation_time = distribution(emulation_time_histogram);
+    statistics.gpu_time = distribution(gpu_time_histogram);
+    statistics.frame_limiting = distribution(frame_limiting_histogram);
+    statistics.stutter_threshold = StutterThresholdMs;
+    statistics.stutters = stutters;
+    return statistics;
+}
+
+void PerfStats::ResetFrameStatistics() {
+    std::lock_guard lock{object_mutex};
+
+    wall_time_histogram.Reset();
+    emulation_time_histogram.Reset();
+    gpu_time_histogram.Reset();
+    frame_limiting_histogram.Reset();
+    stutters = 0;
+}
+
+bool PerfStats::ExportFrameStatistics(const std::string& path) const {
+    const FrameStatistics statistics = GetFrameStatistics();
+    const std::array<std::pair<const char*, const FrameTimeDistribution*>, 4> components{{
+        {"wall_time", &statistics.wall_time},
+        {"emulation_time", &statistics.emulation_time},
+        {"gpu_time", &statistics.gpu_time},
+        {"frame_limiting", &statistics.frame_limiting},
+    }};
+
+    std::string contents;
+    const bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    if (json) {
+        contents = fmt::format("{{\n  \"title_id\": \"{:016X}\",\n"
+                               "  \"stutter_threshold_ms\": {:.3f},\n  \"stutters\": {},\n",
+                               title_id, statistics.stutter_threshold, statistics.stutters);
+        for (std::size_t i = 0; i < components.size(); ++i) {
+            const auto& [name, distribution] = components[i];
+            contents += fmt::format("  \"{}\": {{\"frames\": {}, \"mean_ms\": {:.3f}, "
+                                    "\"p50_ms\": {:.3f}, \"p95_ms\": {:.3f}, \"p99_ms\": {:.3f}, "
+                                    "\"max_ms\": {:.3f}}}{}\n",
+                                    name, distribution->frames, distribution->mean,
+                                    distribution->p50, distribution->p95, distribution->p99,
+                                    distribution->max, i + 1 < components.size() ? "," : "");
+        }
+        contents += "}\n";
+    } else {
+        contents = "component,frames,mean_ms,p50_ms,p95_ms,p99_ms,max_ms,stutters\n";
+        for (const auto& [name, distribution] : components) {
+            // Stutters are counted from the wall time only
+            const u64 stutters = distribution == &statistics.wall_time ? statistics.stutters : 0;
+            contents += fmt::format("{},{},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{}\n", name,
+                                    distribution->frames, distribution->mean, distribution->p50,
+                                    distribution->p95, distribution->p99, distribution->max,
+                                    stutters);
+        }
+    }
+
+    FileUtil::IOFile file(path, "w");
+    if (!file.IsOpen() || file.WriteString(contents) != contents.size()) {
+        LOG_ERROR(Core, "Failed to write frame statistics to {}", path);
+        return false;
+    }
+    return true;
+}
+
 double PerfStats::GetMeanFrametime() const {
     std::lock_guard lock{object_mutex};
 
@@ -134,6 +244,11 @@ void FrameLimiter::DoFrameLimiting(microseconds current_system_time_us) {
         return;
     }
 
+    if (VideoCore::IsTurboActive()) {
+        // Turbo mode runs as fast as the CPU emulation allows
+        return;
+    }
+
     auto now = Clock::now();
     double sleep_scale = Settings::values.frame_limit / 100.0;
 
@@ -9,7 +9,9 @@
 #include <chrono>
 #include <cstddef>
 #include <mutex>
+#include <string>
 #include "common/common_types.h"
+#include "common/histogram.h"
 #include "common/thread.h"
 
 namespace Core {
@@ -36,10 +38,55 @@ public:
         double emulation_speed;
     };
 
+    /// Distribution of one component of the time taken by system frames, in milliseconds
+    struct FrameTimeDistribution {
+        u64 frames;
+        double mean;
+        double p50;
+        double p95;
+        double p99;
+        double max;
+    };
+
+    struct FrameStatistics {
+        /// Walltime between the ends of consecutive system frames
+        FrameTimeDistribution wall_time;
+        /// Walltime of the frames excluding any waits and the gpu_time
+        FrameTimeDistribution emulation_time;
+        /// Walltime spent presenting the frames, or waiting for the GPU thread to present them
+        FrameTimeDistribution gpu_time;
+        /// Walltime between frames spent frame limiting and handling frontend events
+        FrameTimeDistribution frame_limiting;
+        /// Threshold of wall_time for a frame to count as a stutter, in milliseconds
+        double stutter_threshold;
+        /// Number of frames whose wall_time exceeded stutter_threshold
+        u64 stutters;
+    };
+
     void BeginSystemFrame();
     void EndSystemFrame();
     void EndGameFrame();
 
+    /// Adds time spent presenting to the current system frame
+    void AddFrameGPUTime(Clock::duration time);
+
+    /**
+     * Gets the distribution of the frame times since the start of emulation or the last reset. A
+     * frame is a stutter if its wall time exceeds two frames at the refresh rate of the emulated
+     * screens.
+     */
+    FrameStatistics GetFrameStatistics() const;
+
+    /// Discards the frame times recorded for GetFrameStatistics
+    void ResetFrameStatistics();
+
+    /**
+     * Writes the statistics of GetFrameStatistics to a file, as JSON if the path ends with .json
+     * and as CSV otherwise.
+     * @return False if the file could not be written
+     */
+    bool ExportFrameStatistics(const std::string& path) const;
+
     Results GetAndResetStats(std::chrono::microseconds current_system_time_us);
 
     /**
@@ -64,6 +111,18 @@ private:
     /// regressions with code changes.
     std::array<double, 216000> perf_history{};
 
+    /// Number of system frames ended, including the ignored ones
+    u64 total_system_frames = 0;
+    /// Time spent presenting in the current system frame
+    Clock::duration frame_gpu_time = Clock::duration::zero();
+    /// Distributions of the frame time components, in microseconds
+    Common::Histogram wall_time_histogram;
+    Common::Histogram emulation_time_histogram;
+    Common::Histogram gpu_time_histogram;
+    Common::Histogram frame_limiting_histogram;
+    /// Number of frames whose wall time exceeded the stutter threshold
+    u64 stutters = 0;
+
     /// Point when the cumulative counters were reset
     Clock::time_point reset_point = Clock::now();
     /// System time when the cumulative counters were reset
@@ -0,0 +1,288 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <thread>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/zstd_compression.h"
+#include "core/memory.h"
+#include "core/rewind_buffer.h"
+#include "core/settings.h"
+
+namespace Core {
+
+struct RewindBuffer::Snapshot {
+    u64 frame;
+
+    std::vector<u8> state;
+    bool state_compressed = false;
+
+    /// Indices of the pages changed by the next snapshot, filled in when it is captured
+    std::vector<u32> page_indices;
+    /// Contents of those pages in this snapshot
+    std::vector<u8> pages;
+    bool pages_compressed = false;
+
+    /// Whether the snapshot was dropped while the worker compressed it
+    bool dropped = false;
+
+    std::size_t Size() const {
+        return state.size() + pages.size() + page_indices.size() * sizeof(u32);
+    }
+};
+
+/// Amount of RAM compared with the previous snapshot by a thread at a time
+constexpr std::size_t CompareChunkSize = 8 * 1024 * 1024;
+
+std::vector<RewindBuffer::Region> RewindBuffer::GetSystemRegions(Memory::MemorySystem& memory) {
+    std::vector<Region> regions{
+        {memory.GetFCRAMPointer(0),
+         Settings::values.is_new_3ds ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE},
+        {memory.GetPhysicalPointer(Memory::VRAM_PADDR), Memory::VRAM_SIZE},
+    };
+    if (Settings::values.is_new_3ds) {
+        regions.push_back({memory.GetPhysicalPointer(Memory::N3DS_EXTRA_RAM_PADDR),
+                           Memory::N3DS_EXTRA_RAM_SIZE});
+    }
+    return regions;
+}
+
+RewindBuffer::RewindBuffer(std::size_t memory_budget)
+    : memory_budget(memory_budget),
+      compare_workers(std::clamp(std::thread::hardware_concurrency(), 1u, 4u), "RewindBuffer"),
+      compression_worker(1, "RewindBuffer") {}
+
+RewindBuffer::~RewindBuffer() = default;
+
+void RewindBuffer::Capture(u64 frame, std::vector<u8> state, const std::vector<Region>& regions) {
+    BeginCapture(frame, regions);
+    FinishCapture(std::move(state));
+}
+
+void RewindBuffer::BeginCapture(u64 frame, const std::vector<Region>& regions) {
+    ASSERT(!capture_frame);
+    const std::size_t ram_size = std::accumulate(
+        regions.begin(), regions.end(), std::size_t{0},
+        [](std::size_t size, const Region& region) { return size + region.size; });
+    if (!snapshots.empty() && frame <= snapshots.back()->frame) {
+        DropSnapshots();
+    }
+
+    if (ram.size() != ram_size) {
+        DropSnapshots();
+        ram.resize(ram_size);
+        std::size_t offset = 0;
+        for (const Region& region : regions) {
+            std::memcpy(ram.data() + offset, region.data, region.size);
+            offset += region.size;
+        }
+    } else {
+        QueueCompare(regions, !snapshots.empty());
+    }
+    capture_frame = frame;
+}
+
+void RewindBuffer::FinishCapture(std::vector<u8> state) {
+    ASSERT(capture_frame);
+    compare_workers.WaitForRequests();
+
+    std::shared_ptr<Snapshot> previous = snapshots.empty() ? nullptr : snapshots.back();
+    if (previous) {
+        CollectChangedPages(*previous);
+        {
+            std::lock_guard lock{mutex};
+            memory_usage += previous->page_indices.size() * sizeof(u32) + previous->pages.size();
+        }
+        QueueCompression(previous, true);
+    }
+    compare_chunks.clear();
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->frame = *capture_frame;
+    capture_frame.reset();
+    snapshot->state = std::move(state);
+    {
+        std::lock_guard lock{mutex};
+        memory_usage += snapshot->state.size();
+    }
+    snapshots.push_back(snapshot);
+    QueueCompression(std::move(snapshot), false);
+
+    DropOldSnapshots();
+}
+
+std::optional<std::vector<u8>> RewindBuffer::Restore(u64 frame) {
+    ASSERT(!capture_frame);
+    compression_worker.WaitForRequests();
+
+    const auto target = std::find_if(snapshots.rbegin(), snapshots.rend(),
+                                     [frame](const auto& snapshot) {
+                                         return snapshot->frame <= frame;
+                                     });
+    if (target == snapshots.rend()) {
+        return std::nullopt;
+    }
+
+    const std::size_t num_dropped = std::distance(snapshots.rbegin(), target);
+    for (std::size_t i = 0; i < num_dropped; ++i) {
+        {
+            std::lock_guard lock{mutex};
+            memory_usage -= snapshots.back()->Size();
+        }
+        snapshots.pop_back();
+        UndoPages(*snapshots.back());
+    }
+    LOG_DEBUG(Core, "Restored snapshot of frame {}, dropped {} newer snapshots",
+              snapshots.back()->frame, num_dropped);
+
+    const Snapshot& snapshot = *snapshots.back();
+    if (snapshot.state_compressed) {
+        return Common::Compression::DecompressDataZSTD(snapshot.state);
+    }
+    return snapshot.state;
+}
+
+void RewindBuffer::WriteMemory(const std::vector<Region>& regions) const {
+    std::size_t offset = 0;
+    for (const Region& region : regions) {
+        ASSERT(offset + region.size <= ram.size());
+        std::memcpy(region.data, ram.data() + offset, region.size);
+        offset += region.size;
+    }
+}
+
+void RewindBuffer::Clear() {
+    ASSERT(!capture_frame);
+    DropSnapshots();
+    ram.clear();
+    ram.shrink_to_fit();
+}
+
+std::optional<u64> RewindBuffer::GetNewestFrame() const {
+    if (snapshots.empty()) {
+        return std::nullopt;
+    }
+    return snapshots.back()->frame;
+}
+
+std::size_t RewindBuffer::NumSnapshots() const {
+    return snapshots.size();
+}
+
+std::size_t RewindBuffer::GetMemoryUsage() const {
+    std::lock_guard lock{mutex};
+    return memory_usage;
+}
+
+void RewindBuffer::DropSnapshots() {
+    std::lock_guard lock{mutex};
+    for (const auto& snapshot : snapshots) {
+        snapshot->dropped = true;
+    }
+    snapshots.clear();
+    memory_usage = 0;
+}
+
+void RewindBuffer::DropOldSnapshots() {
+    std::lock_guard lock{mutex};
+    // Snapshots still being compressed count with their uncompressed size
+    while (memory_usage > memory_budget && snapshots.size() > 1) {
+        memory_usage -= snapshots.front()->Size();
+        snapshots.front()->dropped = true;
+        snapshots.pop_front();
+    }
+}
+
+void RewindBuffer::QueueCompare(const std::vector<Region>& regions, bool keep_old_pages) {
+    std::size_t ram_offset = 0;
+    for (const Region& region : regions) {
+        ASSERT(region.size % PageSize == 0);
+        for (std::size_t offset = 0; offset < region.size; offset += CompareChunkSize) {
+            const std::size_t size = std::min(CompareChunkSize, region.size - offset);
+            compare_chunks.push_back({region.data + offset, size, ram_offset + offset, {}, {}});
+        }
+        ram_offset += region.size;
+    }
+
+    // Comparing is cheaper than copying, and most pages don't change between two snapshots. The
+    // comparison is limited by memory bandwidth, which a single thread can't saturate. Every chunk
+    // updates its own part of the copy of the RAM, so the workers don't need to synchronize.
+    for (CompareChunk& chunk : compare_chunks) {
+        compare_workers.QueueWork([this, &chunk, keep_old_pages] {
+            for (std::size_t offset = 0; offset < chunk.size; offset += PageSize) {
+                u8* const old_page = ram.data() + chunk.ram_offset + offset;
+                if (std::memcmp(chunk.data + offset, old_page, PageSize) == 0) {
+                    continue;
+                }
+                chunk.changed_pages.push_back(
+                    static_cast<u32>((chunk.ram_offset + offset) / PageSize));
+                if (keep_old_pages) {
+                    chunk.old_pages.insert(chunk.old_pages.end(), old_page, old_page + PageSize);
+                }
+                std::memcpy(old_page, chunk.data + offset, PageSize);
+            }
+        });
+    }
+}
+
+void RewindBuffer::CollectChangedPages(Snapshot& previous) {
+    const std::size_t num_changed =
+        std::accumulate(compare_chunks.begin(), compare_chunks.end(), std::size_t{0},
+                        [](std::size_t num, const CompareChunk& chunk) {
+                            return num + chunk.changed_pages.size();
+                        });
+    previous.page_indices.reserve(num_changed);
+    previous.pages.reserve(num_changed * PageSize);
+    for (const CompareChunk& chunk : compare_chunks) {
+        previous.page_indices.insert(previous.page_indices.end(), chunk.changed_pages.begin(),
+                                     chunk.changed_pages.end());
+        previous.pages.insert(previous.pages.end(), chunk.old_pages.begin(),
+                              chunk.old_pages.end());
+    }
+}
+
+void RewindBuffer::UndoPages(Snapshot& snapshot) {
+    const std::size_t pages_size = snapshot.Size() - snapshot.state.size();
+    std::vector<u8> pages = snapshot.pages_compressed
+                                ? Common::Compression::DecompressDataZSTD(snapshot.pages)
+                                : std::move(snapshot.pages);
+    ASSERT(pages.size() == snapshot.page_indices.size() * PageSize);
+    for (std::size_t i = 0; i < snapshot.page_indices.size(); ++i) {
+        std::memcpy(ram.data() + snapshot.page_indices[i] * PageSize, pages.data() + i * PageSize,
+                    PageSize);
+    }
+
+    // The pages changed by the next snapshot are collected again from here on
+    std::lock_guard lock{mutex};
+    memory_usage -= pages_size;
+    snapshot.page_indices.clear();
+    snapshot.pages.clear();
+    snapshot.pages_compressed = false;
+}
+
+void RewindBuffer::QueueCompression(std::shared_ptr<Snapshot> snapshot, bool pages) {
+    compression_worker.QueueWork([this, snapshot = std::move(snapshot), pages] {
+        // Captures don't touch the data of a snapshot once it is queued here
+        const std::vector<u8>& data = pages ? snapshot->pages : snapshot->state;
+        std::vector<u8> compressed =
+            Common::Compression::CompressDataZSTDDefault(data.data(), data.size());
+
+        std::lock_guard lock{mutex};
+        if (!snapshot->dropped) {
+            memory_usage = memory_usage - data.size() + compressed.size();
+        }
+        if (pages) {
+            snapshot->pages = std::move(compressed);
+            snapshot->pages_compressed = true;
+        } else {
+            snapshot->state = std::move(compressed);
+            snapshot->state_compressed = true;
+        }
+    });
+}
+
+} // namespace Core
@@ -0,0 +1,151 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "common/common_types.h"
+#include "common/thread_worker.h"
+
+namespace Memory {
+class MemorySystem;
+}
+
+namespace Core {
+
+/**
+ * Snapshots of the emulated system kept in host memory, to step back in time by a number of
+ * frames.
+ *
+ * A snapshot consists of the serialized system state without the emulated RAM, and of the RAM
+ * pages changed since the previous snapshot. Only the RAM of the newest snapshot is kept whole,
+ * uncompressed so that it can be compared with the RAM of the next one. Every older snapshot keeps
+ * the contents its pages had before they were changed, so a snapshot is restored by undoing the
+ * newer snapshots one after the other. Both parts are compressed on a worker thread, and the
+ * oldest snapshots are dropped when the snapshots exceed the memory budget.
+ */
+class RewindBuffer {
+public:
+    /// Host memory of emulated RAM. The size must be a multiple of PageSize.
+    struct Region {
+        u8* data;
+        std::size_t size;
+    };
+
+    /// Granularity at which changes of the RAM are detected
+    static constexpr std::size_t PageSize = 0x1000;
+
+    /// Returns the emulated RAM of the system, whose contents are left out of the state
+    static std::vector<Region> GetSystemRegions(Memory::MemorySystem& memory);
+
+    /// @param memory_budget Maximum size of the snapshots, not counting the copy of the RAM
+    explicit RewindBuffer(std::size_t memory_budget);
+    ~RewindBuffer();
+
+    RewindBuffer(const RewindBuffer&) = delete;
+    RewindBuffer& operator=(const RewindBuffer&) = delete;
+
+    /**
+     * Captures a snapshot, like BeginCapture followed by FinishCapture.
+     * @param frame Frame the snapshot is taken at
+     * @param state Serialized state of the system, without the contents of the regions
+     * @param regions Emulated RAM, in the same order on every call
+     */
+    void Capture(u64 frame, std::vector<u8> state, const std::vector<Region>& regions);
+
+    /**
+     * Starts capturing a snapshot by comparing the RAM with the previous snapshot on worker
+     * threads, so that the state can be serialized in the meantime. The regions must not be
+     * written until FinishCapture returns. A snapshot of an earlier frame than the newest one
+     * starts a new timeline, dropping all snapshots, and so do regions of a different size.
+     * @param frame Frame the snapshot is taken at
+     * @param regions Emulated RAM, in the same order on every call
+     */
+    void BeginCapture(u64 frame, const std::vector<Region>& regions);
+
+    /**
+     * Waits for the comparison started by BeginCapture and adds the snapshot.
+     * @param state Serialized state of the system, without the contents of the regions
+     */
+    void FinishCapture(std::vector<u8> state);
+
+    /**
+     * Goes back to the newest snapshot taken at or before a frame, dropping the newer snapshots.
+     * Its RAM is then written with WriteMemory, after the returned state is loaded.
+     * @return The state passed to Capture, or std::nullopt if there is no such snapshot
+     */
+    std::optional<std::vector<u8>> Restore(u64 frame);
+
+    /// Writes the RAM of the newest snapshot to the regions
+    void WriteMemory(const std::vector<Region>& regions) const;
+
+    /// Drops all snapshots and frees the copy of the RAM
+    void Clear();
+
+    /// Returns the frame of the newest snapshot, if any
+    std::optional<u64> GetNewestFrame() const;
+
+    std::size_t NumSnapshots() const;
+
+    /// Returns the size of the snapshots, which is kept under the memory budget
+    std::size_t GetMemoryUsage() const;
+
+private:
+    struct Snapshot;
+
+    /// Part of the RAM compared by one worker thread
+    struct CompareChunk {
+        const u8* data;
+        std::size_t size;
+        std::size_t ram_offset;
+        std::vector<u32> changed_pages;
+        /// Contents the changed pages had in the previous snapshot
+        std::vector<u8> old_pages;
+    };
+
+    /// Drops the snapshots, keeping the copy of the RAM to compare the next snapshot with
+    void DropSnapshots();
+
+    /// Drops the oldest snapshots until the snapshots fit into the memory budget
+    void DropOldSnapshots();
+
+    /**
+     * Queues the comparison of the RAM with the copy of the previous snapshot, which copies the
+     * changed pages into it
+     * @param keep_old_pages Whether to keep the old contents of the changed pages
+     */
+    void QueueCompare(const std::vector<Region>& regions, bool keep_old_pages);
+
+    /// Moves the pages found by the comparison into the previous snapshot
+    void CollectChangedPages(Snapshot& previous);
+
+    /// Undoes the changes of the snapshot after the given one in the copy of the RAM
+    void UndoPages(Snapshot& snapshot);
+
+    void QueueCompression(std::shared_ptr<Snapshot> snapshot, bool pages);
+
+    std::size_t memory_budget;
+
+    std::deque<std::shared_ptr<Snapshot>> snapshots;
+    /// RAM of the newest snapshot
+    std::vector<u8> ram;
+
+    /// Frame of the snapshot between BeginCapture and FinishCapture
+    std::optional<u64> capture_frame;
+    std::vector<CompareChunk> compare_chunks;
+
+    /// Protects the compressed data and the memory usage, which the worker updates
+    mutable std::mutex mutex;
+    std::size_t memory_usage = 0;
+
+    Common::ThreadWorker compare_workers;
+    Common::ThreadWorker compression_worker;
+};
+
+} // namespace Core
@@ -7,10 +7,12 @@
 #include <cryptopp/hex.h>
 #include "common/archives.h"
 #include "common/logging/log.h"
+#include "common/scope_exit.h"
 #include "common/scm_rev.h"
 #include "common/zstd_compression.h"
 #include "core/cheats/cheats.h"
 #include "core/core.h"
+#include "core/memory.h"
 #include "core/savestate.h"
 #include "network/network.h"
 #include "video_core/video_core.h"
@@ -88,15 +90,50 @@ std::vector<SaveStateInfo> ListSaveStates(u64 program_id) {
     return result;
 }
 
-void System::SaveState(u32 slot) const {
+std::vector<u8> System::SerializeState(bool include_ram) const {
+    serialize_ram = include_ram;
+    SCOPE_EXIT({ serialize_ram = true; });
+
     std::ostringstream sstream{std::ios_base::binary};
     // Serialize
     oarchive oa{sstream};
     oa&* this;
 
     const std::string& str{sstream.str()};
-    auto buffer = Common::Compression::CompressDataZSTDDefault(
-        reinterpret_cast<const u8*>(str.data()), str.size());
+    return std::vector<u8>(str.begin(), str.end());
+}
+
+void System::DeserializeState(std::vector<u8> state, bool include_ram) {
+    serialize_ram = include_ram;
+    SCOPE_EXIT({ serialize_ram = true; });
+
+    std::istringstream sstream{std::string{reinterpret_cast<char*>(state.data()), state.size()},
+                               std::ios_base::binary};
+    state.clear();
+    state.shrink_to_fit();
+
+    // Deserialize
+    iarchive ia{sstream};
+    ia&* this;
+}
+
+std::vector<u8> System::SaveStateBuffer() const {
+    const std::vector<u8> state = SerializeState(true);
+    return Common::Compression::CompressDataZSTDDefault(state.data(), state.size());
+}
+
+void System::LoadStateBuffer(std::vector<u8> buffer) {
+    if (Network::GetRoomMember().lock()->IsConnected()) {
+        throw std::runtime_error("Unable to load while connected to multiplayer");
+    }
+
+    std::vector<u8> decompressed = Common::Compression::DecompressDataZSTD(buffer);
+    buffer.clear();
+    DeserializeState(std::move(decompressed), true);
+}
+
+void System::SaveState(u32 slot) const {
+    const auto buffer = SaveStateBuffer();
 
     const auto path = GetSaveStatePath(title_id, slot);
     if (!FileUtil::CreateFullPath(path)) {
@@ -132,25 +169,15 @@ void System::LoadState(u32 slot) {
 
     const auto path = GetSaveStatePath(title_id, slot);
 
-    std::vector<u8> decompressed;
+    std::vector<u8> buffer(FileUtil::GetSize(path) - sizeof(CSTHeader));
     {
-        std::vector<u8> buffer(FileUtil::GetSize(path) - sizeof(CSTHeader));
-
         FileUtil::IOFile file(path, "rb");
         file.Seek(sizeof(CSTHeader), SEEK_SET); // Skip header
         if (file.ReadBytes(buffer.data(), buffer.size()) != buffer.size()) {
             throw std::runtime_error("Could not read from file at " + path);
         }
-        decompressed = Common::Compression::DecompressDataZSTD(buffer);
     }
-    std::istringstream sstream{
-        std::string{reinterpret_cast<char*>(decompressed.data()), decompressed.size()},
-        std::ios_base::binary};
-    decompressed.clear();
-
-    // Deserialize
-    iarchive ia{sstream};
-    ia&* this;
+    LoadStateBuffer(std::move(buffer));
 }
 
 } // namespace Core
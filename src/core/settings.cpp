@@ -78,16 +78,25 @@ void LogSettings() {
     LOG_INFO(Config, "Citra Configuration:");
     log_setting("Core_UseCpuJit", values.use_cpu_jit);
     log_setting("Core_CPUClockPercentage", values.cpu_clock_percentage);
+    log_setting("Core_UseMultiCore", values.use_multi_core);
+    log_setting("Core_SkipIdleLoops", values.skip_idle_loops);
+    log_setting("Core_EnableRewind", values.enable_rewind);
+    log_setting("Core_RewindInterval", values.rewind_interval);
+    log_setting("Core_RewindMemoryLimit", values.rewind_memory_limit);
     log_setting("Renderer_UseGLES", values.use_gles);
     log_setting("Renderer_UseHwRenderer", values.use_hw_renderer);
     log_setting("Renderer_UseHwShader", values.use_hw_shader);
     log_setting("Renderer_SeparableShader", values.separable_shader);
     log_setting("Renderer_ShadersAccurateMul", values.shaders_accurate_mul);
     log_setting("Renderer_UseShaderJit", values.use_shader_jit);
+    log_setting("Renderer_UseGPUThread", values.use_gpu_thread);
     log_setting("Renderer_UseResolutionFactor", values.resolution_factor);
     log_setting("Renderer_FrameLimit", values.frame_limit);
     log_setting("Renderer_UseFrameLimitAlternate", values.use_frame_limit_alternate);
     log_setting("Renderer_FrameLimitAlternate", values.frame_limit_alternate);
+    log_setting("Renderer_UseTurbo", values.use_turbo);
+    log_setting("Renderer_TurboSkipFrames", values.turbo_skip_frames);
+    log_setting("Renderer_TurboFrameInterval", values.turbo_frame_interval);
     log_setting("Renderer_VSyncNew", values.use_vsync_new);
     log_setting("Renderer_PostProcessingShader", values.pp_shader_name);
     log_setting("Renderer_FilterMode", values.filter_mode);
@@ -118,8 +127,11 @@ void LogSettings() {
     log_setting("Camera_OuterLeftConfig", values.camera_config[OuterLeftCamera]);
     log_setting("Camera_OuterLeftFlip", values.camera_flip[OuterLeftCamera]);
     log_setting("DataStorage_UseVirtualSd", values.use_virtual_sd);
+    log_setting("DataStorage_AsyncFileReads", values.async_file_reads);
+    log_setting("DataStorage_WriteBackSaveData", values.write_back_save_data);
     log_setting("System_IsNew3ds", values.is_new_3ds);
     log_setting("System_RegionValue", values.region_value);
+    log_setting("Debugging_MovieKeyframeInterval", values.movie_keyframe_interval);
     log_setting("Debugging_UseGdbstub", values.use_gdbstub);
     log_setting("Debugging_GdbstubPort", values.gdbstub_port);
 }
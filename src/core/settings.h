@@ -137,9 +137,16 @@ struct Values {
     // Core
     bool use_cpu_jit;
     int cpu_clock_percentage;
+    bool use_multi_core;
+    bool skip_idle_loops;
+    bool enable_rewind;
+    int rewind_interval;     ///< Frames between two rewind snapshots
+    int rewind_memory_limit; ///< MiB
 
     // Data Storage
     bool use_virtual_sd;
+    bool async_file_reads;
+    bool write_back_save_data;
 
     // System
     int region_value;
@@ -154,10 +161,14 @@ struct Values {
     bool use_disk_shader_cache;
     bool shaders_accurate_mul;
     bool use_shader_jit;
+    bool use_gpu_thread;
     u16 resolution_factor;
     bool use_frame_limit_alternate;
     u16 frame_limit;
     u16 frame_limit_alternate;
+    bool use_turbo;
+    u16 turbo_skip_frames;
+    u16 turbo_frame_interval;
     std::string texture_filter_name;
 
     LayoutOption layout_option;
@@ -206,9 +217,11 @@ struct Values {
 
     // Debugging
     bool record_frame_times;
+    int movie_keyframe_interval; ///< Seconds of emulated time, 0 to disable keyframes
     bool use_gdbstub;
     u16 gdbstub_port;
     std::string log_filter;
+    bool binary_logging;
     std::unordered_map<std::string, bool> lle_modules;
 
     // WebService
@@ -2,13 +2,19 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <regex>
 #include <string>
 #include <thread>
+#include <vector>
 #include <cryptopp/base64.h>
 #include <glad/glad.h>
 
@@ -27,14 +33,18 @@
 #include "common/logging/log.h"
 #include "common/scm_rev.h"
 #include "common/string_util.h"
+#include "common/thread.h"
 #include "core/announce_multiplayer_session.h"
 #include "core/core.h"
 #include "core/settings.h"
 #include "network/network.h"
 #include "network/room.h"
+#include "network/room_event_loop.h"
 #include "network/verify_user.h"
 
 #ifdef ENABLE_WEB_SERVICE
+#include <httplib.h>
+#include <json.hpp>
 #include "web_service/verify_user_jwt.h"
 #endif
 
@@ -60,6 +70,10 @@ static void PrintHelp(const char* argv0) {
                  "--ban-list-file     The file for storing the room ban list\n"
                  "--log-file          The file for storing the room log\n"
                  "--enable-citra-mods Allow Citra Community Moderators to moderate on your room\n"
+                 "--rooms-file        The file listing the rooms to host, instead of one room\n"
+                 "--threads           The number of threads to share the rooms between,\n"
+                 "                    0 to run each room on its own thread (default)\n"
+                 "--stats-port        The local port serving the traffic of the rooms as JSON\n"
                  "-h, --help          Display this help and exit\n"
                  "-v, --version       Output version information and exit\n";
 }
@@ -152,6 +166,225 @@ static void SaveBanList(const Network::Room::BanList& ban_list, const std::strin
     file.flush();
 }
 
+/// Settings of one of the hosted rooms
+struct RoomConfig {
+    std::string name;
+    std::string description;
+    std::string password;
+    std::string preferred_game;
+    u64 preferred_game_id = 0;
+    u32 port = Network::DefaultRoomPort;
+    u32 max_members = 16;
+};
+
+/// Parses a whole value of the rooms file as an unsigned number
+static std::optional<u64> ParseNumber(const std::string& value, int base) {
+    char* end;
+    errno = 0;
+    const u64 number = strtoull(value.c_str(), &end, base);
+    if (value.empty() || value[0] == '-' || *end != '\0' || errno == ERANGE) {
+        return std::nullopt;
+    }
+    return number;
+}
+
+/**
+ * Loads the rooms to host. Each room starts with a [room] line, followed by key = value lines
+ * for the keys name, description, port, max_members, password, preferred_game and
+ * preferred_game_id. Missing keys are taken from the defaults, except for the port, which
+ * defaults to the port after the one of the previous room.
+ */
+static std::optional<std::vector<RoomConfig>> LoadRoomsFile(const std::string& path,
+                                                            const RoomConfig& defaults) {
+    std::ifstream file;
+    OpenFStream(file, path, std::ios_base::in);
+    if (!file) {
+        std::cout << "Could not open rooms file!\n\n";
+        return std::nullopt;
+    }
+
+    std::vector<RoomConfig> rooms;
+    std::string line;
+    for (u32 line_number = 1; std::getline(file, line); ++line_number) {
+        line = Common::StripSpaces(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';') {
+            continue;
+        }
+        if (line == "[room]") {
+            rooms.push_back(defaults);
+            if (rooms.size() > 1) {
+                rooms.back().port = rooms[rooms.size() - 2].port + 1;
+            }
+            continue;
+        }
+        const std::size_t separator = line.find('=');
+        if (rooms.empty() || separator == std::string::npos) {
+            std::cout << "Invalid line " << line_number << " in rooms file!\n\n";
+            return std::nullopt;
+        }
+        const std::string key = Common::StripSpaces(line.substr(0, separator));
+        const std::string value = Common::StripSpaces(line.substr(separator + 1));
+        RoomConfig& room = rooms.back();
+        if (key == "name") {
+            room.name = value;
+        } else if (key == "description") {
+            room.description = value;
+        } else if (key == "port" || key == "max_members") {
+            // The ranges are checked by ValidateRoomConfig, like the ones of the command line
+            const std::optional<u64> number = ParseNumber(value, 0);
+            if (!number || *number > std::numeric_limits<u32>::max()) {
+                std::cout << "Invalid " << key << " on line " << line_number
+                          << " in rooms file!\n\n";
+                return std::nullopt;
+            }
+            (key == "port" ? room.port : room.max_members) = static_cast<u32>(*number);
+        } else if (key == "password") {
+            room.password = value;
+        } else if (key == "preferred_game") {
+            room.preferred_game = value;
+        } else if (key == "preferred_game_id") {
+            const std::optional<u64> number = ParseNumber(value, 16);
+            if (!number) {
+                std::cout << "Invalid preferred_game_id on line " << line_number
+                          << " in rooms file!\n\n";
+                return std::nullopt;
+            }
+            room.preferred_game_id = *number;
+        } else {
+            std::cout << "Unknown key " << key << " in rooms file!\n\n";
+            return std::nullopt;
+        }
+    }
+    if (rooms.empty()) {
+        std::cout << "Rooms file does not list any room!\n\n";
+        return std::nullopt;
+    }
+    return rooms;
+}
+
+/// Checks the settings of a room, printing what is wrong with them
+static bool ValidateRoomConfig(const RoomConfig& room) {
+    if (room.name.empty()) {
+        std::cout << "room name is empty!\n\n";
+        return false;
+    }
+    if (room.preferred_game.empty()) {
+        std::cout << "preferred game of room " << room.name << " is empty!\n\n";
+        return false;
+    }
+    if (room.preferred_game_id == 0) {
+        std::cout << "preferred-game-id of room " << room.name
+                  << " not set!\nThis should get set to allow users to find your "
+                     "room.\nSet with --preferred-game-id id\n\n";
+    }
+    if (room.max_members > Network::MaxConcurrentConnections || room.max_members < 2) {
+        std::cout << "max_members needs to be in the range 2 - "
+                  << Network::MaxConcurrentConnections << "!\n\n";
+        return false;
+    }
+    if (room.port > 65535) {
+        std::cout << "port needs to be in the range 0 - 65535!\n\n";
+        return false;
+    }
+    return true;
+}
+
+#ifdef ENABLE_WEB_SERVICE
+/**
+ * Serves the traffic of the hosted rooms as JSON on the local host. The traffic is sampled every
+ * second, so that the rates are averaged over the last second.
+ */
+class RoomStatsServer {
+public:
+    RoomStatsServer(std::vector<std::shared_ptr<Network::Room>> rooms, u16 port)
+        : rooms(std::move(rooms)), samples(this->rooms.size()), rates(this->rooms.size()) {
+        server.Get("/", [this](const httplib::Request&, httplib::Response& response) {
+            response.set_content(ToJson(), "application/json");
+        });
+        sample_thread = std::thread([this] { SampleLoop(); });
+        server_thread = std::thread([this, port] {
+            if (!server.listen("127.0.0.1", port)) {
+                LOG_ERROR(Network, "Failed to serve the room statistics on port {}", port);
+            }
+        });
+    }
+
+    ~RoomStatsServer() {
+        server.stop();
+        server_thread.join();
+        shutdown_event.Set();
+        sample_thread.join();
+    }
+
+private:
+    struct Rates {
+        double packets_received = 0;
+        double bytes_received = 0;
+        double packets_forwarded = 0;
+        double bytes_forwarded = 0;
+    };
+
+    void SampleLoop() {
+        auto next = std::chrono::steady_clock::now();
+        while (true) {
+            {
+                std::lock_guard lock(mutex);
+                for (std::size_t i = 0; i < rooms.size(); ++i) {
+                    const Network::Room::Statistics sample = rooms[i]->GetStatistics();
+                    const Network::Room::Statistics& last = samples[i];
+                    rates[i].packets_received =
+                        static_cast<double>(sample.packets_received - last.packets_received);
+                    rates[i].bytes_received =
+                        static_cast<double>(sample.bytes_received - last.bytes_received);
+                    rates[i].packets_forwarded =
+                        static_cast<double>(sample.packets_forwarded - last.packets_forwarded);
+                    rates[i].bytes_forwarded =
+                        static_cast<double>(sample.bytes_forwarded - last.bytes_forwarded);
+                    samples[i] = sample;
+                }
+            }
+            next += std::chrono::seconds(1);
+            if (shutdown_event.WaitUntil(next)) {
+                return;
+            }
+        }
+    }
+
+    std::string ToJson() {
+        nlohmann::json json = nlohmann::json::array();
+        std::lock_guard lock(mutex);
+        for (std::size_t i = 0; i < rooms.size(); ++i) {
+            const Network::RoomInformation& information = rooms[i]->GetRoomInformation();
+            json.push_back({
+                {"name", information.name},
+                {"port", information.port},
+                {"members", samples[i].num_members},
+                {"max_members", information.member_slots},
+                {"packets_received", samples[i].packets_received},
+                {"bytes_received", samples[i].bytes_received},
+                {"packets_forwarded", samples[i].packets_forwarded},
+                {"bytes_forwarded", samples[i].bytes_forwarded},
+                {"packets_received_per_second", rates[i].packets_received},
+                {"bytes_received_per_second", rates[i].bytes_received},
+                {"packets_forwarded_per_second", rates[i].packets_forwarded},
+                {"bytes_forwarded_per_second", rates[i].bytes_forwarded},
+            });
+        }
+        return json.dump();
+    }
+
+    std::vector<std::shared_ptr<Network::Room>> rooms;
+    std::mutex mutex;
+    std::vector<Network::Room::Statistics> samples;
+    std::vector<Rates> rates;
+
+    httplib::Server server;
+    Common::Event shutdown_event;
+    std::thread sample_thread;
+    std::thread server_thread;
+};
+#endif
+
 static void InitializeLogging(const std::string& log_file) {
     Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
 
@@ -173,18 +406,15 @@ int main(int argc, char** argv) {
     // This is just to be able to link against core
     gladLoadGL();
 
-    std::string room_name;
-    std::string room_description;
-    std::string password;
-    std::string preferred_game;
+    RoomConfig room_config;
+    std::string rooms_file;
     std::string username;
     std::string token;
     std::string web_api_url;
     std::string ban_list_file;
     std::string log_file = "citra-room.log";
-    u64 preferred_game_id = 0;
-    u32 port = Network::DefaultRoomPort;
-    u32 max_members = 16;
+    u32 num_threads = 0;
+    u32 stats_port = 0;
     bool enable_citra_mods = false;
 
     static struct option long_options[] = {
@@ -201,35 +431,39 @@ int main(int argc, char** argv) {
         {"ban-list-file", required_argument, 0, 'b'},
         {"log-file", required_argument, 0, 'l'},
         {"enable-citra-mods", no_argument, 0, 'e'},
+        {"rooms-file", required_argument, 0, 'r'},
+        {"threads", required_argument, 0, 'T'},
+        {"stats-port", required_argument, 0, 's'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},
         {0, 0, 0, 0},
     };
 
     while (optind < argc) {
-        int arg = getopt_long(argc, argv, "n:d:p:m:w:g:u:t:a:i:l:hv", long_options, &option_index);
+        int arg = getopt_long(argc, argv, "n:d:p:m:w:g:u:t:a:i:l:r:T:s:hv", long_options,
+                              &option_index);
         if (arg != -1) {
             switch (static_cast<char>(arg)) {
             case 'n':
-                room_name.assign(optarg);
+                room_config.name.assign(optarg);
                 break;
             case 'd':
-                room_description.assign(optarg);
+                room_config.description.assign(optarg);
                 break;
             case 'p':
-                port = strtoul(optarg, &endarg, 0);
+                room_config.port = strtoul(optarg, &endarg, 0);
                 break;
             case 'm':
-                max_members = strtoul(optarg, &endarg, 0);
+                room_config.max_members = strtoul(optarg, &endarg, 0);
                 break;
             case 'w':
-                password.assign(optarg);
+                room_config.password.assign(optarg);
                 break;
             case 'g':
-                preferred_game.assign(optarg);
+                room_config.preferred_game.assign(optarg);
                 break;
             case 'i':
-                preferred_game_id = strtoull(optarg, &endarg, 16);
+                room_config.preferred_game_id = strtoull(optarg, &endarg, 16);
                 break;
             case 'u':
                 username.assign(optarg);
@@ -249,6 +483,15 @@ int main(int argc, char** argv) {
             case 'e':
                 enable_citra_mods = true;
                 break;
+            case 'r':
+                rooms_file.assign(optarg);
+                break;
+            case 'T':
+                num_threads = strtoul(optarg, &endarg, 0);
+                break;
+            case 's':
+                stats_port = strtoul(optarg, &endarg, 0);
+                break;
             case 'h':
                 PrintHelp(argv[0]);
                 return 0;
@@ -259,28 +502,22 @@ int main(int argc, char** argv) {
         }
     }
 
-    if (room_name.empty()) {
-        std::cout << "room name is empty!\n\n";
-        PrintHelp(argv[0]);
-        return -1;
-    }
-    if (preferred_game.empty()) {
-        std::cout << "preferred game is empty!\n\n";
-        PrintHelp(argv[0]);
+    std::vector<RoomConfig> room_configs;
+    if (rooms_file.empty()) {
+        room_configs.push_back(room_config);
+    } else if (auto loaded = LoadRoomsFile(rooms_file, room_config)) {
+        room_configs = std::move(*loaded);
+    } else {
         return -1;
     }
-    if (preferred_game_id == 0) {
-        std::cout << "preferred-game-id not set!\nThis should get set to allow users to find your "
-                     "room.\nSet with --preferred-game-id id\n\n";
-    }
-    if (max_members > Network::MaxConcurrentConnections || max_members < 2) {
-        std::cout << "max_members needs to be in the range 2 - "
-                  << Network::MaxConcurrentConnections << "!\n\n";
-        PrintHelp(argv[0]);
-        return -1;
+    for (const RoomConfig& config : room_configs) {
+        if (!ValidateRoomConfig(config)) {
+            PrintHelp(argv[0]);
+            return -1;
+        }
     }
-    if (port > 65535) {
-        std::cout << "port needs to be in the range 0 - 65535!\n\n";
+    if (stats_port > 65535) {
+        std::cout << "stats-port needs to be in the range 0 - 65535!\n\n";
         PrintHelp(argv[0]);
         return -1;
     }
@@ -318,56 +555,106 @@ int main(int argc, char** argv) {
 
     InitializeLogging(log_file);
 
-    // Load the ban list
-    Network::Room::BanList ban_list;
+    // Load the ban list, which is shared by all rooms
+    auto ban_list = std::make_shared<Network::Room::SharedBanList>();
     if (!ban_list_file.empty()) {
-        ban_list = LoadBanList(ban_list_file);
+        std::tie(ban_list->username_ban_list, ban_list->ip_ban_list) = LoadBanList(ban_list_file);
     }
 
-    std::unique_ptr<Network::VerifyUser::Backend> verify_backend;
+#ifndef ENABLE_WEB_SERVICE
     if (announce) {
-#ifdef ENABLE_WEB_SERVICE
-        verify_backend = std::make_unique<WebService::VerifyUserJWT>(Settings::values.web_api_url);
-#else
         std::cout
             << "Citra Web Services is not available with this build: validation is disabled.\n\n";
-        verify_backend = std::make_unique<Network::VerifyUser::NullBackend>();
-#endif
-    } else {
-        verify_backend = std::make_unique<Network::VerifyUser::NullBackend>();
     }
+#endif
+    const auto make_verify_backend = [announce]() -> std::unique_ptr<Network::VerifyUser::Backend> {
+#ifdef ENABLE_WEB_SERVICE
+        if (announce) {
+            return std::make_unique<WebService::VerifyUserJWT>(Settings::values.web_api_url);
+        }
+#endif
+        return std::make_unique<Network::VerifyUser::NullBackend>();
+    };
 
     Network::Init();
-    if (std::shared_ptr<Network::Room> room = Network::GetRoom().lock()) {
-        if (!room->Create(room_name, room_description, "", port, password, max_members, username,
-                          preferred_game, preferred_game_id, std::move(verify_backend), ban_list,
-                          enable_citra_mods)) {
-            std::cout << "Failed to create room: \n\n";
+
+    // The rooms are distributed over the event loops in turn
+    std::vector<std::unique_ptr<Network::RoomEventLoop>> event_loops(
+        std::min<std::size_t>(num_threads, room_configs.size()));
+    for (auto& event_loop : event_loops) {
+        event_loop = std::make_unique<Network::RoomEventLoop>();
+    }
+
+    std::vector<std::shared_ptr<Network::Room>> rooms;
+    for (std::size_t i = 0; i < room_configs.size(); ++i) {
+        const RoomConfig& config = room_configs[i];
+        Network::RoomEventLoop* event_loop =
+            event_loops.empty() ? nullptr : event_loops[i % event_loops.size()].get();
+        auto room = std::make_shared<Network::Room>();
+        if (!room->Create(config.name, config.description, "", static_cast<u16>(config.port),
+                          config.password, config.max_members, username, config.preferred_game,
+                          config.preferred_game_id, make_verify_backend(), {}, enable_citra_mods,
+                          event_loop, ban_list)) {
+            std::cout << "Failed to create room " << config.name << ": \n\n";
+            for (const auto& created_room : rooms) {
+                created_room->Destroy();
+            }
             return -1;
         }
+        rooms.push_back(std::move(room));
+    }
+    if (rooms.size() == 1) {
         std::cout << "Room is open. Close with Q+Enter...\n\n";
-        auto announce_session = std::make_unique<Core::AnnounceMultiplayerSession>();
+    } else {
+        std::cout << rooms.size() << " rooms are open. Close with Q+Enter...\n\n";
+    }
+
+    std::vector<std::unique_ptr<Core::AnnounceMultiplayerSession>> announce_sessions;
+    for (const auto& room : rooms) {
+        announce_sessions.push_back(std::make_unique<Core::AnnounceMultiplayerSession>(room));
         if (announce) {
-            announce_session->Start();
+            announce_sessions.back()->Start();
         }
-        while (room->GetState() == Network::Room::State::Open) {
-            std::string in;
-            std::cin >> in;
-            if (in.size() > 0) {
-                break;
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+#ifdef ENABLE_WEB_SERVICE
+    std::unique_ptr<RoomStatsServer> stats_server;
+    if (stats_port != 0) {
+        stats_server = std::make_unique<RoomStatsServer>(rooms, static_cast<u16>(stats_port));
+        std::cout << "Serving room statistics on http://127.0.0.1:" << stats_port << "/\n\n";
+    }
+#else
+    if (stats_port != 0) {
+        std::cout << "Room statistics are not available with this build.\n\n";
+    }
+#endif
+
+    while (rooms.front()->GetState() == Network::Room::State::Open) {
+        std::string in;
+        std::cin >> in;
+        if (in.size() > 0) {
+            break;
         }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+#ifdef ENABLE_WEB_SERVICE
+    stats_server.reset();
+#endif
+    for (auto& announce_session : announce_sessions) {
         if (announce) {
             announce_session->Stop();
         }
         announce_session.reset();
-        // Save the ban list
-        if (!ban_list_file.empty()) {
-            SaveBanList(room->GetBanList(), ban_list_file);
-        }
+    }
+    // Save the ban list
+    if (!ban_list_file.empty()) {
+        SaveBanList(rooms.front()->GetBanList(), ban_list_file);
+    }
+    for (const auto& room : rooms) {
         room->Destroy();
     }
+    event_loops.clear();
     Network::Shutdown();
     detached_tasks.WaitForAllTasks();
     return 0;
@@ -0,0 +1,233 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_types.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "network/network.h"
+#include "network/room.h"
+#include "network/room_member.h"
+#include "network/verify_user.h"
+
+#undef _UNICODE
+#include <getopt.h>
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options]\n"
+                 "Connects members to a room over loopback and measures how fast it forwards\n"
+                 "WiFi packets between them.\n\n"
+                 "--server      Address of the room, a local room is hosted if not given\n"
+                 "--port        The port used for the room\n"
+                 "--members     The number of members to connect\n"
+                 "--rate        The number of packets each member sends per second\n"
+                 "--size        The size of the data of each packet\n"
+                 "--duration    How long to send packets for, in seconds\n"
+                 "--broadcast   Send broadcast packets instead of packets to another member\n"
+                 "-h, --help    Display this help and exit\n";
+}
+
+namespace {
+
+/// A member of the room that records when the packets sent to it arrive
+struct LoadMember {
+    Network::RoomMember member;
+    Network::RoomMember::CallbackHandle<Network::WifiPacket> callback;
+    std::vector<u64> latencies_ns; ///< Only accessed by the thread of the member until it left
+};
+
+u64 NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch())
+        .count();
+}
+
+bool WaitForJoin(const Network::RoomMember& member) {
+    const auto deadline = Clock::now() + std::chrono::seconds(5);
+    while (member.GetState() == Network::RoomMember::State::Joining && Clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return member.GetState() == Network::RoomMember::State::Joined;
+}
+
+} // Anonymous namespace
+
+/// Application entry point
+int main(int argc, char** argv) {
+    int option_index = 0;
+    char* endarg;
+
+    std::string server;
+    u32 port = Network::DefaultRoomPort;
+    u32 num_members = 16;
+    u32 rate = 100;
+    u32 size = 256;
+    long duration = 10;
+    bool broadcast = false;
+
+    static struct option long_options[] = {
+        {"server", required_argument, 0, 's'},  {"port", required_argument, 0, 'p'},
+        {"members", required_argument, 0, 'm'}, {"rate", required_argument, 0, 'r'},
+        {"size", required_argument, 0, 'z'},    {"duration", required_argument, 0, 'd'},
+        {"broadcast", no_argument, 0, 'b'},     {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0},
+    };
+
+    while (optind < argc) {
+        int arg = getopt_long(argc, argv, "s:p:m:r:z:d:bh", long_options, &option_index);
+        if (arg != -1) {
+            switch (static_cast<char>(arg)) {
+            case 's':
+                server.assign(optarg);
+                break;
+            case 'p':
+                port = strtoul(optarg, &endarg, 0);
+                break;
+            case 'm':
+                num_members = strtoul(optarg, &endarg, 0);
+                break;
+            case 'r':
+                rate = strtoul(optarg, &endarg, 0);
+                break;
+            case 'z':
+                size = strtoul(optarg, &endarg, 0);
+                break;
+            case 'd':
+                duration = strtol(optarg, &endarg, 0);
+                break;
+            case 'b':
+                broadcast = true;
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            }
+        } else {
+            PrintHelp(argv[0]);
+            return -1;
+        }
+    }
+
+    if (num_members < 2 || rate == 0) {
+        std::cout << "At least 2 members sending at a non-zero rate are needed\n\n";
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    if (duration <= 0) {
+        std::cout << "The duration has to be at least 1 second\n\n";
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    size = std::max<u32>(size, sizeof(u64));
+
+    // Joins and leaves of every member would drown out the results
+    Log::Filter log_filter(Log::Level::Warning);
+    Log::SetGlobalFilter(log_filter);
+    Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
+
+    if (!Network::Init()) {
+        return -1;
+    }
+
+    std::unique_ptr<Network::Room> room;
+    if (server.empty()) {
+        server = "127.0.0.1";
+        room = std::make_unique<Network::Room>();
+        if (!room->Create("Load generator", "", server, static_cast<u16>(port), "", num_members,
+                          "", "", 0, std::make_unique<Network::VerifyUser::NullBackend>())) {
+            std::cout << "Failed to create room\n\n";
+            return -1;
+        }
+    }
+
+    std::vector<std::unique_ptr<LoadMember>> members;
+    for (u32 i = 0; i < num_members; ++i) {
+        auto load_member = std::make_unique<LoadMember>();
+        load_member->callback = load_member->member.BindOnWifiPacketReceived(
+            [member = load_member.get()](const Network::WifiPacket& packet) {
+                u64 sent_ns;
+                std::memcpy(&sent_ns, packet.data.data(), sizeof(sent_ns));
+                member->latencies_ns.push_back(NowNs() - sent_ns);
+            });
+        load_member->member.Join(fmt::format("loadgen{:03}", i), fmt::format("{:016X}", i),
+                                 server.c_str(), static_cast<u16>(port));
+        if (!WaitForJoin(load_member->member)) {
+            std::cout << "Member " << i << " failed to join the room\n\n";
+            return -1;
+        }
+        members.push_back(std::move(load_member));
+    }
+    std::cout << "Connected " << num_members << " members, sending " << rate
+              << " packets per second each for " << duration << " seconds\n";
+
+    // Every member sends to the next one, so that each receives as many packets as it sends
+    Network::WifiPacket packet;
+    packet.type = Network::WifiPacket::PacketType::Data;
+    packet.channel = 1;
+    packet.data.resize(size);
+
+    u64 num_sent = 0;
+    const auto interval = std::chrono::nanoseconds(std::chrono::seconds(1)) / rate;
+    const auto start = Clock::now();
+    const auto end = start + std::chrono::seconds(duration);
+    for (auto next = start; next < end; next += interval) {
+        std::this_thread::sleep_until(next);
+        for (u32 i = 0; i < num_members; ++i) {
+            auto& sender = members[i]->member;
+            packet.transmitter_address = sender.GetMacAddress();
+            packet.destination_address =
+                broadcast ? Network::BroadcastMac
+                          : members[(i + 1) % num_members]->member.GetMacAddress();
+            const u64 now_ns = NowNs();
+            std::memcpy(packet.data.data(), &now_ns, sizeof(now_ns));
+            sender.SendWifiPacket(packet);
+            ++num_sent;
+        }
+    }
+
+    // Give the packets in flight time to arrive, then stop the members to read their results
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    std::vector<u64> latencies_ns;
+    for (auto& load_member : members) {
+        load_member->member.Leave();
+        latencies_ns.insert(latencies_ns.end(), load_member->latencies_ns.begin(),
+                            load_member->latencies_ns.end());
+    }
+    if (room) {
+        room->Destroy();
+    }
+    Network::Shutdown();
+
+    const u64 expected = broadcast ? num_sent * (num_members - 1) : num_sent;
+    std::cout << fmt::format("Sent {} packets, received {} of {}\n", num_sent, latencies_ns.size(),
+                             expected);
+    if (latencies_ns.empty()) {
+        return -1;
+    }
+
+    std::sort(latencies_ns.begin(), latencies_ns.end());
+    const auto percentile = [&latencies_ns](double p) {
+        const auto index = static_cast<std::size_t>(p * (latencies_ns.size() - 1));
+        return latencies_ns[index] / 1000.0;
+    };
+    std::cout << fmt::format("Forwarded {:.0f} packets per second\n",
+                             latencies_ns.size() / static_cast<double>(duration));
+    std::cout << fmt::format("Latency: p50 {:.0f}us, p99 {:.0f}us, max {:.0f}us\n",
+                             percentile(0.5), percentile(0.99), percentile(1.0));
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "common/file_util.h"
+#include "common/logging/backend.h"
+#include "common/logging/binary_log.h"
+#include "common/logging/filter.h"
+#include "common/logging/text_formatter.h"
+
+#undef _UNICODE
+#include <getopt.h>
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options] <binary log file>\n"
+                 "Formats the messages of a binary log file as text.\n\n"
+                 "-o, --output     File to write the messages to instead of the standard output\n"
+                 "-f, --filter     Only output the messages that pass this log filter\n"
+                 "-u, --unsorted   Output the messages of every thread in batches as they were\n"
+                 "                 written, instead of sorting them by time\n"
+                 "-h, --help       Display this help and exit\n";
+}
+
+/// Application entry point
+int main(int argc, char** argv) {
+    int option_index = 0;
+
+    std::string output_path;
+    std::string filter_string = "*:Trace";
+    bool sort = true;
+
+    static struct option long_options[] = {
+        {"output", required_argument, 0, 'o'},
+        {"filter", required_argument, 0, 'f'},
+        {"unsorted", no_argument, 0, 'u'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0},
+    };
+
+    while (optind < argc) {
+        int arg = getopt_long(argc, argv, "o:f:uh", long_options, &option_index);
+        if (arg != -1) {
+            switch (static_cast<char>(arg)) {
+            case 'o':
+                output_path.assign(optarg);
+                break;
+            case 'f':
+                filter_string.assign(optarg);
+                break;
+            case 'u':
+                sort = false;
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            }
+        } else {
+            break;
+        }
+    }
+
+    if (optind + 1 != argc) {
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    const std::string input_path = argv[optind];
+
+    Log::BinaryLog::Reader reader;
+    if (!reader.Open(input_path)) {
+        std::cerr << "Failed to read binary log file " << input_path << "\n";
+        return -1;
+    }
+
+    Log::Filter filter;
+    filter.ParseFilterString(filter_string);
+    std::vector<Log::Entry> entries;
+    Log::Entry entry;
+    while (reader.ReadEntry(entry)) {
+        if (filter.CheckMessage(entry.log_class, entry.log_level)) {
+            entries.push_back(std::move(entry));
+        }
+    }
+    if (sort) {
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const Log::Entry& a, const Log::Entry& b) {
+                             return a.timestamp < b.timestamp;
+                         });
+    }
+
+    FileUtil::IOFile output_file;
+    if (!output_path.empty()) {
+        output_file = FileUtil::IOFile(output_path, "w");
+        if (!output_file.IsOpen()) {
+            std::cerr << "Failed to open output file " << output_path << "\n";
+            return -1;
+        }
+    }
+    for (const auto& message_entry : entries) {
+        const std::string line = Log::FormatLogMessage(message_entry).append(1, '\n');
+        if (output_file.IsOpen()) {
+            output_file.WriteString(line);
+        } else {
+            std::cout << line;
+        }
+    }
+
+    if (reader.NumDroppedMessages() != 0) {
+        std::cerr << reader.NumDroppedMessages()
+                  << " messages were dropped while logging, as a thread logged faster than they "
+                     "were written\n";
+    }
+    return 0;
+}
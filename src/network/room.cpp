@@ -4,16 +4,19 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cstring>
 #include <iomanip>
 #include <mutex>
 #include <random>
 #include <regex>
 #include <sstream>
 #include <thread>
+#include <unordered_map>
 #include "common/logging/log.h"
 #include "enet/enet.h"
 #include "network/packet.h"
 #include "network/room.h"
+#include "network/room_event_loop.h"
 #include "network/verify_user.h"
 
 namespace Network {
@@ -48,9 +51,24 @@ public:
     mutable std::mutex member_mutex; ///< Mutex for locking the members list
     /// This should be a std::shared_mutex as soon as C++17 is supported
 
-    UsernameBanList username_ban_list; ///< List of banned usernames
-    IPBanList ip_ban_list;             ///< List of banned IP addresses
-    mutable std::mutex ban_list_mutex; ///< Mutex for the ban lists
+    struct MacAddressHash {
+        std::size_t operator()(const MacAddress& address) const {
+            u64 value = 0;
+            std::memcpy(&value, address.data(), address.size());
+            return std::hash<u64>{}(value);
+        }
+    };
+    /// Peers of the members by MAC address, for forwarding WiFi packets. Locked by member_mutex.
+    std::unordered_map<MacAddress, ENetPeer*, MacAddressHash> peers_by_mac;
+
+    std::shared_ptr<SharedBanList> ban_lists; ///< Ban lists, possibly shared with other rooms
+
+    RoomEventLoop* event_loop = nullptr; ///< Event loop servicing this room, if any
+
+    std::atomic<u64> packets_received{0};  ///< Number of packets received from members
+    std::atomic<u64> bytes_received{0};    ///< Size of the packets received from members
+    std::atomic<u64> packets_forwarded{0}; ///< Number of WiFi packets forwarded to members
+    std::atomic<u64> bytes_forwarded{0};   ///< Size of the WiFi packets forwarded to members
 
     RoomImpl()
         : NintendoOUI{0x00, 0x1F, 0x32, 0x00, 0x00, 0x00}, random_gen(std::random_device()()) {}
@@ -65,6 +83,12 @@ public:
     void ServerLoop();
     void StartLoop();
 
+    /**
+     * Handles the events that have arrived, then sends the packets they caused.
+     * @param timeout_ms Time to wait for the first event
+     */
+    void ServiceEvents(u32 timeout_ms);
+
     /**
      * Parses and answers a room join request from a client.
      * Validates the uniqueness of the username and assigns the MAC address
@@ -223,7 +247,8 @@ public:
     MacAddress GenerateMacAddress();
 
     /**
-     * Broadcasts this packet to all members except the sender.
+     * Forwards this packet to the member with its destination MAC address, or to all members
+     * except the sender if it is a broadcast. The received ENet packet is sent as is.
      * @param event The ENet event containing the data
      */
     void HandleWifiPacket(const ENetEvent* event);
@@ -250,50 +275,65 @@ public:
 // RoomImpl
 void Room::RoomImpl::ServerLoop() {
     while (state != State::Closed) {
-        ENetEvent event;
-        if (enet_host_service(server, &event, 50) > 0) {
-            switch (event.type) {
-            case ENET_EVENT_TYPE_RECEIVE:
-                switch (event.packet->data[0]) {
-                case IdJoinRequest:
-                    HandleJoinRequest(&event);
-                    break;
-                case IdSetGameInfo:
-                    HandleGameNamePacket(&event);
-                    break;
-                case IdWifiPacket:
-                    HandleWifiPacket(&event);
-                    break;
-                case IdChatMessage:
-                    HandleChatPacket(&event);
-                    break;
-                // Moderation
-                case IdModKick:
-                    HandleModKickPacket(&event);
-                    break;
-                case IdModBan:
-                    HandleModBanPacket(&event);
-                    break;
-                case IdModUnban:
-                    HandleModUnbanPacket(&event);
-                    break;
-                case IdModGetBanList:
-                    HandleModGetBanListPacket(&event);
-                    break;
-                }
-                enet_packet_destroy(event.packet);
+        ServiceEvents(50);
+    }
+    // Close the connection to all members:
+    SendCloseMessage();
+}
+
+void Room::RoomImpl::ServiceEvents(u32 timeout_ms) {
+    ENetEvent event;
+    if (enet_host_service(server, &event, timeout_ms) <= 0) {
+        return;
+    }
+    // Handle every event that has already arrived before sending anything, so that packets
+    // forwarded to the same member are sent together
+    do {
+        switch (event.type) {
+        case ENET_EVENT_TYPE_RECEIVE:
+            ++packets_received;
+            bytes_received += event.packet->dataLength;
+            switch (event.packet->data[0]) {
+            case IdJoinRequest:
+                HandleJoinRequest(&event);
+                break;
+            case IdSetGameInfo:
+                HandleGameNamePacket(&event);
+                break;
+            case IdWifiPacket:
+                HandleWifiPacket(&event);
+                break;
+            case IdChatMessage:
+                HandleChatPacket(&event);
                 break;
-            case ENET_EVENT_TYPE_DISCONNECT:
-                HandleClientDisconnection(event.peer);
+            // Moderation
+            case IdModKick:
+                HandleModKickPacket(&event);
                 break;
-            case ENET_EVENT_TYPE_NONE:
-            case ENET_EVENT_TYPE_CONNECT:
+            case IdModBan:
+                HandleModBanPacket(&event);
                 break;
+            case IdModUnban:
+                HandleModUnbanPacket(&event);
+                break;
+            case IdModGetBanList:
+                HandleModGetBanListPacket(&event);
+                break;
+            }
+            // Forwarded packets are freed by ENet once they have been sent
+            if (event.packet->referenceCount == 0) {
+                enet_packet_destroy(event.packet);
             }
+            break;
+        case ENET_EVENT_TYPE_DISCONNECT:
+            HandleClientDisconnection(event.peer);
+            break;
+        case ENET_EVENT_TYPE_NONE:
+        case ENET_EVENT_TYPE_CONNECT:
+            break;
         }
-    }
-    // Close the connection to all members:
-    SendCloseMessage();
+    } while (enet_host_check_events(server, &event) > 0);
+    enet_host_flush(server);
 }
 
 void Room::RoomImpl::StartLoop() {
@@ -376,7 +416,9 @@ void Room::RoomImpl::HandleJoinRequest(const ENetEvent* event) {
 
     std::string ip;
     {
-        std::lock_guard lock(ban_list_mutex);
+        std::lock_guard lock(ban_lists->mutex);
+        auto& username_ban_list = ban_lists->username_ban_list;
+        auto& ip_ban_list = ban_lists->ip_ban_list;
 
         // Check username ban
         if (!member.user_data.username.empty() &&
@@ -403,6 +445,7 @@ void Room::RoomImpl::HandleJoinRequest(const ENetEvent* event) {
 
     {
         std::lock_guard lock(member_mutex);
+        peers_by_mac[member.mac_address] = member.peer;
         members.push_back(std::move(member));
     }
 
@@ -449,6 +492,7 @@ void Room::RoomImpl::HandleModKickPacket(const ENetEvent* event) {
         ip = ip_raw;
 
         enet_peer_disconnect(target_member->peer, 0);
+        peers_by_mac.erase(target_member->mac_address);
         members.erase(target_member);
     }
 
@@ -492,11 +536,14 @@ void Room::RoomImpl::HandleModBanPacket(const ENetEvent* event) {
         ip = ip_raw;
 
         enet_peer_disconnect(target_member->peer, 0);
+        peers_by_mac.erase(target_member->mac_address);
         members.erase(target_member);
     }
 
     {
-        std::lock_guard lock(ban_list_mutex);
+        std::lock_guard lock(ban_lists->mutex);
+        auto& username_ban_list = ban_lists->username_ban_list;
+        auto& ip_ban_list = ban_lists->ip_ban_list;
 
         if (!username.empty()) {
             // Ban the forum username
@@ -533,7 +580,9 @@ void Room::RoomImpl::HandleModUnbanPacket(const ENetEvent* event) {
 
     bool unbanned = false;
     {
-        std::lock_guard lock(ban_list_mutex);
+        std::lock_guard lock(ban_lists->mutex);
+        auto& username_ban_list = ban_lists->username_ban_list;
+        auto& ip_ban_list = ban_lists->ip_ban_list;
 
         auto it = std::find(username_ban_list.begin(), username_ban_list.end(), address);
         if (it != username_ban_list.end()) {
@@ -579,8 +628,7 @@ bool Room::RoomImpl::IsValidNickname(const std::string& nickname) const {
 bool Room::RoomImpl::IsValidMacAddress(const MacAddress& address) const {
     // A MAC address is valid if it is not already taken by anybody else in the room.
     std::lock_guard lock(member_mutex);
-    return std::all_of(members.begin(), members.end(),
-                       [&address](const auto& member) { return member.mac_address != address; });
+    return peers_by_mac.count(address) == 0;
 }
 
 bool Room::RoomImpl::IsValidConsoleId(const std::string& console_id_hash) const {
@@ -737,7 +785,9 @@ void Room::RoomImpl::SendModBanListResponse(ENetPeer* client) {
     Packet packet;
     packet << static_cast<u8>(IdModBanListResponse);
     {
-        std::lock_guard lock(ban_list_mutex);
+        std::lock_guard lock(ban_lists->mutex);
+        auto& username_ban_list = ban_lists->username_ban_list;
+        auto& ip_ban_list = ban_lists->ip_ban_list;
         packet << username_ban_list;
         packet << ip_ban_list;
     }
@@ -847,51 +897,43 @@ MacAddress Room::RoomImpl::GenerateMacAddress() {
 }
 
 void Room::RoomImpl::HandleWifiPacket(const ENetEvent* event) {
-    Packet in_packet;
-    in_packet.Append(event->packet->data, event->packet->dataLength);
-    in_packet.IgnoreBytes(sizeof(u8));         // Message type
-    in_packet.IgnoreBytes(sizeof(u8));         // WifiPacket Type
-    in_packet.IgnoreBytes(sizeof(u8));         // WifiPacket Channel
-    in_packet.IgnoreBytes(sizeof(MacAddress)); // WifiPacket Transmitter Address
+    // The destination address follows the message type, WifiPacket type, channel and transmitter
+    // address. It is read in place, as the packet itself is forwarded without being copied.
+    constexpr std::size_t destination_offset = 3 * sizeof(u8) + sizeof(MacAddress);
+    ENetPacket* enet_packet = event->packet;
+    if (enet_packet->dataLength < destination_offset + sizeof(MacAddress)) {
+        LOG_ERROR(Network, "Received truncated WifiPacket");
+        return;
+    }
     MacAddress destination_address;
-    in_packet >> destination_address;
-
-    Packet out_packet;
-    out_packet.Append(event->packet->data, event->packet->dataLength);
-    ENetPacket* enet_packet = enet_packet_create(out_packet.GetData(), out_packet.GetDataSize(),
-                                                 ENET_PACKET_FLAG_RELIABLE);
+    std::memcpy(destination_address.data(), enet_packet->data + destination_offset,
+                sizeof(MacAddress));
+    enet_packet->flags |= ENET_PACKET_FLAG_RELIABLE;
 
+    // The packets are sent once all received events have been handled by the server loop
+    std::lock_guard lock(member_mutex);
     if (destination_address == BroadcastMac) { // Send the data to everyone except the sender
-        std::lock_guard lock(member_mutex);
-        bool sent_packet = false;
         for (const auto& member : members) {
-            if (member.peer != event->peer) {
-                sent_packet = true;
-                enet_peer_send(member.peer, 0, enet_packet);
+            if (member.peer != event->peer && enet_peer_send(member.peer, 0, enet_packet) == 0) {
+                ++packets_forwarded;
+                bytes_forwarded += enet_packet->dataLength;
             }
         }
-
-        if (!sent_packet) {
-            enet_packet_destroy(enet_packet);
-        }
     } else { // Send the data only to the destination client
-        std::lock_guard lock(member_mutex);
-        auto member = std::find_if(members.begin(), members.end(),
-                                   [destination_address](const Member& member) -> bool {
-                                       return member.mac_address == destination_address;
-                                   });
-        if (member != members.end()) {
-            enet_peer_send(member->peer, 0, enet_packet);
+        const auto peer = peers_by_mac.find(destination_address);
+        if (peer != peers_by_mac.end()) {
+            if (enet_peer_send(peer->second, 0, enet_packet) == 0) {
+                ++packets_forwarded;
+                bytes_forwarded += enet_packet->dataLength;
+            }
         } else {
             LOG_ERROR(Network,
                       "Attempting to send to unknown MAC address: "
                       "{:02X}:{:02X}:{:02X}:{:02X}:{:02X}:{:02X}",
                       destination_address[0], destination_address[1], destination_address[2],
                       destination_address[3], destination_address[4], destination_address[5]);
-            enet_packet_destroy(enet_packet);
         }
     }
-    enet_host_flush(server);
 }
 
 void Room::RoomImpl::HandleChatPacket(const ENetEvent* event) {
@@ -993,6 +1035,7 @@ void Room::RoomImpl::HandleClientDisconnection(ENetPeer* client) {
             enet_address_get_host_ip(&member->peer->address, ip_raw, sizeof(ip_raw) - 1);
             ip = ip_raw;
 
+            peers_by_mac.erase(member->mac_address);
             members.erase(member);
         }
     }
@@ -1014,7 +1057,8 @@ bool Room::Create(const std::string& name, const std::string& description,
                   const u32 max_connections, const std::string& host_username,
                   const std::string& preferred_game, u64 preferred_game_id,
                   std::unique_ptr<VerifyUser::Backend> verify_backend,
-                  const Room::BanList& ban_list, bool enable_citra_mods) {
+                  const Room::BanList& ban_list, bool enable_citra_mods,
+                  RoomEventLoop* event_loop, std::shared_ptr<SharedBanList> shared_ban_list) {
     ENetAddress address;
     address.host = ENET_HOST_ANY;
     if (!server_address.empty()) {
@@ -1040,10 +1084,20 @@ bool Room::Create(const std::string& name, const std::string& description,
     room_impl->room_information.enable_citra_mods = enable_citra_mods;
     room_impl->password = password;
     room_impl->verify_backend = std::move(verify_backend);
-    room_impl->username_ban_list = ban_list.first;
-    room_impl->ip_ban_list = ban_list.second;
+    if (shared_ban_list) {
+        room_impl->ban_lists = std::move(shared_ban_list);
+    } else {
+        room_impl->ban_lists = std::make_shared<SharedBanList>();
+        room_impl->ban_lists->username_ban_list = ban_list.first;
+        room_impl->ban_lists->ip_ban_list = ban_list.second;
+    }
 
-    room_impl->StartLoop();
+    room_impl->event_loop = event_loop;
+    if (event_loop) {
+        event_loop->AddRoom(this);
+    } else {
+        room_impl->StartLoop();
+    }
     return true;
 }
 
@@ -1061,8 +1115,8 @@ std::string Room::GetVerifyUID() const {
 }
 
 Room::BanList Room::GetBanList() const {
-    std::lock_guard lock(room_impl->ban_list_mutex);
-    return {room_impl->username_ban_list, room_impl->ip_ban_list};
+    std::lock_guard lock(room_impl->ban_lists->mutex);
+    return {room_impl->ban_lists->username_ban_list, room_impl->ban_lists->ip_ban_list};
 }
 
 std::vector<Room::Member> Room::GetRoomMemberList() const {
@@ -1090,10 +1144,46 @@ void Room::SetVerifyUID(const std::string& uid) {
     room_impl->verify_UID = uid;
 }
 
+Room::Statistics Room::GetStatistics() const {
+    Statistics statistics;
+    {
+        std::lock_guard lock(room_impl->member_mutex);
+        statistics.num_members = static_cast<u32>(room_impl->members.size());
+    }
+    statistics.packets_received = room_impl->packets_received;
+    statistics.bytes_received = room_impl->bytes_received;
+    statistics.packets_forwarded = room_impl->packets_forwarded;
+    statistics.bytes_forwarded = room_impl->bytes_forwarded;
+    return statistics;
+}
+
+bool Room::WaitForEvents(const std::vector<Room*>& rooms, std::chrono::milliseconds timeout) {
+    ENetSocketSet read_set;
+    ENET_SOCKETSET_EMPTY(read_set);
+    ENetSocket max_socket = 0;
+    for (const Room* room : rooms) {
+        const ENetSocket socket = room->room_impl->server->socket;
+        ENET_SOCKETSET_ADD(read_set, socket);
+        max_socket = std::max(max_socket, socket);
+    }
+    return enet_socketset_select(max_socket, &read_set, nullptr,
+                                 static_cast<enet_uint32>(timeout.count())) >= 0;
+}
+
+void Room::ServiceEvents() {
+    room_impl->ServiceEvents(0);
+}
+
 void Room::Destroy() {
     room_impl->state = State::Closed;
-    room_impl->room_thread->join();
-    room_impl->room_thread.reset();
+    if (room_impl->event_loop) {
+        room_impl->event_loop->RemoveRoom(this);
+        room_impl->event_loop = nullptr;
+        room_impl->SendCloseMessage();
+    } else {
+        room_impl->room_thread->join();
+        room_impl->room_thread.reset();
+    }
 
     if (room_impl->server) {
         enet_host_destroy(room_impl->server);
@@ -1103,6 +1193,7 @@ void Room::Destroy() {
     {
         std::lock_guard lock(room_impl->member_mutex);
         room_impl->members.clear();
+        room_impl->peers_by_mac.clear();
     }
     room_impl->room_information.member_slots = 0;
     room_impl->room_information.name.clear();
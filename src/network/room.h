@@ -5,7 +5,9 @@
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include "common/common_types.h"
@@ -87,6 +89,8 @@ enum StatusMessageTypes : u8 {
     IdAddressUnbanned, ///< A username / ip address is unbanned from the room
 };
 
+class RoomEventLoop;
+
 /// This is what a server [person creating a server] would use.
 class Room final {
 public:
@@ -137,9 +141,28 @@ public:
 
     using BanList = std::pair<UsernameBanList, IPBanList>;
 
+    /// Ban lists that several rooms hosted by the same process can share
+    struct SharedBanList {
+        UsernameBanList username_ban_list;
+        IPBanList ip_ban_list;
+        mutable std::mutex mutex; ///< Mutex for the ban lists
+    };
+
+    /// Traffic of the room since it was created
+    struct Statistics {
+        u32 num_members;       ///< Number of members currently in the room
+        u64 packets_received;  ///< Number of packets received from members
+        u64 bytes_received;    ///< Size of the packets received from members
+        u64 packets_forwarded; ///< Number of WiFi packets forwarded to members
+        u64 bytes_forwarded;   ///< Size of the WiFi packets forwarded to members
+    };
+
     /**
      * Creates the socket for this room. Will bind to default address if
      * server is empty string.
+     * @param event_loop Event loop to service the room on. The room runs its own thread if null.
+     * @param shared_ban_list Ban lists to share with other rooms. The room uses its own lists
+     *                        initialized from ban_list if null.
      */
     bool Create(const std::string& name, const std::string& description = "",
                 const std::string& server = "", u16 server_port = DefaultRoomPort,
@@ -148,7 +171,9 @@ public:
                 const std::string& host_username = "", const std::string& preferred_game = "",
                 u64 preferred_game_id = 0,
                 std::unique_ptr<VerifyUser::Backend> verify_backend = nullptr,
-                const BanList& ban_list = {}, bool enable_citra_mods = false);
+                const BanList& ban_list = {}, bool enable_citra_mods = false,
+                RoomEventLoop* event_loop = nullptr,
+                std::shared_ptr<SharedBanList> shared_ban_list = nullptr);
 
     /**
      * Sets the verification GUID of the room.
@@ -160,12 +185,28 @@ public:
      */
     BanList GetBanList() const;
 
+    /**
+     * Gets the traffic of the room since it was created.
+     */
+    Statistics GetStatistics() const;
+
     /**
      * Destroys the socket
      */
     void Destroy();
 
 private:
+    friend class RoomEventLoop;
+
+    /**
+     * Waits until any of the rooms has received data.
+     * @return False if the wait failed
+     */
+    static bool WaitForEvents(const std::vector<Room*>& rooms, std::chrono::milliseconds timeout);
+
+    /// Handles the events that have arrived on the room without waiting
+    void ServiceEvents();
+
     class RoomImpl;
     std::unique_ptr<RoomImpl> room_impl;
 };
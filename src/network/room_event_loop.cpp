@@ -0,0 +1,78 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include "common/logging/log.h"
+#include "common/thread.h"
+#include "network/room.h"
+#include "network/room_event_loop.h"
+
+namespace Network {
+
+RoomEventLoop::RoomEventLoop() : thread(&RoomEventLoop::ThreadLoop, this) {}
+
+RoomEventLoop::~RoomEventLoop() {
+    {
+        std::lock_guard lock(rooms_mutex);
+        running = false;
+    }
+    rooms_cv.notify_all();
+    thread.join();
+}
+
+void RoomEventLoop::AddRoom(Room* room) {
+    {
+        std::lock_guard lock(rooms_mutex);
+        rooms.push_back(room);
+    }
+    rooms_cv.notify_all();
+}
+
+void RoomEventLoop::RemoveRoom(Room* room) {
+    std::unique_lock lock(rooms_mutex);
+    rooms.erase(std::remove(rooms.begin(), rooms.end(), room), rooms.end());
+    if (std::this_thread::get_id() != thread.get_id() && servicing) {
+        // The loop keeps servicing while other rooms remain, so wait for the current pass to end
+        const u64 pass = num_passes;
+        rooms_cv.wait(lock, [this, pass] { return num_passes != pass; });
+    }
+}
+
+std::size_t RoomEventLoop::NumRooms() const {
+    std::lock_guard lock(rooms_mutex);
+    return rooms.size();
+}
+
+void RoomEventLoop::ThreadLoop() {
+    Common::SetCurrentThreadName("RoomEventLoop");
+
+    std::vector<Room*> active_rooms;
+    std::unique_lock lock(rooms_mutex);
+    while (true) {
+        rooms_cv.wait(lock, [this] { return !running || !rooms.empty(); });
+        if (!running) {
+            return;
+        }
+        // Rooms can be added meanwhile, and removing them waits for this iteration
+        active_rooms = rooms;
+        servicing = true;
+        lock.unlock();
+
+        // Also wakes up regularly for the timeouts and resends of ENet
+        if (!Room::WaitForEvents(active_rooms, std::chrono::milliseconds(50))) {
+            LOG_ERROR(Network, "Failed to wait for the sockets of the rooms");
+        }
+        for (Room* room : active_rooms) {
+            room->ServiceEvents();
+        }
+
+        lock.lock();
+        servicing = false;
+        ++num_passes;
+        rooms_cv.notify_all();
+    }
+}
+
+} // namespace Network
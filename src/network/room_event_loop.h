@@ -0,0 +1,53 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Network {
+
+class Room;
+
+/**
+ * Services several rooms on one thread. It waits on the sockets of all its rooms at once, so a
+ * process hosting many rooms needs only as many threads as it has event loops.
+ */
+class RoomEventLoop final {
+public:
+    RoomEventLoop();
+    ~RoomEventLoop();
+
+    RoomEventLoop(const RoomEventLoop&) = delete;
+    RoomEventLoop& operator=(const RoomEventLoop&) = delete;
+
+    /// Starts servicing a created room. Called by Room::Create.
+    void AddRoom(Room* room);
+
+    /// Stops servicing a room, waiting until the loop no longer uses it. Called by Room::Destroy.
+    void RemoveRoom(Room* room);
+
+    /// Gets the number of rooms serviced by the loop.
+    std::size_t NumRooms() const;
+
+private:
+    void ThreadLoop();
+
+    mutable std::mutex rooms_mutex;
+    std::condition_variable rooms_cv;
+    std::vector<Room*> rooms;
+    /// Set while the loop uses a copy of the rooms, so that they are not removed meanwhile
+    bool servicing = false;
+    /// Number of finished passes over the rooms, so that removing a room can wait for the next one
+    u64 num_passes = 0;
+    bool running = true;
+    std::thread thread;
+};
+
+} // namespace Network
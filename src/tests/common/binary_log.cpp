@@ -0,0 +1,87 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "common/logging/backend.h"
+#include "common/logging/binary_log.h"
+#include "common/logging/log.h"
+
+namespace {
+
+struct CustomFormatted {
+    int value;
+};
+
+} // Anonymous namespace
+
+template <>
+struct fmt::formatter<CustomFormatted> : fmt::formatter<int> {
+    template <typename FormatContext>
+    auto format(const CustomFormatted& custom, FormatContext& ctx) {
+        return fmt::formatter<int>::format(custom.value, ctx);
+    }
+};
+
+TEST_CASE("Binary log messages are formatted when decoded", "[common]") {
+    const std::string path = "binary_log_test.bin";
+    REQUIRE(Log::BinaryLog::Start(path));
+    REQUIRE(Log::BinaryLog::IsActive());
+    REQUIRE_FALSE(Log::BinaryLog::Start(path));
+
+    LOG_INFO(Common, "{} {:#x} {} {:.2f} {} {} {}", -1, 255u, true, 1.5, 'c', "literal",
+             std::string("string"));
+    LOG_WARNING(Common, "custom {}", CustomFormatted{42});
+    std::thread([] { LOG_ERROR(Core, "from thread {}", 1); }).join();
+    LOG_INFO(Common, "{}{}{}{}{}{}{}{}{}{}{}{}{}{}{}{}", 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+             13, 14, 15);
+    Log::BinaryLog::Stop();
+    REQUIRE_FALSE(Log::BinaryLog::IsActive());
+
+    Log::BinaryLog::Reader reader;
+    REQUIRE(reader.Open(path));
+    std::vector<Log::Entry> entries;
+    Log::Entry entry;
+    while (reader.ReadEntry(entry)) {
+        entries.push_back(std::move(entry));
+    }
+    FileUtil::Delete(path);
+    // The buffers of the threads are written one after another
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const auto& a, const auto& b) { return a.timestamp < b.timestamp; });
+
+    REQUIRE(entries.size() == 5);
+    REQUIRE(entries[0].message == "-1 0xff true 1.50 c literal string");
+    REQUIRE(entries[0].log_class == Log::Class::Common);
+    REQUIRE(entries[0].log_level == Log::Level::Info);
+    REQUIRE(entries[1].message == "custom 42");
+    REQUIRE(entries[1].log_level == Log::Level::Warning);
+    REQUIRE(entries[2].message == "from thread 1");
+    REQUIRE(entries[2].log_class == Log::Class::Core);
+    // Messages with too many arguments for a record are formatted right away, with a warning
+    const auto FindEntry = [&entries](Log::Class log_class) {
+        return std::find_if(entries.begin() + 3, entries.end(),
+                            [log_class](const auto& e) { return e.log_class == log_class; });
+    };
+    const auto message = FindEntry(Log::Class::Common);
+    REQUIRE(message != entries.end());
+    REQUIRE(message->message == "0123456789101112131415");
+    const auto warning = FindEntry(Log::Class::Log);
+    REQUIRE(warning != entries.end());
+    REQUIRE(warning->log_level == Log::Level::Warning);
+    REQUIRE(reader.NumDroppedMessages() == 0);
+}
+
+TEST_CASE("Binary log reader rejects other files", "[common]") {
+    const std::string path = "binary_log_test.txt";
+    FileUtil::WriteStringToFile(true, path, "not a binary log");
+    Log::BinaryLog::Reader reader;
+    REQUIRE_FALSE(reader.Open(path));
+    FileUtil::Delete(path);
+}
@@ -0,0 +1,49 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/histogram.h"
+
+TEST_CASE("Histogram counts small values exactly", "[common]") {
+    Common::Histogram histogram;
+    for (u64 value = 1; value <= 100; ++value) {
+        histogram.Record(value);
+    }
+    REQUIRE(histogram.Count() == 100);
+    REQUIRE(histogram.Max() == 100);
+    REQUIRE(histogram.Mean() == Approx(50.5));
+    REQUIRE(histogram.Percentile(0.5) == 50);
+    REQUIRE(histogram.Percentile(0.99) == 99);
+    REQUIRE(histogram.Percentile(1.0) == 100);
+    REQUIRE(histogram.CountAbove(90) == 10);
+
+    histogram.Reset();
+    REQUIRE(histogram.Count() == 0);
+    REQUIRE(histogram.Percentile(0.5) == 0);
+}
+
+TEST_CASE("Histogram percentiles stay within its precision", "[common]") {
+    Common::Histogram histogram;
+    std::mt19937_64 rng(1);
+    std::vector<u64> values(10000);
+    for (u64& value : values) {
+        // Spread over many powers of two
+        value = rng() >> (rng() % 60);
+        histogram.Record(value);
+    }
+    std::sort(values.begin(), values.end());
+
+    for (const double fraction : {0.1, 0.5, 0.9, 0.95, 0.99, 0.999}) {
+        const u64 expected = values[static_cast<std::size_t>(fraction * values.size()) - 1];
+        const u64 percentile = histogram.Percentile(fraction);
+        INFO("fraction " << fraction);
+        REQUIRE(percentile <= expected);
+        REQUIRE(percentile >= expected - expected / 64);
+    }
+    REQUIRE(histogram.Percentile(1.0) == values.back());
+    REQUIRE(histogram.Max() == values.back());
+}
@@ -0,0 +1,225 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/arm/idle_loop.h"
+#include "core/memory.h"
+
+namespace Core {
+
+namespace {
+
+constexpr VAddr CODE_ADDRESS = 0x00100000;
+
+// Condition codes
+constexpr u32 EQ = 0x0;
+constexpr u32 NE = 0x1;
+constexpr u32 CC = 0x3;
+constexpr u32 AL = 0xE;
+
+/// A permanently undefined instruction, which is never part of an idle loop
+constexpr u32 UDF = 0xE7F000F0;
+
+/// Encodes a B or BL at index `from` of the code to index `to`
+constexpr u32 Branch(u32 cond, std::size_t from, std::size_t to, bool link = false) {
+    const u32 offset = static_cast<u32>(static_cast<s32>(to) - static_cast<s32>(from) - 2);
+    return cond << 28 | 0x0A000000 | (link ? 1 << 24 : 0) | (offset & 0x00FFFFFF);
+}
+
+struct IdleLoopCase {
+    const char* name;
+    std::vector<u32> code;
+    /// Index of the instruction the analysis starts from
+    std::size_t pc;
+    /// Indices of the first instruction and of the branch back of the loop, if it is idle
+    std::optional<std::pair<std::size_t, std::size_t>> loop;
+};
+
+const std::vector<IdleLoopCase> IdleLoopCases{
+    {"polling a word until it changes",
+     {
+         0xE5910000,       // ldr r0, [r1]
+         0xE3500000,       // cmp r0, #0
+         Branch(EQ, 2, 0), // beq 0
+     },
+     0,
+     std::pair{0, 2}},
+    {"starting from the middle of the loop",
+     {
+         0xE5910000,       // ldr r0, [r1]
+         0xE3500000,       // cmp r0, #0
+         Branch(EQ, 2, 0), // beq 0
+     },
+     1,
+     std::pair{0, 2}},
+    {"polling a halfword with a mask",
+     {
+         0xE1D100B0,       // ldrh r0, [r1]
+         0xE3100004,       // tst r0, #4
+         Branch(NE, 2, 0), // bne 0
+     },
+     0,
+     std::pair{0, 2}},
+    {"waiting for the system tick",
+     {
+         0xEF000028,       // svc GetSystemTick
+         0xE0402004,       // sub r2, r0, r4
+         0xE1520005,       // cmp r2, r5
+         Branch(CC, 3, 0), // bcc 0
+     },
+     0,
+     std::pair{0, 3}},
+    {"leaving through a conditional branch",
+     {
+         0xE5910000,       // ldr r0, [r1]
+         0xE3500001,       // cmp r0, #1
+         Branch(EQ, 2, 4), // beq 4
+         Branch(AL, 3, 0), // b 0
+         UDF,
+     },
+     0,
+     std::pair{0, 3}},
+    {"the longest loop that is considered",
+     {
+         0xE5910000, 0xE5910000, 0xE5910000, 0xE5910000, 0xE5910000, // ldr r0, [r1]
+         0xE5910000, 0xE5910000, 0xE5910000, 0xE5910000, 0xE5910000, //
+         0xE5910000, 0xE5910000, 0xE5910000, 0xE5910000, 0xE5910000, //
+         Branch(AL, 15, 0),                                          // b 0
+     },
+     0,
+     std::pair{0, 15}},
+    {"a loop longer than that",
+     {
+         0xE5910000, 0xE5910000, 0xE5910000, 0xE5910000, 0xE5910000, // ldr r0, [r1]
+         0xE5910000, 0xE5910000, 0xE5910000, 0xE5910000, 0xE5910000, //
+         0xE5910000, 0xE5910000, 0xE5910000, 0xE5910000, 0xE5910000, //
+         0xE5910000,                                                 //
+         Branch(AL, 16, 0),                                          // b 0
+     },
+     0,
+     std::nullopt},
+    {"a counter carried between iterations",
+     {
+         0xE2500001,       // subs r0, r0, #1
+         Branch(NE, 1, 0), // bne 0
+     },
+     0,
+     std::nullopt},
+    {"a flag carried between iterations",
+     {
+         0xE5910000,       // ldr r0, [r1]
+         0xE2A02000,       // adc r2, r0, #0
+         0xE3520000,       // cmp r2, #0
+         Branch(EQ, 3, 0), // beq 0
+     },
+     0,
+     std::nullopt},
+    {"a register that is only written conditionally",
+     {
+         0xE5910000,       // ldr r0, [r1]
+         0xE3500000,       // cmp r0, #0
+         0x03A02001,       // moveq r2, #1
+         0xE3520000,       // cmp r2, #0
+         Branch(EQ, 4, 0), // beq 0
+     },
+     0,
+     std::nullopt},
+    {"a load with writeback",
+     {
+         0xE4910004,       // ldr r0, [r1], #4
+         0xE3500000,       // cmp r0, #0
+         Branch(EQ, 2, 0), // beq 0
+     },
+     0,
+     std::nullopt},
+    {"a store",
+     {
+         0xE5810000,       // str r0, [r1]
+         0xE5912000,       // ldr r2, [r1]
+         0xE3520000,       // cmp r2, #0
+         Branch(EQ, 3, 0), // beq 0
+     },
+     0,
+     std::nullopt},
+    {"a function call",
+     {
+         Branch(AL, 0, 8, true), // bl 8
+         0xE3500000,             // cmp r0, #0
+         Branch(EQ, 2, 0),       // beq 0
+     },
+     0,
+     std::nullopt},
+    {"another SVC",
+     {
+         0xEF00000A,       // svc SleepThread
+         0xE3500000,       // cmp r0, #0
+         Branch(EQ, 2, 0), // beq 0
+     },
+     0,
+     std::nullopt},
+    {"a branch within the loop",
+     {
+         0xE5910000,       // ldr r0, [r1]
+         0xE3500000,       // cmp r0, #0
+         Branch(NE, 2, 4), // bne 4
+         0xE3A02000,       // mov r2, #0
+         Branch(AL, 4, 0), // b 0
+     },
+     0,
+     std::nullopt},
+    {"no branch back",
+     {
+         0xE5910000,       // ldr r0, [r1]
+         0xE3500000,       // cmp r0, #0
+         Branch(EQ, 2, 3), // beq 3
+         UDF,
+     },
+     0,
+     std::nullopt},
+};
+
+} // Anonymous namespace
+
+TEST_CASE("FindIdleLoop only accepts loops without side effects", "[core][arm]") {
+    // The page table holds a pointer per page, which is too much for the stack of some platforms
+    auto page_table = std::make_unique<Memory::PageTable>();
+    std::vector<u32> page(Memory::PAGE_SIZE / sizeof(u32));
+    page_table->GetPointerArray()[CODE_ADDRESS >> Memory::PAGE_BITS] =
+        reinterpret_cast<u8*>(page.data());
+
+    for (const IdleLoopCase& test : IdleLoopCases) {
+        INFO(test.name);
+        std::fill(page.begin(), page.end(), UDF);
+        std::copy(test.code.begin(), test.code.end(), page.begin());
+
+        const auto address = [](std::size_t index) {
+            return static_cast<VAddr>(CODE_ADDRESS + index * sizeof(u32));
+        };
+        const std::optional<IdleLoop> loop = FindIdleLoop(*page_table, address(test.pc));
+        REQUIRE(loop.has_value() == test.loop.has_value());
+        if (test.loop) {
+            REQUIRE(loop->start == address(test.loop->first));
+            REQUIRE(loop->end == address(test.loop->second));
+        }
+    }
+
+    SECTION("code that isn't mapped") {
+        const VAddr unmapped = CODE_ADDRESS + Memory::PAGE_SIZE;
+        REQUIRE_FALSE(FindIdleLoop(*page_table, unmapped).has_value());
+
+        // A loop that runs into the unmapped page
+        std::fill(page.begin(), page.end(), UDF);
+        page[page.size() - 1] = 0xE5910000; // ldr r0, [r1]
+        REQUIRE_FALSE(FindIdleLoop(*page_table, unmapped - sizeof(u32)).has_value());
+    }
+
+    page_table->GetPointerArray()[CODE_ADDRESS >> Memory::PAGE_BITS] = nullptr;
+}
+
+} // namespace Core
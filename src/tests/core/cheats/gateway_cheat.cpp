@@ -0,0 +1,224 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <chrono>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fmt/format.h>
+#include "common/memory_ref.h"
+#include "core/cheats/gateway_cheat.h"
+#include "core/memory.h"
+
+using Cheats::GatewayCheat;
+
+namespace {
+
+constexpr u32 REGION_SIZE = 0x10000;
+
+class CheatTestEnvironment final : public GatewayCheat::Environment {
+public:
+    CheatTestEnvironment() : backing(std::make_shared<BufferMem>(REGION_SIZE + sizeof(u32))) {
+        // Cheats can access any address through their offset, so the same region is mirrored
+        // over the whole address space. The extra word catches accesses that cross its end.
+        page_table = std::make_shared<Memory::PageTable>();
+        for (u64 base = 0; base < (u64{1} << 32); base += REGION_SIZE) {
+            memory.MapMemoryRegion(*page_table, static_cast<VAddr>(base), REGION_SIZE,
+                                   MemoryRef(backing));
+        }
+        memory.SetCurrentPageTable(page_table);
+    }
+
+    Memory::MemorySystem& Memory() override {
+        return memory;
+    }
+
+    void InvalidateCacheRange(VAddr address, std::size_t size) override {
+        invalidated.emplace_back(address, size);
+    }
+
+    u32 GetPadState() override {
+        return pad_state;
+    }
+
+    /// Fills the region with pseudo-random data, so that both paths start from the same state
+    void Fill(u32 seed) {
+        std::mt19937 rng(seed);
+        u8* data = backing->GetPtr();
+        for (std::size_t i = 0; i < backing->GetSize(); ++i) {
+            // Mostly small values, so that conditionals pass about as often as they fail
+            data[i] = static_cast<u8>(rng() % 4 == 0 ? rng() : rng() % 2);
+        }
+        invalidated.clear();
+    }
+
+    std::vector<u8> Contents() const {
+        const u8* data = backing->GetPtr();
+        return std::vector<u8>(data, data + backing->GetSize());
+    }
+
+    Memory::MemorySystem memory;
+    std::vector<std::pair<VAddr, std::size_t>> invalidated;
+    u32 pad_state = 0;
+
+private:
+    std::shared_ptr<BufferMem> backing;
+    std::shared_ptr<Memory::PageTable> page_table;
+};
+
+/**
+ * Generates a random cheat from all code types.
+ * @param with_loops Whether to generate loops. Cheats with loops never contain both a full
+ *                   terminator and conditionals, as those loop forever when a conditional fails.
+ */
+std::string MakeRandomCheat(std::mt19937& rng, std::size_t num_lines, bool with_loops) {
+    static constexpr std::array<u32, 28> types{
+        0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, 0xA, 0xB, 0xC, 0xD0,
+        0xD1, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xE,
+    };
+    const bool with_conditionals = !with_loops || rng() % 2 == 0;
+    const auto address = [&rng] { return rng() & 0x0FFFFFFF; };
+
+    std::string code;
+    for (std::size_t i = 0; i < num_lines; ++i) {
+        u32 type = types[rng() % types.size()];
+        const bool is_conditional = (type >= 0x3 && type <= 0xA) || type == 0xDD;
+        if ((type == 0xC && !with_loops) || (is_conditional && !with_conditionals) ||
+            (type == 0xD2 && with_loops && with_conditionals)) {
+            type = 0x0;
+        }
+
+        u32 first = type < 0x10 ? type << 28 | address() : type << 24;
+        u32 value = rng() % 4 == 0 ? rng() : rng() % 2;
+        switch (type) {
+        case 0x7:
+        case 0x8:
+        case 0x9:
+        case 0xA:
+            // Random mask in the upper half
+            value |= rng() << 16;
+            break;
+        case 0xC:
+            value = rng() % 3;
+            break;
+        case 0xD6:
+        case 0xD7:
+        case 0xD8:
+        case 0xD9:
+        case 0xDA:
+        case 0xDB:
+            value = address();
+            break;
+        case 0xDD:
+            value = rng() % 4;
+            break;
+        case 0xE:
+            value = std::min<u32>(rng() % 32, static_cast<u32>(num_lines - i - 1) * 8);
+            break;
+        }
+        if (type == 0xE) {
+            // Patch data lines are never run, so they can hold anything
+            code += fmt::format("{:08X} {:08X}\n", first, value);
+            for (u32 line = 0; line < (value + 7) / 8; ++line, ++i) {
+                code += fmt::format("{:08X} {:08X}\n", rng(), rng());
+            }
+            continue;
+        }
+        code += fmt::format("{:08X} {:08X}\n", first, value);
+    }
+    return code;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("GatewayCheat::Execute matches ExecuteLineByLine", "[core][cheats]") {
+    CheatTestEnvironment env;
+    std::mt19937 rng(1234);
+
+    for (int iteration = 0; iteration < 2000; ++iteration) {
+        const bool with_loops = rng() % 3 == 0;
+        const std::string code = MakeRandomCheat(rng, rng() % 48 + 1, with_loops);
+        const GatewayCheat cheat("test", code, "");
+        env.pad_state = rng() % 4;
+        INFO(code);
+
+        const u32 seed = rng();
+        env.Fill(seed);
+        cheat.ExecuteLineByLine(env);
+        const std::vector<u8> expected = env.Contents();
+        const auto expected_invalidated = env.invalidated;
+
+        env.Fill(seed);
+        cheat.Execute(env);
+        REQUIRE(env.Contents() == expected);
+        REQUIRE(env.invalidated == expected_invalidated);
+    }
+}
+
+TEST_CASE("GatewayCheat::Execute writes patches", "[core][cheats]") {
+    CheatTestEnvironment env;
+    env.Fill(0);
+    const std::vector<u8> before = env.Contents();
+
+    const GatewayCheat cheat("patch",
+                             fmt::format("D3000000 {:08X}\n"
+                                         "E0000010 0000000B\n"
+                                         "03020100 07060504\n"
+                                         "0B0A0908 FFFFFFFF\n"
+                                         "00000020 11223344\n",
+                                         Memory::HEAP_VADDR),
+                             "");
+    cheat.Execute(env);
+
+    const std::vector<u8> contents = env.Contents();
+    for (u8 i = 0; i < 0xB; ++i) {
+        REQUIRE(contents[0x10 + i] == i);
+    }
+    REQUIRE(contents[0x1B] == before[0x1B]);
+    // The last line is a write after the patch data
+    REQUIRE(env.memory.Read32(Memory::HEAP_VADDR + 0x20) == 0x11223344);
+}
+
+TEST_CASE("GatewayCheat::Execute benchmark", "[.benchmark][core][cheats]") {
+    CheatTestEnvironment env;
+    env.Fill(1);
+
+    // A typical cheat file: many short codes that each set an offset and write a few values,
+    // some of them behind button or value checks
+    std::mt19937 rng(1);
+    std::string code;
+    for (int i = 0; i < 100; ++i) {
+        code += fmt::format("D3000000 {:08X}\n", Memory::HEAP_VADDR + rng() % 0x1000 * 4);
+        if (i % 4 == 0) {
+            code += fmt::format("DD000000 {:08X}\n", rng() % 2);
+        } else if (i % 4 == 1) {
+            code += fmt::format("9{:07X} FF00{:04X}\n", rng() % 0x100 * 2, rng() % 0x100);
+        }
+        for (int write = 0; write < 4; ++write) {
+            code += fmt::format("{}{:07X} {:08X}\n", rng() % 3, rng() % 0x400, rng());
+        }
+        code += "D2000000 00000000\n";
+    }
+    const GatewayCheat cheat("benchmark", code, "");
+
+    const auto measure = [&env, &cheat](auto execute) {
+        constexpr int iterations = 1000;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            execute(cheat, env);
+        }
+        const std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return elapsed.count() / iterations;
+    };
+    const double line_by_line = measure(
+        [](const GatewayCheat& cheat, CheatTestEnvironment& env) { cheat.ExecuteLineByLine(env); });
+    const double compiled =
+        measure([](const GatewayCheat& cheat, CheatTestEnvironment& env) { cheat.Execute(env); });
+    WARN("line by line " << line_by_line << "us, compiled " << compiled << "us ("
+                         << line_by_line / compiled << "x)");
+}
@@ -0,0 +1,110 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "core/custom_tex_cache.h"
+#include "core/frontend/image_interface.h"
+
+namespace Core {
+
+namespace {
+
+constexpr u64 TEST_PROGRAM_ID = 0x000400000FF0C0DF;
+constexpr u32 TEXTURE_SIZE = 16;
+constexpr std::size_t TEXTURE_BYTES = TEXTURE_SIZE * TEXTURE_SIZE * 4;
+constexpr std::size_t NUM_TEXTURES = 4;
+
+/// Decodes every path into a texture whose pixels are derived from the path
+class FakeImageInterface final : public Frontend::ImageInterface {
+public:
+    bool DecodePNG(std::vector<u8>& dst, u32& width, u32& height,
+                   const std::string& path) override {
+        width = TEXTURE_SIZE;
+        height = TEXTURE_SIZE;
+        dst.resize(TEXTURE_BYTES);
+        u32 value = static_cast<u32>(std::hash<std::string>{}(path));
+        // Only half of the bytes vary, so that the textures compress
+        for (std::size_t i = 0; i < dst.size(); i += 2) {
+            value = value * 1103515245 + 12345;
+            dst[i] = static_cast<u8>(value >> 16);
+            dst[i + 1] = 0xFF;
+        }
+        return true;
+    }
+
+    bool EncodePNG(const std::string& path, const std::vector<u8>& src, u32 width,
+                   u32 height) override {
+        return false;
+    }
+};
+
+u64 TextureHash(std::size_t i) {
+    return 0x1234567800000000 + i;
+}
+
+std::string TexturePath(std::size_t i) {
+    return fmt::format("tex1_{}x{}_{:016X}_13.png", TEXTURE_SIZE, TEXTURE_SIZE, TextureHash(i));
+}
+
+} // Anonymous namespace
+
+TEST_CASE("CustomTexCache loads textures back from a pack", "[core][custom_tex]") {
+    FakeImageInterface image_interface;
+    const std::string texture_dir =
+        fmt::format("{}textures" DIR_SEP "{:016X}" DIR_SEP,
+                    FileUtil::GetUserPath(FileUtil::UserPath::LoadDir), TEST_PROGRAM_ID);
+    REQUIRE(FileUtil::CreateFullPath(texture_dir));
+
+    // Room for two decompressed textures and a half
+    CustomTexCache cache(TEXTURE_BYTES * 5 / 2);
+    for (std::size_t i = 0; i < NUM_TEXTURES; ++i) {
+        cache.AddTexturePath(TextureHash(i), TexturePath(i));
+    }
+    REQUIRE(cache.PackTextures(image_interface, TEST_PROGRAM_ID) == NUM_TEXTURES);
+
+    const auto check_texture = [&image_interface](CustomTexCache& cache, std::size_t i) {
+        CustomTexInfo expected;
+        REQUIRE(DecodeCustomTexture(image_interface, TexturePath(i), expected));
+        CustomTexInfo info;
+        REQUIRE(cache.LoadPackedTexture(TextureHash(i), info));
+        REQUIRE(info.width == expected.width);
+        REQUIRE(info.height == expected.height);
+        REQUIRE(info.tex == expected.tex);
+    };
+
+    SECTION("decompressed textures are bounded") {
+        for (std::size_t i = 0; i < NUM_TEXTURES; ++i) {
+            check_texture(cache, i);
+            REQUIRE(cache.GetPackedCacheSize() <= TEXTURE_BYTES * 5 / 2);
+        }
+        REQUIRE(cache.GetPackedCacheSize() == TEXTURE_BYTES * 2);
+
+        // Textures that were dropped are decompressed again
+        check_texture(cache, 0);
+        check_texture(cache, 3);
+        REQUIRE(cache.GetPackedCacheSize() == TEXTURE_BYTES * 2);
+
+        CustomTexInfo info;
+        REQUIRE_FALSE(cache.LoadPackedTexture(TextureHash(NUM_TEXTURES), info));
+    }
+
+    SECTION("a pack is found for the title") {
+        CustomTexCache other_cache;
+        other_cache.FindCustomTextures(TEST_PROGRAM_ID);
+        for (std::size_t i = 0; i < NUM_TEXTURES; ++i) {
+            check_texture(other_cache, i);
+        }
+        REQUIRE(other_cache.GetPackedCacheSize() == TEXTURE_BYTES * NUM_TEXTURES);
+    }
+
+    FileUtil::DeleteDirRecursively(texture_dir);
+}
+
+} // namespace Core
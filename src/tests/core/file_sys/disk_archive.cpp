@@ -0,0 +1,80 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <catch2/catch.hpp>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "core/file_sys/disk_archive.h"
+
+namespace FileSys {
+
+namespace {
+
+std::string ReadHostFile(const std::string& path) {
+    std::string contents;
+    FileUtil::ReadFileToString(true, path, contents);
+    return contents;
+}
+
+DiskFile OpenFile(WriteBackCache& cache, const std::string& path, bool write) {
+    Mode mode{};
+    mode.read_flag.Assign(1);
+    mode.write_flag.Assign(write ? 1 : 0);
+    return DiskFile(FileUtil::IOFile(path, "rb"), mode, nullptr, cache.Open(path));
+}
+
+} // Anonymous namespace
+
+TEST_CASE("WriteBackCache shares pending writes and writes them back", "[core][file_sys]") {
+    const std::string test_dir = "./write_back_test" DIR_SEP;
+    const std::string save_dir = test_dir + "save" DIR_SEP;
+    FileUtil::CreateFullPath(save_dir);
+    const std::string path = save_dir + "data.bin";
+    FileUtil::WriteStringToFile(true, path, "old!");
+
+    {
+        WriteBackCache cache(test_dir, std::chrono::milliseconds(20));
+        DiskFile writer = OpenFile(cache, path, true);
+        REQUIRE(writer.Write(0, 4, false, reinterpret_cast<const u8*>("new!")).Unwrap() == 4);
+
+        // A read-only handle sees the write before it reaches the host file
+        DiskFile reader = OpenFile(cache, path, false);
+        char data[4]{};
+        REQUIRE(reader.Read(0, 4, reinterpret_cast<u8*>(data)).Unwrap() == 4);
+        REQUIRE(std::string(data, 4) == "new!");
+        REQUIRE(ReadHostFile(path) == "old!");
+
+        // Stale writes are written back without further writes or closing the file
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (ReadHostFile(path) != "new!" && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        REQUIRE(ReadHostFile(path) == "new!");
+
+        // Writes to a file that was renamed follow it
+        cache.Flush();
+        const std::string renamed_path = save_dir + "renamed.bin";
+        REQUIRE(FileUtil::Rename(path, renamed_path));
+        cache.Move(path, renamed_path);
+        REQUIRE(writer.Write(0, 4, false, reinterpret_cast<const u8*>("moved")).Unwrap() == 4);
+        REQUIRE(writer.Close());
+        REQUIRE(ReadHostFile(renamed_path) == "move");
+        REQUIRE_FALSE(FileUtil::Exists(path));
+
+        // Writes to a deleted file don't bring it back
+        REQUIRE(writer.Write(0, 4, false, reinterpret_cast<const u8*>("gone")).Unwrap() == 4);
+        cache.Flush();
+        REQUIRE(FileUtil::Delete(renamed_path));
+        cache.Remove(save_dir);
+        REQUIRE(writer.Write(0, 4, false, reinterpret_cast<const u8*>("back")).Unwrap() == 4);
+    }
+    REQUIRE_FALSE(FileUtil::Exists(save_dir + "renamed.bin"));
+
+    FileUtil::DeleteDirRecursively(test_dir);
+}
+
+} // namespace FileSys
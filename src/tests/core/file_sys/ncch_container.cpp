@@ -0,0 +1,96 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "core/file_sys/ncch_container.h"
+#include "core/loader/loader.h"
+
+namespace FileSys {
+
+namespace {
+
+constexpr u64 TEST_PROGRAM_ID = 0x00040000'0FF0C0DE;
+constexpr u32 TEST_BSS_SIZE = 0x10;
+
+/// Writes an unencrypted NCCH whose ExeFS contains only the given uncompressed .code section
+void WriteNCCH(const std::string& path, const std::vector<u8>& code) {
+    NCCH_Header ncch_header{};
+    ncch_header.magic = Loader::MakeMagic('N', 'C', 'C', 'H');
+    ncch_header.program_id = TEST_PROGRAM_ID;
+    ncch_header.no_crypto.Assign(1);
+    ncch_header.extended_header_size = 0x400;
+    // In blocks of 0x200 bytes, after the NCCH header and the extended header
+    ncch_header.exefs_offset = (sizeof(NCCH_Header) + sizeof(ExHeader_Header)) / 0x200;
+    ncch_header.exefs_size = 1;
+
+    const ExHeader_Header exheader_header{};
+
+    ExeFs_Header exefs_header{};
+    std::strcpy(exefs_header.section[0].name, ".code");
+    exefs_header.section[0].offset = 0;
+    exefs_header.section[0].size = static_cast<u32>(code.size());
+
+    FileUtil::IOFile file(path, "wb");
+    file.WriteObject(ncch_header);
+    file.WriteObject(exheader_header);
+    file.WriteObject(exefs_header);
+    file.WriteBytes(code.data(), code.size());
+}
+
+std::vector<u8> LoadCode(const std::string& path) {
+    NCCHContainer container(path);
+    std::vector<u8> code;
+    REQUIRE(container.LoadCode(code, TEST_BSS_SIZE) == Loader::ResultStatus::Success);
+    return code;
+}
+
+std::vector<u8> WithBss(std::vector<u8> code) {
+    code.resize(code.size() + TEST_BSS_SIZE, 0);
+    return code;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("NCCHContainer doesn't cache code overridden by mods", "[core][file_sys]") {
+    const std::string test_dir = "./ncch_container_test" DIR_SEP;
+    FileUtil::CreateFullPath(test_dir);
+    const std::string ncch_path = test_dir + "test.cxi";
+    const std::vector<u8> original{'o', 'r', 'i', 'g', 'i', 'n', 'a', 'l'};
+    const std::vector<u8> modded{'m', 'o', 'd', 'd', 'e', 'd', '!', '!'};
+    WriteNCCH(ncch_path, original);
+
+    const std::string mod_dir = fmt::format(
+        "{}mods" DIR_SEP "{:016X}" DIR_SEP, FileUtil::GetUserPath(FileUtil::UserPath::LoadDir),
+        TEST_PROGRAM_ID);
+    const std::string cache_dir = fmt::format(
+        "{}code" DIR_SEP "{:016X}" DIR_SEP, FileUtil::GetUserPath(FileUtil::UserPath::CacheDir),
+        TEST_PROGRAM_ID);
+    FileUtil::CreateFullPath(mod_dir);
+    const std::string mod_path = mod_dir + "code.bin";
+
+    // A mod installed before the first boot isn't stored as the code of the NCCH
+    FileUtil::WriteStringToFile(false, mod_path, std::string(modded.begin(), modded.end()));
+    REQUIRE(LoadCode(ncch_path) == WithBss(modded));
+
+    REQUIRE(FileUtil::Delete(mod_path));
+    REQUIRE(LoadCode(ncch_path) == WithBss(original));
+    // Loaded from the cache
+    REQUIRE(LoadCode(ncch_path) == WithBss(original));
+
+    // A mod installed later takes priority over the cached code
+    FileUtil::WriteStringToFile(false, mod_path, std::string(modded.begin(), modded.end()));
+    REQUIRE(LoadCode(ncch_path) == WithBss(modded));
+
+    FileUtil::DeleteDirRecursively(mod_dir);
+    FileUtil::DeleteDirRecursively(cache_dir);
+    FileUtil::DeleteDirRecursively(test_dir);
+}
+
+} // namespace FileSys
@@ -0,0 +1,91 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "core/game_library.h"
+#include "core/loader/loader.h"
+
+namespace Core {
+
+namespace {
+
+void WriteFile(const std::string& path, const std::string& contents) {
+    FileUtil::IOFile file(path, "wb");
+    REQUIRE(file.WriteBytes(contents.data(), contents.size()) == contents.size());
+}
+
+} // Anonymous namespace
+
+TEST_CASE("GameLibrary only probes new and changed files", "[core]") {
+    const std::string test_dir = "./game_library_test";
+    const std::string index_path = test_dir + DIR_SEP "index.bin";
+    const std::string game_dir = test_dir + DIR_SEP "games";
+    FileUtil::CreateFullPath(game_dir + DIR_SEP "sub" DIR_SEP);
+    WriteFile(game_dir + DIR_SEP "homebrew.3dsx", std::string("3DSX") + std::string(60, '\0'));
+    WriteFile(game_dir + DIR_SEP "broken.3ds", "not a game");
+    WriteFile(game_dir + DIR_SEP "readme.txt", "3DSX");
+    WriteFile(game_dir + DIR_SEP "sub" DIR_SEP "nested.3dsx", "3DSX");
+
+    {
+        GameLibrary library(index_path);
+        std::vector<std::string> subdirectories;
+        std::vector<std::string> reported_paths;
+        const std::vector<GameLibraryEntry> entries =
+            library.Scan(game_dir, 1, &subdirectories, [&](const GameLibraryEntry& entry) {
+                reported_paths.push_back(entry.path);
+            });
+        REQUIRE(entries.size() == 2);
+        // Every entry is reported while scanning, in the order they are returned
+        REQUIRE(reported_paths.size() == 2);
+        REQUIRE(reported_paths[0] == entries[0].path);
+        REQUIRE(reported_paths[1] == entries[1].path);
+        const auto homebrew = std::find_if(entries.begin(), entries.end(), [&](const auto& entry) {
+            return entry.path == game_dir + DIR_SEP "homebrew.3dsx";
+        });
+        REQUIRE(homebrew != entries.end());
+        REQUIRE(homebrew->file_type == Loader::FileType::THREEDSX);
+        REQUIRE(homebrew->size == 64);
+        REQUIRE_FALSE(homebrew->HasValidSMDH());
+        REQUIRE(homebrew->GetCompatibilityKey() == "0000000000000000");
+        REQUIRE(subdirectories == std::vector<std::string>{game_dir + DIR_SEP "sub"});
+        // Files that are not bootable are remembered as well
+        REQUIRE(library.GetStats().num_probed == 3);
+        REQUIRE(GameLibrary::IsSupportedExtension("GAME.3DS"));
+        REQUIRE_FALSE(GameLibrary::IsSupportedExtension("readme.txt"));
+        REQUIRE_FALSE(GameLibrary::IsSupportedExtension("3ds"));
+        REQUIRE(library.SaveIndex());
+    }
+
+    {
+        GameLibrary library(index_path);
+        REQUIRE(library.Scan(game_dir, 1).size() == 2);
+        REQUIRE(library.GetStats().num_games == 2);
+        REQUIRE(library.GetStats().num_probed == 0);
+    }
+
+    // A file whose size changed is opened again
+    WriteFile(game_dir + DIR_SEP "broken.3ds", "3DSX, now fixed");
+    FileUtil::Delete(game_dir + DIR_SEP "sub" DIR_SEP "nested.3dsx");
+    {
+        GameLibrary library(index_path);
+        REQUIRE(library.Scan(game_dir, 1).size() == 2);
+        REQUIRE(library.GetStats().num_probed == 1);
+        REQUIRE(library.SaveIndex());
+    }
+
+    {
+        GameLibrary library(index_path);
+        REQUIRE(library.Scan(game_dir, 0).size() == 2);
+        REQUIRE(library.GetStats().num_probed == 0);
+    }
+
+    FileUtil::DeleteDirRecursively(test_dir);
+}
+
+} // namespace Core
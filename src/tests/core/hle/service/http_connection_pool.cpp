@@ -0,0 +1,265 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <catch2/catch.hpp>
+#include <fmt/format.h>
+#ifndef _WIN32
+#include <netinet/tcp.h>
+#endif
+#include "core/hle/service/http_connection_pool.h"
+
+namespace Service::HTTP {
+
+namespace {
+
+/**
+ * httplib writes every response header line separately. With Nagle's algorithm, the server then
+ * waits for the delayed ACK of the client, 40ms on Linux, before each response completes on a
+ * persistent connection. Other servers coalesce their writes, so disable it on the accepted
+ * sockets.
+ */
+class NoDelayServer : public httplib::Server {
+public:
+    /**
+     * Answers only the first request of every connection, and closes the connection without an
+     * answer once the next request arrives. This is what a client sees when the server closes an
+     * idle connection while a request is being sent on it.
+     */
+    bool drop_second_request = false;
+
+private:
+    bool process_and_close_socket(socket_t sock) override {
+        const int enable = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&enable),
+                   sizeof(enable));
+        if (drop_second_request) {
+            httplib::detail::SocketStream stream(sock, read_timeout_sec_, read_timeout_usec_);
+            bool connection_close = false;
+            process_request(stream, false, connection_close, nullptr);
+            char byte;
+            stream.read(&byte, 1);
+            httplib::detail::close_socket(sock);
+            return true;
+        }
+        return httplib::detail::process_and_close_socket(
+            false, sock, keep_alive_max_count_, read_timeout_sec_, read_timeout_usec_,
+            [this](httplib::Stream& stream, bool last_connection, bool& connection_close) {
+                return process_request(stream, last_connection, connection_close, nullptr);
+            });
+    }
+};
+
+/// Serves on a free loopback port until destroyed
+class TestServer {
+public:
+    explicit TestServer(bool drop_second_request = false) {
+        server.drop_second_request = drop_second_request;
+        // Each persistent connection occupies a server thread until it is closed
+        server.new_task_queue = [] { return new httplib::ThreadPool(8); };
+        server.set_keep_alive_max_count(1000);
+        server.Get("/hello", [](const httplib::Request& request, httplib::Response& response) {
+            response.set_content("hello " + request.get_param_value("name"), "text/plain");
+        });
+        server.Get("/large", [](const httplib::Request&, httplib::Response& response) {
+            std::string body(1 << 20, '\0');
+            for (std::size_t i = 0; i < body.size(); ++i) {
+                body[i] = static_cast<char>(i * 7);
+            }
+            response.set_content(body, "application/octet-stream");
+        });
+        server.Get("/close", [](const httplib::Request&, httplib::Response& response) {
+            response.set_header("Connection", "close");
+            response.set_content("bye", "text/plain");
+        });
+        server.Get("/slow", [this](const httplib::Request&, httplib::Response& response) {
+            std::unique_lock lock{slow_mutex};
+            slow_cv.wait_for(lock, std::chrono::seconds(5), [this] { return slow_released; });
+            response.set_content("late", "text/plain");
+        });
+        port = server.bind_to_any_port("127.0.0.1");
+        thread = std::thread([this] { server.listen_after_bind(); });
+        while (!server.is_running()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    ~TestServer() {
+        ReleaseSlow();
+        server.stop();
+        thread.join();
+    }
+
+    /// Lets the requests to /slow complete
+    void ReleaseSlow() {
+        std::lock_guard lock{slow_mutex};
+        slow_released = true;
+        slow_cv.notify_all();
+    }
+
+    ConnectionPool::Endpoint GetEndpoint() const {
+        return {false, "127.0.0.1", port, {}, {}};
+    }
+
+    int port;
+
+private:
+    NoDelayServer server;
+    std::thread thread;
+    std::mutex slow_mutex;
+    std::condition_variable slow_cv;
+    bool slow_released = false;
+};
+
+httplib::Request MakeRequest(std::string method, std::string path) {
+    httplib::Request request;
+    request.method = std::move(method);
+    request.path = std::move(path);
+    return request;
+}
+
+httplib::Request MakeGet(std::string path) {
+    return MakeRequest("GET", std::move(path));
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ConnectionPool reuses the connection of previous requests", "[core][service]") {
+    TestServer server;
+    ConnectionPool pool;
+
+    for (int i = 0; i < 3; ++i) {
+        httplib::Response response;
+        REQUIRE(pool.Send(server.GetEndpoint(), MakeGet(fmt::format("/hello?name={}", i)),
+                          response));
+        REQUIRE(response.status == 200);
+        REQUIRE(response.body == fmt::format("hello {}", i));
+    }
+    REQUIRE(pool.GetStats().connections_opened == 1);
+    REQUIRE(pool.GetStats().connections_reused == 2);
+
+    // The connection is not kept when the server closes it
+    httplib::Response response;
+    REQUIRE(pool.Send(server.GetEndpoint(), MakeGet("/close"), response));
+    REQUIRE(response.body == "bye");
+    REQUIRE(pool.Send(server.GetEndpoint(), MakeGet("/hello?name=again"), response));
+    REQUIRE(pool.GetStats().connections_opened == 2);
+
+    httplib::Response not_found;
+    REQUIRE(pool.Send(server.GetEndpoint(), MakeGet("/missing"), not_found));
+    REQUIRE(not_found.status == 404);
+}
+
+TEST_CASE("ConnectionPool streams response bodies to the content receiver", "[core][service]") {
+    TestServer server;
+    ConnectionPool pool;
+
+    httplib::Request request = MakeGet("/large");
+    std::string received;
+    std::size_t num_parts = 0;
+    bool headers_received = false;
+    request.response_handler = [&](const httplib::Response& response) {
+        headers_received = response.status == 200;
+        return true;
+    };
+    request.content_receiver = [&](const char* data, std::size_t length) {
+        received.append(data, length);
+        ++num_parts;
+        return true;
+    };
+    httplib::Response response;
+    REQUIRE(pool.Send(server.GetEndpoint(), request, response));
+    REQUIRE(headers_received);
+    REQUIRE(response.body.empty());
+    REQUIRE(received.size() == (1 << 20));
+    REQUIRE(num_parts > 1);
+    bool matches = true;
+    for (std::size_t i = 0; i < received.size(); ++i) {
+        matches &= received[i] == static_cast<char>(i * 7);
+    }
+    REQUIRE(matches);
+
+    // An aborted response leaves the connection in an unknown state, so it is closed
+    request.content_receiver = [](const char*, std::size_t) { return false; };
+    REQUIRE_FALSE(pool.Send(server.GetEndpoint(), request, response));
+    REQUIRE(pool.Send(server.GetEndpoint(), MakeGet("/hello"), response));
+    REQUIRE(pool.GetStats().connections_opened == 2);
+}
+
+TEST_CASE("ConnectionPool aborts cancelled requests", "[core][service]") {
+    TestServer server;
+    ConnectionPool pool;
+
+    // The request is aborted while it waits for the response
+    RequestCanceller canceller;
+    std::thread cancel_thread([&canceller] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        canceller.Cancel();
+    });
+    httplib::Response response;
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE_FALSE(pool.Send(server.GetEndpoint(), MakeGet("/slow"), response, &canceller));
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+    cancel_thread.join();
+
+    // A cancelled request is not sent at all
+    REQUIRE_FALSE(pool.Send(server.GetEndpoint(), MakeGet("/hello"), response, &canceller));
+    REQUIRE(pool.GetStats().connections_opened == 1);
+}
+
+TEST_CASE("ConnectionPool only resends idempotent requests", "[core][service]") {
+    TestServer server(true);
+    ConnectionPool pool;
+
+    httplib::Response response;
+    REQUIRE(pool.Send(server.GetEndpoint(), MakeGet("/hello?name=first"), response));
+    REQUIRE(pool.GetStats().connections_opened == 1);
+
+    // The server drops the reused connection, so the request is sent again on a new one
+    REQUIRE(pool.Send(server.GetEndpoint(), MakeGet("/hello?name=second"), response));
+    REQUIRE(response.body == "hello second");
+    REQUIRE(pool.GetStats().connections_reused == 1);
+    REQUIRE(pool.GetStats().connections_opened == 2);
+
+    // The server may have acted on a POST before dropping the connection, so it fails instead
+    REQUIRE_FALSE(pool.Send(server.GetEndpoint(), MakeRequest("POST", "/hello"), response));
+    REQUIRE(pool.GetStats().connections_reused == 2);
+    REQUIRE(pool.GetStats().connections_opened == 2);
+}
+
+TEST_CASE("ConnectionPool request rate", "[.][benchmark]") {
+    TestServer server;
+    constexpr int NumRequests = 2000;
+
+    const auto measure = [&](auto&& send) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < NumRequests; ++i) {
+            httplib::Response response;
+            REQUIRE(send(MakeGet("/hello?name=bench"), response));
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return NumRequests / elapsed.count();
+    };
+
+    ConnectionPool pool;
+    const double pooled_rate = measure([&](const httplib::Request& request,
+                                           httplib::Response& response) {
+        return pool.Send(server.GetEndpoint(), request, response);
+    });
+    // What every request did before, a new client and connection
+    const double unpooled_rate = measure([&](const httplib::Request& request,
+                                             httplib::Response& response) {
+        httplib::Client client("127.0.0.1", server.port);
+        return client.send(request, response);
+    });
+
+    fmt::print("pooled: {:.0f} requests/s, new connection per request: {:.0f} requests/s\n",
+               pooled_rate, unpooled_rate);
+}
+
+} // namespace Service::HTTP
@@ -0,0 +1,178 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#ifndef _WIN32
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <catch2/catch.hpp>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "core/hle/service/socket_reactor.h"
+
+namespace Service::SOC {
+
+namespace {
+
+/// Creates a non-blocking TCP socket that listens on a free loopback port
+int Listen(sockaddr_in& addr) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    REQUIRE(::bind(fd, reinterpret_cast<sockaddr*>(&addr), addr_len) == 0);
+    REQUIRE(::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &addr_len) == 0);
+    REQUIRE(::listen(fd, 1) == 0);
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+int Connect(const sockaddr_in& addr) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    REQUIRE(::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0);
+    return fd;
+}
+
+bool WaitForCompletion(SocketReactor& reactor, u64 id) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline) {
+        for (const u64 completed : reactor.PopCompleted()) {
+            if (completed == id) {
+                return true;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("SocketReactor completes an accept once a client connects", "[core][service]") {
+    SocketReactor reactor;
+    sockaddr_in addr;
+    const int server = Listen(addr);
+
+    int accepted = -1;
+    const auto accept = [server, &accepted] {
+        accepted = ::accept(server, nullptr, nullptr);
+        return accepted != -1;
+    };
+    REQUIRE_FALSE(accept());
+    const u64 id = reactor.Submit({{static_cast<u32>(server), SocketReactor::Read}}, accept);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(reactor.PopCompleted().empty());
+    REQUIRE(reactor.NumPending() == 1);
+
+    const int client = Connect(addr);
+    REQUIRE(WaitForCompletion(reactor, id));
+    REQUIRE(accepted != -1);
+    REQUIRE(reactor.NumPending() == 0);
+
+    ::close(accepted);
+    ::close(client);
+    ::close(server);
+}
+
+TEST_CASE("SocketReactor completes a recv once data arrives", "[core][service]") {
+    SocketReactor reactor;
+    sockaddr_in addr;
+    const int server = Listen(addr);
+    const int client = Connect(addr);
+    int accepted = -1;
+    for (int i = 0; i < 1000 && accepted == -1; ++i) {
+        accepted = ::accept(server, nullptr, nullptr);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(accepted != -1);
+    ::fcntl(accepted, F_SETFL, ::fcntl(accepted, F_GETFL, 0) | O_NONBLOCK);
+
+    char received = 0;
+    const auto recv = [accepted, &received] {
+        return ::recv(accepted, &received, sizeof(received), 0) == sizeof(received);
+    };
+    const u64 id = reactor.Submit({{static_cast<u32>(accepted), SocketReactor::Read}}, recv);
+    // A cancelled operation is not attempted anymore
+    std::atomic_bool cancelled_ran{false};
+    const u64 cancelled_id = reactor.Submit({{static_cast<u32>(accepted), SocketReactor::Read}},
+                                            [&cancelled_ran] {
+                                                cancelled_ran = true;
+                                                return true;
+                                            });
+    REQUIRE(reactor.Cancel(cancelled_id));
+
+    const char sent = 'x';
+    REQUIRE(::send(client, &sent, sizeof(sent), 0) == sizeof(sent));
+    REQUIRE(WaitForCompletion(reactor, id));
+    REQUIRE(received == sent);
+    REQUIRE_FALSE(cancelled_ran);
+    REQUIRE_FALSE(reactor.Cancel(id));
+
+    ::close(accepted);
+    ::close(client);
+    ::close(server);
+}
+
+TEST_CASE("SocketReactor completes priority waits on out-of-band data only", "[core][service]") {
+    SocketReactor reactor;
+    sockaddr_in addr;
+    const int server = Listen(addr);
+    const int client = Connect(addr);
+    int accepted = -1;
+    for (int i = 0; i < 1000 && accepted == -1; ++i) {
+        accepted = ::accept(server, nullptr, nullptr);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(accepted != -1);
+
+    const u64 id = reactor.Submit({{static_cast<u32>(accepted), SocketReactor::Priority}},
+                                  [] { return true; });
+    const char sent = 'x';
+    REQUIRE(::send(client, &sent, sizeof(sent), 0) == sizeof(sent));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(reactor.PopCompleted().empty());
+
+    REQUIRE(::send(client, &sent, sizeof(sent), MSG_OOB) == sizeof(sent));
+    REQUIRE(WaitForCompletion(reactor, id));
+
+    ::close(accepted);
+    ::close(client);
+    ::close(server);
+}
+
+TEST_CASE("SocketReactor completes waits without events on errors", "[core][service]") {
+    SocketReactor reactor;
+    sockaddr_in addr;
+    const int server = Listen(addr);
+    const int client = Connect(addr);
+    int accepted = -1;
+    for (int i = 0; i < 1000 && accepted == -1; ++i) {
+        accepted = ::accept(server, nullptr, nullptr);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(accepted != -1);
+
+    const u64 id = reactor.Submit({{static_cast<u32>(accepted), 0}}, [] { return true; });
+    const char sent = 'x';
+    REQUIRE(::send(client, &sent, sizeof(sent), 0) == sizeof(sent));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(reactor.PopCompleted().empty());
+
+    // Closing with a zero linger time resets the connection
+    const linger reset{1, 0};
+    REQUIRE(::setsockopt(client, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset)) == 0);
+    ::close(client);
+    REQUIRE(WaitForCompletion(reactor, id));
+
+    ::close(accepted);
+    ::close(server);
+}
+
+} // namespace Service::SOC
+
+#endif
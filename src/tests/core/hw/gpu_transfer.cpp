@@ -0,0 +1,214 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/color.h"
+#include "common/vector_math.h"
+#include "core/hw/gpu.h"
+#include "core/hw/gpu_transfer.h"
+#include "video_core/utils.h"
+
+namespace GPU {
+
+namespace {
+
+using PixelFormat = Regs::PixelFormat;
+using DisplayTransferConfig = Regs::DisplayTransferConfig;
+
+Common::Vec4<u8> ReferenceDecodePixel(PixelFormat input_format, const u8* src_pixel) {
+    switch (input_format) {
+    case PixelFormat::RGBA8:
+        return Color::DecodeRGBA8(src_pixel);
+    case PixelFormat::RGB8:
+        return Color::DecodeRGB8(src_pixel);
+    case PixelFormat::RGB565:
+        return Color::DecodeRGB565(src_pixel);
+    case PixelFormat::RGB5A1:
+        return Color::DecodeRGB5A1(src_pixel);
+    case PixelFormat::RGBA4:
+        return Color::DecodeRGBA4(src_pixel);
+    default:
+        return {0, 0, 0, 0};
+    }
+}
+
+u32 ReferenceBytesPerPixel(PixelFormat format) {
+    const auto index = static_cast<u32>(format);
+    return index > static_cast<u32>(PixelFormat::RGBA4) ? 0 : Regs::BytesPerPixel(format);
+}
+
+/// The per-pixel display transfer that the kernels replaced
+void ReferenceDisplayTransfer(const DisplayTransferConfig& config, const u8* src_pointer,
+                              u8* dst_pointer) {
+    const u32 horizontal_scale = config.scaling != config.NoScale ? 1 : 0;
+    const u32 vertical_scale = config.scaling == config.ScaleXY ? 1 : 0;
+    const u32 output_width = config.output_width >> horizontal_scale;
+    const u32 output_height = config.output_height >> vertical_scale;
+    const u32 dst_bytes_per_pixel = Regs::BytesPerPixel(config.output_format);
+    const u32 src_bytes_per_pixel = ReferenceBytesPerPixel(config.input_format);
+
+    for (u32 y = 0; y < output_height; ++y) {
+        for (u32 x = 0; x < output_width; ++x) {
+            const u32 input_x = x << horizontal_scale;
+            const u32 input_y = y << vertical_scale;
+            const u32 output_y = config.flip_vertically ? output_height - y - 1 : y;
+
+            u32 src_offset;
+            u32 dst_offset;
+            if (config.input_linear) {
+                src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
+                if (!config.dont_swizzle) {
+                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
+                                 (output_y & ~7) * output_width * dst_bytes_per_pixel;
+                } else {
+                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
+                }
+            } else {
+                src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
+                             (input_y & ~7) * config.input_width * src_bytes_per_pixel;
+                if (!config.dont_swizzle) {
+                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
+                } else {
+                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
+                                 (output_y & ~7) * output_width * dst_bytes_per_pixel;
+                }
+            }
+
+            const u8* src_pixel = src_pointer + src_offset;
+            Common::Vec4<u8> src_color = ReferenceDecodePixel(config.input_format, src_pixel);
+            if (config.scaling == config.ScaleX) {
+                const Common::Vec4<u8> pixel =
+                    ReferenceDecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
+                src_color = ((src_color + pixel) / 2).Cast<u8>();
+            } else if (config.scaling == config.ScaleXY) {
+                const Common::Vec4<u8> pixel1 = ReferenceDecodePixel(
+                    config.input_format, src_pixel + 1 * src_bytes_per_pixel);
+                const Common::Vec4<u8> pixel2 = ReferenceDecodePixel(
+                    config.input_format, src_pixel + 2 * src_bytes_per_pixel);
+                const Common::Vec4<u8> pixel3 = ReferenceDecodePixel(
+                    config.input_format, src_pixel + 3 * src_bytes_per_pixel);
+                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
+            }
+
+            u8* dst_pixel = dst_pointer + dst_offset;
+            switch (config.output_format) {
+            case PixelFormat::RGBA8:
+                Color::EncodeRGBA8(src_color, dst_pixel);
+                break;
+            case PixelFormat::RGB8:
+                Color::EncodeRGB8(src_color, dst_pixel);
+                break;
+            case PixelFormat::RGB565:
+                Color::EncodeRGB565(src_color, dst_pixel);
+                break;
+            case PixelFormat::RGB5A1:
+                Color::EncodeRGB5A1(src_color, dst_pixel);
+                break;
+            case PixelFormat::RGBA4:
+                Color::EncodeRGBA4(src_color, dst_pixel);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+/// The memory fill that SoftwareMemoryFill replaced
+void ReferenceMemoryFill(const Regs::MemoryFillConfig& config, u8* start, u8* end) {
+    if (config.fill_24bit) {
+        for (u8* ptr = start; ptr < end; ptr += 3) {
+            ptr[0] = static_cast<u8>(config.value_24bit_r);
+            ptr[1] = static_cast<u8>(config.value_24bit_g);
+            ptr[2] = static_cast<u8>(config.value_24bit_b);
+        }
+    } else if (config.fill_32bit) {
+        const u32 value = config.value_32bit;
+        const std::size_t len = (end - start) / sizeof(u32);
+        for (std::size_t i = 0; i < len; ++i) {
+            std::memcpy(&start[i * sizeof(u32)], &value, sizeof(u32));
+        }
+    } else {
+        const u16 value = static_cast<u16>(config.value_16bit.Value());
+        for (u8* ptr = start; ptr < end; ptr += sizeof(u16)) {
+            std::memcpy(ptr, &value, sizeof(u16));
+        }
+    }
+}
+
+std::vector<u8> RandomBytes(std::mt19937& rng, std::size_t size) {
+    std::vector<u8> bytes(size);
+    std::generate(bytes.begin(), bytes.end(), [&rng] { return static_cast<u8>(rng()); });
+    return bytes;
+}
+
+/// Room for the largest image of the test, including the tiles past the width of scaled images
+constexpr std::size_t BufferSize = 2 * 128 * 64 * 4;
+
+} // Anonymous namespace
+
+TEST_CASE("SoftwareDisplayTransfer matches the per-pixel transfer", "[core][gpu]") {
+    std::mt19937 rng(1234);
+
+    for (int iteration = 0; iteration < 2000; ++iteration) {
+        DisplayTransferConfig config{};
+        // Every eighth transfer has one of the unknown input formats, which decode to zero
+        const u32 input_format = iteration % 8 == 0 ? 5 + rng() % 3 : rng() % 5;
+        config.input_format.Assign(static_cast<PixelFormat>(input_format));
+        config.output_format.Assign(static_cast<PixelFormat>(rng() % 5));
+        config.input_linear.Assign(rng() % 2);
+        config.dont_swizzle.Assign(rng() % 2);
+        config.flip_vertically.Assign(rng() % 2);
+        // Scaling is only implemented for tiled input
+        config.scaling.Assign(config.input_linear ? DisplayTransferConfig::NoScale
+                                                  : static_cast<DisplayTransferConfig::ScalingMode>(
+                                                        rng() % 3));
+        // Widths that aren't a multiple of the vectorized runs once scaled
+        config.output_width.Assign((rng() % 16 + 1) * 8);
+        config.output_height.Assign((rng() % 4 + 1) * 16);
+        config.input_width.Assign(config.output_width);
+        config.input_height.Assign(config.output_height);
+        INFO("input " << input_format << " output "
+                      << static_cast<u32>(config.output_format.Value()) << " linear "
+                      << config.input_linear << " dont_swizzle " << config.dont_swizzle << " flip "
+                      << config.flip_vertically << " scaling "
+                      << static_cast<u32>(config.scaling.Value()) << " size "
+                      << config.output_width << "x" << config.output_height);
+
+        const std::vector<u8> src = RandomBytes(rng, BufferSize);
+        std::vector<u8> expected = RandomBytes(rng, BufferSize);
+        std::vector<u8> actual = expected;
+        ReferenceDisplayTransfer(config, src.data(), expected.data());
+        SoftwareDisplayTransfer(config, src.data(), actual.data());
+        REQUIRE(actual == expected);
+    }
+}
+
+TEST_CASE("SoftwareMemoryFill matches the per-value fill", "[core][gpu]") {
+    std::mt19937 rng(5678);
+
+    for (int iteration = 0; iteration < 500; ++iteration) {
+        Regs::MemoryFillConfig config{};
+        config.value_32bit = static_cast<u32>(rng());
+        const u32 mode = rng() % 3;
+        config.fill_24bit.Assign(mode == 1);
+        config.fill_32bit.Assign(mode == 2);
+        const std::size_t offset = rng() % 16;
+        const std::size_t size = rng() % 1000 + 1;
+        INFO("mode " << mode << " offset " << offset << " size " << size);
+
+        // Whole 24-bit and 16-bit values are written past the end
+        std::vector<u8> expected = RandomBytes(rng, offset + size + 8);
+        std::vector<u8> actual = expected;
+        ReferenceMemoryFill(config, expected.data() + offset, expected.data() + offset + size);
+        SoftwareMemoryFill(config, actual.data() + offset, actual.data() + offset + size);
+        REQUIRE(actual == expected);
+    }
+}
+
+} // namespace GPU
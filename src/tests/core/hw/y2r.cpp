@@ -0,0 +1,230 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <catch2/catch.hpp>
+#include "common/memory_ref.h"
+#include "core/hle/service/y2r_u.h"
+#include "core/hw/y2r.h"
+#include "core/memory.h"
+
+using namespace Service::Y2R;
+
+namespace {
+
+constexpr VAddr INPUT_Y_ADDRESS = Memory::HEAP_VADDR;
+constexpr VAddr INPUT_U_ADDRESS = INPUT_Y_ADDRESS + 0x100000;
+constexpr VAddr INPUT_V_ADDRESS = INPUT_U_ADDRESS + 0x100000;
+constexpr VAddr OUTPUT_ADDRESS = INPUT_V_ADDRESS + 0x100000;
+constexpr u32 REGION_SIZE = 0x400000;
+constexpr u32 OUTPUT_SIZE = REGION_SIZE - (OUTPUT_ADDRESS - INPUT_Y_ADDRESS);
+
+class Y2RTestEnvironment {
+public:
+    Y2RTestEnvironment() : backing(std::make_shared<BufferMem>(REGION_SIZE)) {
+        page_table = std::make_shared<Memory::PageTable>();
+        memory.MapMemoryRegion(*page_table, INPUT_Y_ADDRESS, REGION_SIZE, MemoryRef(backing));
+        memory.SetCurrentPageTable(page_table);
+    }
+
+    /// Fills the whole region with pseudo-random data, so that both paths start from the same state
+    void Fill(u32 seed) {
+        std::mt19937 rng(seed);
+        u8* data = memory.GetPointer(INPUT_Y_ADDRESS);
+        for (u32 i = 0; i < REGION_SIZE; ++i) {
+            data[i] = static_cast<u8>(rng());
+        }
+    }
+
+    std::vector<u8> Output() {
+        const u8* data = memory.GetPointer(OUTPUT_ADDRESS);
+        return std::vector<u8>(data, data + OUTPUT_SIZE);
+    }
+
+    /// Returns the offset of the first output byte that differs from the expected output
+    std::size_t FindMismatch(const std::vector<u8>& expected) {
+        const u8* data = memory.GetPointer(OUTPUT_ADDRESS);
+        return std::mismatch(expected.begin(), expected.end(), data).first - expected.begin();
+    }
+
+    Memory::MemorySystem memory;
+
+private:
+    std::shared_ptr<BufferMem> backing;
+    std::shared_ptr<Memory::PageTable> page_table;
+};
+
+std::size_t BytesPerPixel(OutputFormat format) {
+    switch (format) {
+    case OutputFormat::RGBA8:
+        return 4;
+    case OutputFormat::RGB8:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+ConversionConfiguration MakeConfiguration(std::mt19937& rng, InputFormat input_format,
+                                          OutputFormat output_format, Rotation rotation,
+                                          BlockAlignment block_alignment, u16 width, u16 lines) {
+    ConversionConfiguration cvt{};
+    cvt.input_format = input_format;
+    cvt.output_format = output_format;
+    cvt.rotation = rotation;
+    cvt.block_alignment = block_alignment;
+    cvt.input_line_width = width;
+    cvt.input_lines = lines;
+    cvt.SetStandardCoefficient(static_cast<StandardCoefficient>(rng() % 4));
+    cvt.alpha = static_cast<u16>(rng() % 0x100);
+
+    const bool is_16bit = input_format == InputFormat::YUV422_Indiv16 ||
+                          input_format == InputFormat::YUV420_Indiv16;
+    const bool is_420 = input_format == InputFormat::YUV420_Indiv8 ||
+                        input_format == InputFormat::YUV420_Indiv16;
+    const u16 sample_size = is_16bit ? 2 : 1;
+    const auto buffer = [&rng](VAddr address, u32 transfer_unit) {
+        return ConversionBuffer{address, 0, static_cast<u16>(transfer_unit),
+                                static_cast<u16>(rng() % 3 * 8)};
+    };
+    if (input_format == InputFormat::YUYV422_Interleaved) {
+        cvt.src_YUYV = buffer(INPUT_Y_ADDRESS, width * 2);
+    } else {
+        cvt.src_Y = buffer(INPUT_Y_ADDRESS, width * sample_size);
+        cvt.src_U = buffer(INPUT_U_ADDRESS, width / (is_420 ? 4 : 2) * sample_size);
+        cvt.src_V = buffer(INPUT_V_ADDRESS, width / (is_420 ? 4 : 2) * sample_size);
+    }
+    cvt.dst = buffer(OUTPUT_ADDRESS, static_cast<u32>(width * BytesPerPixel(output_format)));
+    return cvt;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Y2R::PerformConversion matches the scalar implementation", "[core][y2r]") {
+    Y2RTestEnvironment env;
+    std::mt19937 rng(1234);
+
+    for (int iteration = 0; iteration < 200; ++iteration) {
+        const auto input_format = static_cast<InputFormat>(rng() % 5);
+        const auto output_format = static_cast<OutputFormat>(rng() % 4);
+        const auto rotation = static_cast<Rotation>(rng() % 4);
+        const auto block_alignment = static_cast<BlockAlignment>(rng() % 2);
+        const u16 width = static_cast<u16>((rng() % 64 + 1) * 8);
+        u16 lines = static_cast<u16>(rng() % 96 + 1);
+        if (block_alignment == BlockAlignment::Block8x8) {
+            lines = static_cast<u16>((lines + 7) / 8 * 8);
+        } else if (input_format == InputFormat::YUV420_Indiv8 ||
+                   input_format == InputFormat::YUV420_Indiv16) {
+            // With an odd height, the last line of 4:2:0 chroma samples is never received
+            lines = static_cast<u16>((lines + 1) / 2 * 2);
+        }
+
+        const ConversionConfiguration cvt = MakeConfiguration(
+            rng, input_format, output_format, rotation, block_alignment, width, lines);
+        INFO("input " << static_cast<int>(input_format) << " output "
+                      << static_cast<int>(output_format) << " rotation "
+                      << static_cast<int>(rotation) << " alignment "
+                      << static_cast<int>(block_alignment) << " size " << width << "x" << lines);
+
+        const u32 seed = rng();
+        env.Fill(seed);
+        ConversionConfiguration scalar_cvt = cvt;
+        HW::Y2R::PerformConversionScalar(env.memory, scalar_cvt);
+        const std::vector<u8> expected = env.Output();
+
+        env.Fill(seed);
+        ConversionConfiguration fast_cvt = cvt;
+        HW::Y2R::PerformConversion(env.memory, fast_cvt);
+        REQUIRE(env.FindMismatch(expected) == expected.size());
+        REQUIRE(fast_cvt.dst.address == scalar_cvt.dst.address);
+        REQUIRE(fast_cvt.dst.image_size == scalar_cvt.dst.image_size);
+    }
+}
+
+TEST_CASE("Y2R::PerformConversion handles output overlapping the input", "[core][y2r]") {
+    Y2RTestEnvironment env;
+    std::mt19937 rng(5678);
+
+    // Writing the output over the Y plane changes the input of the following strips, which must
+    // then be converted one at a time
+    ConversionConfiguration cvt =
+        MakeConfiguration(rng, InputFormat::YUV422_Indiv8, OutputFormat::RGBA8, Rotation::None,
+                          BlockAlignment::Linear, 256, 128);
+    cvt.dst.address = INPUT_Y_ADDRESS;
+    cvt.dst.gap = 0;
+
+    env.Fill(42);
+    ConversionConfiguration scalar_cvt = cvt;
+    HW::Y2R::PerformConversionScalar(env.memory, scalar_cvt);
+    const u8* data = env.memory.GetPointer(INPUT_Y_ADDRESS);
+    const std::vector<u8> expected(data, data + REGION_SIZE);
+
+    env.Fill(42);
+    ConversionConfiguration fast_cvt = cvt;
+    HW::Y2R::PerformConversion(env.memory, fast_cvt);
+    REQUIRE(std::memcmp(data, expected.data(), REGION_SIZE) == 0);
+}
+
+TEST_CASE("Y2R::PerformConversion converts unknown input formats like zero samples",
+          "[core][y2r]") {
+    Y2RTestEnvironment env;
+    std::mt19937 rng(9012);
+
+    for (u8 format = 5; format < 8; ++format) {
+        const auto output_format = static_cast<OutputFormat>(rng() % 4);
+        INFO("input " << static_cast<int>(format) << " output "
+                      << static_cast<int>(output_format));
+        // The planes are set up as if the input was 4:2:2, so that the strips are received
+        ConversionConfiguration cvt =
+            MakeConfiguration(rng, InputFormat::YUV422_Indiv8, output_format, Rotation::None,
+                              BlockAlignment::Linear, 64, 16);
+        cvt.input_format = static_cast<InputFormat>(format);
+
+        const u32 seed = rng();
+        env.Fill(seed);
+        ConversionConfiguration scalar_cvt = cvt;
+        HW::Y2R::PerformConversionScalar(env.memory, scalar_cvt);
+        const std::vector<u8> expected = env.Output();
+
+        env.Fill(seed);
+        ConversionConfiguration fast_cvt = cvt;
+        HW::Y2R::PerformConversion(env.memory, fast_cvt);
+        REQUIRE(env.FindMismatch(expected) == expected.size());
+    }
+}
+
+TEST_CASE("Y2R::PerformConversion benchmark", "[.benchmark][core][y2r]") {
+    Y2RTestEnvironment env;
+    std::mt19937 rng(1);
+    env.Fill(1);
+
+    const auto measure = [&env](const ConversionConfiguration& cvt, auto convert) {
+        constexpr int iterations = 100;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            ConversionConfiguration copy = cvt;
+            convert(env.memory, copy);
+        }
+        const std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return elapsed.count() / iterations;
+    };
+
+    for (const auto output_format : {OutputFormat::RGBA8, OutputFormat::RGB565}) {
+        for (const auto input_format :
+             {InputFormat::YUV420_Indiv8, InputFormat::YUYV422_Interleaved}) {
+            const ConversionConfiguration cvt =
+                MakeConfiguration(rng, input_format, output_format, Rotation::None,
+                                  BlockAlignment::Block8x8, 400, 240);
+            const double scalar = measure(cvt, HW::Y2R::PerformConversionScalar);
+            const double fast = measure(cvt, HW::Y2R::PerformConversion);
+            WARN("input " << static_cast<int>(input_format) << " output "
+                          << static_cast<int>(output_format) << ": scalar " << scalar
+                          << "us, fast " << fast << "us (" << scalar / fast << "x)");
+        }
+    }
+}
@@ -0,0 +1,80 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <utility>
+#include <catch2/catch.hpp>
+#include "core/memory.h"
+
+namespace Memory {
+
+namespace {
+
+using Attributes = SparsePageArray<PageType>;
+
+constexpr std::size_t BLOCK_BYTES = Attributes::BLOCK_SIZE * sizeof(PageType);
+
+} // Anonymous namespace
+
+TEST_CASE("SparsePageArray allocates blocks lazily", "[core][memory]") {
+    // The array holds a pointer per block, which is too much for the stack of some platforms
+    auto attributes = std::make_unique<Attributes>();
+    const std::size_t empty_usage = attributes->GetMemoryUsage();
+    REQUIRE(empty_usage == sizeof(Attributes));
+
+    SECTION("entries that were never written read as empty") {
+        REQUIRE(attributes->Get(0) == PageType::Unmapped);
+        REQUIRE((*attributes)[PAGE_TABLE_NUM_ENTRIES - 1] == PageType::Unmapped);
+        REQUIRE(std::as_const(*attributes)[0x12345] == PageType::Unmapped);
+        REQUIRE(attributes->GetMemoryUsage() == empty_usage);
+    }
+
+    SECTION("writing an empty value does not allocate") {
+        attributes->Set(0x100, PageType::Unmapped);
+        (*attributes)[0x200] = PageType::Unmapped;
+        REQUIRE(attributes->GetMemoryUsage() == empty_usage);
+    }
+
+    SECTION("a block is allocated for the first written entry in it") {
+        constexpr std::size_t page = 3 * Attributes::BLOCK_SIZE + 5;
+        (*attributes)[page] = PageType::Memory;
+        REQUIRE(attributes->Get(page) == PageType::Memory);
+        REQUIRE(attributes->GetMemoryUsage() == empty_usage + BLOCK_BYTES);
+
+        // The rest of the block reads as empty, and is written without allocating again
+        REQUIRE(attributes->Get(page - 1) == PageType::Unmapped);
+        REQUIRE(attributes->Get(page + 1) == PageType::Unmapped);
+        attributes->Set(page + 1, PageType::Special);
+        REQUIRE(attributes->Get(page + 1) == PageType::Special);
+        REQUIRE(attributes->GetMemoryUsage() == empty_usage + BLOCK_BYTES);
+
+        // Neighbouring blocks stay unallocated
+        REQUIRE(attributes->Get(page - Attributes::BLOCK_SIZE) == PageType::Unmapped);
+        REQUIRE(attributes->Get(page + Attributes::BLOCK_SIZE) == PageType::Unmapped);
+
+        attributes->Set(PAGE_TABLE_NUM_ENTRIES - 1, PageType::RasterizerCachedMemory);
+        REQUIRE(attributes->Get(PAGE_TABLE_NUM_ENTRIES - 1) == PageType::RasterizerCachedMemory);
+        REQUIRE(attributes->GetMemoryUsage() == empty_usage + 2 * BLOCK_BYTES);
+
+        // Unmapping an entry keeps its block
+        attributes->Set(page, PageType::Unmapped);
+        REQUIRE(attributes->Get(page) == PageType::Unmapped);
+        REQUIRE(attributes->GetMemoryUsage() == empty_usage + 2 * BLOCK_BYTES);
+    }
+
+    SECTION("clearing frees every block") {
+        for (std::size_t page = 0; page < 4 * Attributes::BLOCK_SIZE; page += 7) {
+            attributes->Set(page, PageType::Memory);
+        }
+        REQUIRE(attributes->GetMemoryUsage() == empty_usage + 4 * BLOCK_BYTES);
+
+        attributes->Clear();
+        REQUIRE(attributes->GetMemoryUsage() == empty_usage);
+        for (std::size_t page = 0; page < 4 * Attributes::BLOCK_SIZE; page += 7) {
+            REQUIRE(attributes->Get(page) == PageType::Unmapped);
+        }
+    }
+}
+
+} // namespace Memory
@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
+#include <random>
 #include <vector>
 #include <catch2/catch.hpp>
 #include "core/hle/kernel/errors.h"
@@ -138,3 +141,96 @@ TEST_CASE("Memory Basics", "[kernel][memory]") {
         REQUIRE(code == RESULT_SUCCESS);
     }
 }
+
+namespace {
+
+/// Randomly maps, unmaps, reprotects and changes the state of pages in the heap region
+void ChurnVMManager(Kernel::VMManager& manager, const std::shared_ptr<BufferMem>& mem,
+                    std::mt19937& rng) {
+    const u32 size = (rng() % 8 + 1) * Memory::PAGE_SIZE;
+    const VAddr address = Memory::HEAP_VADDR + rng() % 0x4000 * Memory::PAGE_SIZE;
+    // Most of these fail because the range is in the wrong state, which must leave it untouched
+    switch (rng() % 4) {
+    case 0:
+        manager.MapBackingMemory(address, MemoryRef(mem, rng() % 16 * Memory::PAGE_SIZE), size,
+                                 Kernel::MemoryState::Private);
+        break;
+    case 1:
+        manager.UnmapRange(address, size);
+        break;
+    case 2:
+        manager.ReprotectRange(address, size, static_cast<Kernel::VMAPermission>(rng() % 8));
+        break;
+    case 3:
+        manager.ChangeMemoryState(address, size, Kernel::MemoryState::Private,
+                                  Kernel::VMAPermission::None, Kernel::MemoryState::Aliased,
+                                  Kernel::VMAPermission::ReadWrite);
+        break;
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("VMManager::FindVMA stays consistent with the VMA map", "[kernel][memory]") {
+    auto mem = std::make_shared<BufferMem>(Memory::PAGE_SIZE * 32);
+    Memory::MemorySystem memory;
+    auto manager = std::make_unique<Kernel::VMManager>(memory);
+    std::mt19937 rng(1234);
+
+    for (int iteration = 0; iteration < 20000; ++iteration) {
+        ChurnVMManager(*manager, mem, rng);
+        if (iteration % 100 != 0) {
+            continue;
+        }
+
+        const auto& vma_map = manager->vma_map;
+        for (auto vma = vma_map.begin(); vma != vma_map.end(); ++vma) {
+            REQUIRE(manager->FindVMA(vma->second.base) == vma);
+            REQUIRE(manager->FindVMA(vma->second.base + vma->second.size - 1) == vma);
+        }
+        for (int lookup = 0; lookup < 100; ++lookup) {
+            const VAddr address = rng() % Kernel::VMManager::MAX_ADDRESS;
+            REQUIRE(manager->FindVMA(address) == std::prev(vma_map.upper_bound(address)));
+            REQUIRE(manager->FindVMAFrom(address) == vma_map.lower_bound(address));
+        }
+        REQUIRE(manager->FindVMA(Kernel::VMManager::MAX_ADDRESS) == vma_map.end());
+    }
+}
+
+TEST_CASE("VMManager churn benchmark", "[.benchmark][kernel][memory]") {
+    auto mem = std::make_shared<BufferMem>(Memory::PAGE_SIZE * 32);
+    Memory::MemorySystem memory;
+    auto manager = std::make_unique<Kernel::VMManager>(memory);
+    std::mt19937 rng(1);
+
+    constexpr int operations = 100000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < operations; ++i) {
+        ChurnVMManager(*manager, mem, rng);
+    }
+    const std::chrono::duration<double, std::nano> churn = std::chrono::steady_clock::now() - start;
+
+    constexpr int lookups = 1000000;
+    std::vector<VAddr> addresses(lookups);
+    std::generate(addresses.begin(), addresses.end(),
+                  [&rng] { return Memory::HEAP_VADDR + rng() % 0x4000000; });
+    const auto measure = [&addresses](auto find) {
+        u64 checksum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (const VAddr address : addresses) {
+            checksum += find(address)->second.size;
+        }
+        const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return std::make_pair(elapsed.count() / addresses.size(), checksum);
+    };
+    const auto indexed = measure([&manager](VAddr address) { return manager->FindVMA(address); });
+    const auto tree = measure([&manager](VAddr address) {
+        return std::prev(manager->vma_map.upper_bound(address));
+    });
+    REQUIRE(indexed.second == tree.second);
+
+    WARN(manager->vma_map.size() << " VMAs: " << churn.count() / operations
+                                 << "ns per change, lookups " << indexed.first
+                                 << "ns indexed, " << tree.first << "ns in the map");
+}
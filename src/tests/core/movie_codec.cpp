@@ -0,0 +1,233 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/movie_codec.h"
+
+namespace Core::MovieCodec {
+
+namespace {
+
+constexpr u64 FramesPerBlock = 16;
+
+/// Appends an input of a type, with a payload of three little endian words
+void AppendInput(std::vector<u8>& input, u8 type, u16 a, u16 b, u16 c) {
+    input.push_back(type);
+    for (const u16 word : {a, b, c}) {
+        input.push_back(static_cast<u8>(word));
+        input.push_back(static_cast<u8>(word >> 8));
+    }
+}
+
+/**
+ * Generates frames of input of every type, with runs of repeated frames like a movie has while the
+ * player doesn't touch anything.
+ * @param block_index Receives the offset of every FramesPerBlock-th frame
+ */
+std::vector<u8> GenerateInput(std::size_t num_frames, std::vector<std::size_t>& block_index) {
+    std::mt19937 rng(1234);
+    std::vector<u8> input;
+    std::vector<u8> last_frame;
+    u16 circle_x = 0x800;
+    for (std::size_t frame = 0; frame < num_frames; ++frame) {
+        if (frame % FramesPerBlock == 0) {
+            block_index.push_back(input.size());
+        }
+        if (!last_frame.empty() && rng() % 3 == 0) {
+            input.insert(input.end(), last_frame.begin(), last_frame.end());
+            continue;
+        }
+
+        const std::size_t frame_start = input.size();
+        circle_x = static_cast<u16>(circle_x + static_cast<s16>(rng() % 64) - 32);
+        AppendInput(input, PadAndCircleType, static_cast<u16>(rng() & 0xFFF), circle_x, 0x800);
+        for (u8 type = PadAndCircleType + 1; type < NumInputTypes; ++type) {
+            if (rng() % 2 == 0) {
+                AppendInput(input, type, static_cast<u16>(rng()), static_cast<u16>(rng()),
+                            static_cast<u16>(rng() % 4));
+            }
+        }
+        last_frame.assign(input.begin() + frame_start, input.end());
+    }
+    return input;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("MovieCodec::EncodeBlock round-trips", "[core][movie]") {
+    SECTION("every input type and repeated frames") {
+        std::vector<std::size_t> block_index;
+        const std::vector<u8> input = GenerateInput(FramesPerBlock, block_index);
+
+        std::vector<u8> encoded;
+        EncodeBlock(input.data(), input.size(), encoded);
+        REQUIRE(encoded.size() < input.size());
+
+        std::vector<u8> decoded;
+        REQUIRE(DecodeBlock(encoded.data(), encoded.size(), FramesPerBlock, decoded));
+        REQUIRE(decoded == input);
+    }
+
+    SECTION("a block made of a single repeated frame") {
+        std::vector<u8> input;
+        for (u64 frame = 0; frame < FramesPerBlock; ++frame) {
+            AppendInput(input, PadAndCircleType, 0xFFFF, 0x8000, 0x0001);
+        }
+
+        std::vector<u8> encoded;
+        EncodeBlock(input.data(), input.size(), encoded);
+        // The tag and deltas of the frame, then a repeat tag and its count
+        REQUIRE(encoded.size() == 1 + 1 + 3 + 1 + 2);
+
+        std::vector<u8> decoded;
+        REQUIRE(DecodeBlock(encoded.data(), encoded.size(), FramesPerBlock, decoded));
+        REQUIRE(decoded == input);
+    }
+
+    SECTION("decoding appends to what was decoded before") {
+        std::vector<u8> input;
+        AppendInput(input, PadAndCircleType, 1, 2, 3);
+
+        std::vector<u8> encoded;
+        EncodeBlock(input.data(), input.size(), encoded);
+
+        std::vector<u8> decoded(input);
+        REQUIRE(DecodeBlock(encoded.data(), encoded.size(), FramesPerBlock, decoded));
+        REQUIRE(decoded.size() == 2 * input.size());
+        REQUIRE(std::equal(input.begin(), input.end(), decoded.begin() + input.size()));
+    }
+}
+
+TEST_CASE("MovieCodec::DecodeBlock rejects corrupted input", "[core][movie]") {
+    std::vector<u8> input;
+    AppendInput(input, PadAndCircleType, 0x1234, 0x5678, 0x9ABC);
+    AppendInput(input, PadAndCircleType, 0x1234, 0x5678, 0x9ABC);
+    std::vector<u8> encoded;
+    EncodeBlock(input.data(), input.size(), encoded);
+    std::vector<u8> decoded;
+
+    SECTION("truncated in the middle of a delta") {
+        REQUIRE_FALSE(DecodeBlock(encoded.data(), encoded.size() - 3, FramesPerBlock, decoded));
+    }
+
+    SECTION("unknown input type") {
+        const u8 tag = NumInputTypes;
+        REQUIRE_FALSE(DecodeBlock(&tag, 1, FramesPerBlock, decoded));
+    }
+
+    SECTION("repeats longer than a block") {
+        REQUIRE_FALSE(DecodeBlock(encoded.data(), encoded.size(), 0, decoded));
+    }
+
+    SECTION("repeats before any frame") {
+        const std::vector<u8> repeat{encoded.end() - 2, encoded.end()};
+        REQUIRE_FALSE(DecodeBlock(repeat.data(), repeat.size(), FramesPerBlock, decoded));
+    }
+}
+
+TEST_CASE("MovieCodec::EncodeInput round-trips", "[core][movie]") {
+    constexpr std::size_t NumFrames = FramesPerBlock * 5 + 3;
+    std::vector<std::size_t> block_index;
+    const std::vector<u8> input = GenerateInput(NumFrames, block_index);
+    REQUIRE(block_index.size() == 6);
+
+    std::vector<BlockIndexEntry> entries;
+    const std::vector<u8> encoded = EncodeInput(input, block_index, entries);
+    REQUIRE(entries.size() == block_index.size());
+
+    std::vector<u8> decoded;
+    std::vector<std::size_t> decoded_index;
+    REQUIRE(DecodeInput(encoded, entries, FramesPerBlock, input.size(), decoded, decoded_index));
+    REQUIRE(decoded == input);
+    REQUIRE(decoded_index == block_index);
+
+    SECTION("every block decodes on its own") {
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            const std::size_t end = i + 1 < entries.size() ? entries[i + 1].offset : encoded.size();
+            const std::size_t input_end =
+                i + 1 < block_index.size() ? block_index[i + 1] : input.size();
+            std::vector<u8> block;
+            REQUIRE(DecodeBlock(encoded.data() + entries[i].offset, end - entries[i].offset,
+                                FramesPerBlock, block));
+            REQUIRE(std::equal(block.begin(), block.end(), input.begin() + block_index[i],
+                               input.begin() + input_end));
+        }
+    }
+
+    SECTION("wrong input size") {
+        REQUIRE_FALSE(DecodeInput(encoded, entries, FramesPerBlock, input.size() + InputSize,
+                                  decoded, decoded_index));
+    }
+
+    SECTION("block index out of order") {
+        std::swap(entries[1], entries[2]);
+        REQUIRE_FALSE(
+            DecodeInput(encoded, entries, FramesPerBlock, input.size(), decoded, decoded_index));
+    }
+
+    SECTION("block index past the encoded input") {
+        entries.back().offset = encoded.size() + 1;
+        REQUIRE_FALSE(
+            DecodeInput(encoded, entries, FramesPerBlock, input.size(), decoded, decoded_index));
+    }
+
+    SECTION("mismatched input offset") {
+        entries[3].input_offset = entries[3].input_offset + InputSize;
+        REQUIRE_FALSE(
+            DecodeInput(encoded, entries, FramesPerBlock, input.size(), decoded, decoded_index));
+    }
+}
+
+TEST_CASE("MovieCodec::PlanSeek", "[core][movie]") {
+    SECTION("without keyframes") {
+        const std::vector<Keyframe> keyframes;
+
+        const SeekPlan ahead = PlanSeek(keyframes, 10, 50);
+        REQUIRE(ahead.reachable);
+        REQUIRE(ahead.keyframe == nullptr);
+
+        const SeekPlan current = PlanSeek(keyframes, 50, 50);
+        REQUIRE(current.reachable);
+        REQUIRE(current.keyframe == nullptr);
+
+        REQUIRE_FALSE(PlanSeek(keyframes, 60, 50).reachable);
+    }
+
+    SECTION("with keyframes") {
+        const std::vector<Keyframe> keyframes{{100, 0, 10}, {200, 10, 10}, {300, 20, 10}};
+
+        // Ahead, with a keyframe closer to the frame than playback is
+        const SeekPlan jump = PlanSeek(keyframes, 10, 250);
+        REQUIRE(jump.reachable);
+        REQUIRE(jump.keyframe == &keyframes[1]);
+
+        // Ahead, with playback already past the closest keyframe
+        const SeekPlan play_on = PlanSeek(keyframes, 210, 250);
+        REQUIRE(play_on.reachable);
+        REQUIRE(play_on.keyframe == nullptr);
+
+        // Back to the frame of a keyframe
+        const SeekPlan exact = PlanSeek(keyframes, 250, 200);
+        REQUIRE(exact.reachable);
+        REQUIRE(exact.keyframe == &keyframes[1]);
+
+        // Back to between keyframes
+        const SeekPlan back = PlanSeek(keyframes, 250, 150);
+        REQUIRE(back.reachable);
+        REQUIRE(back.keyframe == &keyframes[0]);
+
+        // Past the last keyframe
+        const SeekPlan last = PlanSeek(keyframes, 0, 1000);
+        REQUIRE(last.reachable);
+        REQUIRE(last.keyframe == &keyframes[2]);
+
+        // Back to before the first keyframe
+        REQUIRE_FALSE(PlanSeek(keyframes, 250, 50).reachable);
+    }
+}
+
+} // namespace Core::MovieCodec
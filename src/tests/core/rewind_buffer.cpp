@@ -0,0 +1,183 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <fmt/format.h>
+#include "common/archives.h"
+#include "core/core_timing.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/process.h"
+#include "core/memory.h"
+#include "core/rewind_buffer.h"
+
+namespace Core {
+
+namespace {
+
+constexpr std::size_t PageSize = RewindBuffer::PageSize;
+
+/// Overwrites a number of random pages of a region with random data
+void ChangePages(const RewindBuffer::Region& region, std::size_t num_pages, std::mt19937& rng) {
+    std::uniform_int_distribution<std::size_t> page_dist(0, region.size / PageSize - 1);
+    for (std::size_t i = 0; i < num_pages; ++i) {
+        u8* page = region.data + page_dist(rng) * PageSize;
+        for (std::size_t j = 0; j < PageSize; ++j) {
+            page[j] = static_cast<u8>(rng());
+        }
+    }
+}
+
+/// Emulated RAM made of two regions, like FCRAM and VRAM
+struct TestMemory {
+    TestMemory(std::size_t fcram_size, std::size_t vram_size)
+        : fcram(fcram_size), vram(vram_size) {}
+
+    std::vector<RewindBuffer::Region> Regions() {
+        return {{fcram.data(), fcram.size()}, {vram.data(), vram.size()}};
+    }
+
+    /// Overwrites a number of random pages with random data
+    void ChangePages(std::size_t num_pages, std::mt19937& rng) {
+        Core::ChangePages({fcram.data(), fcram.size()}, num_pages, rng);
+        vram[rng() % vram.size()] ^= 0xFF;
+    }
+
+    bool operator==(const TestMemory& other) const {
+        return fcram == other.fcram && vram == other.vram;
+    }
+
+    std::vector<u8> fcram;
+    std::vector<u8> vram;
+};
+
+std::vector<u8> MakeState(u64 frame) {
+    return std::vector<u8>(1000, static_cast<u8>(frame));
+}
+
+} // Anonymous namespace
+
+TEST_CASE("RewindBuffer restores the memory and state of earlier snapshots", "[core]") {
+    std::mt19937 rng(1234);
+    TestMemory memory(256 * PageSize, 64 * PageSize);
+    RewindBuffer buffer(16 * 1024 * 1024);
+
+    std::vector<TestMemory> history;
+    for (u64 frame = 0; frame <= 240; frame += 60) {
+        memory.ChangePages(8, rng);
+        history.push_back(memory);
+        buffer.Capture(frame, MakeState(frame), memory.Regions());
+    }
+    REQUIRE(buffer.NumSnapshots() == 5);
+    REQUIRE(buffer.GetNewestFrame() == 240u);
+
+    // Changes after the newest snapshot are undone as well
+    memory.ChangePages(8, rng);
+    auto state = buffer.Restore(250);
+    REQUIRE(state == MakeState(240));
+    buffer.WriteMemory(memory.Regions());
+    REQUIRE(memory == history[4]);
+
+    // The snapshot at or before the frame is restored, and the newer ones are dropped
+    state = buffer.Restore(179);
+    REQUIRE(state == MakeState(120));
+    buffer.WriteMemory(memory.Regions());
+    REQUIRE(memory == history[2]);
+    REQUIRE(buffer.NumSnapshots() == 3);
+
+    // Capturing continues from the restored snapshot
+    memory.ChangePages(8, rng);
+    const TestMemory branched = memory;
+    buffer.Capture(180, MakeState(180), memory.Regions());
+    memory.ChangePages(8, rng);
+    buffer.Capture(240, MakeState(240), memory.Regions());
+    REQUIRE(buffer.Restore(200) == MakeState(180));
+    buffer.WriteMemory(memory.Regions());
+    REQUIRE(memory == branched);
+
+    REQUIRE(buffer.Restore(0) == MakeState(0));
+    buffer.WriteMemory(memory.Regions());
+    REQUIRE(memory == history[0]);
+    REQUIRE(buffer.NumSnapshots() == 1);
+
+    // Going back in time without restoring starts over
+    buffer.Capture(0, MakeState(1), memory.Regions());
+    REQUIRE(buffer.NumSnapshots() == 1);
+    REQUIRE(buffer.Restore(~0ULL) == MakeState(1));
+}
+
+TEST_CASE("RewindBuffer drops the oldest snapshots to stay within its budget", "[core]") {
+    std::mt19937 rng(5678);
+    TestMemory memory(256 * PageSize, 64 * PageSize);
+    // Random pages don't compress, so every snapshot takes about 32 pages
+    RewindBuffer buffer(32 * PageSize * 4);
+
+    for (u64 frame = 0; frame < 20; ++frame) {
+        memory.ChangePages(32, rng);
+        buffer.Capture(frame, MakeState(frame), memory.Regions());
+    }
+    REQUIRE(buffer.NumSnapshots() <= 5);
+    REQUIRE(buffer.GetMemoryUsage() <= 32 * PageSize * 4);
+    REQUIRE(buffer.Restore(19) == MakeState(19));
+    REQUIRE_FALSE(buffer.Restore(10).has_value());
+}
+
+TEST_CASE("RewindBuffer capture cost", "[.][benchmark]") {
+    // The memory and kernel of an old 3DS running one process. Their page tables make up most of
+    // the serialized state, the state of the services is small in comparison.
+    Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(
+        memory, timing, [] {}, 0, 1, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    const std::vector<RewindBuffer::Region> regions = RewindBuffer::GetSystemRegions(memory);
+
+    // Serializes the state without the RAM, like System::SerializeState for rewind snapshots
+    memory.SetSerializeRAM(false);
+    const auto serialize_state = [&memory, &kernel] {
+        std::ostringstream stream{std::ios_base::binary};
+        oarchive archive{stream};
+        archive& memory;
+        archive& kernel;
+        const std::string& str = stream.str();
+        return std::vector<u8>(str.begin(), str.end());
+    };
+
+    RewindBuffer buffer(512 * 1024 * 1024);
+    buffer.Capture(0, serialize_state(), regions);
+
+    // Games usually change a few MiB of RAM per second
+    std::mt19937 rng(42);
+    constexpr int NumSnapshots = 30;
+    constexpr std::size_t ChangedPages = 4 * 1024 * 1024 / PageSize;
+    std::chrono::duration<double> capture_time{};
+    std::chrono::duration<double> max_capture_time{};
+    for (int i = 1; i <= NumSnapshots; ++i) {
+        ChangePages(regions[0], ChangedPages, rng);
+        // Like System::CaptureRewindSnapshot, the state is serialized during the comparison
+        const auto start = std::chrono::steady_clock::now();
+        buffer.BeginCapture(i * 60, regions);
+        buffer.FinishCapture(serialize_state());
+        const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+        capture_time += time;
+        max_capture_time = std::max(max_capture_time, time);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE(buffer.Restore(0).has_value());
+    buffer.WriteMemory(regions);
+    const std::chrono::duration<double> restore_time = std::chrono::steady_clock::now() - start;
+
+    const double capture_ms = capture_time.count() * 1000 / NumSnapshots;
+    fmt::print("capture: {:.2f} ms on average, {:.2f} ms at most ({:.2f}% of emulation time at 1 "
+               "snapshot/s), restore of {} snapshots: {:.2f} ms\n",
+               capture_ms, max_capture_time.count() * 1000, capture_ms / 10, NumSnapshots,
+               restore_time.count() * 1000);
+}
+
+} // namespace Core
@@ -0,0 +1,39 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <thread>
+#include <catch2/catch.hpp>
+#include "network/network.h"
+#include "network/room.h"
+#include "network/room_event_loop.h"
+
+namespace Network {
+
+TEST_CASE("RoomEventLoop removes a room while servicing others", "[network]") {
+    REQUIRE(Init());
+    {
+        RoomEventLoop event_loop;
+        Room first;
+        Room second;
+        REQUIRE(first.Create("first", "", "127.0.0.1", 24900, "", 4, "", "", 0, nullptr, {},
+                             false, &event_loop));
+        REQUIRE(second.Create("second", "", "127.0.0.1", 24901, "", 4, "", "", 0, nullptr, {},
+                              false, &event_loop));
+        REQUIRE(event_loop.NumRooms() == 2);
+
+        // Let the loop service both rooms, then remove one while the other remains
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        first.Destroy();
+        REQUIRE(event_loop.NumRooms() == 1);
+        REQUIRE(first.GetState() == Room::State::Closed);
+        REQUIRE(second.GetState() == Room::State::Open);
+
+        second.Destroy();
+        REQUIRE(event_loop.NumRooms() == 0);
+    }
+    Shutdown();
+}
+
+} // namespace Network
@@ -0,0 +1,153 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <nihstro/shader_bytecode.h>
+#include "common/assert.h"
+#include "common/common_types.h"
+#include "video_core/shader/shader.h"
+
+/**
+ * Encodes shader programs for tests. The inline assembler of nihstro can't encode flow control or
+ * relative addressing, so the instructions are encoded here directly.
+ */
+class ProgramBuilder {
+public:
+    using CompareOp = nihstro::Instruction::Common::CompareOpType::Op;
+    using ConditionOp = nihstro::Instruction::FlowControlType::Op;
+    using OpCode = nihstro::OpCode;
+
+    /// Address registers that can be added to the index of the first source register
+    enum AddressRegister : u32 {
+        None = 0,
+        A0X = 1,
+        A0Y = 2,
+        AL = 3,
+    };
+
+    static constexpr u32 Input(u32 index) {
+        return index;
+    }
+
+    static constexpr u32 Output(u32 index) {
+        return index;
+    }
+
+    static constexpr u32 Temporary(u32 index) {
+        return 0x10 + index;
+    }
+
+    /// Float uniforms can only be used as the first source register
+    static constexpr u32 Uniform(u32 index) {
+        return 0x20 + index;
+    }
+
+    /**
+     * Appends an arithmetic instruction.
+     * @param dest_mask Components of the destination that are written, such as "xz"
+     * @param src1_swizzle Swizzle of the first source, such as "wzyx", or "-wzyx" to negate it
+     * @param address_register Address register added to the index of the first source
+     */
+    void Arithmetic(OpCode::Id op, u32 dest, std::string_view dest_mask, u32 src1,
+                    std::string_view src1_swizzle, u32 src2 = 0,
+                    std::string_view src2_swizzle = "xyzw",
+                    AddressRegister address_register = None) {
+        const u32 desc = AddOperandDescriptor(dest_mask, src1_swizzle, src2_swizzle);
+        program.push_back(static_cast<u32>(op) << 26 | dest << 21 | address_register << 19 |
+                          src1 << 12 | src2 << 7 | desc);
+    }
+
+    /// Appends a CMP instruction, which sets the conditional code from the x and y components
+    void Compare(u32 src1, std::string_view src1_swizzle, CompareOp op_x, CompareOp op_y,
+                 u32 src2, std::string_view src2_swizzle) {
+        const u32 desc = AddOperandDescriptor("", src1_swizzle, src2_swizzle);
+        program.push_back(static_cast<u32>(OpCode::Id::CMP) << 26 | static_cast<u32>(op_x) << 24 |
+                          static_cast<u32>(op_y) << 21 | src1 << 12 | src2 << 7 | desc);
+    }
+
+    /// Appends IFC, CALLC or JMPC, which are taken if the conditional code matches refx and refy
+    void Conditional(OpCode::Id op, ConditionOp condition, bool refx, bool refy, u32 dest,
+                     u32 num_instructions = 0) {
+        program.push_back(static_cast<u32>(op) << 26 | static_cast<u32>(refx) << 25 |
+                          static_cast<u32>(refy) << 24 | static_cast<u32>(condition) << 22 |
+                          dest << 10 | num_instructions);
+    }
+
+    /// Appends IFU, CALLU, JMPU or LOOP, which depend on a bool or int uniform
+    void UniformFlowControl(OpCode::Id op, u32 uniform_id, u32 dest, u32 num_instructions = 0) {
+        program.push_back(static_cast<u32>(op) << 26 | uniform_id << 22 | dest << 10 |
+                          num_instructions);
+    }
+
+    void Call(u32 dest, u32 num_instructions) {
+        program.push_back(static_cast<u32>(OpCode::Id::CALL) << 26 | dest << 10 |
+                          num_instructions);
+    }
+
+    /// Appends an instruction without operands, such as END
+    void Trivial(OpCode::Id op) {
+        program.push_back(static_cast<u32>(op) << 26);
+    }
+
+    /// Returns the address of the next instruction
+    u32 Next() const {
+        return static_cast<u32>(program.size());
+    }
+
+    /// Creates a shader setup that runs the program, with all uniforms cleared
+    std::unique_ptr<Pica::Shader::ShaderSetup> MakeSetup() const {
+        auto setup = std::make_unique<Pica::Shader::ShaderSetup>();
+        std::copy(program.begin(), program.end(), setup->program_code.begin());
+        std::copy(swizzle_data.begin(), swizzle_data.end(), setup->swizzle_data.begin());
+        for (auto& uniform : setup->uniforms.f) {
+            uniform = Common::MakeVec(Pica::float24::Zero(), Pica::float24::Zero(),
+                                      Pica::float24::Zero(), Pica::float24::Zero());
+        }
+        setup->uniforms.b.fill(false);
+        setup->uniforms.i.fill(Common::MakeVec<u8>(0, 0, 0, 0));
+        return setup;
+    }
+
+private:
+    static u32 EncodeSwizzle(std::string_view swizzle) {
+        u32 negate = 0;
+        if (!swizzle.empty() && swizzle.front() == '-') {
+            negate = 1;
+            swizzle.remove_prefix(1);
+        }
+        ASSERT(swizzle.size() == 4);
+        u32 selectors = 0;
+        for (const char component : swizzle) {
+            const std::size_t selector = std::string_view("xyzw").find(component);
+            ASSERT(selector != std::string_view::npos);
+            selectors = selectors << 2 | static_cast<u32>(selector);
+        }
+        return selectors << 1 | negate;
+    }
+
+    u32 AddOperandDescriptor(std::string_view dest_mask, std::string_view src1_swizzle,
+                             std::string_view src2_swizzle) {
+        u32 desc = EncodeSwizzle(src1_swizzle) << 4 | EncodeSwizzle(src2_swizzle) << 13;
+        for (const char component : dest_mask) {
+            const std::size_t index = std::string_view("xyzw").find(component);
+            ASSERT(index != std::string_view::npos);
+            desc |= 0x8u >> index;
+        }
+
+        const auto it = std::find(swizzle_data.begin(), swizzle_data.end(), desc);
+        if (it != swizzle_data.end()) {
+            return static_cast<u32>(it - swizzle_data.begin());
+        }
+        swizzle_data.push_back(desc);
+        return static_cast<u32>(swizzle_data.size() - 1);
+    }
+
+    std::vector<u32> program;
+    std::vector<u32> swizzle_data;
+};
@@ -0,0 +1,400 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <catch2/catch.hpp>
+#include <nihstro/inline_assembly.h>
+#include "tests/video_core/shader/program_builder.h"
+#include "video_core/shader/shader_interpreter.h"
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/shader/shader_jit_x64_compiler.h"
+#endif
+
+using float24 = Pica::float24;
+using InterpreterEngine = Pica::Shader::InterpreterEngine;
+using ShaderSetup = Pica::Shader::ShaderSetup;
+using UnitState = Pica::Shader::UnitState;
+
+using DestRegister = nihstro::DestRegister;
+using OpCode = nihstro::OpCode;
+using SourceRegister = nihstro::SourceRegister;
+
+namespace {
+
+std::unique_ptr<ShaderSetup> AssembleShader(std::initializer_list<nihstro::InlineAsm> code) {
+    const auto shbin = nihstro::InlineAsm::CompileToRawBinary(code);
+
+    auto shader_setup = std::make_unique<ShaderSetup>();
+    std::transform(shbin.program.begin(), shbin.program.end(),
+                   shader_setup->program_code.begin(), [](const auto& x) { return x.hex; });
+    std::transform(shbin.swizzle_table.begin(), shbin.swizzle_table.end(),
+                   shader_setup->swizzle_data.begin(), [](const auto& x) { return x.hex; });
+    return shader_setup;
+}
+
+class ShaderTest {
+public:
+    explicit ShaderTest(std::initializer_list<nihstro::InlineAsm> code)
+        : shader_setup(AssembleShader(code)) {
+        engine.SetupBatch(*shader_setup, 0);
+    }
+
+    float Run(float input) {
+        UnitState shader_unit;
+
+        shader_unit.registers.input[0].x = float24::FromFloat32(input);
+        engine.Run(*shader_setup, shader_unit);
+        return shader_unit.registers.output[0].x.ToFloat32();
+    }
+
+private:
+    InterpreterEngine engine;
+    std::unique_ptr<ShaderSetup> shader_setup;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("Interpreter LG2", "[video_core][shader][shader_interpreter]") {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    auto shader = ShaderTest({
+        // clang-format off
+        {OpCode::Id::LG2, sh_output, sh_input},
+        {OpCode::Id::END},
+        // clang-format on
+    });
+
+    REQUIRE(std::isnan(shader.Run(NAN)));
+    REQUIRE(std::isnan(shader.Run(-1.f)));
+    REQUIRE(std::isinf(shader.Run(0.f)));
+    REQUIRE(shader.Run(4.f) == Approx(2.f));
+    REQUIRE(shader.Run(64.f) == Approx(6.f));
+    REQUIRE(shader.Run(1.e24f) == Approx(79.7262742773f));
+}
+
+TEST_CASE("Interpreter EX2", "[video_core][shader][shader_interpreter]") {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    auto shader = ShaderTest({
+        // clang-format off
+        {OpCode::Id::EX2, sh_output, sh_input},
+        {OpCode::Id::END},
+        // clang-format on
+    });
+
+    REQUIRE(std::isnan(shader.Run(NAN)));
+    REQUIRE(shader.Run(-800.f) == Approx(0.f));
+    REQUIRE(shader.Run(0.f) == Approx(1.f));
+    REQUIRE(shader.Run(2.f) == Approx(4.f));
+    REQUIRE(shader.Run(6.f) == Approx(64.f));
+    REQUIRE(shader.Run(79.7262742773f) == Approx(1.e24f));
+    REQUIRE(std::isinf(shader.Run(800.f)));
+}
+
+TEST_CASE("Decoded programs are shared between identical shaders",
+          "[video_core][shader][shader_interpreter]") {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+    const std::initializer_list<nihstro::InlineAsm> code = {
+        // clang-format off
+        {OpCode::Id::MOV, sh_output, sh_input},
+        {OpCode::Id::END},
+        // clang-format on
+    };
+
+    InterpreterEngine engine;
+    auto setup_a = AssembleShader(code);
+    auto setup_b = AssembleShader(code);
+    engine.SetupBatch(*setup_a, 0);
+    engine.SetupBatch(*setup_b, 0);
+    REQUIRE(setup_a->engine_data.cached_shader != nullptr);
+    REQUIRE(setup_a->engine_data.cached_shader == setup_b->engine_data.cached_shader);
+
+    UnitState shader_unit;
+    shader_unit.registers.input[0].x = float24::FromFloat32(3.f);
+    engine.Run(*setup_b, shader_unit);
+    REQUIRE(shader_unit.registers.output[0].x.ToFloat32() == 3.f);
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+namespace {
+
+using Vec4f = std::array<float, 4>;
+using Outputs = std::array<Vec4f, 16>;
+
+/**
+ * Runs a program on the interpreter and on the JIT, and requires both to write the same output
+ * registers.
+ * @param inputs Values of the input registers, starting at v0
+ * @return Output registers written by the interpreter
+ */
+Outputs RunOnBothEngines(ShaderSetup& setup, std::initializer_list<Vec4f> inputs) {
+    UnitState interpreter_unit;
+    UnitState jit_unit;
+    std::memset(&interpreter_unit.registers, 0, sizeof(interpreter_unit.registers));
+    std::memset(&jit_unit.registers, 0, sizeof(jit_unit.registers));
+    unsigned reg = 0;
+    for (const auto& input : inputs) {
+        for (std::size_t i = 0; i < 4; ++i) {
+            interpreter_unit.registers.input[reg][i] = float24::FromFloat32(input[i]);
+            jit_unit.registers.input[reg][i] = float24::FromFloat32(input[i]);
+        }
+        ++reg;
+    }
+
+    InterpreterEngine interpreter;
+    interpreter.SetupBatch(setup, 0);
+    interpreter.Run(setup, interpreter_unit);
+
+    Pica::Shader::JitShader jit;
+    jit.Compile(&setup.program_code, &setup.swizzle_data);
+    jit.Run(setup, jit_unit, 0);
+
+    Outputs outputs;
+    for (reg = 0; reg < outputs.size(); ++reg) {
+        for (std::size_t i = 0; i < 4; ++i) {
+            const float expected = interpreter_unit.registers.output[reg][i].ToFloat32();
+            const float actual = jit_unit.registers.output[reg][i].ToFloat32();
+            INFO("o" << reg << "." << "xyzw"[i]);
+            REQUIRE((expected == actual || (std::isnan(expected) && std::isnan(actual))));
+            outputs[reg][i] = expected;
+        }
+    }
+    return outputs;
+}
+
+/// Value of a float uniform set by SetFloatUniforms
+Vec4f UniformValue(unsigned index) {
+    const float value = static_cast<float>(index + 1);
+    return {value, value * 0.5f, -value, value * 4.f};
+}
+
+/// Sum of the values of float uniforms set by SetFloatUniforms
+Vec4f SumOfUniforms(std::initializer_list<unsigned> indices) {
+    Vec4f sum{};
+    for (const unsigned index : indices) {
+        const Vec4f value = UniformValue(index);
+        for (std::size_t i = 0; i < 4; ++i) {
+            sum[i] += value[i];
+        }
+    }
+    return sum;
+}
+
+/// Sets each of the first float uniforms to a distinct value
+void SetFloatUniforms(ShaderSetup& setup) {
+    for (unsigned index = 0; index < 16; ++index) {
+        const Vec4f value = UniformValue(index);
+        setup.uniforms.f[index] =
+            Common::MakeVec(float24::FromFloat32(value[0]), float24::FromFloat32(value[1]),
+                            float24::FromFloat32(value[2]), float24::FromFloat32(value[3]));
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Interpreter matches the JIT for swizzles, negation and write masks",
+          "[video_core][shader][shader_interpreter]") {
+    using P = ProgramBuilder;
+    ProgramBuilder program;
+    // clang-format off
+    program.Arithmetic(OpCode::Id::ADD, P::Output(0), "xz", P::Input(0), "-wzyx", P::Input(1),
+                       "yyxw");
+    program.Arithmetic(OpCode::Id::MUL, P::Output(1), "yw", P::Input(0), "xxyy", P::Input(1),
+                       "-zwzw");
+    program.Arithmetic(OpCode::Id::MOV, P::Output(2), "xyzw", P::Uniform(0), "-zxwy");
+    program.Arithmetic(OpCode::Id::DP3, P::Output(3), "xyzw", P::Input(0), "xyzw", P::Input(1),
+                       "-wzyx");
+    program.Arithmetic(OpCode::Id::DP4, P::Output(4), "xw", P::Uniform(1), "wwxy", P::Input(0),
+                       "xyzw");
+    program.Arithmetic(OpCode::Id::MAX, P::Output(5), "xy", P::Input(0), "wzyx", P::Input(1),
+                       "xyzw");
+    program.Arithmetic(OpCode::Id::MIN, P::Output(5), "zw", P::Input(0), "-xyzw", P::Input(1),
+                       "xxxx");
+    program.Arithmetic(OpCode::Id::FLR, P::Output(6), "xyz", P::Input(0), "yzwx");
+    program.Arithmetic(OpCode::Id::SGE, P::Output(7), "xyzw", P::Input(0), "xyzw", P::Input(1),
+                       "zzzz");
+    program.Arithmetic(OpCode::Id::SLT, P::Output(8), "xyzw", P::Input(1), "-xyzw", P::Input(0),
+                       "xyzw");
+    program.Arithmetic(OpCode::Id::MOV, P::Temporary(0), "yz", P::Input(1), "wxyz");
+    program.Arithmetic(OpCode::Id::ADD, P::Output(9), "xyw", P::Temporary(0), "zyzy",
+                       P::Temporary(0), "-yzyz");
+    program.Trivial(OpCode::Id::END);
+    // clang-format on
+
+    auto setup = program.MakeSetup();
+    SetFloatUniforms(*setup);
+    const Vec4f c0 = UniformValue(0);
+    for (const auto& [v0, v1] : {std::make_pair(Vec4f{1.5f, -2.25f, 3.f, -4.5f},
+                                                Vec4f{0.5f, 6.f, -1.f, 2.f}),
+                                 std::make_pair(Vec4f{-7.75f, 0.f, 8.f, 1.f},
+                                                Vec4f{-0.5f, -3.f, 16.f, -2.f})}) {
+        const Outputs outputs = RunOnBothEngines(*setup, {v0, v1});
+        REQUIRE(outputs[0] == Vec4f{-v0[3] + v1[1], 0.f, -v0[1] + v1[0], 0.f});
+        REQUIRE(outputs[2] == Vec4f{-c0[2], -c0[0], -c0[3], -c0[1]});
+    }
+}
+
+TEST_CASE("Interpreter matches the JIT for relative addressing",
+          "[video_core][shader][shader_interpreter]") {
+    using P = ProgramBuilder;
+    ProgramBuilder program;
+    // clang-format off
+    program.Arithmetic(OpCode::Id::MOVA, 0, "xy", P::Input(0), "xyzw");                 // 0
+    program.Arithmetic(OpCode::Id::MOV, P::Output(0), "xyzw", P::Uniform(4), "xyzw", 0, // 1
+                       "xyzw", P::A0X);
+    program.Arithmetic(OpCode::Id::MOV, P::Output(1), "xyzw", P::Uniform(4), "wzyx", 0, // 2
+                       "xyzw", P::A0Y);
+    program.UniformFlowControl(OpCode::Id::LOOP, 0, 4);                                 // 3
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Uniform(0), "xyzw", // 4
+                       P::Temporary(0), "xyzw", P::AL);
+    program.Arithmetic(OpCode::Id::MOV, P::Output(2), "xyzw", P::Temporary(0), "xyzw"); // 5
+    program.Trivial(OpCode::Id::END);                                                   // 6
+    // clang-format on
+
+    auto setup = program.MakeSetup();
+    SetFloatUniforms(*setup);
+    // Three iterations with aL = 1, 3, 5
+    setup->uniforms.i[0] = Common::MakeVec<u8>(2, 1, 2, 0);
+
+    const Outputs outputs = RunOnBothEngines(*setup, {{2.75f, -1.5f, 0.f, 0.f}});
+    const Vec4f c3 = UniformValue(3);
+    REQUIRE(outputs[0] == UniformValue(6));
+    REQUIRE(outputs[1] == Vec4f{c3[3], c3[2], c3[1], c3[0]});
+    REQUIRE(outputs[2] == SumOfUniforms({1, 3, 5}));
+
+    RunOnBothEngines(*setup, {{0.f, 3.25f, 0.f, 0.f}});
+}
+
+TEST_CASE("Interpreter matches the JIT for CMP", "[video_core][shader][shader_interpreter]") {
+    using P = ProgramBuilder;
+    using CompareOp = ProgramBuilder::CompareOp;
+    using ConditionOp = ProgramBuilder::ConditionOp;
+    ProgramBuilder program;
+    // clang-format off
+    program.Compare(P::Input(0), "xyzw", CompareOp::LessThan, CompareOp::GreaterEqual, // 0
+                    P::Input(1), "xyzw");
+    program.Conditional(OpCode::Id::IFC, ConditionOp::JustX, true, false, 3, 1);       // 1
+    program.Arithmetic(OpCode::Id::MOV, P::Output(0), "xyzw", P::Uniform(0), "xyzw");  // 2
+    program.Arithmetic(OpCode::Id::MOV, P::Output(0), "xyzw", P::Uniform(1), "xyzw");  // 3
+    program.Conditional(OpCode::Id::IFC, ConditionOp::And, true, true, 6, 1);          // 4
+    program.Arithmetic(OpCode::Id::MOV, P::Output(1), "xyzw", P::Uniform(0), "xyzw");  // 5
+    program.Arithmetic(OpCode::Id::MOV, P::Output(1), "xyzw", P::Uniform(1), "xyzw");  // 6
+    program.Conditional(OpCode::Id::IFC, ConditionOp::Or, false, false, 9, 1);         // 7
+    program.Arithmetic(OpCode::Id::MOV, P::Output(2), "xyzw", P::Uniform(0), "xyzw");  // 8
+    program.Arithmetic(OpCode::Id::MOV, P::Output(2), "xyzw", P::Uniform(1), "xyzw");  // 9
+    program.Conditional(OpCode::Id::JMPC, ConditionOp::JustY, false, false, 12);       // 10
+    program.Arithmetic(OpCode::Id::MOV, P::Output(3), "xyzw", P::Uniform(0), "xyzw");  // 11
+    program.Compare(P::Input(0), "wzyx", CompareOp::Equal, CompareOp::NotEqual,        // 12
+                    P::Input(1), "-wzyx");
+    program.Conditional(OpCode::Id::IFC, ConditionOp::JustY, false, true, 15, 1);      // 13
+    program.Arithmetic(OpCode::Id::MOV, P::Output(4), "xyzw", P::Uniform(0), "xyzw");  // 14
+    program.Arithmetic(OpCode::Id::MOV, P::Output(4), "xyzw", P::Uniform(1), "xyzw");  // 15
+    program.Conditional(OpCode::Id::IFC, ConditionOp::And, true, false, 18, 1);        // 16
+    program.Arithmetic(OpCode::Id::MOV, P::Output(5), "xyzw", P::Uniform(0), "xyzw");  // 17
+    program.Arithmetic(OpCode::Id::MOV, P::Output(5), "xyzw", P::Uniform(1), "xyzw");  // 18
+    program.Trivial(OpCode::Id::END);                                                  // 19
+    // clang-format on
+
+    auto setup = program.MakeSetup();
+    SetFloatUniforms(*setup);
+
+    // v0.x < v1.x and v0.y >= v1.y
+    auto outputs = RunOnBothEngines(*setup, {{1.f, 2.f, 5.f, 5.f}, {2.f, 1.f, -5.f, -5.f}});
+    REQUIRE(outputs[0] == UniformValue(0));
+    REQUIRE(outputs[1] == UniformValue(0));
+    REQUIRE(outputs[2] == UniformValue(1));
+    REQUIRE(outputs[3] == UniformValue(0));
+    REQUIRE(outputs[4] == UniformValue(1));
+    REQUIRE(outputs[5] == UniformValue(0));
+
+    // v0.x >= v1.x and v0.y < v1.y
+    outputs = RunOnBothEngines(*setup, {{3.f, 0.f, 5.f, 4.f}, {2.f, 1.f, -6.f, -5.f}});
+    REQUIRE(outputs[0] == UniformValue(1));
+    REQUIRE(outputs[1] == UniformValue(1));
+    REQUIRE(outputs[2] == UniformValue(0));
+    REQUIRE(outputs[3] == Vec4f{});
+    REQUIRE(outputs[4] == UniformValue(0));
+    REQUIRE(outputs[5] == UniformValue(1));
+
+    RunOnBothEngines(*setup, {{1.f, 0.f, 2.f, 3.f}, {2.f, 1.f, -2.f, -3.f}});
+    RunOnBothEngines(*setup, {{NAN, NAN, 0.f, 0.f}, {0.f, 0.f, 0.f, 0.f}});
+}
+
+TEST_CASE("Interpreter matches the JIT for flow control",
+          "[video_core][shader][shader_interpreter]") {
+    using P = ProgramBuilder;
+    using CompareOp = ProgramBuilder::CompareOp;
+    using ConditionOp = ProgramBuilder::ConditionOp;
+    ProgramBuilder program;
+    // clang-format off
+    program.Compare(P::Input(0), "xyzw", CompareOp::Equal, CompareOp::Equal, P::Input(1), // 0
+                    "xyzw");
+    program.UniformFlowControl(OpCode::Id::IFU, 0, 3, 1);                                 // 1
+    program.Arithmetic(OpCode::Id::MOV, P::Output(0), "xyzw", P::Uniform(0), "xyzw");     // 2
+    program.Arithmetic(OpCode::Id::MOV, P::Output(0), "xyzw", P::Uniform(1), "xyzw");     // 3
+    program.UniformFlowControl(OpCode::Id::CALLU, 1, 19, 2);                              // 4
+    program.Conditional(OpCode::Id::CALLC, ConditionOp::JustX, true, false, 21, 1);       // 5
+    program.UniformFlowControl(OpCode::Id::JMPU, 2, 8);                                   // 6
+    program.Arithmetic(OpCode::Id::MOV, P::Output(1), "xyzw", P::Uniform(2), "xyzw");     // 7
+    program.UniformFlowControl(OpCode::Id::LOOP, 0, 13);                                  // 8
+    program.UniformFlowControl(OpCode::Id::IFU, 3, 11, 1);                                // 9
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Uniform(0), "xyzw",   // 10
+                       P::Temporary(0), "xyzw", P::AL);
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(1), "xyzw", P::Uniform(0), "xyzw",   // 11
+                       P::Temporary(1), "xyzw", P::AL);
+    program.Call(22, 1);                                                                  // 12
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(3), "xyzw", P::Uniform(0), "xyzw",   // 13
+                       P::Temporary(3), "xyzw");
+    program.Arithmetic(OpCode::Id::MOV, P::Output(3), "xyzw", P::Temporary(0), "xyzw");   // 14
+    program.Arithmetic(OpCode::Id::MOV, P::Output(4), "xyzw", P::Temporary(1), "xyzw");   // 15
+    program.Arithmetic(OpCode::Id::MOV, P::Output(5), "xyzw", P::Temporary(2), "xyzw");   // 16
+    program.Arithmetic(OpCode::Id::MOV, P::Output(6), "xyzw", P::Temporary(3), "xyzw");   // 17
+    program.Trivial(OpCode::Id::END);                                                     // 18
+    program.Arithmetic(OpCode::Id::MOV, P::Output(2), "xyzw", P::Uniform(3), "xyzw");     // 19
+    program.Arithmetic(OpCode::Id::ADD, P::Output(2), "xy", P::Uniform(4), "xyzw",        // 20
+                       P::Input(0), "xyzw");
+    program.Arithmetic(OpCode::Id::MOV, P::Output(7), "xyzw", P::Uniform(5), "xyzw");     // 21
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(2), "xyzw", P::Uniform(1), "xyzw",   // 22
+                       P::Temporary(2), "xyzw", P::AL);
+    // clang-format on
+
+    auto setup = program.MakeSetup();
+    SetFloatUniforms(*setup);
+    for (const auto& loop : {Common::MakeVec<u8>(2, 1, 2, 0), Common::MakeVec<u8>(0, 4, 1, 0)}) {
+        setup->uniforms.i[0] = loop;
+        for (unsigned bools = 0; bools < 16; ++bools) {
+            for (std::size_t i = 0; i < 4; ++i) {
+                setup->uniforms.b[i] = (bools >> i) & 1;
+            }
+            INFO("b0-b3 " << bools << ", i0.x " << static_cast<int>(loop.x));
+            RunOnBothEngines(*setup, {{1.f, 2.f, 0.f, 0.f}, {1.f, 2.f, 0.f, 0.f}});
+            RunOnBothEngines(*setup, {{1.f, 2.f, 0.f, 0.f}, {-1.f, 2.f, 0.f, 0.f}});
+        }
+    }
+
+    setup->uniforms.i[0] = Common::MakeVec<u8>(2, 1, 2, 0);
+    setup->uniforms.b = {true, true, true, true};
+    const Outputs outputs = RunOnBothEngines(*setup, {{1.f, 2.f, 0.f, 0.f}, {1.f, 2.f, 0.f, 0.f}});
+    const Vec4f c3 = UniformValue(3);
+    const Vec4f c4 = UniformValue(4);
+    REQUIRE(outputs[0] == UniformValue(0));
+    REQUIRE(outputs[1] == Vec4f{});
+    REQUIRE(outputs[2] == Vec4f{c4[0] + 1.f, c4[1] + 2.f, c3[2], c3[3]});
+    REQUIRE(outputs[3] == SumOfUniforms({1, 3, 5}));
+    REQUIRE(outputs[4] == Vec4f{});
+    REQUIRE(outputs[5] == SumOfUniforms({2, 4, 6}));
+    REQUIRE(outputs[6] == SumOfUniforms({0, 0, 0}));
+    REQUIRE(outputs[7] == UniformValue(5));
+}
+
+#endif // ARCHITECTURE_x86_64
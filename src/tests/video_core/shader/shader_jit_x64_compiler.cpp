@@ -4,9 +4,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <memory>
 #include <catch2/catch.hpp>
 #include <nihstro/inline_assembly.h>
+#include "tests/video_core/shader/program_builder.h"
 #include "video_core/shader/shader_jit_x64_compiler.h"
 
 using float24 = Pica::float24;
@@ -89,3 +91,199 @@ TEST_CASE("EX2", "[video_core][shader][shader_jit]") {
     REQUIRE(shader.Run(79.7262742773f) == Approx(1.e24f));
     REQUIRE(std::isinf(shader.Run(800.f)));
 }
+
+/// Runs programs built with a ProgramBuilder, which can use flow control and uniforms
+class ProgramTest {
+public:
+    explicit ProgramTest(const ProgramBuilder& program)
+        : setup(program.MakeSetup()), shader(std::make_unique<JitShader>()) {
+        shader->Compile(&setup->program_code, &setup->swizzle_data);
+    }
+
+    /// Sets all components of a float uniform
+    void SetFloatUniform(unsigned index, float value) {
+        const auto value24 = float24::FromFloat32(value);
+        setup->uniforms.f[index] = Common::MakeVec(value24, value24, value24, value24);
+    }
+
+    void SetBoolUniform(unsigned index, bool value) {
+        setup->uniforms.b[index] = value;
+    }
+
+    void SetIntUniform(unsigned index, u8 x, u8 y, u8 z) {
+        setup->uniforms.i[index] = Common::MakeVec<u8>(x, y, z, 0);
+    }
+
+    float Run(float input) {
+        Pica::Shader::UnitState shader_unit;
+        std::memset(&shader_unit.registers, 0, sizeof(shader_unit.registers));
+
+        shader_unit.registers.input[0].x = float24::FromFloat32(input);
+        shader->Run(*setup, shader_unit, 0);
+        return shader_unit.registers.output[0].x.ToFloat32();
+    }
+
+private:
+    std::unique_ptr<Pica::Shader::ShaderSetup> setup;
+    std::unique_ptr<JitShader> shader;
+};
+
+TEST_CASE("LOOP", "[video_core][shader][shader_jit]") {
+    using P = ProgramBuilder;
+    ProgramBuilder program;
+    // clang-format off
+    program.UniformFlowControl(OpCode::Id::LOOP, 0, 2);                                 // 0
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Input(0), "xyzw",   // 1
+                       P::Temporary(0), "xyzw");
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(1), "xyzw", P::Uniform(0), "xyzw", // 2
+                       P::Temporary(1), "xyzw", P::AL);
+    program.Arithmetic(OpCode::Id::ADD, P::Output(0), "xyzw", P::Temporary(0), "xyzw",  // 3
+                       P::Temporary(1), "xyzw");
+    program.Trivial(OpCode::Id::END);                                                   // 4
+    // clang-format on
+
+    ProgramTest shader(program);
+    for (unsigned i = 0; i < 16; ++i) {
+        shader.SetFloatUniform(i, static_cast<float>(i));
+    }
+
+    // Four iterations with aL = 2, 3, 4, 5
+    shader.SetIntUniform(0, 3, 2, 1);
+    REQUIRE(shader.Run(1.f) == 4.f + 14.f);
+    REQUIRE(shader.Run(-0.5f) == -2.f + 14.f);
+
+    // One iteration with aL = 10
+    shader.SetIntUniform(0, 0, 10, 1);
+    REQUIRE(shader.Run(1.f) == 1.f + 10.f);
+
+    // Three iterations with aL = 1, 4, 7
+    shader.SetIntUniform(0, 2, 1, 3);
+    REQUIRE(shader.Run(0.f) == 12.f);
+}
+
+TEST_CASE("CALL, CALLC and CALLU", "[video_core][shader][shader_jit]") {
+    using P = ProgramBuilder;
+    using CompareOp = ProgramBuilder::CompareOp;
+    using ConditionOp = ProgramBuilder::ConditionOp;
+    ProgramBuilder program;
+    // clang-format off
+    program.Compare(P::Uniform(0), "xyzw", CompareOp::LessThan, CompareOp::LessThan,    // 0
+                    P::Input(0), "xyzw");
+    program.Call(6, 1);                                                                 // 1
+    program.Conditional(OpCode::Id::CALLC, ConditionOp::JustX, true, false, 7, 1);      // 2
+    program.UniformFlowControl(OpCode::Id::CALLU, 0, 8, 2);                             // 3
+    program.Arithmetic(OpCode::Id::MOV, P::Output(0), "xyzw", P::Temporary(0), "xyzw"); // 4
+    program.Trivial(OpCode::Id::END);                                                   // 5
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Uniform(1), "xyzw", // 6
+                       P::Temporary(0), "xyzw");
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Uniform(2), "xyzw", // 7
+                       P::Temporary(0), "xyzw");
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Uniform(3), "xyzw", // 8
+                       P::Temporary(0), "xyzw");
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Uniform(3), "xyzw", // 9
+                       P::Temporary(0), "xyzw");
+    // clang-format on
+
+    ProgramTest shader(program);
+    shader.SetFloatUniform(0, 0.f);
+    shader.SetFloatUniform(1, 1.f);
+    shader.SetFloatUniform(2, 10.f);
+    shader.SetFloatUniform(3, 100.f);
+
+    shader.SetBoolUniform(0, false);
+    REQUIRE(shader.Run(1.f) == 11.f);
+    REQUIRE(shader.Run(-1.f) == 1.f);
+
+    shader.SetBoolUniform(0, true);
+    REQUIRE(shader.Run(1.f) == 211.f);
+    REQUIRE(shader.Run(-1.f) == 201.f);
+}
+
+TEST_CASE("IF and ELSE", "[video_core][shader][shader_jit]") {
+    using P = ProgramBuilder;
+    using CompareOp = ProgramBuilder::CompareOp;
+    using ConditionOp = ProgramBuilder::ConditionOp;
+    ProgramBuilder program;
+    // clang-format off
+    program.Compare(P::Uniform(0), "xyzw", CompareOp::LessThan, CompareOp::LessThan,    // 0
+                    P::Input(0), "xyzw");
+    program.Conditional(OpCode::Id::IFC, ConditionOp::JustX, true, false, 3, 2);        // 1
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Uniform(1), "xyzw", // 2
+                       P::Temporary(0), "xyzw");
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Uniform(2), "xyzw", // 3
+                       P::Temporary(0), "xyzw");
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Uniform(2), "xyzw", // 4
+                       P::Temporary(0), "xyzw");
+    program.UniformFlowControl(OpCode::Id::IFU, 0, 7, 1);                               // 5
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Uniform(3), "xyzw", // 6
+                       P::Temporary(0), "xyzw");
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Uniform(4), "xyzw", // 7
+                       P::Temporary(0), "xyzw");
+    program.UniformFlowControl(OpCode::Id::IFU, 1, 10, 0);                              // 8
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Uniform(5), "xyzw", // 9
+                       P::Temporary(0), "xyzw");
+    program.Arithmetic(OpCode::Id::MOV, P::Output(0), "xyzw", P::Temporary(0), "xyzw"); // 10
+    program.Trivial(OpCode::Id::END);                                                   // 11
+    // clang-format on
+
+    ProgramTest shader(program);
+    shader.SetFloatUniform(0, 0.f);
+    shader.SetFloatUniform(1, 1.f);
+    shader.SetFloatUniform(2, 10.f);
+    shader.SetFloatUniform(3, 100.f);
+    shader.SetFloatUniform(4, 1000.f);
+    shader.SetFloatUniform(5, 10000.f);
+
+    shader.SetBoolUniform(0, false);
+    shader.SetBoolUniform(1, false);
+    REQUIRE(shader.Run(1.f) == 1001.f);
+    REQUIRE(shader.Run(-1.f) == 1020.f);
+
+    shader.SetBoolUniform(0, true);
+    shader.SetBoolUniform(1, true);
+    REQUIRE(shader.Run(1.f) == 10101.f);
+    REQUIRE(shader.Run(-1.f) == 10120.f);
+}
+
+TEST_CASE("Nested flow control", "[video_core][shader][shader_jit]") {
+    using P = ProgramBuilder;
+    using CompareOp = ProgramBuilder::CompareOp;
+    using ConditionOp = ProgramBuilder::ConditionOp;
+    ProgramBuilder program;
+    // clang-format off
+    program.UniformFlowControl(OpCode::Id::LOOP, 0, 5);                                 // 0
+    program.UniformFlowControl(OpCode::Id::IFU, 0, 4, 1);                               // 1
+    program.Call(8, 4);                                                                 // 2
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Uniform(1), "xyzw", // 3
+                       P::Temporary(0), "xyzw");
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Uniform(2), "xyzw", // 4
+                       P::Temporary(0), "xyzw");
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(1), "xyzw", P::Uniform(1), "xyzw", // 5
+                       P::Temporary(1), "xyzw");
+    program.Arithmetic(OpCode::Id::ADD, P::Output(0), "xyzw", P::Temporary(0), "xyzw",  // 6
+                       P::Temporary(1), "xyzw");
+    program.Trivial(OpCode::Id::END);                                                   // 7
+    program.Compare(P::Uniform(0), "xyzw", CompareOp::LessThan, CompareOp::LessThan,    // 8
+                    P::Input(0), "xyzw");
+    program.Conditional(OpCode::Id::IFC, ConditionOp::JustX, true, false, 11, 1);       // 9
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Uniform(3), "xyzw", // 10
+                       P::Temporary(0), "xyzw");
+    program.Arithmetic(OpCode::Id::ADD, P::Temporary(0), "xyzw", P::Uniform(4), "xyzw", // 11
+                       P::Temporary(0), "xyzw");
+    // clang-format on
+
+    ProgramTest shader(program);
+    shader.SetFloatUniform(0, 0.f);
+    shader.SetFloatUniform(1, 1.f);
+    shader.SetFloatUniform(2, 10.f);
+    shader.SetFloatUniform(3, 100.f);
+    shader.SetFloatUniform(4, 1000.f);
+    shader.SetIntUniform(0, 2, 0, 1);
+
+    shader.SetBoolUniform(0, true);
+    REQUIRE(shader.Run(1.f) == 306.f);
+    REQUIRE(shader.Run(-1.f) == 3006.f);
+
+    shader.SetBoolUniform(0, false);
+    REQUIRE(shader.Run(1.f) == 33.f);
+}
@@ -0,0 +1,85 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <nihstro/inline_assembly.h>
+#include "video_core/shader/shader_liveness.h"
+
+using namespace Pica::Shader;
+
+using DestRegister = nihstro::DestRegister;
+using OpCode = nihstro::OpCode;
+using SourceRegister = nihstro::SourceRegister;
+
+namespace {
+
+/// Output components of o0
+constexpr u64 OUTPUT_0 = 0xF;
+/// Output components of o1
+constexpr u64 OUTPUT_1 = 0xF0;
+
+std::bitset<MAX_PROGRAM_CODE_LENGTH> FindDeadInstructions(
+    std::initializer_list<nihstro::InlineAsm> code, u64 live_outputs) {
+    const auto shbin = nihstro::InlineAsm::CompileToRawBinary(code);
+
+    ProgramCode program_code{};
+    SwizzleData swizzle_data{};
+    std::transform(shbin.program.begin(), shbin.program.end(), program_code.begin(),
+                   [](const auto& x) { return x.hex; });
+    std::transform(shbin.swizzle_table.begin(), shbin.swizzle_table.end(), swizzle_data.begin(),
+                   [](const auto& x) { return x.hex; });
+    return Pica::Shader::FindDeadInstructions(program_code, swizzle_data, live_outputs);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Instructions writing unused outputs are dead", "[video_core][shader][liveness]") {
+    const std::initializer_list<nihstro::InlineAsm> code = {
+        // clang-format off
+        {OpCode::Id::MOV, DestRegister::MakeOutput(0), SourceRegister::MakeInput(0)},
+        {OpCode::Id::MOV, DestRegister::MakeOutput(1), SourceRegister::MakeInput(1)},
+        {OpCode::Id::END},
+        // clang-format on
+    };
+
+    const auto dead = FindDeadInstructions(code, OUTPUT_0);
+    REQUIRE(!dead[0]);
+    REQUIRE(dead[1]);
+    REQUIRE(!dead[2]);
+    REQUIRE(FindDeadInstructions(code, OUTPUT_0 | OUTPUT_1).none());
+}
+
+TEST_CASE("Temporaries are live until their last use", "[video_core][shader][liveness]") {
+    const std::initializer_list<nihstro::InlineAsm> code = {
+        // clang-format off
+        {OpCode::Id::MOV, DestRegister::MakeTemporary(0), SourceRegister::MakeInput(0)},
+        {OpCode::Id::MOV, DestRegister::MakeTemporary(1), SourceRegister::MakeInput(1)},
+        {OpCode::Id::MOV, DestRegister::MakeOutput(0), SourceRegister::MakeTemporary(0)},
+        {OpCode::Id::MOV, DestRegister::MakeOutput(1), SourceRegister::MakeTemporary(1)},
+        {OpCode::Id::END},
+        // clang-format on
+    };
+
+    const auto dead = FindDeadInstructions(code, OUTPUT_1);
+    REQUIRE(dead[0]);
+    REQUIRE(!dead[1]);
+    REQUIRE(dead[2]);
+    REQUIRE(!dead[3]);
+    REQUIRE(FindDeadInstructions(code, 0).count() == 4);
+}
+
+TEST_CASE("Overwritten results are dead", "[video_core][shader][liveness]") {
+    const auto dead = FindDeadInstructions(
+        {
+            // clang-format off
+            {OpCode::Id::MOV, DestRegister::MakeOutput(0), SourceRegister::MakeInput(0)},
+            {OpCode::Id::MOV, DestRegister::MakeOutput(0), SourceRegister::MakeInput(1)},
+            {OpCode::Id::END},
+            // clang-format on
+        },
+        OUTPUT_0);
+    REQUIRE(dead[0]);
+    REQUIRE(!dead[1]);
+}
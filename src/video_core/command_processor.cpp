@@ -113,6 +113,16 @@ static void WriteUniformFloatReg(ShaderRegs& config, Shader::ShaderSetup& setup,
     }
 }
 
+/// Prepares the vertex shader for a batch of vertices, letting the engine skip unused outputs
+static void SetupVertexShaderBatch(Shader::ShaderEngine* shader_engine) {
+    const auto& regs = g_state.regs;
+    // With a geometry shader, all outputs are passed on to it
+    g_state.vs.live_outputs = regs.pipeline.use_gs == PipelineRegs::UseGS::No
+                                  ? Shader::OutputVertex::GetUsedOutputs(regs.vs, regs.rasterizer)
+                                  : ~u64{0};
+    shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
+}
+
 static void WritePicaReg(u32 id, u32 value, u32 mask) {
     auto& regs = g_state.regs;
 
@@ -212,6 +222,9 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
                 if (immediate_attribute_id < regs.pipeline.max_input_attrib_index) {
                     immediate_attribute_id += 1;
+                } else if (VideoCore::g_renderer->AreDrawsSkipped()) {
+                    // The vertex is dropped along with the rest of the frame's draws
+                    immediate_attribute_id = 0;
                 } else {
                     MICROPROFILE_SCOPE(GPU_Drawing);
                     immediate_attribute_id = 0;
@@ -219,7 +232,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                     Shader::OutputVertex::ValidateSemantics(regs.rasterizer);
 
                     auto* shader_engine = Shader::GetEngine();
-                    shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
+                    SetupVertexShaderBatch(shader_engine);
 
                     // Send to vertex shader
                     if (g_debug_context)
@@ -273,6 +286,13 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     // It seems like these trigger vertex rendering
     case PICA_REG_INDEX(pipeline.trigger_draw):
     case PICA_REG_INDEX(pipeline.trigger_draw_indexed): {
+        if (VideoCore::g_renderer->AreDrawsSkipped()) {
+            // Draws only write to the render targets. Register state, memory fills, display
+            // transfers and texture copies are still processed as usual, but anything that reads
+            // the skipped render targets back, including the application, sees stale contents.
+            break;
+        }
+
         MICROPROFILE_SCOPE(GPU_Drawing);
 
 #if PICA_LOG_TEV
@@ -356,7 +376,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         auto* shader_engine = Shader::GetEngine();
         Shader::UnitState shader_unit;
 
-        shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
+        SetupVertexShaderBatch(shader_engine);
 
         g_state.geometry_pipeline.Reconfigure();
         g_state.geometry_pipeline.Setup(shader_engine);
@@ -0,0 +1,139 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "core/frontend/emu_window.h"
+#include "video_core/gpu_thread.h"
+
+namespace VideoCore {
+
+namespace {
+
+/// Set on the GPU thread only
+thread_local bool is_gpu_thread = false;
+
+/// Callbacks deferred by the work that is running on the GPU thread
+thread_local std::vector<std::function<void()>>* deferred_callbacks = nullptr;
+
+} // Anonymous namespace
+
+GPUThread::GPUThread(Frontend::EmuWindow& emu_window)
+    : emu_window(emu_window), thread(&GPUThread::ThreadLoop, this) {}
+
+GPUThread::~GPUThread() {
+    queue.Push([this] {
+        if (context_acquired) {
+            emu_window.DoneCurrent();
+        }
+        running = false;
+    });
+    thread.join();
+
+    if (context_acquired) {
+        emu_window.MakeCurrent();
+    }
+}
+
+u64 GPUThread::Push(std::function<void()> work) {
+    std::lock_guard lock{submit_mutex};
+    if (!context_acquired) {
+        // The submitting thread holds the context until the GPU thread starts rendering
+        context_acquired = true;
+        emu_window.DoneCurrent();
+        queue.Push([this] { emu_window.MakeCurrent(); });
+        ++submitted_fence;
+    }
+    queue.Push(std::move(work));
+    return ++submitted_fence;
+}
+
+void GPUThread::RunSync(std::function<void()> func) {
+    // Until the first submission, the calling thread still holds the context
+    if (IsGPUThread() || !context_acquired) {
+        func();
+        return;
+    }
+    WaitForFence(Push(std::move(func)));
+}
+
+void GPUThread::WaitForFence(u64 fence) {
+    if (signaled_fence.load(std::memory_order_acquire) >= fence) {
+        return;
+    }
+    std::unique_lock lock{fence_mutex};
+    fence_cv.wait(lock, [this, fence] { return signaled_fence >= fence; });
+}
+
+void GPUThread::WaitForIdle() {
+    WaitForFence(submitted_fence);
+}
+
+void GPUThread::Retire(u64 fence) {
+    // Fences of events restored from a savestate can be ahead of this session
+    fence = std::min(fence, submitted_fence.load());
+    WaitForFence(fence);
+
+    while (true) {
+        std::vector<std::function<void()>> callbacks;
+        {
+            std::lock_guard lock{completion_mutex};
+            if (completions.empty() || completions.front().fence > fence) {
+                return;
+            }
+            callbacks = std::move(completions.front().callbacks);
+            completions.pop_front();
+        }
+        for (const auto& callback : callbacks) {
+            callback();
+        }
+    }
+}
+
+void GPUThread::RetireAll() {
+    Retire(submitted_fence);
+}
+
+bool GPUThread::IsGPUThread() {
+    return is_gpu_thread;
+}
+
+bool GPUThread::DeferToCPU(std::function<void()> callback) {
+    if (deferred_callbacks == nullptr) {
+        return false;
+    }
+    deferred_callbacks->push_back(std::move(callback));
+    return true;
+}
+
+void GPUThread::ThreadLoop() {
+    Common::SetCurrentThreadName("GPUThread");
+    MicroProfileOnThreadCreate("GPUThread");
+    is_gpu_thread = true;
+
+    u64 fence = 0;
+    std::vector<std::function<void()>> callbacks;
+    while (running) {
+        std::function<void()> work = queue.PopWait();
+
+        deferred_callbacks = &callbacks;
+        work();
+        deferred_callbacks = nullptr;
+        ++fence;
+
+        if (!callbacks.empty()) {
+            std::lock_guard lock{completion_mutex};
+            completions.push_back({fence, std::move(callbacks)});
+            callbacks.clear();
+        }
+        {
+            std::lock_guard lock{fence_mutex};
+            signaled_fence.store(fence, std::memory_order_release);
+        }
+        fence_cv.notify_all();
+    }
+}
+
+} // namespace VideoCore
@@ -0,0 +1,102 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+#include "common/threadsafe_queue.h"
+
+namespace Frontend {
+class EmuWindow;
+}
+
+namespace VideoCore {
+
+/**
+ * Runs the work of the emulated GPU on a dedicated host thread, so that it overlaps with the
+ * emulated CPU. Work can be submitted from any thread and runs in submission order, and every
+ * submission is identified by a fence that is signaled once it has run. Side effects of the work
+ * on the emulated system, like signalling interrupts, are deferred to the emulated CPU thread and
+ * happen when it retires the submission, so the guest observes them in submission order.
+ *
+ * The graphics context of the emulator window is taken from the thread that submits the first
+ * work, and is handed to the thread that destroys the GPU thread once all work has run.
+ */
+class GPUThread {
+public:
+    explicit GPUThread(Frontend::EmuWindow& emu_window);
+    ~GPUThread();
+
+    /**
+     * Queues work for the GPU thread.
+     * @param work Work to run
+     * @return The fence that is signaled once the work has run
+     */
+    u64 Push(std::function<void()> work);
+
+    /**
+     * Runs a function on the GPU thread and waits for it. The function runs directly if called from
+     * the GPU thread, or if no work was submitted yet.
+     */
+    void RunSync(std::function<void()> func);
+
+    /// Waits until the work up to the given fence has run
+    void WaitForFence(u64 fence);
+
+    /// Waits until all queued work has run
+    void WaitForIdle();
+
+    /**
+     * Waits until the work up to the given fence has run, and runs the callbacks it deferred to the
+     * emulated CPU thread in submission order.
+     */
+    void Retire(u64 fence);
+
+    /// Retires all submitted work
+    void RetireAll();
+
+    /// Returns whether the calling thread is the GPU thread
+    static bool IsGPUThread();
+
+    /**
+     * Defers a callback from the work running on the GPU thread to the emulated CPU thread, which
+     * runs it when retiring the work.
+     * @return False if not called from the GPU thread, in which case the callback is not stored
+     */
+    static bool DeferToCPU(std::function<void()> callback);
+
+private:
+    struct Completion {
+        u64 fence;
+        std::vector<std::function<void()>> callbacks;
+    };
+
+    void ThreadLoop();
+
+    Frontend::EmuWindow& emu_window;
+    std::atomic<bool> context_acquired{false};
+
+    /// Keeps the fences in the order in which work is queued
+    std::mutex submit_mutex;
+    Common::MPSCQueue<std::function<void()>> queue;
+    std::atomic<u64> submitted_fence{0};
+    std::atomic<u64> signaled_fence{0};
+    std::mutex fence_mutex;
+    std::condition_variable fence_cv;
+
+    std::mutex completion_mutex;
+    std::deque<Completion> completions;
+
+    bool running = true;
+    std::thread thread;
+};
+
+} // namespace VideoCore
@@ -4,6 +4,7 @@
 
 #include <memory>
 #include "core/frontend/emu_window.h"
+#include "core/settings.h"
 #include "video_core/renderer_base.h"
 #include "video_core/renderer_opengl/gl_rasterizer.h"
 #include "video_core/swrasterizer/swrasterizer.h"
@@ -32,3 +33,24 @@ void RendererBase::RefreshRasterizerSetting() {
 void RendererBase::Sync() {
     rasterizer->SyncEntireState();
 }
+
+void RendererBase::AdvanceFrameSkip() {
+    if (VideoCore::g_turbo_until_trigger) {
+        // Draws still run so that the emulated state stays exact, only presenting is skipped
+        frame_skipped = true;
+        draws_skipped = false;
+        return;
+    }
+    if (!Settings::values.use_turbo || Settings::values.turbo_frame_interval == 0) {
+        frame_skipped = false;
+        draws_skipped = false;
+        turbo_frame = 0;
+        return;
+    }
+
+    // Skip the first turbo_skip_frames frames of every interval, so at least one frame per interval
+    // is still presented unless every frame is skipped
+    turbo_frame = (turbo_frame + 1) % Settings::values.turbo_frame_interval;
+    frame_skipped = turbo_frame < Settings::values.turbo_skip_frames;
+    draws_skipped = frame_skipped;
+}
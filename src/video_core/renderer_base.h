@@ -51,6 +51,19 @@ public:
         return m_current_frame;
     }
 
+    /// Whether the current guest frame won't be presented because of turbo mode
+    bool IsFrameSkipped() const {
+        return frame_skipped;
+    }
+
+    /**
+     * Whether the draws of the current guest frame are skipped because of turbo mode. Skipped draws
+     * leave their render targets stale, which the application can observe if it reads them back.
+     */
+    bool AreDrawsSkipped() const {
+        return draws_skipped;
+    }
+
     VideoCore::RasterizerInterface* Rasterizer() const {
         return rasterizer.get();
     }
@@ -67,6 +80,10 @@ public:
     void Sync();
 
 protected:
+    /// Decides whether the next guest frame is rasterized. Should be called by the renderer at the
+    /// end of every frame.
+    void AdvanceFrameSkip();
+
     Frontend::EmuWindow& render_window; ///< Reference to the render window handle.
     std::unique_ptr<VideoCore::RasterizerInterface> rasterizer;
     f32 m_current_fps = 0.0f; ///< Current framerate, should be set by the renderer
@@ -74,4 +91,7 @@ protected:
 
 private:
     bool opengl_rasterizer_active = false;
+    bool frame_skipped = false;
+    bool draws_skipped = false;
+    u32 turbo_frame = 0; ///< Position of the current frame in the turbo frame interval
 };
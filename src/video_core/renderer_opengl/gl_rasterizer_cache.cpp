@@ -721,26 +721,19 @@ bool CachedSurface::LoadCustomTexture(u64 tex_hash) {
         return true;
     }
 
-    if (!custom_tex_cache.CustomTextureExists(tex_hash)) {
-        return false;
+    if (custom_tex_cache.LoadPackedTexture(tex_hash, custom_tex_info)) {
+        return true;
     }
 
-    const auto& path_info = custom_tex_cache.LookupTexturePathInfo(tex_hash);
-    if (!image_interface->DecodePNG(custom_tex_info.tex, custom_tex_info.width,
-                                    custom_tex_info.height, path_info.path)) {
-        LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
+    if (!custom_tex_cache.CustomTextureExists(tex_hash)) {
         return false;
     }
 
-    const std::bitset<32> width_bits(custom_tex_info.width);
-    const std::bitset<32> height_bits(custom_tex_info.height);
-    if (width_bits.count() != 1 || height_bits.count() != 1) {
-        LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
+    const auto& path_info = custom_tex_cache.LookupTexturePathInfo(tex_hash);
+    if (!Core::DecodeCustomTexture(*image_interface, path_info.path, custom_tex_info)) {
         return false;
     }
 
-    LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
-    Common::FlipRGBA8Texture(custom_tex_info.tex, custom_tex_info.width, custom_tex_info.height);
     custom_tex_cache.CacheTexture(tex_hash, custom_tex_info.tex, custom_tex_info.width,
                                   custom_tex_info.height);
     return true;
@@ -17,7 +17,6 @@
 #include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "core/core.h"
-#include "core/core_timing.h"
 #include "core/dumping/backend.h"
 #include "core/frontend/emu_window.h"
 #include "core/frontend/framebuffer_layout.h"
@@ -390,32 +389,28 @@ void RendererOpenGL::SwapBuffers() {
     OpenGLState prev_state = OpenGLState::GetCurState();
     state.Apply();
 
-    PrepareRendertarget();
+    // Frames skipped by turbo mode weren't rasterized, so there is nothing worth presenting
+    if (!IsFrameSkipped() || VideoCore::g_renderer_screenshot_requested) {
+        PrepareRendertarget();
 
-    RenderScreenshot();
+        RenderScreenshot();
 
-    const auto& layout = render_window.GetFramebufferLayout();
-    RenderToMailbox(layout, render_window.mailbox, false);
+        const auto& layout = render_window.GetFramebufferLayout();
+        RenderToMailbox(layout, render_window.mailbox, false);
 
-    if (frame_dumper.IsDumping()) {
-        try {
-            RenderToMailbox(frame_dumper.GetLayout(), frame_dumper.mailbox, true);
-        } catch (const OGLTextureMailboxException& exception) {
-            LOG_DEBUG(Render_OpenGL, "Frame dumper exception caught: {}", exception.what());
+        if (frame_dumper.IsDumping()) {
+            try {
+                RenderToMailbox(frame_dumper.GetLayout(), frame_dumper.mailbox, true);
+            } catch (const OGLTextureMailboxException& exception) {
+                LOG_DEBUG(Render_OpenGL, "Frame dumper exception caught: {}", exception.what());
+            }
         }
-    }
 
-    RenderCTroll3D();
+        RenderCTroll3D();
+    }
 
     m_current_frame++;
-
-    Core::System::GetInstance().perf_stats->EndSystemFrame();
-
-    render_window.PollEvents();
-
-    Core::System::GetInstance().frame_limiter.DoFrameLimiting(
-        Core::System::GetInstance().CoreTiming().GetGlobalTimeUs());
-    Core::System::GetInstance().perf_stats->BeginSystemFrame();
+    AdvanceFrameSkip();
 
     prev_state.Apply();
     RefreshRasterizerSetting();
@@ -32,6 +32,27 @@ void OutputVertex::ValidateSemantics(const RasterizerRegs& regs) {
     }
 }
 
+u64 OutputVertex::GetUsedOutputs(const ShaderRegs& vs_regs, const RasterizerRegs& regs) {
+    // Output registers are written to consecutive attributes, of which only the first
+    // vs_output_total are mapped to semantics
+    const unsigned num_attributes = regs.vs_output_total & 7;
+    unsigned attrib = 0;
+    u64 used = 0;
+    for (int reg : Common::BitSet<u32>(vs_regs.output_mask)) {
+        if (attrib >= num_attributes) {
+            break;
+        }
+        const u32 output_register_map = regs.vs_output_attributes[attrib++].raw;
+        for (unsigned comp = 0; comp < 4; ++comp) {
+            const u32 semantic = (output_register_map >> (8 * comp)) & 0x1F;
+            if (semantic != RasterizerRegs::VSOutputAttributes::INVALID) {
+                used |= u64{1} << (reg * 4 + comp);
+            }
+        }
+    }
+    return used;
+}
+
 OutputVertex OutputVertex::FromAttributeBuffer(const RasterizerRegs& regs,
                                                const AttributeBuffer& input) {
     // Setup output data
@@ -137,7 +158,7 @@ MICROPROFILE_DEFINE(GPU_Shader, "GPU", "Shader", MP_RGB(50, 50, 240));
 #ifdef ARCHITECTURE_x86_64
 static std::unique_ptr<JitX64Engine> jit_engine;
 #endif // ARCHITECTURE_x86_64
-static InterpreterEngine interpreter_engine;
+static std::unique_ptr<InterpreterEngine> interpreter_engine;
 
 ShaderEngine* GetEngine() {
 #ifdef ARCHITECTURE_x86_64
@@ -150,13 +171,17 @@ ShaderEngine* GetEngine() {
     }
 #endif // ARCHITECTURE_x86_64
 
-    return &interpreter_engine;
+    if (interpreter_engine == nullptr) {
+        interpreter_engine = std::make_unique<InterpreterEngine>();
+    }
+    return interpreter_engine.get();
 }
 
 void Shutdown() {
 #ifdef ARCHITECTURE_x86_64
     jit_engine = nullptr;
 #endif // ARCHITECTURE_x86_64
+    interpreter_engine = nullptr;
 }
 
 } // namespace Pica::Shader
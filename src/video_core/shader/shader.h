@@ -62,6 +62,13 @@ struct OutputVertex {
     Common::Vec2<float24> tc2;
 
     static void ValidateSemantics(const RasterizerRegs& regs);
+
+    /**
+     * Finds the vertex shader output register components that are read by FromAttributeBuffer.
+     * @return The used components, in the format of ShaderSetup::live_outputs
+     */
+    static u64 GetUsedOutputs(const ShaderRegs& vs_regs, const RasterizerRegs& regs);
+
     static OutputVertex FromAttributeBuffer(const RasterizerRegs& regs,
                                             const AttributeBuffer& output);
 
@@ -273,10 +280,14 @@ struct ShaderSetup {
     ProgramCode program_code;
     SwizzleData swizzle_data;
 
+    /// Output register components that are read after the program ends, with bit 4 * n + c for
+    /// component c of output register n. Engines may skip code that only computes other outputs.
+    u64 live_outputs = ~u64{0};
+
     /// Data private to ShaderEngines
     struct EngineData {
         unsigned int entry_point;
-        /// Used by the JIT, points to a compiled shader object.
+        /// Points to a compiled shader object of the JIT or a decoded program of the interpreter.
         const void* cached_shader = nullptr;
     } engine_data;
 
@@ -5,6 +5,8 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstring>
+#include <memory>
 #include <numeric>
 #include <boost/container/static_vector.hpp>
 #include <boost/range/algorithm/fill.hpp>
@@ -666,19 +668,819 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
     }
 }
 
+/// Operations executed by the pre-decoded interpreter
+enum class DecodedOp : u8 {
+    // Arithmetic operations, which read their sources and write the destination
+    ADD,
+    MUL,
+    FLR,
+    MAX,
+    MIN,
+    DP3,
+    DP4,
+    DPH,
+    RCP,
+    RSQ,
+    MOVA,
+    MOV,
+    SGE,
+    SLT,
+    CMP,
+    EX2,
+    LG2,
+    MAD,
+
+    // Flow control and other operations
+    END,
+    JMPC,
+    JMPU,
+    CALL,
+    CALLU,
+    CALLC,
+    NOP,
+    IFU,
+    IFC,
+    LOOP,
+    EMIT,
+    SETEMIT,
+    Unhandled,
+};
+
+/// Register files a source operand can be read from
+enum class SourceBase : u8 {
+    State = 0,
+    Uniforms = 1,
+    Dummy = 2,
+};
+
+/// Value of DecodedInstruction::relative_source when no source uses relative addressing
+constexpr u8 NO_RELATIVE_SOURCE = 0xFF;
+
+/// Sign bit of a float24, which is stored as a 32-bit float
+constexpr u32 SIGN_BIT = 0x80000000;
+static_assert(sizeof(float24) == sizeof(u32), "float24 is not stored as a 32-bit float");
+
+struct DecodedSource {
+    u16 offset = 0; ///< Byte offset of the register in its register file
+    SourceBase base = SourceBase::Dummy;
+    std::array<u8, 4> selector{}; ///< Register component read for each swizzled component
+    u32 negate_mask = 0;          ///< XORed into every component to negate the operand
+    bool identity = false;        ///< Whether the components are read in order
+};
+
+/// Block of instructions entered by a call, conditional or loop
+struct DecodedCall {
+    u16 offset = 0;         ///< First instruction of the block
+    u16 final_address = 0;  ///< Address upon which we jump to return_address
+    u16 return_address = 0; ///< Where to jump when leaving the block
+};
+
+struct DecodedInstruction;
+
+/// Register files of a shader unit, indexed by SourceBase
+using SourceBases = std::array<const u8*, 3>;
+
+using ArithmeticHandler = void (*)(const DecodedInstruction& op, const SourceBases& bases,
+                                   UnitState& state);
+
+struct DecodedInstruction {
+    DecodedOp op = DecodedOp::Unhandled;
+    ArithmeticHandler handler = nullptr; ///< Executes arithmetic operations
+    u16 dest_offset = 0;                 ///< Byte offset of the destination register in UnitState
+    u8 address_register_index = 0;
+    u8 relative_source = NO_RELATIVE_SOURCE; ///< Source offset by the address register
+    u8 condition = 0;     ///< Result of the condition, indexed by the two conditional codes
+    u8 uniform_id = 0;    ///< Bool or int uniform read by flow control
+    bool jump_if = false; ///< Bool uniform value on which JMPU jumps
+    std::array<DecodedSource, 3> src{};
+    std::array<u32, 4> dest_mask{}; ///< Bits of each component written to the destination
+    DecodedCall target{};           ///< Jump or call target, or the block entered if true
+    DecodedCall else_target{};      ///< Block entered if the condition is false
+    u32 hex = 0;                    ///< Original instruction, for fields that are rarely used
+};
+
+/// Shader program translated to a form that is cheap to interpret
+struct DecodedProgram {
+    std::array<DecodedInstruction, MAX_PROGRAM_CODE_LENGTH> instructions;
+};
+
+static DecodedOp DecodeArithmeticOp(OpCode::Id opcode) {
+    switch (opcode) {
+    case OpCode::Id::ADD:
+        return DecodedOp::ADD;
+    case OpCode::Id::MUL:
+        return DecodedOp::MUL;
+    case OpCode::Id::FLR:
+        return DecodedOp::FLR;
+    case OpCode::Id::MAX:
+        return DecodedOp::MAX;
+    case OpCode::Id::MIN:
+        return DecodedOp::MIN;
+    case OpCode::Id::DP3:
+        return DecodedOp::DP3;
+    case OpCode::Id::DP4:
+        return DecodedOp::DP4;
+    case OpCode::Id::DPH:
+    case OpCode::Id::DPHI:
+        return DecodedOp::DPH;
+    case OpCode::Id::RCP:
+        return DecodedOp::RCP;
+    case OpCode::Id::RSQ:
+        return DecodedOp::RSQ;
+    case OpCode::Id::MOVA:
+        return DecodedOp::MOVA;
+    case OpCode::Id::MOV:
+        return DecodedOp::MOV;
+    case OpCode::Id::SGE:
+    case OpCode::Id::SGEI:
+        return DecodedOp::SGE;
+    case OpCode::Id::SLT:
+    case OpCode::Id::SLTI:
+        return DecodedOp::SLT;
+    case OpCode::Id::CMP:
+        return DecodedOp::CMP;
+    case OpCode::Id::EX2:
+        return DecodedOp::EX2;
+    case OpCode::Id::LG2:
+        return DecodedOp::LG2;
+    default:
+        return DecodedOp::Unhandled;
+    }
+}
+
+static DecodedSource DecodeSource(const SourceRegister& source_reg,
+                                  const std::array<u8, 4>& selector, bool negate) {
+    DecodedSource source;
+    switch (source_reg.GetRegisterType()) {
+    case RegisterType::Input:
+    case RegisterType::Temporary:
+        source.base = SourceBase::State;
+        source.offset = static_cast<u16>(UnitState::InputOffset(source_reg));
+        break;
+    case RegisterType::FloatUniform:
+        source.base = SourceBase::Uniforms;
+        source.offset = static_cast<u16>(Uniforms::GetFloatUniformOffset(source_reg.GetIndex()));
+        break;
+    default:
+        source.base = SourceBase::Dummy;
+        break;
+    }
+    source.selector = selector;
+    source.negate_mask = negate ? SIGN_BIT : 0;
+    source.identity = selector == std::array<u8, 4>{0, 1, 2, 3};
+    return source;
+}
+
+static std::array<u32, 4> DecodeDestMask(const SwizzlePattern& swizzle) {
+    std::array<u32, 4> mask;
+    for (int i = 0; i < 4; ++i) {
+        mask[i] = swizzle.DestComponentEnabled(i) ? 0xFFFFFFFF : 0;
+    }
+    return mask;
+}
+
+/// Evaluates a condition for every combination of conditional codes ahead of time
+static u8 DecodeCondition(Instruction::FlowControlType flow_control) {
+    using Op = Instruction::FlowControlType::Op;
+
+    u8 table = 0;
+    for (unsigned codes = 0; codes < 4; ++codes) {
+        const bool result_x = flow_control.refx.Value() == ((codes & 1) != 0);
+        const bool result_y = flow_control.refy.Value() == ((codes & 2) != 0);
+
+        bool result = false;
+        switch (flow_control.op) {
+        case Op::Or:
+            result = result_x || result_y;
+            break;
+        case Op::And:
+            result = result_x && result_y;
+            break;
+        case Op::JustX:
+            result = result_x;
+            break;
+        case Op::JustY:
+            result = result_y;
+            break;
+        default:
+            UNREACHABLE();
+            break;
+        }
+        table |= static_cast<u8>(result) << codes;
+    }
+    return table;
+}
+
+static DecodedInstruction DecodeInstruction(const SwizzleData& swizzle_data, u32 program_counter,
+                                            const Instruction instr) {
+    DecodedInstruction op;
+    op.hex = instr.hex;
+
+    switch (instr.opcode.Value().GetInfo().type) {
+    case OpCode::Type::Arithmetic: {
+        const SwizzlePattern swizzle = {swizzle_data[instr.common.operand_desc_id]};
+        const bool is_inverted =
+            (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+
+        op.op = DecodeArithmeticOp(instr.opcode.Value().EffectiveOpCode());
+        op.address_register_index = static_cast<u8>(instr.common.address_register_index);
+        if (op.address_register_index != 0) {
+            op.relative_source = is_inverted ? 1 : 0;
+        }
+        op.src[0] = DecodeSource(instr.common.GetSrc1(is_inverted),
+                                 {static_cast<u8>(swizzle.src1_selector_0.Value()),
+                                  static_cast<u8>(swizzle.src1_selector_1.Value()),
+                                  static_cast<u8>(swizzle.src1_selector_2.Value()),
+                                  static_cast<u8>(swizzle.src1_selector_3.Value())},
+                                 static_cast<bool>(swizzle.negate_src1));
+        op.src[1] = DecodeSource(instr.common.GetSrc2(is_inverted),
+                                 {static_cast<u8>(swizzle.src2_selector_0.Value()),
+                                  static_cast<u8>(swizzle.src2_selector_1.Value()),
+                                  static_cast<u8>(swizzle.src2_selector_2.Value()),
+                                  static_cast<u8>(swizzle.src2_selector_3.Value())},
+                                 static_cast<bool>(swizzle.negate_src2));
+        op.dest_mask = DecodeDestMask(swizzle);
+        op.dest_offset = static_cast<u16>(UnitState::OutputOffset(instr.common.dest.Value()));
+        break;
+    }
+
+    case OpCode::Type::MultiplyAdd: {
+        if ((instr.opcode.Value().EffectiveOpCode() != OpCode::Id::MAD) &&
+            (instr.opcode.Value().EffectiveOpCode() != OpCode::Id::MADI)) {
+            break;
+        }
+
+        const SwizzlePattern swizzle = {swizzle_data[instr.mad.operand_desc_id]};
+        const bool is_inverted = (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI);
+
+        op.op = DecodedOp::MAD;
+        op.address_register_index = static_cast<u8>(instr.mad.address_register_index);
+        if (op.address_register_index != 0) {
+            op.relative_source = is_inverted ? 2 : 1;
+        }
+        op.src[0] = DecodeSource(instr.mad.GetSrc1(is_inverted),
+                                 {static_cast<u8>(swizzle.src1_selector_0.Value()),
+                                  static_cast<u8>(swizzle.src1_selector_1.Value()),
+                                  static_cast<u8>(swizzle.src1_selector_2.Value()),
+                                  static_cast<u8>(swizzle.src1_selector_3.Value())},
+                                 static_cast<bool>(swizzle.negate_src1));
+        op.src[1] = DecodeSource(instr.mad.GetSrc2(is_inverted),
+                                 {static_cast<u8>(swizzle.src2_selector_0.Value()),
+                                  static_cast<u8>(swizzle.src2_selector_1.Value()),
+                                  static_cast<u8>(swizzle.src2_selector_2.Value()),
+                                  static_cast<u8>(swizzle.src2_selector_3.Value())},
+                                 static_cast<bool>(swizzle.negate_src2));
+        op.src[2] = DecodeSource(instr.mad.GetSrc3(is_inverted),
+                                 {static_cast<u8>(swizzle.src3_selector_0.Value()),
+                                  static_cast<u8>(swizzle.src3_selector_1.Value()),
+                                  static_cast<u8>(swizzle.src3_selector_2.Value()),
+                                  static_cast<u8>(swizzle.src3_selector_3.Value())},
+                                 static_cast<bool>(swizzle.negate_src3));
+        op.dest_mask = DecodeDestMask(swizzle);
+        op.dest_offset = static_cast<u16>(UnitState::OutputOffset(instr.mad.dest.Value()));
+        break;
+    }
+
+    default: {
+        const u32 dest_offset = instr.flow_control.dest_offset;
+        const u32 num_instructions = instr.flow_control.num_instructions;
+
+        // Calls and conditionals enter a block of instructions that is left once the final
+        // address is reached. The boundaries of these blocks only depend on the instruction.
+        const DecodedCall call_target{static_cast<u16>(dest_offset),
+                                      static_cast<u16>(dest_offset + num_instructions),
+                                      static_cast<u16>(program_counter + 1)};
+        const DecodedCall if_target{static_cast<u16>(program_counter + 1),
+                                    static_cast<u16>(dest_offset),
+                                    static_cast<u16>(dest_offset + num_instructions)};
+        const DecodedCall else_target{static_cast<u16>(dest_offset),
+                                      static_cast<u16>(dest_offset + num_instructions),
+                                      static_cast<u16>(dest_offset + num_instructions)};
+
+        switch (instr.opcode.Value()) {
+        case OpCode::Id::END:
+            op.op = DecodedOp::END;
+            break;
+
+        case OpCode::Id::JMPC:
+            op.op = DecodedOp::JMPC;
+            op.condition = DecodeCondition(instr.flow_control);
+            op.target.offset = static_cast<u16>(dest_offset);
+            break;
+
+        case OpCode::Id::JMPU:
+            op.op = DecodedOp::JMPU;
+            op.uniform_id = static_cast<u8>(instr.flow_control.bool_uniform_id);
+            op.jump_if = !(num_instructions & 1);
+            op.target.offset = static_cast<u16>(dest_offset);
+            break;
+
+        case OpCode::Id::CALL:
+            op.op = DecodedOp::CALL;
+            op.target = call_target;
+            break;
+
+        case OpCode::Id::CALLU:
+            op.op = DecodedOp::CALLU;
+            op.uniform_id = static_cast<u8>(instr.flow_control.bool_uniform_id);
+            op.target = call_target;
+            break;
+
+        case OpCode::Id::CALLC:
+            op.op = DecodedOp::CALLC;
+            op.condition = DecodeCondition(instr.flow_control);
+            op.target = call_target;
+            break;
+
+        case OpCode::Id::NOP:
+            op.op = DecodedOp::NOP;
+            break;
+
+        case OpCode::Id::IFU:
+            op.op = DecodedOp::IFU;
+            op.uniform_id = static_cast<u8>(instr.flow_control.bool_uniform_id);
+            op.target = if_target;
+            op.else_target = else_target;
+            break;
+
+        case OpCode::Id::IFC:
+            op.op = DecodedOp::IFC;
+            op.condition = DecodeCondition(instr.flow_control);
+            op.target = if_target;
+            op.else_target = else_target;
+            break;
+
+        case OpCode::Id::LOOP:
+            op.op = DecodedOp::LOOP;
+            op.uniform_id = static_cast<u8>(instr.flow_control.int_uniform_id);
+            op.target = {static_cast<u16>(program_counter + 1), static_cast<u16>(dest_offset + 1),
+                         static_cast<u16>(dest_offset + 1)};
+            break;
+
+        case OpCode::Id::EMIT:
+            op.op = DecodedOp::EMIT;
+            break;
+
+        case OpCode::Id::SETEMIT:
+            op.op = DecodedOp::SETEMIT;
+            break;
+
+        default:
+            break;
+        }
+        break;
+    }
+    }
+
+    return op;
+}
+
+/// Returns the register read by the source that is offset by an address register
+static SourceRegister GetRelativeSourceRegister(const DecodedInstruction& op) {
+    const Instruction instr = {op.hex};
+    if (op.op == DecodedOp::MAD) {
+        return op.relative_source == 2 ? instr.mad.GetSrc3(true) : instr.mad.GetSrc2(false);
+    }
+    return op.relative_source == 1 ? instr.common.GetSrc2(true) : instr.common.GetSrc1(false);
+}
+
+static const float24* LookupSourceRegister(const SourceBases& bases,
+                                           const SourceRegister& source_reg) {
+    const DecodedSource source = DecodeSource(source_reg, {}, false);
+    return reinterpret_cast<const float24*>(bases[static_cast<std::size_t>(source.base)] +
+                                            source.offset);
+}
+
+FORCE_INLINE static void LoadSource(const DecodedInstruction& op, unsigned index,
+                                    const SourceBases& bases, const UnitState& state,
+                                    float24 (&value)[4]) {
+    const DecodedSource& source = op.src[index];
+
+    const float24* reg;
+    if (index == op.relative_source) {
+        // The register type can change with the offset, so it is only resolved at this point
+        const int address_offset = state.address_registers[op.address_register_index - 1];
+        reg = LookupSourceRegister(bases, GetRelativeSourceRegister(op) + address_offset);
+    } else {
+        reg = reinterpret_cast<const float24*>(bases[static_cast<std::size_t>(source.base)] +
+                                               source.offset);
+    }
+
+    u32 bits[4];
+    if (source.identity) {
+        std::memcpy(bits, reg, sizeof(bits));
+    } else {
+        for (int i = 0; i < 4; ++i) {
+            std::memcpy(&bits[i], &reg[source.selector[i]], sizeof(u32));
+        }
+    }
+    // Negation only flips the sign bit, so it is applied to the bits without branching
+    for (int i = 0; i < 4; ++i) {
+        bits[i] ^= source.negate_mask;
+    }
+    std::memcpy(value, bits, sizeof(bits));
+}
+
+/// Writes the enabled components of a result to the destination register
+FORCE_INLINE static void WriteDest(const DecodedInstruction& op, UnitState& state,
+                                   const float24 (&result)[4]) {
+    u8* dest = reinterpret_cast<u8*>(&state) + op.dest_offset;
+    for (int i = 0; i < 4; ++i) {
+        u32 dest_bits;
+        u32 result_bits;
+        std::memcpy(&dest_bits, dest + i * sizeof(float24), sizeof(dest_bits));
+        std::memcpy(&result_bits, &result[i], sizeof(result_bits));
+        dest_bits = (dest_bits & ~op.dest_mask[i]) | (result_bits & op.dest_mask[i]);
+        std::memcpy(dest + i * sizeof(float24), &dest_bits, sizeof(dest_bits));
+    }
+}
+
+template <DecodedOp Op>
+static void RunArithmetic(const DecodedInstruction& op, const SourceBases& bases,
+                          UnitState& state) {
+    constexpr bool is_unary = Op == DecodedOp::FLR || Op == DecodedOp::RCP ||
+                              Op == DecodedOp::RSQ || Op == DecodedOp::MOVA ||
+                              Op == DecodedOp::MOV || Op == DecodedOp::EX2 || Op == DecodedOp::LG2;
+
+    float24 src1[4];
+    float24 src2[4];
+    LoadSource(op, 0, bases, state, src1);
+    if constexpr (!is_unary)
+        LoadSource(op, 1, bases, state, src2);
+
+    // Every component of the result is computed, and only the enabled ones are written
+    float24 result[4];
+    const auto fill_result = [&result](float24 value) {
+        for (int i = 0; i < 4; ++i) {
+            result[i] = value;
+        }
+    };
+
+    switch (Op) {
+    case DecodedOp::ADD:
+        for (int i = 0; i < 4; ++i) {
+            result[i] = src1[i] + src2[i];
+        }
+        break;
+
+    case DecodedOp::MUL:
+        for (int i = 0; i < 4; ++i) {
+            result[i] = src1[i] * src2[i];
+        }
+        break;
+
+    case DecodedOp::FLR:
+        for (int i = 0; i < 4; ++i) {
+            result[i] = float24::FromFloat32(std::floor(src1[i].ToFloat32()));
+        }
+        break;
+
+    case DecodedOp::MAX:
+        for (int i = 0; i < 4; ++i) {
+            // NOTE: Exact form required to match NaN semantics to hardware:
+            //   max(0, NaN) -> NaN
+            //   max(NaN, 0) -> 0
+            result[i] = (src1[i] > src2[i]) ? src1[i] : src2[i];
+        }
+        break;
+
+    case DecodedOp::MIN:
+        for (int i = 0; i < 4; ++i) {
+            // NOTE: Exact form required to match NaN semantics to hardware:
+            //   min(0, NaN) -> NaN
+            //   min(NaN, 0) -> 0
+            result[i] = (src1[i] < src2[i]) ? src1[i] : src2[i];
+        }
+        break;
+
+    case DecodedOp::DP3:
+    case DecodedOp::DP4:
+    case DecodedOp::DPH: {
+        if (Op == DecodedOp::DPH)
+            src1[3] = float24::FromFloat32(1.0f);
+
+        const int num_components = (Op == DecodedOp::DP3) ? 3 : 4;
+        fill_result(
+            std::inner_product(src1, src1 + num_components, src2, float24::FromFloat32(0.f)));
+        break;
+    }
+
+    // Reciprocal
+    case DecodedOp::RCP:
+        fill_result(float24::FromFloat32(1.0f / src1[0].ToFloat32()));
+        break;
+
+    // Reciprocal Square Root
+    case DecodedOp::RSQ:
+        fill_result(float24::FromFloat32(1.0f / std::sqrt(src1[0].ToFloat32())));
+        break;
+
+    case DecodedOp::MOVA:
+        for (int i = 0; i < 2; ++i) {
+            if (op.dest_mask[i] == 0)
+                continue;
+
+            // TODO: Figure out how the rounding is done on hardware
+            state.address_registers[i] = static_cast<s32>(src1[i].ToFloat32());
+        }
+        return;
+
+    case DecodedOp::MOV:
+        for (int i = 0; i < 4; ++i) {
+            result[i] = src1[i];
+        }
+        break;
+
+    case DecodedOp::SGE:
+        for (int i = 0; i < 4; ++i) {
+            result[i] = (src1[i] >= src2[i]) ? float24::FromFloat32(1.0f)
+                                             : float24::FromFloat32(0.0f);
+        }
+        break;
+
+    case DecodedOp::SLT:
+        for (int i = 0; i < 4; ++i) {
+            result[i] = (src1[i] < src2[i]) ? float24::FromFloat32(1.0f)
+                                            : float24::FromFloat32(0.0f);
+        }
+        break;
+
+    case DecodedOp::CMP: {
+        const Instruction instr = {op.hex};
+        for (int i = 0; i < 2; ++i) {
+            auto compare_op = instr.common.compare_op;
+            auto cmp = (i == 0) ? compare_op.x.Value() : compare_op.y.Value();
+
+            switch (cmp) {
+            case Instruction::Common::CompareOpType::Equal:
+                state.conditional_code[i] = (src1[i] == src2[i]);
+                break;
+
+            case Instruction::Common::CompareOpType::NotEqual:
+                state.conditional_code[i] = (src1[i] != src2[i]);
+                break;
+
+            case Instruction::Common::CompareOpType::LessThan:
+                state.conditional_code[i] = (src1[i] < src2[i]);
+                break;
+
+            case Instruction::Common::CompareOpType::LessEqual:
+                state.conditional_code[i] = (src1[i] <= src2[i]);
+                break;
+
+            case Instruction::Common::CompareOpType::GreaterThan:
+                state.conditional_code[i] = (src1[i] > src2[i]);
+                break;
+
+            case Instruction::Common::CompareOpType::GreaterEqual:
+                state.conditional_code[i] = (src1[i] >= src2[i]);
+                break;
+
+            default:
+                LOG_ERROR(HW_GPU, "Unknown compare mode {:x}", static_cast<int>(cmp));
+                break;
+            }
+        }
+        return;
+    }
+
+    // EX2 only takes first component exp2 and writes it to all dest components
+    case DecodedOp::EX2:
+        fill_result(float24::FromFloat32(std::exp2(src1[0].ToFloat32())));
+        break;
+
+    // LG2 only takes the first component log2 and writes it to all dest components
+    case DecodedOp::LG2:
+        fill_result(float24::FromFloat32(std::log2(src1[0].ToFloat32())));
+        break;
+
+    case DecodedOp::MAD: {
+        float24 src3[4];
+        LoadSource(op, 2, bases, state, src3);
+        for (int i = 0; i < 4; ++i) {
+            result[i] = src1[i] * src2[i] + src3[i];
+        }
+        break;
+    }
+
+    default:
+        UNREACHABLE();
+        return;
+    }
+
+    WriteDest(op, state, result);
+}
+
+static ArithmeticHandler GetArithmeticHandler(DecodedOp op) {
+    switch (op) {
+#define HANDLER(name)                                                                              \
+    case DecodedOp::name:                                                                          \
+        return &RunArithmetic<DecodedOp::name>;
+        HANDLER(ADD)
+        HANDLER(MUL)
+        HANDLER(FLR)
+        HANDLER(MAX)
+        HANDLER(MIN)
+        HANDLER(DP3)
+        HANDLER(DP4)
+        HANDLER(DPH)
+        HANDLER(RCP)
+        HANDLER(RSQ)
+        HANDLER(MOVA)
+        HANDLER(MOV)
+        HANDLER(SGE)
+        HANDLER(SLT)
+        HANDLER(CMP)
+        HANDLER(EX2)
+        HANDLER(LG2)
+        HANDLER(MAD)
+#undef HANDLER
+    default:
+        return nullptr;
+    }
+}
+
+static std::unique_ptr<DecodedProgram> DecodeProgram(const ProgramCode& program_code,
+                                                     const SwizzleData& swizzle_data) {
+    auto program = std::make_unique<DecodedProgram>();
+    for (u32 offset = 0; offset < MAX_PROGRAM_CODE_LENGTH; ++offset) {
+        DecodedInstruction& op = program->instructions[offset];
+        op = DecodeInstruction(swizzle_data, offset, Instruction{program_code[offset]});
+        op.handler = GetArithmeticHandler(op.op);
+    }
+    return program;
+}
+
+/// Runs a pre-decoded program. This matches RunInterpreter without debug data, but does not
+/// decode the instructions and swizzle patterns again for every vertex.
+static void RunDecodedProgram(const DecodedProgram& program, const ShaderSetup& setup,
+                              UnitState& state, unsigned offset) {
+    boost::container::static_vector<CallStackElement, 16> call_stack;
+    u32 program_counter = offset;
+
+    state.conditional_code[0] = false;
+    state.conditional_code[1] = false;
+
+    auto call = [&program_counter, &call_stack](const DecodedCall& target, u8 repeat_count,
+                                                u8 loop_increment) {
+        program_counter = target.offset;
+        ASSERT(call_stack.size() < call_stack.capacity());
+        call_stack.push_back({target.final_address, target.return_address, repeat_count,
+                              loop_increment, target.offset});
+    };
+
+    auto evaluate_condition = [&state](const DecodedInstruction& op) {
+        const unsigned codes = (state.conditional_code[0] ? 1 : 0) |
+                               (state.conditional_code[1] ? 2 : 0);
+        return ((op.condition >> codes) & 1) != 0;
+    };
+
+    const auto& uniforms = setup.uniforms;
+
+    // Placeholder for invalid inputs
+    static float24 dummy_vec4_float24[4];
+    const SourceBases bases = {reinterpret_cast<const u8*>(&state),
+                               reinterpret_cast<const u8*>(&uniforms),
+                               reinterpret_cast<const u8*>(dummy_vec4_float24)};
+
+    while (true) {
+        if (!call_stack.empty()) {
+            auto& top = call_stack.back();
+            if (program_counter == top.final_address) {
+                state.address_registers[2] += top.loop_increment;
+
+                if (top.repeat_counter-- == 0) {
+                    program_counter = top.return_address;
+                    call_stack.pop_back();
+                } else {
+                    program_counter = top.loop_address;
+                }
+
+                // TODO: Is "trying again" accurate to hardware?
+                continue;
+            }
+        }
+
+        const DecodedInstruction& op = program.instructions[program_counter];
+        switch (op.op) {
+        case DecodedOp::END:
+            return;
+
+        case DecodedOp::JMPC:
+            if (evaluate_condition(op)) {
+                program_counter = op.target.offset;
+                continue;
+            }
+            break;
+
+        case DecodedOp::JMPU:
+            if (uniforms.b[op.uniform_id] == op.jump_if) {
+                program_counter = op.target.offset;
+                continue;
+            }
+            break;
+
+        case DecodedOp::CALL:
+            call(op.target, 0, 0);
+            continue;
+
+        case DecodedOp::CALLU:
+            if (uniforms.b[op.uniform_id]) {
+                call(op.target, 0, 0);
+                continue;
+            }
+            break;
+
+        case DecodedOp::CALLC:
+            if (evaluate_condition(op)) {
+                call(op.target, 0, 0);
+                continue;
+            }
+            break;
+
+        case DecodedOp::NOP:
+            break;
+
+        case DecodedOp::IFU:
+            call(uniforms.b[op.uniform_id] ? op.target : op.else_target, 0, 0);
+            continue;
+
+        case DecodedOp::IFC:
+            call(evaluate_condition(op) ? op.target : op.else_target, 0, 0);
+            continue;
+
+        case DecodedOp::LOOP: {
+            const Common::Vec4<u8>& loop_param = uniforms.i[op.uniform_id];
+            state.address_registers[2] = loop_param.y;
+            call(op.target, loop_param.x, loop_param.z);
+            continue;
+        }
+
+        case DecodedOp::EMIT: {
+            GSEmitter* emitter = state.emitter_ptr;
+            ASSERT_MSG(emitter, "Execute EMIT on VS");
+            emitter->Emit(state.registers.output);
+            break;
+        }
+
+        case DecodedOp::SETEMIT: {
+            const Instruction instr = {op.hex};
+            GSEmitter* emitter = state.emitter_ptr;
+            ASSERT_MSG(emitter, "Execute SETEMIT on VS");
+            emitter->vertex_id = instr.setemit.vertex_id;
+            emitter->prim_emit = instr.setemit.prim_emit != 0;
+            emitter->winding = instr.setemit.winding != 0;
+            break;
+        }
+
+        case DecodedOp::Unhandled: {
+            const Instruction instr = {op.hex};
+            LOG_ERROR(HW_GPU, "Unhandled instruction: 0x{:02x} ({}): 0x{:08x}",
+                      (int)instr.opcode.Value().EffectiveOpCode(),
+                      instr.opcode.Value().GetInfo().name, instr.hex);
+            break;
+        }
+
+        default:
+            op.handler(op, bases, state);
+            break;
+        }
+
+        ++program_counter;
+    }
+}
+
+InterpreterEngine::InterpreterEngine() = default;
+InterpreterEngine::~InterpreterEngine() = default;
+
 void InterpreterEngine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
     setup.engine_data.entry_point = entry_point;
+
+    u64 code_hash = setup.GetProgramCodeHash();
+    u64 swizzle_hash = setup.GetSwizzleDataHash();
+
+    u64 cache_key = code_hash ^ swizzle_hash;
+    auto iter = cache.find(cache_key);
+    if (iter != cache.end()) {
+        setup.engine_data.cached_shader = iter->second.get();
+    } else {
+        auto program = DecodeProgram(setup.program_code, setup.swizzle_data);
+        setup.engine_data.cached_shader = program.get();
+        cache.emplace_hint(iter, cache_key, std::move(program));
+    }
 }
 
 MICROPROFILE_DECLARE(GPU_Shader);
 
 void InterpreterEngine::Run(const ShaderSetup& setup, UnitState& state) const {
+    ASSERT(setup.engine_data.cached_shader != nullptr);
 
     MICROPROFILE_SCOPE(GPU_Shader);
 
-    DebugData<false> dummy_debug_data;
-    RunInterpreter(setup, state, dummy_debug_data, setup.engine_data.entry_point);
+    const DecodedProgram* program =
+        static_cast<const DecodedProgram*>(setup.engine_data.cached_shader);
+    RunDecodedProgram(*program, setup, state, setup.engine_data.entry_point);
 }
 
 DebugData<true> InterpreterEngine::ProduceDebugInfo(const ShaderSetup& setup,
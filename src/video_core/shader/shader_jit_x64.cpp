@@ -19,13 +19,16 @@ void JitX64Engine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     u64 code_hash = setup.GetProgramCodeHash();
     u64 swizzle_hash = setup.GetSwizzleDataHash();
 
-    u64 cache_key = code_hash ^ swizzle_hash;
+    u64 live_outputs_hash = Common::ComputeHash64(&setup.live_outputs, sizeof(setup.live_outputs));
+
+    // Variants of a program that compute different sets of outputs are compiled separately
+    u64 cache_key = code_hash ^ swizzle_hash ^ live_outputs_hash;
     auto iter = cache.find(cache_key);
     if (iter != cache.end()) {
         setup.engine_data.cached_shader = iter->second.get();
     } else {
         auto shader = std::make_unique<JitShader>();
-        shader->Compile(&setup.program_code, &setup.swizzle_data);
+        shader->Compile(&setup.program_code, &setup.swizzle_data, setup.live_outputs);
         setup.engine_data.cached_shader = shader.get();
         cache.emplace_hint(iter, cache_key, std::move(shader));
     }
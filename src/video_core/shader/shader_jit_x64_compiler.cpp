@@ -18,6 +18,7 @@
 #include "video_core/pica_types.h"
 #include "video_core/shader/shader.h"
 #include "video_core/shader/shader_jit_x64_compiler.h"
+#include "video_core/shader/shader_liveness.h"
 
 using namespace Common::X64;
 using namespace Xbyak::util;
@@ -847,6 +848,12 @@ void JitShader::Compile_NextInstr() {
 
     L(instruction_labels[program_counter]);
 
+    if (dead_instructions[program_counter]) {
+        // The label is kept, as the instruction can still be the target of a jump
+        ++program_counter;
+        return;
+    }
+
     Instruction instr = {(*program_code)[program_counter++]};
 
     OpCode::Id opcode = instr.opcode.Value();
@@ -885,7 +892,8 @@ void JitShader::FindReturnOffsets() {
 }
 
 void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code_,
-                        const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data_) {
+                        const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data_,
+                        u64 live_outputs) {
     program_code = program_code_;
     swizzle_data = swizzle_data_;
 
@@ -898,6 +906,8 @@ void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_
     // Find all `CALL` instructions and identify return locations
     FindReturnOffsets();
 
+    dead_instructions = FindDeadInstructions(*program_code, *swizzle_data, live_outputs);
+
     // The stack pointer is 8 modulo 16 at the entry of a procedure
     // We reserve 16 bytes and assign a dummy value to the first 8 bytes, to catch any potential
     // return checks (see Compile_Return) that happen in shader main routine.
@@ -944,7 +954,8 @@ void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_
     ready();
 
     ASSERT_MSG(getSize() <= MAX_SHADER_SIZE, "Compiled a shader that exceeds the allocated size!");
-    LOG_DEBUG(HW_GPU, "Compiled shader size={}", getSize());
+    LOG_DEBUG(HW_GPU, "Compiled shader size={}, skipped {} dead instructions", getSize(),
+              dead_instructions.count());
 }
 
 JitShader::JitShader() : Xbyak::CodeGenerator(MAX_SHADER_SIZE) {
@@ -37,8 +37,17 @@ public:
         program(&setup.uniforms, &state, instruction_labels[offset].getAddress());
     }
 
+    /**
+     * Compiles a shader program. Instructions whose results never reach the live outputs are
+     * skipped.
+     * @param program_code Program to compile
+     * @param swizzle_data Operand descriptors of the program
+     * @param live_outputs Output register components read after the program ends, in the format of
+     *                     ShaderSetup::live_outputs
+     */
     void Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code,
-                 const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data);
+                 const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data,
+                 u64 live_outputs = ~u64{0});
 
     void Compile_ADD(Instruction instr);
     void Compile_DP3(Instruction instr);
@@ -127,6 +136,9 @@ private:
     /// Offsets in code where a return needs to be inserted
     std::vector<unsigned> return_offsets;
 
+    /// Offsets of the instructions that don't need to be compiled because their results are unused
+    std::bitset<MAX_PROGRAM_CODE_LENGTH> dead_instructions;
+
     unsigned program_counter = 0; ///< Offset of the next instruction to decode
     bool looping = false;         ///< True if compiling a loop, used to check for nested loops
 
@@ -0,0 +1,353 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <nihstro/shader_bytecode.h>
+#include "video_core/shader/shader_liveness.h"
+
+using nihstro::Instruction;
+using nihstro::OpCode;
+using nihstro::RegisterType;
+using nihstro::SourceRegister;
+using nihstro::SwizzlePattern;
+
+namespace Pica::Shader {
+
+namespace {
+
+/// Set of register components. Bit 4 * n + c stands for component c of output register n for
+/// n < 16, and of temporary register n - 16 otherwise.
+using ComponentSet = std::bitset<128>;
+
+const ComponentSet ALL_OUTPUTS = ComponentSet{}.set() >> 64;
+const ComponentSet ALL_REGISTERS = ComponentSet{}.set();
+
+/// Offset reached when execution runs past the last instruction
+constexpr u32 END_OF_PROGRAM = MAX_PROGRAM_CODE_LENGTH;
+
+/// Register components read and written by a single instruction
+struct InstructionUsage {
+    /// Components written by the instruction
+    ComponentSet defs;
+    /// Components read to compute each component of the result
+    std::array<ComponentSet, 4> uses;
+    /// Components read whether or not the result is used
+    ComponentSet side_uses;
+    /// Bit of the first component of the destination register
+    unsigned dest_base = 0;
+    /// True if the only effect of the instruction is writing its destination register
+    bool removable = false;
+};
+
+/// Reads of the source operands of an arithmetic instruction
+class SourceReads {
+public:
+    SourceReads(const SwizzlePattern& swizzle, unsigned relative_source)
+        : relative_source(relative_source) {
+        selectors[0] = {static_cast<u8>(swizzle.src1_selector_0.Value()),
+                        static_cast<u8>(swizzle.src1_selector_1.Value()),
+                        static_cast<u8>(swizzle.src1_selector_2.Value()),
+                        static_cast<u8>(swizzle.src1_selector_3.Value())};
+        selectors[1] = {static_cast<u8>(swizzle.src2_selector_0.Value()),
+                        static_cast<u8>(swizzle.src2_selector_1.Value()),
+                        static_cast<u8>(swizzle.src2_selector_2.Value()),
+                        static_cast<u8>(swizzle.src2_selector_3.Value())};
+        selectors[2] = {static_cast<u8>(swizzle.src3_selector_0.Value()),
+                        static_cast<u8>(swizzle.src3_selector_1.Value()),
+                        static_cast<u8>(swizzle.src3_selector_2.Value()),
+                        static_cast<u8>(swizzle.src3_selector_3.Value())};
+    }
+
+    /// Returns the register components read by component `comp` of source `src`
+    ComponentSet Read(unsigned src, const SourceRegister& reg, unsigned comp) const {
+        ComponentSet set;
+        if (src == relative_source && reg.GetRegisterType() != RegisterType::FloatUniform) {
+            // The address register can move the access to any register of the unit state. Like
+            // in the JIT, relative uniform accesses are assumed to stay within the uniforms.
+            return ALL_REGISTERS;
+        }
+        if (reg.GetRegisterType() == RegisterType::Temporary) {
+            set.set((16 + reg.GetIndex()) * 4 + selectors[src][comp]);
+        }
+        return set;
+    }
+
+    /// Returns the register components read by the first `count` components of source `src`
+    ComponentSet ReadFirst(unsigned src, const SourceRegister& reg, unsigned count) const {
+        ComponentSet set;
+        for (unsigned comp = 0; comp < count; ++comp) {
+            set |= Read(src, reg, comp);
+        }
+        return set;
+    }
+
+private:
+    std::array<std::array<u8, 4>, 3> selectors;
+    unsigned relative_source;
+};
+
+void SetDestination(InstructionUsage& usage, const DestRegister& dest,
+                    const SwizzlePattern& swizzle) {
+    usage.dest_base = dest.GetRegisterType() == RegisterType::Output ? dest.GetIndex() * 4
+                                                                      : (16 + dest.GetIndex()) * 4;
+    for (unsigned comp = 0; comp < 4; ++comp) {
+        if (swizzle.DestComponentEnabled(comp)) {
+            usage.defs.set(usage.dest_base + comp);
+        }
+    }
+}
+
+InstructionUsage AnalyzeArithmetic(const SwizzleData& swizzle_data, Instruction instr) {
+    InstructionUsage usage;
+    const SwizzlePattern swizzle = {swizzle_data[instr.common.operand_desc_id]};
+    const bool is_inverted =
+        (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+    const unsigned relative_source =
+        instr.common.address_register_index == 0 ? 3 : (is_inverted ? 1 : 0);
+    const SourceReads reads(swizzle, relative_source);
+    const SourceRegister src1 = instr.common.GetSrc1(is_inverted);
+    const SourceRegister src2 = instr.common.GetSrc2(is_inverted);
+
+    const auto set_uses = [&usage](const ComponentSet& uses) { usage.uses.fill(uses); };
+
+    switch (instr.opcode.Value().EffectiveOpCode()) {
+    case OpCode::Id::ADD:
+    case OpCode::Id::MUL:
+    case OpCode::Id::MAX:
+    case OpCode::Id::MIN:
+    case OpCode::Id::SGE:
+    case OpCode::Id::SGEI:
+    case OpCode::Id::SLT:
+    case OpCode::Id::SLTI:
+        for (unsigned comp = 0; comp < 4; ++comp) {
+            usage.uses[comp] = reads.Read(0, src1, comp) | reads.Read(1, src2, comp);
+        }
+        break;
+    case OpCode::Id::FLR:
+    case OpCode::Id::MOV:
+        for (unsigned comp = 0; comp < 4; ++comp) {
+            usage.uses[comp] = reads.Read(0, src1, comp);
+        }
+        break;
+    case OpCode::Id::DP3:
+        set_uses(reads.ReadFirst(0, src1, 3) | reads.ReadFirst(1, src2, 3));
+        break;
+    case OpCode::Id::DP4:
+        set_uses(reads.ReadFirst(0, src1, 4) | reads.ReadFirst(1, src2, 4));
+        break;
+    case OpCode::Id::DPH:
+    case OpCode::Id::DPHI:
+        set_uses(reads.ReadFirst(0, src1, 3) | reads.ReadFirst(1, src2, 4));
+        break;
+    case OpCode::Id::RCP:
+    case OpCode::Id::RSQ:
+    case OpCode::Id::EX2:
+    case OpCode::Id::LG2:
+        set_uses(reads.Read(0, src1, 0));
+        break;
+    case OpCode::Id::MOVA:
+        usage.side_uses = reads.ReadFirst(0, src1, 2);
+        return usage;
+    case OpCode::Id::CMP:
+        usage.side_uses = reads.ReadFirst(0, src1, 2) | reads.ReadFirst(1, src2, 2);
+        return usage;
+    default:
+        usage.side_uses = ALL_REGISTERS;
+        return usage;
+    }
+
+    SetDestination(usage, instr.common.dest.Value(), swizzle);
+    usage.removable = true;
+    return usage;
+}
+
+InstructionUsage AnalyzeMultiplyAdd(const SwizzleData& swizzle_data, Instruction instr) {
+    InstructionUsage usage;
+    const OpCode::Id opcode = instr.opcode.Value().EffectiveOpCode();
+    if (opcode != OpCode::Id::MAD && opcode != OpCode::Id::MADI) {
+        return usage;
+    }
+
+    const SwizzlePattern swizzle = {swizzle_data[instr.mad.operand_desc_id]};
+    const bool is_inverted = opcode == OpCode::Id::MADI;
+    const unsigned relative_source =
+        instr.mad.address_register_index == 0 ? 3 : (is_inverted ? 2 : 1);
+    const SourceReads reads(swizzle, relative_source);
+    const SourceRegister src1 = instr.mad.GetSrc1(is_inverted);
+    const SourceRegister src2 = instr.mad.GetSrc2(is_inverted);
+    const SourceRegister src3 = instr.mad.GetSrc3(is_inverted);
+
+    for (unsigned comp = 0; comp < 4; ++comp) {
+        usage.uses[comp] =
+            reads.Read(0, src1, comp) | reads.Read(1, src2, comp) | reads.Read(2, src3, comp);
+    }
+    SetDestination(usage, instr.mad.dest.Value(), swizzle);
+    usage.removable = true;
+    return usage;
+}
+
+InstructionUsage AnalyzeInstruction(const SwizzleData& swizzle_data, Instruction instr) {
+    switch (instr.opcode.Value().GetInfo().type) {
+    case OpCode::Type::Arithmetic:
+        return AnalyzeArithmetic(swizzle_data, instr);
+    case OpCode::Type::MultiplyAdd:
+        return AnalyzeMultiplyAdd(swizzle_data, instr);
+    default: {
+        InstructionUsage usage;
+        if (instr.opcode.Value() == OpCode::Id::EMIT) {
+            usage.side_uses = ALL_OUTPUTS;
+        }
+        return usage;
+    }
+    }
+}
+
+} // Anonymous namespace
+
+std::bitset<MAX_PROGRAM_CODE_LENGTH> FindDeadInstructions(const ProgramCode& program_code,
+                                                          const SwizzleData& swizzle_data,
+                                                          u64 live_outputs) {
+    const auto position = [](u32 offset) { return std::min(offset, END_OF_PROGRAM); };
+
+    std::vector<InstructionUsage> usages(MAX_PROGRAM_CODE_LENGTH);
+    // Instructions that may execute after each instruction
+    std::vector<std::vector<u32>> successors(MAX_PROGRAM_CODE_LENGTH);
+    // Offsets that execution may return to instead of continuing at each offset, which happens
+    // when the end of a CALL, IF or LOOP block is reached
+    std::vector<std::vector<u32>> returns(END_OF_PROGRAM + 1);
+    // Ranges of the LOOP blocks, used to find the targets of BREAKC
+    std::vector<std::pair<u32, u32>> loops;
+
+    for (u32 offset = 0; offset < MAX_PROGRAM_CODE_LENGTH; ++offset) {
+        const Instruction instr = {program_code[offset]};
+        usages[offset] = AnalyzeInstruction(swizzle_data, instr);
+
+        const u32 next = position(offset + 1);
+        const u32 dest = position(instr.flow_control.dest_offset);
+        const u32 block_end =
+            position(instr.flow_control.dest_offset + instr.flow_control.num_instructions);
+
+        auto& next_offsets = successors[offset];
+        switch (instr.opcode.Value()) {
+        case OpCode::Id::END:
+            break;
+        case OpCode::Id::JMPC:
+        case OpCode::Id::JMPU:
+        case OpCode::Id::CALLC:
+        case OpCode::Id::CALLU:
+            next_offsets = {next, dest};
+            break;
+        case OpCode::Id::CALL:
+            next_offsets = {dest};
+            break;
+        case OpCode::Id::IFU:
+        case OpCode::Id::IFC:
+            next_offsets = {next, dest};
+            break;
+        case OpCode::Id::LOOP:
+            next_offsets = {next};
+            loops.emplace_back(offset, instr.flow_control.dest_offset);
+            break;
+        default:
+            next_offsets = {next};
+            break;
+        }
+
+        switch (instr.opcode.Value()) {
+        case OpCode::Id::CALL:
+        case OpCode::Id::CALLC:
+        case OpCode::Id::CALLU:
+            returns[block_end].push_back(next);
+            break;
+        case OpCode::Id::IFU:
+        case OpCode::Id::IFC:
+            if (block_end != dest) {
+                returns[dest].push_back(block_end);
+            }
+            break;
+        case OpCode::Id::LOOP:
+            returns[position(instr.flow_control.dest_offset + 1)].push_back(next);
+            break;
+        default:
+            break;
+        }
+    }
+
+    for (u32 offset = 0; offset < MAX_PROGRAM_CODE_LENGTH; ++offset) {
+        const Instruction instr = {program_code[offset]};
+        if (instr.opcode.Value() != OpCode::Id::BREAKC) {
+            continue;
+        }
+        for (const auto& [loop_start, loop_end] : loops) {
+            if (loop_start < offset && offset <= loop_end) {
+                successors[offset].push_back(position(loop_end + 1));
+            }
+        }
+    }
+
+    // Components that are live when execution reaches each offset, before any return is taken
+    std::vector<ComponentSet> live(END_OF_PROGRAM + 1);
+
+    const ComponentSet live_at_end{live_outputs};
+    const auto live_out = [&](u32 offset) {
+        const Instruction instr = {program_code[offset]};
+        if (instr.opcode.Value() == OpCode::Id::END) {
+            return live_at_end;
+        }
+        ComponentSet set;
+        for (const u32 next : successors[offset]) {
+            set |= live[next];
+        }
+        return set;
+    };
+    const auto is_dead = [&usages](u32 offset, const ComponentSet& out) {
+        const InstructionUsage& usage = usages[offset];
+        return usage.removable && (usage.defs & out).none();
+    };
+
+    // Iterate backwards until the live sets stop changing. Each pass propagates liveness through
+    // the whole straight-line code, so only loops and calls require more than one pass.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (u32 offset = END_OF_PROGRAM + 1; offset-- > 0;) {
+            ComponentSet in;
+            if (offset == END_OF_PROGRAM) {
+                // Running past the end of the program behaves like reaching an END instruction
+                in = live_at_end;
+            } else {
+                const ComponentSet out = live_out(offset);
+                const InstructionUsage& usage = usages[offset];
+                in = out;
+                if (!is_dead(offset, out)) {
+                    in &= ~usage.defs;
+                    in |= usage.side_uses;
+                    for (unsigned comp = 0; comp < 4; ++comp) {
+                        if (usage.defs.test(usage.dest_base + comp) &&
+                            out.test(usage.dest_base + comp)) {
+                            in |= usage.uses[comp];
+                        }
+                    }
+                }
+            }
+            for (const u32 target : returns[offset]) {
+                in |= live[target];
+            }
+            if (in != live[offset]) {
+                live[offset] = in;
+                changed = true;
+            }
+        }
+    }
+
+    std::bitset<MAX_PROGRAM_CODE_LENGTH> dead;
+    for (u32 offset = 0; offset < MAX_PROGRAM_CODE_LENGTH; ++offset) {
+        dead[offset] = is_dead(offset, live_out(offset));
+    }
+    return dead;
+}
+
+} // namespace Pica::Shader
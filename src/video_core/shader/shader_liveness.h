@@ -0,0 +1,28 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <bitset>
+#include "common/common_types.h"
+#include "video_core/shader/shader.h"
+
+namespace Pica::Shader {
+
+/**
+ * Finds the arithmetic instructions of a shader program whose results can never reach one of the
+ * live output components. The analysis works on individual register components and follows all
+ * possible control flow, including calls, conditionals and loops, so skipping the dead
+ * instructions never changes the live outputs of any entry point.
+ * @param program_code Program to analyze
+ * @param swizzle_data Operand descriptors of the program
+ * @param live_outputs Output register components read after the program ends, in the format of
+ *                     ShaderSetup::live_outputs
+ * @return A set with the offsets of the dead instructions
+ */
+std::bitset<MAX_PROGRAM_CODE_LENGTH> FindDeadInstructions(const ProgramCode& program_code,
+                                                          const SwizzleData& swizzle_data,
+                                                          u64 live_outputs);
+
+} // namespace Pica::Shader
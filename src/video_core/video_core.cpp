@@ -19,6 +19,7 @@
 namespace VideoCore {
 
 std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
+std::unique_ptr<GPUThread> g_gpu_thread; ///< GPU thread, if enabled
 
 std::atomic<bool> g_hw_renderer_enabled;
 std::atomic<bool> g_shader_jit_enabled;
@@ -30,6 +31,8 @@ std::atomic<bool> g_renderer_bg_color_update_requested;
 std::atomic<bool> g_renderer_sampler_update_requested;
 std::atomic<bool> g_renderer_shader_update_requested;
 std::atomic<bool> g_texture_filter_update_requested;
+// Turbo mode
+std::atomic<bool> g_turbo_until_trigger;
 // Screenshot
 std::atomic<bool> g_renderer_screenshot_requested;
 void* g_screenshot_bits;
@@ -57,6 +60,9 @@ ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemorySystem& memory)
         LOG_ERROR(Render, "initialization failed !");
     } else {
         LOG_DEBUG(Render, "initialized OK");
+        if (Settings::values.use_gpu_thread) {
+            g_gpu_thread = std::make_unique<GPUThread>(emu_window);
+        }
     }
 
     return result;
@@ -64,6 +70,9 @@ ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemorySystem& memory)
 
 /// Shutdown the video core
 void Shutdown() {
+    // Runs the remaining work and hands the graphics context back to this thread
+    g_gpu_thread.reset();
+
     Pica::Shutdown();
 
     g_renderer->ShutDown();
@@ -107,8 +116,15 @@ u16 GetResolutionScaleFactor() {
     }
 }
 
+bool IsTurboActive() {
+    return Settings::values.use_turbo || g_turbo_until_trigger;
+}
+
 template <class Archive>
 void serialize(Archive& ar, const unsigned int) {
+    if (g_gpu_thread) {
+        g_gpu_thread->WaitForIdle();
+    }
     ar& Pica::g_state;
 }
 
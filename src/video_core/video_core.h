@@ -8,6 +8,7 @@
 #include <iostream>
 #include <memory>
 #include "core/frontend/emu_window.h"
+#include "video_core/gpu_thread.h"
 
 namespace Frontend {
 class EmuWindow;
@@ -25,6 +26,7 @@ class MemorySystem;
 namespace VideoCore {
 
 extern std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
+extern std::unique_ptr<GPUThread> g_gpu_thread; ///< GPU thread, if enabled
 
 // TODO: Wrap these in a user settings struct along with any other graphics settings (often set from
 // qt ui)
@@ -38,6 +40,8 @@ extern std::atomic<bool> g_renderer_bg_color_update_requested;
 extern std::atomic<bool> g_renderer_sampler_update_requested;
 extern std::atomic<bool> g_renderer_shader_update_requested;
 extern std::atomic<bool> g_texture_filter_update_requested;
+// Turbo mode
+extern std::atomic<bool> g_turbo_until_trigger; ///< Skips presenting frames until cleared
 // Screenshot
 extern std::atomic<bool> g_renderer_screenshot_requested;
 extern void* g_screenshot_bits;
@@ -63,6 +67,16 @@ ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemorySystem& memory)
 /// Shutdown the video core
 void Shutdown();
 
+/// Runs a function that uses the renderer on the GPU thread if there is one, and waits for it
+template <typename F>
+void RunOnGPUThread(F&& func) {
+    if (g_gpu_thread) {
+        g_gpu_thread->RunSync(std::forward<F>(func));
+    } else {
+        func();
+    }
+}
+
 /// Request a screenshot of the next frame
 void RequestScreenshot(void* data, std::function<void()> callback,
                        const Layout::FramebufferLayout& layout);
@@ -73,6 +87,9 @@ void RequestCTroll3D(void* data, std::function<uint8_t(char *)> callback, const
 
 u16 GetResolutionScaleFactor();
 
+/// Whether emulation currently runs unthrottled with frames being skipped
+bool IsTurboActive();
+
 template <class Archive>
 void serialize(Archive& ar, const unsigned int file_version);
 